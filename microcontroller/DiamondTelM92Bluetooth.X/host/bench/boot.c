@@ -0,0 +1,118 @@
+/**
+ * @file
+ * @author Jeff Lau
+ *
+ * Benchmark of booting with a full directory: the time from power-up to the
+ * first main loop pass (APP_Task()), the EEPROM read until that pass has
+ * loaded storage (STORAGE_Initialize()), and the RAM used by storage.c.
+ *
+ * Storage is formatted and every directory entry is given a name before the
+ * firmware is started, as if it had been used before. The firmware runs
+ * without a Bluetooth module.
+ *
+ * Reading EEPROM costs no simulated time, so the number of bytes read stands
+ * in for the time that loading storage takes on the MCU.
+ *
+ * The original storage.c loaded all of storage (all EEPROM_SIZE bytes of
+ * EEPROM) into RAM at boot, and also kept the sorted directory names and two
+ * journal states in RAM (ORIGINAL_STORAGE_RAM_SIZE). The RAM used by storage.c
+ * now (STORAGE_RAM_SIZE) is the total size of its static data in the host
+ * build (see Makefile), where storage.c is built with packed structs like on
+ * the MCU. With PROFILE=1, it also includes the EEPROM write counters.
+ */
+
+#include "../sim.h"
+#include "../../src/storage/eeprom.h"
+#include "../../src/storage/storage.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/**
+ * RAM used by the original storage.c: all of storage, the sorted directory
+ * names and their count, and the call time and settings journal states.
+ */
+#define ORIGINAL_STORAGE_RAM_SIZE (EEPROM_SIZE + STORAGE_DIRECTORY_SIZE + 1 + 2 * 2)
+
+/**
+ * Simulated execution time of each pass of the main loop (us).
+ */
+#define MAIN_LOOP_PASS_TIME (50)
+
+static struct {
+  uint64_t startTime;
+  uint32_t startDfmReads;
+} bench;
+
+static void completeEepromWrites(void) {
+  while (!EEPROM_IsDoneWriting()) {
+    EEPROM_Task();
+    HOST_Advance(1000);
+  }
+}
+
+static void fillDirectory(void) {
+  char number[MAX_EXTENDED_PHONE_NUMBER_LENGTH + 1];
+  char name[STORAGE_MAX_DIRECTORY_NAME_LENGTH + 1];
+
+  EEPROM_Initialize();
+  STORAGE_Initialize();
+  completeEepromWrites();
+
+  for (uint8_t i = 0; i < STORAGE_DIRECTORY_SIZE; ++i) {
+    sprintf(number, "555%07u", 1234567U + i * 7919U);
+    sprintf(name, "Contact %u", i);
+    STORAGE_SetDirectoryEntry(i, number, name);
+    completeEepromWrites();
+  }
+}
+
+static void handleMainLoopPass(void) {
+  // The main loop pass time is spent before APP_Task()
+  uint64_t const firstTaskTime = HOST_GetTime() - MAIN_LOOP_PASS_TIME - bench.startTime;
+  uint32_t const dfmReads = HOST_GetDfmReadCount() - bench.startDfmReads;
+
+  if (STORAGE_IsDirectoryNameEmpty(STORAGE_DIRECTORY_SIZE - 1)) {
+    fprintf(stderr, "FAIL: directory was not loaded\n");
+    exit(1);
+  }
+
+  printf("Power-up to first APP_Task(): %.3f ms\n", (double)firstTaskTime / 1000.0);
+  printf(
+      "EEPROM read until storage is loaded: %u bytes (originally %u)\n",
+      dfmReads,
+      EEPROM_SIZE
+      );
+  printf(
+      "Storage RAM: %u bytes (originally %u; %u freed)\n",
+      STORAGE_RAM_SIZE,
+      ORIGINAL_STORAGE_RAM_SIZE,
+      ORIGINAL_STORAGE_RAM_SIZE - STORAGE_RAM_SIZE
+      );
+
+  HOST_End();
+}
+
+void FIRMWARE_main(void);
+
+int main(void) {
+  HOST_Options options;
+
+  options.duration = UINT64_MAX;
+  options.mainLoopPassTime = MAIN_LOOP_PASS_TIME;
+  options.isFirmwareOutputEnabled = false;
+  options.isReportEnabled = false;
+  options.mainLoopPassHandler = handleMainLoopPass;
+  options.endHandler = NULL;
+
+  HOST_Initialize(&options);
+  HOST_Peripherals_Initialize();
+  fillDirectory();
+
+  bench.startTime = HOST_GetTime();
+  bench.startDfmReads = HOST_GetDfmReadCount();
+
+  FIRMWARE_main();
+
+  return 1;
+}
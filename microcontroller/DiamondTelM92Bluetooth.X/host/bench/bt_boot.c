@@ -0,0 +1,95 @@
+/**
+ * @file
+ * @author Jeff Lau
+ *
+ * Benchmark of the time from power-up until the phone is fully connected and
+ * idle ("ready"), with a simulated BM62 Bluetooth Module (see bm62.h).
+ *
+ * Ready means that the phone is connected, its name has been stored, its
+ * phonebook has been synced and indexed, and there are no more BT commands to
+ * be sent or ACKed.
+ *
+ * Built twice: bt_boot with the default (pipelined) BT command send mode, and
+ * bt_boot_strict with PIPELINED_CMD_WINDOW set to 0 (see the Makefile).
+ */
+
+#include "../sim.h"
+#include "../bm62.h"
+#include "../../src/bluetooth/bt_command_send.h"
+#include "../../src/storage/phonebook.h"
+#include "../../src/storage/storage.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define PHONE_NAME "Host Phone"
+#define PHONEBOOK_COUNT (100)
+
+static void getPhonebookEntry(uint16_t index, char* number, char* name) {
+  sprintf(number, "555%07u", index * 7919U);
+  sprintf(name, "Name %u", index);
+}
+
+static bool isReady(void) {
+  char name[32];
+
+  return BM62_IsConnected() &&
+      BM62_GetCommandCount(READ_LINKED_DEVICE_INFOR) &&
+      !strcmp(STORAGE_GetPairedDeviceName(name), PHONE_NAME) &&
+      !PHONEBOOK_IsSyncing() &&
+      PHONEBOOK_IsIndexed() &&
+      (PHONEBOOK_GetCount() == PHONEBOOK_COUNT) &&
+      !BT_CommandSend_IsTimer1MSInterruptRequired();
+}
+
+static void handleMainLoopPass(void) {
+  if (isReady()) {
+    HOST_End();
+  }
+}
+
+static void handleEnd(void) {
+  if (!isReady()) {
+    fprintf(stderr, "FAIL: not ready after %.3f s\n", (double)HOST_GetTime() / 1000000.0);
+    exit(1);
+  }
+
+  printf(
+      "Ready after %.3f s (%u phonebook entries; %u AT commands; %u event ACKs)\n",
+      (double)HOST_GetTime() / 1000000.0,
+      PHONEBOOK_COUNT,
+      BM62_GetCommandCount(VENDOR_AT_CMD),
+      BM62_GetCommandCount(MCU_SEND_EVENT_ACK)
+      );
+}
+
+void FIRMWARE_main(void);
+
+int main(void) {
+  HOST_Options options;
+  BM62_Options bm62Options;
+
+  options.duration = 60 * 1000000ULL;
+  options.mainLoopPassTime = 50;
+  options.isFirmwareOutputEnabled = false;
+  options.isReportEnabled = false;
+  options.mainLoopPassHandler = handleMainLoopPass;
+  options.endHandler = handleEnd;
+
+  memset(&bm62Options, 0, sizeof(bm62Options));
+  bm62Options.powerOnTime = 500000;
+  bm62Options.ackDelay = 2000;
+  bm62Options.linkBackDelay = 1000000;
+  bm62Options.atResponseDelay = 20000;
+  bm62Options.phoneName = PHONE_NAME;
+  bm62Options.phonebookCount = PHONEBOOK_COUNT;
+  bm62Options.getPhonebookEntry = getPhonebookEntry;
+
+  HOST_Initialize(&options);
+  HOST_Peripherals_Initialize();
+  BM62_Initialize(&bm62Options);
+
+  FIRMWARE_main();
+
+  return 1;
+}
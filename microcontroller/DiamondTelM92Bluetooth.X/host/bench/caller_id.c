@@ -0,0 +1,261 @@
+/**
+ * @file
+ * @author Jeff Lau
+ *
+ * Benchmark of looking up a caller's name in the directory by phone number
+ * (STORAGE_FindDirectoryName() in storage.c) on a full directory.
+ *
+ * All STORAGE_DIRECTORY_SIZE directory entries are given names and phone
+ * numbers, then callers are looked up by an international format number
+ * (with a leading "+1"):
+ * - "Last entry" matches only the last directory entry.
+ * - "Unknown" matches no directory entry.
+ * - "Build" is the first lookup after STORAGE_Initialize(), which reads the
+ *   numbers of all entries to build the caller ID keys.
+ *
+ * "Linear" compares the caller ID digits of every named entry's number, read
+ * with STORAGE_GetDirectoryNumber(), which is what a lookup without caller ID
+ * keys has to do. "Keyed" is STORAGE_FindDirectoryName(), which only reads
+ * entries whose key matches.
+ *
+ * Times are host CPU time (the best of RUN_COUNT runs), so they are only
+ * meaningful relative to each other. DFM reads are the number of bytes read
+ * from EEPROM, which is the main cost of a lookup on the MCU.
+ */
+
+#include "../sim.h"
+#include "../../src/storage/eeprom.h"
+#include "../../src/storage/storage.h"
+#include <ctype.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define ITERATIONS (20000UL)
+#define BUILD_ITERATIONS (1000UL)
+#define RUN_COUNT (5)
+
+/**
+ * Number of trailing digits of phone numbers that are compared (same as
+ * CALLER_ID_MATCH_LENGTH in storage.c).
+ */
+#define CALLER_ID_MATCH_LENGTH (SHORT_PHONE_NUMBER_LENGTH)
+
+/**
+ * Name of every directory entry (the last entry is renamed, so that a match
+ * can be recognized).
+ */
+#define ENTRY_NAME "Contact"
+#define LAST_ENTRY_NAME "Last Contact"
+
+typedef struct {
+  char const* label;
+  char const* number;
+  uint32_t iterations;
+  uint64_t bestTime[2];
+  uint32_t dfmReads[2];
+} result_t;
+
+static struct {
+  char name[STORAGE_MAX_DIRECTORY_NAME_LENGTH + 1];
+  volatile bool isFound;
+} bench;
+
+static uint64_t getNanoseconds(void) {
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return (uint64_t)now.tv_sec * 1000000000ULL + (uint64_t)now.tv_nsec;
+}
+
+static void completeEepromWrites(void) {
+  while (!EEPROM_IsDoneWriting()) {
+    EEPROM_Task();
+    HOST_Advance(1000);
+  }
+}
+
+static void getPhoneNumber(char* dest, uint8_t index) {
+  sprintf(dest, "555%07u", 1234567U + index * 7919U);
+}
+
+static void fillDirectory(void) {
+  char number[MAX_EXTENDED_PHONE_NUMBER_LENGTH + 1];
+
+  for (uint8_t i = 0; i < STORAGE_DIRECTORY_SIZE; ++i) {
+    getPhoneNumber(number, i);
+    STORAGE_SetDirectoryEntry(i, number, (i == STORAGE_DIRECTORY_SIZE - 1) ? LAST_ENTRY_NAME : ENTRY_NAME);
+    completeEepromWrites();
+  }
+}
+
+/*------------------------------------------------------------------------------
+ * Linear lookup (no caller ID keys)
+ *----------------------------------------------------------------------------*/
+
+static char* getCallerIdDigits(char* dest, char const* number) {
+  uint8_t length = 0;
+
+  while (*number && (*number != 'P') && (*number != 'M')) {
+    char const c = *number++;
+
+    if (isdigit(c)) {
+      if (length == CALLER_ID_MATCH_LENGTH) {
+        memmove(dest, dest + 1, CALLER_ID_MATCH_LENGTH - 1);
+        --length;
+      }
+
+      dest[length++] = c;
+    }
+  }
+
+  dest[length] = 0;
+
+  return dest;
+}
+
+static bool findDirectoryNameLinear(char const* number, char* dest) {
+  char digits[CALLER_ID_MATCH_LENGTH + 1];
+  char entryDigits[CALLER_ID_MATCH_LENGTH + 1];
+  char entryNumber[MAX_EXTENDED_PHONE_NUMBER_LENGTH + 1];
+
+  getCallerIdDigits(digits, number);
+
+  if (!digits[0]) {
+    return false;
+  }
+
+  for (uint8_t i = 0; i < STORAGE_DIRECTORY_SIZE; ++i) {
+    if (
+        !STORAGE_IsDirectoryNameEmpty(i) &&
+        !strcmp(digits, getCallerIdDigits(entryDigits, STORAGE_GetDirectoryNumber(i, entryNumber)))
+        ) {
+      STORAGE_GetDirectoryName(i, dest);
+      return true;
+    }
+  }
+
+  return false;
+}
+
+/*----------------------------------------------------------------------------*/
+
+static bool (*const LOOKUPS[2])(char const*, char*) = {
+  findDirectoryNameLinear,
+  STORAGE_FindDirectoryName
+};
+
+static void addRun(result_t* result, uint8_t variant, uint64_t time, uint32_t dfmReads) {
+  if (time < result->bestTime[variant]) {
+    result->bestTime[variant] = time;
+  }
+
+  result->dfmReads[variant] = dfmReads;
+}
+
+static void benchLookup(result_t* result, uint8_t variant) {
+  bool (*const lookup)(char const*, char*) = LOOKUPS[variant];
+  uint32_t const startDfmReads = HOST_GetDfmReadCount();
+  uint64_t const start = getNanoseconds();
+
+  for (uint32_t i = 0; i < ITERATIONS; ++i) {
+    bench.isFound = lookup(result->number, bench.name);
+  }
+
+  uint64_t const time = getNanoseconds() - start;
+
+  addRun(result, variant, time, HOST_GetDfmReadCount() - startDfmReads);
+  result->iterations = ITERATIONS;
+}
+
+static void benchBuild(result_t* result, uint8_t variant) {
+  bool (*const lookup)(char const*, char*) = LOOKUPS[variant];
+  uint64_t time = 0;
+  uint32_t dfmReads = 0;
+
+  for (uint32_t i = 0; i < BUILD_ITERATIONS; ++i) {
+    STORAGE_Initialize();
+
+    uint32_t const startDfmReads = HOST_GetDfmReadCount();
+    uint64_t const start = getNanoseconds();
+    bench.isFound = lookup(result->number, bench.name);
+    time += getNanoseconds() - start;
+    dfmReads += HOST_GetDfmReadCount() - startDfmReads;
+  }
+
+  addRun(result, variant, time, dfmReads);
+  result->iterations = BUILD_ITERATIONS;
+}
+
+/**
+ * Checks that both lookups find the expected name (or none).
+ */
+static void checkLookups(result_t const* result, char const* expectedName) {
+  for (uint8_t variant = 0; variant < 2; ++variant) {
+    bool const isFound = LOOKUPS[variant](result->number, bench.name);
+
+    if (isFound != (expectedName != NULL) || (isFound && strcmp(bench.name, expectedName))) {
+      fprintf(
+          stderr,
+          "FAIL: %s lookup of %s found \"%s\"\n",
+          variant ? "keyed" : "linear",
+          result->number,
+          isFound ? bench.name : "nothing"
+          );
+      exit(1);
+    }
+  }
+}
+
+static void printResult(result_t const* result) {
+  printf(
+      "%-12s linear %7.1f ns, %6.1f DFM reads; keyed %7.1f ns, %6.1f DFM reads\n",
+      result->label,
+      (double)result->bestTime[0] / result->iterations,
+      (double)result->dfmReads[0] / result->iterations,
+      (double)result->bestTime[1] / result->iterations,
+      (double)result->dfmReads[1] / result->iterations
+      );
+}
+
+int main(void) {
+  HOST_Options options;
+  char lastNumber[MAX_EXTENDED_PHONE_NUMBER_LENGTH + 1];
+  char lastEntryNumber[MAX_EXTENDED_PHONE_NUMBER_LENGTH + 1] = "+1";
+  result_t lastEntry = { "Last entry:", lastEntryNumber, 0, { UINT64_MAX, UINT64_MAX } };
+  result_t unknown = { "Unknown:", "+15550000001", 0, { UINT64_MAX, UINT64_MAX } };
+  result_t build = { "Build:", lastEntryNumber, 0, { UINT64_MAX, UINT64_MAX } };
+
+  getPhoneNumber(lastNumber, STORAGE_DIRECTORY_SIZE - 1);
+  strcat(lastEntryNumber, lastNumber);
+
+  memset(&options, 0, sizeof(options));
+  options.duration = UINT64_MAX;
+
+  HOST_Initialize(&options);
+  HOST_Peripherals_Initialize();
+  EEPROM_Initialize();
+  STORAGE_Initialize();
+  completeEepromWrites();
+  fillDirectory();
+
+  checkLookups(&lastEntry, LAST_ENTRY_NAME);
+  checkLookups(&unknown, NULL);
+
+  // Runs alternate between the variants, so that both are equally affected by
+  // anything else that is running on the host
+  for (uint8_t run = 0; run < RUN_COUNT; ++run) {
+    for (uint8_t variant = 0; variant < 2; ++variant) {
+      benchBuild(&build, variant);
+      benchLookup(&lastEntry, variant);
+      benchLookup(&unknown, variant);
+    }
+  }
+
+  printf("Full directory (%u named entries):\n", STORAGE_DIRECTORY_SIZE);
+  printResult(&lastEntry);
+  printResult(&unknown);
+  printResult(&build);
+
+  return 0;
+}
@@ -0,0 +1,265 @@
+/**
+ * @file
+ * @author Jeff Lau
+ *
+ * Benchmark of parsing +CLCC (call list) and +CPBR (phonebook entry) AT
+ * results, before and after CSV field views (string.c).
+ *
+ * "Before" copies every field up to the last needed field with a copy of the
+ * original CSV parser, the way the result handlers used to. "After" skips
+ * unneeded fields with skipCsvFields(), reads the +CLCC stat field through a
+ * view (scanNextCsvField()), and copies only the needed fields with
+ * parseNextCsvField(), the way the result handlers do now (see
+ * handleCallListAtResponse() in app.c and phonebook.c).
+ *
+ * Times are host CPU time (the best of RUN_COUNT runs), so they are only
+ * meaningful relative to each other. The original parser is kept out of line,
+ * like the parser in string.c, so that both variants make the same kind of
+ * calls.
+ */
+
+#include "../../src/util/string.h"
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#define ITERATIONS (1000000UL)
+#define RUN_COUNT (9)
+
+/**
+ * Realistic +CLCC results (with the "+CLCC: " prefix).
+ */
+static char const* const CLCC_RESULTS[] = {
+  "+CLCC: 1,1,4,0,0,\"5551234567\",129,\"Jeff Lau\"",
+  "+CLCC: 1,1,4,0,0,\"+15551234567\",145,\"\"",
+  "+CLCC: 2,1,5,0,0,\"8005551212\",129,\"Customer Service, Main Office\"",
+  "+CLCC: 1,0,2,0,0,\"5559876543\",129",
+  "+CLCC: 1,1,4,0,0,\"5550001111\",129,\"Dr. \"\"Bob\"\" Smith\""
+};
+
+/**
+ * Realistic +CPBR results (with the "+CPBR: " prefix).
+ */
+static char const* const CPBR_RESULTS[] = {
+  "+CPBR: 1,\"5551234567\",129,\"Mom\"",
+  "+CPBR: 27,\"+15551234567\",145,\"Jeff Lau\"",
+  "+CPBR: 315,\"(555) 987-6543\",129,\"Pizza Place, Downtown\"",
+  "+CPBR: 1999,\"5550001111\",129,\"Dr. \"\"Bob\"\" Smith\""
+};
+
+#define CLCC_COUNT (sizeof(CLCC_RESULTS) / sizeof(CLCC_RESULTS[0]))
+#define CPBR_COUNT (sizeof(CPBR_RESULTS) / sizeof(CPBR_RESULTS[0]))
+
+/**
+ * Parsed values, which are checked to be the same for both variants (and
+ * keep the parsing from being optimized away).
+ */
+typedef struct {
+  char stat;
+  char phoneNumber[24];
+  char name[48];
+} parsed_t;
+
+/*------------------------------------------------------------------------------
+ * Original CSV parser (copies every field)
+ *----------------------------------------------------------------------------*/
+
+__attribute__((noinline)) static char const* originalParseNextCsvField(char* dest, uint8_t destSize, char const* csv, char const* csvEnd) {
+  char* const destEnd = dest + destSize - 1;
+
+  if ((csv >= csvEnd) || !*csv) {
+    *dest = 0;
+    return csvEnd;
+  }
+
+  bool isQuoted = (*csv == '"');
+
+  if (isQuoted) {
+    ++csv;
+  }
+
+  while (true) {
+    if ((csv == csvEnd) || !*csv) {
+      csv = csvEnd;
+      break;
+    }
+
+    if (isQuoted && (*csv == '"')) {
+      char const next = (csv + 1 == csvEnd) ? 0 : csv[1];
+
+      if (next == '"') {
+        if (dest != destEnd) {
+          *dest++ = '"';
+        }
+        csv += 2;
+        continue;
+      } else if (next == ',') {
+        csv += 2;
+        break;
+      } else if (!next) {
+        csv = csvEnd;
+        break;
+      }
+    }
+
+    if (!isQuoted && (*csv == ',')) {
+      ++csv;
+      break;
+    }
+
+    if (dest != destEnd) {
+      *dest++ = *csv;
+    }
+    ++csv;
+  }
+
+  *dest = 0;
+
+  return csv;
+}
+
+static void parseClccBefore(parsed_t* parsed, char const* result, uint8_t resultLength) {
+  char const* const resultEnd = result + resultLength;
+  char buffer[48];
+
+  // id
+  char const* nextField = originalParseNextCsvField(buffer, sizeof(buffer), result + 7, resultEnd);
+  // dir
+  nextField = originalParseNextCsvField(buffer, sizeof(buffer), nextField, resultEnd);
+  // stat
+  nextField = originalParseNextCsvField(buffer, sizeof(buffer), nextField, resultEnd);
+  parsed->stat = *buffer;
+  // mode
+  nextField = originalParseNextCsvField(buffer, sizeof(buffer), nextField, resultEnd);
+  // mpty
+  nextField = originalParseNextCsvField(buffer, sizeof(buffer), nextField, resultEnd);
+  // number
+  nextField = originalParseNextCsvField(parsed->phoneNumber, sizeof(parsed->phoneNumber), nextField, resultEnd);
+  // type
+  nextField = originalParseNextCsvField(buffer, sizeof(buffer), nextField, resultEnd);
+  // alpha
+  originalParseNextCsvField(parsed->name, sizeof(parsed->name), nextField, resultEnd);
+}
+
+static void parseCpbrBefore(parsed_t* parsed, char const* result, uint8_t resultLength) {
+  char const* const resultEnd = result + resultLength;
+  char buffer[48];
+
+  // index
+  char const* nextField = originalParseNextCsvField(buffer, sizeof(buffer), result + 7, resultEnd);
+  parsed->stat = *buffer;
+  // number
+  nextField = originalParseNextCsvField(parsed->phoneNumber, sizeof(parsed->phoneNumber), nextField, resultEnd);
+  // type
+  nextField = originalParseNextCsvField(buffer, sizeof(buffer), nextField, resultEnd);
+  // text
+  originalParseNextCsvField(parsed->name, sizeof(parsed->name), nextField, resultEnd);
+}
+
+/*----------------------------------------------------------------------------*/
+
+static void parseClccAfter(parsed_t* parsed, char const* result, uint8_t resultLength) {
+  char const* const resultEnd = result + resultLength;
+  csv_field_t field;
+
+  // Skip id, dir
+  char const* nextField = skipCsvFields(result + 7, resultEnd, 2);
+  // stat
+  nextField = scanNextCsvField(&field, nextField, resultEnd);
+  parsed->stat = field.length ? *field.start : 0;
+  // Skip mode, mpty
+  nextField = skipCsvFields(nextField, resultEnd, 2);
+  // number
+  nextField = parseNextCsvField(parsed->phoneNumber, sizeof(parsed->phoneNumber), nextField, resultEnd);
+  // Skip type
+  nextField = skipCsvFields(nextField, resultEnd, 1);
+  // alpha
+  parseNextCsvField(parsed->name, sizeof(parsed->name), nextField, resultEnd);
+}
+
+static void parseCpbrAfter(parsed_t* parsed, char const* result, uint8_t resultLength) {
+  char const* const resultEnd = result + resultLength;
+
+  // index
+  char const* nextField = parseNextCsvField(parsed->name, sizeof(parsed->name), result + 7, resultEnd);
+  parsed->stat = *parsed->name;
+  // number
+  nextField = parseNextCsvField(parsed->phoneNumber, sizeof(parsed->phoneNumber), nextField, resultEnd);
+  // Skip type
+  nextField = skipCsvFields(nextField, resultEnd, 1);
+  // text
+  parseNextCsvField(parsed->name, sizeof(parsed->name), nextField, resultEnd);
+}
+
+static uint64_t getNanoseconds(void) {
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return (uint64_t)now.tv_sec * 1000000000ULL + (uint64_t)now.tv_nsec;
+}
+
+/**
+ * @return The time to parse ITERATIONS results (ns).
+ */
+static uint64_t bench(void (*volatile const parse)(parsed_t*, char const*, uint8_t), char const* const* results, uint8_t const* lengths, uint8_t resultCount, parsed_t* parsed) {
+  uint64_t const start = getNanoseconds();
+
+  for (uint32_t i = 0; i < ITERATIONS; ++i) {
+    uint8_t const index = (uint8_t)(i % resultCount);
+    parse(&parsed[index], results[index], lengths[index]);
+  }
+
+  return getNanoseconds() - start;
+}
+
+static int benchResults(char const* name, char const* const* results, uint8_t resultCount,
+    void (*parseBefore)(parsed_t*, char const*, uint8_t),
+    void (*parseAfter)(parsed_t*, char const*, uint8_t)) {
+  parsed_t parsedBefore[8];
+  parsed_t parsedAfter[8];
+  uint8_t lengths[8];
+  uint64_t bestBefore = UINT64_MAX;
+  uint64_t bestAfter = UINT64_MAX;
+
+  memset(parsedBefore, 0, sizeof(parsedBefore));
+  memset(parsedAfter, 0, sizeof(parsedAfter));
+
+  for (uint8_t i = 0; i < resultCount; ++i) {
+    lengths[i] = (uint8_t)strlen(results[i]);
+  }
+
+  // Runs alternate between the variants, so that both are equally affected by 
+  // anything else that is running on the host
+  for (uint8_t run = 0; run < RUN_COUNT; ++run) {
+    uint64_t const before = bench(parseBefore, results, lengths, resultCount, parsedBefore);
+    uint64_t const after = bench(parseAfter, results, lengths, resultCount, parsedAfter);
+
+    if (before < bestBefore) {
+      bestBefore = before;
+    }
+
+    if (after < bestAfter) {
+      bestAfter = after;
+    }
+  }
+
+  if (memcmp(parsedBefore, parsedAfter, sizeof(parsedBefore))) {
+    fprintf(stderr, "FAIL: %s results parsed differently\n", name);
+    return 1;
+  }
+
+  printf(
+      "%s: before %.1f ns, after %.1f ns per result\n",
+      name,
+      (double)bestBefore / ITERATIONS,
+      (double)bestAfter / ITERATIONS
+      );
+  return 0;
+}
+
+int main(void) {
+  if (benchResults("+CLCC", CLCC_RESULTS, CLCC_COUNT, parseClccBefore, parseClccAfter)) {
+    return 1;
+  }
+
+  return benchResults("+CPBR", CPBR_RESULTS, CPBR_COUNT, parseCpbrBefore, parseCpbrAfter);
+}
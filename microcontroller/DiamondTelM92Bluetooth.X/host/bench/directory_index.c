@@ -0,0 +1,275 @@
+/**
+ * @file
+ * @author Jeff Lau
+ *
+ * Benchmark of worst-case updates and lookups of the sorted directory names
+ * (storage.c) on a full directory.
+ *
+ * All STORAGE_DIRECTORY_SIZE directory entries are given realistic contact
+ * names, then:
+ * - "Build" is the first lookup after STORAGE_Initialize(), which reads and
+ *   sorts all names. Before the sorted names were updated incrementally,
+ *   every update invalidated them, so this was also the cost of the first
+ *   lookup after each update.
+ * - "Update" renames one entry from the first sorted name to the last sorted
+ *   name and back, so that every update moves it across all other names.
+ *   Pending EEPROM writes are completed between updates (not timed).
+ * - "Next name" steps from the last sorted name (wrapping around).
+ * - "Letter" jumps to the first name for the last letter of the alphabet.
+ * - "Non-letter" jumps to the first name for a char after all letters, which
+ *   is still a linear search of the sorted names.
+ *
+ * Times are host CPU time (the best of RUN_COUNT runs), so they are only
+ * meaningful relative to each other. DFM reads are the number of bytes read
+ * from EEPROM, which is the main cost of these operations on the MCU.
+ */
+
+#include "../sim.h"
+#include "../../src/storage/eeprom.h"
+#include "../../src/storage/storage.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <time.h>
+
+#define ITERATIONS (100000UL)
+#define BUILD_ITERATIONS (1000UL)
+#define UPDATE_ITERATIONS (1000UL)
+#define RUN_COUNT (5)
+
+/**
+ * Realistic contact names, one for each directory entry.
+ */
+static char const* const NAMES[STORAGE_DIRECTORY_SIZE] = {
+  "Mom",
+  "Dad",
+  "Jeff Lau",
+  "Pizza Place",
+  "Dr. Smith",
+  "Work",
+  "Grandma",
+  "Bob's Garage",
+  "Alice Johnson",
+  "Carlos Mendez",
+  "Dentist",
+  "Emily Chen",
+  "Frank Miller",
+  "Gym",
+  "Hannah Lee",
+  "Insurance Agent",
+  "Kevin O'Brien",
+  "Landlord",
+  "Maria Garcia",
+  "Nick Patel",
+  "Olivia Brown",
+  "Pharmacy",
+  "Quinn Taylor",
+  "Roadside Assist",
+  "Sam Wilson",
+  "Taxi",
+  "Uncle Ray",
+  "Vet Clinic",
+  "Will Turner"
+};
+
+/**
+ * Names that sort before/after all other names.
+ */
+#define FIRST_NAME "Aaron Abbott"
+#define LAST_NAME "Zoe Zimmerman"
+
+/**
+ * Directory index that is renamed by the update benchmark.
+ */
+#define UPDATE_INDEX (STORAGE_DIRECTORY_SIZE / 2)
+
+typedef struct {
+  char const* label;
+  uint64_t bestTime;
+  uint32_t dfmReads;
+  uint32_t iterations;
+} result_t;
+
+static struct {
+  uint8_t sortedIndexes[STORAGE_DIRECTORY_SIZE];
+  bool isLastName;
+  volatile uint8_t lookupResult;
+} bench;
+
+static uint64_t getNanoseconds(void) {
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return (uint64_t)now.tv_sec * 1000000000ULL + (uint64_t)now.tv_nsec;
+}
+
+static void completeEepromWrites(void) {
+  while (!EEPROM_IsDoneWriting()) {
+    EEPROM_Task();
+    HOST_Advance(1000);
+  }
+}
+
+static void getPhoneNumber(char* dest, uint8_t index) {
+  sprintf(dest, "555%07u", 1234567U + index * 7919U);
+}
+
+static int compareNames(void const* a, void const* b) {
+  int const result = strcasecmp(NAMES[*(uint8_t const*)a], NAMES[*(uint8_t const*)b]);
+  return result ? result : (*(uint8_t const*)a - *(uint8_t const*)b);
+}
+
+static void fillDirectory(void) {
+  char number[MAX_EXTENDED_PHONE_NUMBER_LENGTH + 1];
+
+  for (uint8_t i = 0; i < STORAGE_DIRECTORY_SIZE; ++i) {
+    getPhoneNumber(number, i);
+    STORAGE_SetDirectoryEntry(i, number, NAMES[i]);
+    completeEepromWrites();
+    bench.sortedIndexes[i] = i;
+  }
+
+  qsort(bench.sortedIndexes, STORAGE_DIRECTORY_SIZE, 1, compareNames);
+}
+
+/**
+ * Checks that the sorted names are in the expected order.
+ */
+static void checkSortedNames(void) {
+  uint8_t index = bench.sortedIndexes[STORAGE_DIRECTORY_SIZE - 1];
+
+  for (uint8_t i = 0; i < STORAGE_DIRECTORY_SIZE; ++i) {
+    index = STORAGE_GetNextNamedDirectoryIndex(index, true);
+
+    if (index != bench.sortedIndexes[i]) {
+      fprintf(stderr, "FAIL: sorted name %u is directory index %u, expected %u\n", i, index, bench.sortedIndexes[i]);
+      exit(1);
+    }
+  }
+}
+
+static void addRun(result_t* result, uint64_t time, uint32_t dfmReads, uint32_t iterations) {
+  if (time < result->bestTime) {
+    result->bestTime = time;
+  }
+
+  result->dfmReads = dfmReads;
+  result->iterations = iterations;
+}
+
+static void benchBuild(result_t* result) {
+  uint64_t time = 0;
+  uint32_t dfmReads = 0;
+
+  for (uint32_t i = 0; i < BUILD_ITERATIONS; ++i) {
+    STORAGE_Initialize();
+
+    uint32_t const startDfmReads = HOST_GetDfmReadCount();
+    uint64_t const start = getNanoseconds();
+    bench.lookupResult = STORAGE_GetNextNamedDirectoryIndex(0, true);
+    time += getNanoseconds() - start;
+    dfmReads += HOST_GetDfmReadCount() - startDfmReads;
+  }
+
+  addRun(result, time, dfmReads, BUILD_ITERATIONS);
+}
+
+static void benchUpdate(result_t* result) {
+  char number[MAX_EXTENDED_PHONE_NUMBER_LENGTH + 1];
+  uint64_t time = 0;
+  uint32_t dfmReads = 0;
+
+  getPhoneNumber(number, UPDATE_INDEX);
+
+  for (uint32_t i = 0; i < UPDATE_ITERATIONS; ++i) {
+    bench.isLastName = !bench.isLastName;
+
+    uint32_t const startDfmReads = HOST_GetDfmReadCount();
+    uint64_t const start = getNanoseconds();
+    STORAGE_SetDirectoryEntry(UPDATE_INDEX, number, bench.isLastName ? LAST_NAME : FIRST_NAME);
+    time += getNanoseconds() - start;
+    dfmReads += HOST_GetDfmReadCount() - startDfmReads;
+
+    completeEepromWrites();
+  }
+
+  addRun(result, time, dfmReads, UPDATE_ITERATIONS);
+}
+
+static void benchLookup(result_t* result, uint8_t (*lookup)(void)) {
+  uint32_t const startDfmReads = HOST_GetDfmReadCount();
+  uint64_t const start = getNanoseconds();
+
+  for (uint32_t i = 0; i < ITERATIONS; ++i) {
+    bench.lookupResult = lookup();
+  }
+
+  uint64_t const time = getNanoseconds() - start;
+
+  addRun(result, time, HOST_GetDfmReadCount() - startDfmReads, ITERATIONS);
+}
+
+static uint8_t lookupNextName(void) {
+  return STORAGE_GetNextNamedDirectoryIndex(bench.sortedIndexes[STORAGE_DIRECTORY_SIZE - 1], true);
+}
+
+static uint8_t lookupLetter(void) {
+  return STORAGE_GetFirstNamedDirectoryIndexForLetter('z');
+}
+
+static uint8_t lookupNonLetter(void) {
+  return STORAGE_GetFirstNamedDirectoryIndexForLetter('~');
+}
+
+static void printResult(result_t const* result) {
+  printf(
+      "%-12s %9.1f ns, %6.1f DFM reads\n",
+      result->label,
+      (double)result->bestTime / result->iterations,
+      (double)result->dfmReads / result->iterations
+      );
+}
+
+int main(void) {
+  HOST_Options options;
+  result_t build = { "Build:", UINT64_MAX };
+  result_t update = { "Update:", UINT64_MAX };
+  result_t nextName = { "Next name:", UINT64_MAX };
+  result_t letter = { "Letter:", UINT64_MAX };
+  result_t nonLetter = { "Non-letter:", UINT64_MAX };
+
+  memset(&options, 0, sizeof(options));
+  options.duration = UINT64_MAX;
+
+  HOST_Initialize(&options);
+  HOST_Peripherals_Initialize();
+  EEPROM_Initialize();
+  STORAGE_Initialize();
+  completeEepromWrites();
+  fillDirectory();
+  checkSortedNames();
+
+  for (uint8_t run = 0; run < RUN_COUNT; ++run) {
+    benchBuild(&build);
+    benchUpdate(&update);
+    benchLookup(&nextName, lookupNextName);
+    benchLookup(&letter, lookupLetter);
+    benchLookup(&nonLetter, lookupNonLetter);
+  }
+
+  // Restore the name of the updated entry
+  char number[MAX_EXTENDED_PHONE_NUMBER_LENGTH + 1];
+  getPhoneNumber(number, UPDATE_INDEX);
+  STORAGE_SetDirectoryEntry(UPDATE_INDEX, number, NAMES[UPDATE_INDEX]);
+  completeEepromWrites();
+  checkSortedNames();
+
+  printf("Full directory (%u named entries):\n", STORAGE_DIRECTORY_SIZE);
+  printResult(&build);
+  printResult(&update);
+  printResult(&nextName);
+  printResult(&letter);
+  printResult(&nonLetter);
+
+  return 0;
+}
@@ -0,0 +1,145 @@
+/**
+ * @file
+ * @author Jeff Lau
+ *
+ * Benchmark of the rate that queued DTMF digits are sent to the phone
+ * (atcmd.c), with a simulated BM62 Bluetooth Module (see bm62.h).
+ *
+ * Runs twice (in separate processes): once with a phone that accepts multiple
+ * digits in one "+VTS" command, and once with a phone that rejects them, where
+ * the firmware falls back to sending one digit per command with a delay after
+ * each digit, as it always did before batching.
+ */
+
+#include "../sim.h"
+#include "../bm62.h"
+#include "../../src/bluetooth/atcmd.h"
+#include "../../src/bluetooth/bt_command_send.h"
+#include "../../src/storage/phonebook.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#define DIGIT_COUNT (240)
+
+static struct {
+  bool isBatchAccepted;
+  uint16_t digitsQueued;
+  uint16_t digitsReceived;
+  uint16_t commandsReceived;
+  uint64_t startTime;
+  uint64_t endTime;
+} bench;
+
+static bool handleAtCommand(char const* command) {
+  if (strncmp(command, "+VTS=", 5)) {
+    return false;
+  }
+
+  uint8_t const length = (uint8_t)strlen(command + 5);
+
+  if ((length > 1) && !bench.isBatchAccepted) {
+    BM62_SendAtResponse(BM62_AtResponse_ERROR);
+    return true;
+  }
+
+  for (uint8_t i = 0; i < length; ++i) {
+    if (command[5 + i] != '0' + ((bench.digitsReceived + i) % 10)) {
+      fprintf(stderr, "FAIL: wrong DTMF digit %u\n", bench.digitsReceived + i);
+      exit(1);
+    }
+  }
+
+  bench.digitsReceived += length;
+  ++bench.commandsReceived;
+  bench.endTime = HOST_GetTime();
+
+  BM62_SendAtResponse(BM62_AtResponse_OK);
+  return true;
+}
+
+static void handleMainLoopPass(void) {
+  if (!bench.startTime) {
+    // Wait until connected and idle
+    if (!BM62_IsConnected() || PHONEBOOK_IsSyncing() || BT_CommandSend_IsTimer1MSInterruptRequired()) {
+      return;
+    }
+
+    bench.startTime = HOST_GetTime();
+  }
+
+  while ((bench.digitsQueued < DIGIT_COUNT) && ATCMD_SendDTMFDigit('0' + (bench.digitsQueued % 10))) {
+    ++bench.digitsQueued;
+  }
+
+  if (bench.digitsReceived == DIGIT_COUNT) {
+    HOST_End();
+  }
+}
+
+static void handleEnd(void) {
+  if (bench.digitsReceived != DIGIT_COUNT) {
+    fprintf(stderr, "FAIL: %u of %u DTMF digits received\n", bench.digitsReceived, DIGIT_COUNT);
+    exit(1);
+  }
+
+  printf(
+      "%s: %.1f digits/s (%u digits in %u commands)\n",
+      bench.isBatchAccepted ? "Batches accepted" : "Batches rejected",
+      (double)DIGIT_COUNT * 1000000.0 / (double)(bench.endTime - bench.startTime),
+      DIGIT_COUNT,
+      bench.commandsReceived
+      );
+}
+
+void FIRMWARE_main(void);
+
+static void run(bool isBatchAccepted) {
+  HOST_Options options;
+  BM62_Options bm62Options;
+
+  bench.isBatchAccepted = isBatchAccepted;
+
+  options.duration = 120 * 1000000ULL;
+  options.mainLoopPassTime = 50;
+  options.isFirmwareOutputEnabled = false;
+  options.isReportEnabled = false;
+  options.mainLoopPassHandler = handleMainLoopPass;
+  options.endHandler = handleEnd;
+
+  memset(&bm62Options, 0, sizeof(bm62Options));
+  bm62Options.powerOnTime = 500000;
+  bm62Options.ackDelay = 2000;
+  bm62Options.linkBackDelay = 1000000;
+  bm62Options.atResponseDelay = 20000;
+  bm62Options.phoneName = "Host Phone";
+  bm62Options.atCommandHandler = handleAtCommand;
+
+  HOST_Initialize(&options);
+  HOST_Peripherals_Initialize();
+  BM62_Initialize(&bm62Options);
+
+  FIRMWARE_main();
+}
+
+int main(void) {
+  for (int i = 0; i < 2; ++i) {
+    int status;
+
+    fflush(stdout);
+    pid_t const pid = fork();
+
+    if (pid == 0) {
+      run(i == 0);
+      return 1;
+    }
+
+    if ((pid < 0) || (waitpid(pid, &status, 0) != pid) || !WIFEXITED(status) || WEXITSTATUS(status)) {
+      return 1;
+    }
+  }
+
+  return 0;
+}
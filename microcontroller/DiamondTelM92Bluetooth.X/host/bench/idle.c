@@ -0,0 +1,135 @@
+/**
+ * @file
+ * @author Jeff Lau
+ *
+ * Benchmark of how often the CPU wakes up and runs the main loop while the
+ * phone is on hook and idle (see util/scheduler.h and power.h).
+ *
+ * Runs twice (in separate processes): once without a Bluetooth module (no
+ * phone), and once with a simulated BM62 Bluetooth Module (see bm62.h) that
+ * connects to a phone. Each run is measured after SETTLE_TIME, so that boot,
+ * connection and phonebook sync are excluded.
+ */
+
+#include "../sim.h"
+#include "../bm62.h"
+#include "../../src/storage/phonebook.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+/**
+ * Time after power-up until idle is measured (us).
+ */
+#define SETTLE_TIME (30 * 1000000ULL)
+
+/**
+ * Amount of idle time that is measured (us).
+ */
+#define MEASURE_TIME (60 * 1000000ULL)
+
+static struct {
+  bool isPhoneConnected;
+  bool isStarted;
+  uint64_t startTime;
+  uint32_t startMainLoopPasses;
+  uint32_t startSleeps;
+  uint64_t startSleepTime;
+} bench;
+
+static void getPhonebookEntry(uint16_t index, char* number, char* name) {
+  sprintf(number, "555%07u", index * 7919U);
+  sprintf(name, "Name %u", index);
+}
+
+static void handleMainLoopPass(void) {
+  if (bench.isStarted || (HOST_GetTime() < SETTLE_TIME)) {
+    return;
+  }
+
+  if (bench.isPhoneConnected && (!BM62_IsConnected() || PHONEBOOK_IsSyncing())) {
+    fprintf(stderr, "FAIL: phone not connected and synced after %.3f s\n", (double)HOST_GetTime() / 1000000.0);
+    exit(1);
+  }
+
+  bench.isStarted = true;
+  bench.startTime = HOST_GetTime();
+  bench.startMainLoopPasses = HOST_GetMainLoopPassCount();
+  bench.startSleeps = HOST_GetSleepCount();
+  bench.startSleepTime = HOST_GetSleepTime();
+}
+
+static void handleEnd(void) {
+  if (!bench.isStarted) {
+    fprintf(stderr, "FAIL: no main loop pass after %.3f s\n", (double)SETTLE_TIME / 1000000.0);
+    exit(1);
+  }
+
+  double const elapsed = (double)(HOST_GetTime() - bench.startTime);
+  double const seconds = elapsed / 1000000.0;
+  double const sleepTime = (double)(HOST_GetSleepTime() - bench.startSleepTime);
+
+  printf(
+      "%s: %.1f main loop passes/s, %.1f wake-ups/s, %.3f%% idle, %.3f%% active\n",
+      bench.isPhoneConnected ? "Phone connected" : "No phone",
+      (double)(HOST_GetMainLoopPassCount() - bench.startMainLoopPasses) / seconds,
+      (double)(HOST_GetSleepCount() - bench.startSleeps) / seconds,
+      100.0 * sleepTime / elapsed,
+      100.0 * (elapsed - sleepTime) / elapsed
+      );
+}
+
+void FIRMWARE_main(void);
+
+static void run(bool isPhoneConnected) {
+  HOST_Options options;
+  BM62_Options bm62Options;
+
+  bench.isPhoneConnected = isPhoneConnected;
+
+  options.duration = SETTLE_TIME + MEASURE_TIME;
+  options.mainLoopPassTime = 50;
+  options.isFirmwareOutputEnabled = false;
+  options.isReportEnabled = false;
+  options.mainLoopPassHandler = handleMainLoopPass;
+  options.endHandler = handleEnd;
+
+  HOST_Initialize(&options);
+  HOST_Peripherals_Initialize();
+
+  if (isPhoneConnected) {
+    memset(&bm62Options, 0, sizeof(bm62Options));
+    bm62Options.powerOnTime = 500000;
+    bm62Options.ackDelay = 2000;
+    bm62Options.linkBackDelay = 1000000;
+    bm62Options.atResponseDelay = 20000;
+    bm62Options.phoneName = "Host Phone";
+    bm62Options.phonebookCount = 100;
+    bm62Options.getPhonebookEntry = getPhonebookEntry;
+    BM62_Initialize(&bm62Options);
+  }
+
+  FIRMWARE_main();
+}
+
+int main(void) {
+  for (int i = 0; i < 2; ++i) {
+    int status;
+
+    fflush(stdout);
+    pid_t const pid = fork();
+
+    if (pid == 0) {
+      run(i == 1);
+      return 1;
+    }
+
+    if ((pid < 0) || (waitpid(pid, &status, 0) != pid) || !WIFEXITED(status) || WEXITSTATUS(status)) {
+      return 1;
+    }
+  }
+
+  return 0;
+}
@@ -0,0 +1,211 @@
+/**
+ * @file
+ * @author Jeff Lau
+ *
+ * Benchmark of the cost of the sound sample timer interrupt (TMR6, 10kHz)
+ * before and after calculating samples ahead in blocks (tone.c).
+ *
+ * "Before" is a copy of the original sample interrupt handler, which output
+ * the previous sample, then calculated the next sample of two sine tones.
+ * "After" is the current sample interrupt handler, which only outputs the
+ * next sample from the sample buffer, plus the cost per sample of calculating
+ * the samples in blocks in the 1ms interrupt (TONE_Timer1MS_Interrupt()).
+ *
+ * Times are host CPU time, so they are only meaningful relative to each other.
+ */
+
+#include "../sim.h"
+#include "../../mcc_generated_files/dac1.h"
+#include "../../src/sound/tone.h"
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#define SAMPLE_COUNT (20000000UL)
+#define SAMPLES_PER_MS (10)
+
+extern void (*TMR6_InterruptHandler)(void);
+
+/*------------------------------------------------------------------------------
+ * Original sample interrupt handler (two sine tones, no sample buffer)
+ *----------------------------------------------------------------------------*/
+
+#define SINE_MIDPOINT_VALUE (128)
+
+typedef union {
+  uint16_t value;
+
+  struct {
+    uint8_t fraction: 8;
+    uint8_t integer: 8;
+  };
+} sine_index_t;
+
+typedef struct {
+  tone_t tone;
+  sine_index_t index;
+  bool isStopping;
+} toneState_t;
+
+static volatile struct {
+  tone_t tone1;
+  tone_t tone2;
+  bool isStaged;
+} stagedTones;
+
+static struct {
+  uint8_t nextSample;
+  toneState_t tone1;
+  toneState_t tone2;
+} state;
+
+static void initToneState(toneState_t* toneState, tone_t tone) {
+  if (tone) {
+    toneState->tone = tone;
+    toneState->isStopping = false;
+  } else if (toneState->tone) {
+    toneState->isStopping = true;
+  }
+}
+
+static uint16_t getNextToneSample(toneState_t* toneState) {
+  if (!toneState->tone) {
+    return SINE_MIDPOINT_VALUE;
+  }
+
+  uint8_t const lastIndex = toneState->index.integer;
+  toneState->index.value += toneState->tone;
+  uint8_t const newIndex = toneState->index.integer;
+
+  if (toneState->isStopping
+      && ((lastIndex & 0b10000000) != (newIndex & 0b10000000))
+      ) {
+    toneState->tone = 0;
+    toneState->index.value = 0;
+    toneState->isStopping = false;
+
+    return SINE_MIDPOINT_VALUE;
+  } else {
+    return TONE_WAVEFORM_SINE[newIndex];
+  }
+}
+
+static void outputSoundSampleAndCalculateNextSample(void) {
+  DAC1_SetOutput(state.nextSample);
+
+  if (stagedTones.isStaged) {
+    initToneState(&state.tone1, stagedTones.tone1);
+    initToneState(&state.tone2, stagedTones.tone2);
+    stagedTones.isStaged = false;
+  }
+
+  uint16_t const nextOutputCalc =
+      (getNextToneSample(&state.tone1) +
+      getNextToneSample(&state.tone2)) >> 1;
+
+  state.nextSample = (uint8_t)nextOutputCalc;
+}
+
+/*----------------------------------------------------------------------------*/
+
+static uint64_t getNanoseconds(void) {
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return (uint64_t)now.tv_sec * 1000000000ULL + (uint64_t)now.tv_nsec;
+}
+
+/**
+ * Measures the average time between two consecutive getNanoseconds() calls,
+ * which is subtracted from each measured interval.
+ */
+static uint64_t getClockOverhead(void) {
+  uint64_t total = 0;
+
+  for (uint32_t i = 0; i < 1000000; ++i) {
+    uint64_t const start = getNanoseconds();
+    total += getNanoseconds() - start;
+  }
+
+  return total / 1000000;
+}
+
+static double benchBefore(void) {
+  // Called through a volatile pointer, like an interrupt vector, so it is
+  // not inlined into the loop
+  void (*volatile const isr)(void) = outputSoundSampleAndCalculateNextSample;
+
+  stagedTones.tone1 = TONE_DTMF_ROW1;
+  stagedTones.tone2 = TONE_DTMF_COL1;
+  stagedTones.isStaged = true;
+
+  uint64_t const start = getNanoseconds();
+
+  for (uint32_t i = 0; i < SAMPLE_COUNT; ++i) {
+    isr();
+  }
+
+  return (double)(getNanoseconds() - start) / SAMPLE_COUNT;
+}
+
+/**
+ * @param voiceCount - Number of voices to play (at least 2).
+ * @param blockTime - Updated with the cost per sample of calculating the
+ *        samples in the 1ms interrupt (ns).
+ * @return The cost of the sample interrupt (ns).
+ */
+static double benchAfter(uint8_t voiceCount, double* blockTime) {
+  uint64_t const clockOverhead = getClockOverhead();
+  uint64_t isrTime = 0;
+  uint64_t totalBlockTime = 0;
+
+  TONE_Initialize();
+
+  void (*volatile const isr)(void) = TMR6_InterruptHandler;
+  TONE_PlayDualTone(TONE_DTMF_ROW1, TONE_DTMF_COL1);
+
+  for (uint8_t i = 2; i < voiceCount; ++i) {
+    TONE_PlayVoice(i, TONE_A3 << (i - 2), TONE_WAVEFORM_TRIANGLE, 64, 0, 0);
+  }
+
+  for (uint32_t i = 0; i < SAMPLE_COUNT; i += SAMPLES_PER_MS) {
+    uint64_t const blockStart = getNanoseconds();
+    TONE_Timer1MS_Interrupt();
+    uint64_t const isrStart = getNanoseconds();
+
+    for (uint8_t j = 0; j < SAMPLES_PER_MS; ++j) {
+      isr();
+    }
+
+    isrTime += getNanoseconds() - isrStart - clockOverhead;
+    totalBlockTime += isrStart - blockStart - clockOverhead;
+  }
+
+  *blockTime = (double)totalBlockTime / SAMPLE_COUNT;
+  return (double)isrTime / SAMPLE_COUNT;
+}
+
+int main(void) {
+  HOST_Options options;
+  double blockTime;
+
+  memset(&options, 0, sizeof(options));
+  options.duration = 1000000;
+
+  HOST_Initialize(&options);
+  HOST_Peripherals_Initialize();
+
+  printf("Before: %.1f ns per sample interrupt (2 voices)\n", benchBefore());
+
+  for (uint8_t voiceCount = 2; voiceCount <= TONE_VOICE_COUNT; voiceCount += 2) {
+    double const isrTime = benchAfter(voiceCount, &blockTime);
+
+    printf(
+        "After: %.1f ns per sample interrupt, +%.1f ns per sample in the 1ms interrupt (%u voices)\n",
+        isrTime,
+        blockTime,
+        voiceCount
+        );
+  }
+
+  return 0;
+}
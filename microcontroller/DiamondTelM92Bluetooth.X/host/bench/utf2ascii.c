@@ -0,0 +1,321 @@
+/**
+ * @file
+ * @author Jeff Lau
+ *
+ * Benchmark of converting realistic contact names from UTF8 to ASCII
+ * (utf2ascii() in string.c) with each way of looking up the mapping of a
+ * multi-byte character.
+ *
+ * "Linear" and "binary search" are copies of the original conversion, which
+ * searched a short sorted list of mappings (linearly, or with bsearch() if
+ * USE_BINARY_SEARCH was defined). "Table" is the current conversion, which
+ * looks up every mapping in a two-level page table. The current mapping
+ * covers many more characters (e.g., accented letters), so only characters
+ * that the original mapping covered are checked to convert the same.
+ *
+ * Times are host CPU time (the best of RUN_COUNT runs), so they are only
+ * meaningful relative to each other. The original conversion is kept out of
+ * line, like utf2ascii() in string.c.
+ */
+
+#include "../../src/util/string.h"
+#include "../../src/telephone/handset.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define ITERATIONS (1000000UL)
+#define RUN_COUNT (9)
+
+/**
+ * Realistic contact names, as synced from a phone's phonebook.
+ */
+static char const* const NAMES[] = {
+  "Mom",
+  "Jos\xC3\xA9 Garc\xC3\xAD" "a",
+  "Dad\xE2\x80\x99s Work",
+  "M\xC3\xBCller, J\xC3\xBCrgen",
+  "Fran\xC3\xA7ois Dupont",
+  "\xE2\x80\x9C" "Big\xE2\x80\x9D Tony",
+  "Zo\xC3\xAB \xE2\x9D\xA4\xEF\xB8\x8F",
+  "\xC5\x81ukasz Nowak",
+  "S\xC3\xB8ren Kierkegaard",
+  "\xE5\xB1\xB1\xE7\x94\xB0\xE5\xA4\xAA\xE9\x83\x8E",
+  "Pizza \xF0\x9F\x8D\x95",
+  "Cr\xC3\xA8me Br\xC3\xBBl\xC3\xA9" "e Caf\xC3\xA9",
+  "\xC5\xBD" "ofia \xC4\x8C" "ern\xC3\xA1",
+  "Dr. Smith",
+  "Stra\xC3\x9F" "e Taxi",
+  "\xCE\xB1 Team \xE2\x86\x92 HQ"
+};
+
+#define NAME_COUNT (sizeof(NAMES) / sizeof(NAMES[0]))
+
+#define MAX_NAME_LENGTH (48)
+
+/*------------------------------------------------------------------------------
+ * Original UTF8 -> ASCII conversion (searches a sorted list of mappings)
+ *----------------------------------------------------------------------------*/
+
+#define DEFAULT_ASCII_CHAR ('?')
+
+typedef struct {
+  uint16_t utf8Code;
+  char asciiCode;
+} utf2ascii_entry_t;
+
+static utf2ascii_entry_t const utf2ascii_lookup[] = {
+  { 0x00A5, HANDSET_Symbol_YEN_SIGN },
+  { 0x03B1, HANDSET_Symbol_ALPHA },
+  { 0x2018, '\'' },
+  { 0x2019, '\'' },
+  { 0x201C, '"' },
+  { 0x201D, '"' },
+  { 0x2192, HANDSET_Symbol_RIGHT_ARROW },
+  { 0x21FE, HANDSET_Symbol_RIGHT_ARROW },
+  { 0x25A0, HANDSET_Symbol_RECTANGLE },
+  { 0x25A4, HANDSET_Symbol_RECTANGLE_STRIPED },
+  { 0x25AE, HANDSET_Symbol_RECTANGLE },
+  { 0x25B2, HANDSET_Symbol_LARGE_UP_ARROW },
+  { 0x25B4, HANDSET_Symbol_SMALL_UP_ARROW },
+  { 0x25B5, HANDSET_Symbol_SMALL_UP_ARROW_OUTLINE },
+  { 0x25BC, HANDSET_Symbol_LARGE_DOWN_ARROW },
+  { 0x25BE, HANDSET_Symbol_SMALL_DOWN_ARROW },
+  { 0x25BF, HANDSET_Symbol_SMALL_DOWN_ARROW_OUTLINE },
+};
+
+#define UTF2ASCII_LOOKUP_LENGTH (sizeof(utf2ascii_lookup) / sizeof(utf2ascii_entry_t))
+
+static int utf2ascii_compare(void const* key, void const* entry) {
+  if (*(uint16_t const*)key < ((utf2ascii_entry_t const*)entry)->utf8Code) {
+    return -1;
+  } else if (*(uint16_t const*)key > ((utf2ascii_entry_t const*)entry)->utf8Code) {
+    return 1;
+  } else {
+    return 0;
+  }
+}
+
+__attribute__((noinline)) static char* originalUtf2ascii(char* str, bool useBinarySearch) {
+  typedef enum UTFState {
+    UTF_StartByte,
+    UTF_OneMore,
+    UTF_TwoMore,
+    UTF_ThreeMore,
+    UTF_Done
+  } UTFState;
+
+  UTFState utfState = UTF_StartByte;
+  char *dest = str;
+  char *src = str;
+  bool is4ByteChar = false;
+  uint16_t utf8Code = 0;
+
+  while (utfState != UTF_Done) {
+    switch(utfState) {
+      case UTF_StartByte:
+        if ((*src & 0b10000000) == 0) {
+          *dest++ = *src;
+
+          if (!*src) {
+            utfState = UTF_Done;
+          } else {
+            ++src;
+          }
+        } else if ((*src & 0b11100000) == 0b11000000) {
+          is4ByteChar = false;
+          utf8Code = (uint16_t)(*src & 0b00011111) << 6;
+          ++src;
+          utfState = UTF_OneMore;
+        } else if ((*src & 0b11110000) == 0b11100000) {
+          is4ByteChar = false;
+          utf8Code = (uint16_t)(*src & 0b00001111) << 12;
+          ++src;
+          utfState = UTF_TwoMore;
+        } else if ((*src & 0b11111000) == 0b11110000) {
+          is4ByteChar = true;
+          ++src;
+          utfState = UTF_ThreeMore;
+        } else {
+          *dest++ = DEFAULT_ASCII_CHAR;
+          ++src;
+          utfState = UTF_StartByte;
+        }
+        break;
+
+      case UTF_ThreeMore:
+        if ((*src & 0b11000000) == 0b10000000) {
+          utf8Code |= (uint16_t)(*src & 0b00111111) << 12;
+          ++src;
+          utfState = UTF_TwoMore;
+        } else {
+          *dest++ = DEFAULT_ASCII_CHAR;
+          utfState = UTF_StartByte;
+        }
+        break;
+
+      case UTF_TwoMore:
+        if ((*src & 0b11000000) == 0b10000000) {
+          utf8Code |= (uint16_t)(*src & 0b00111111) << 6;
+          ++src;
+          utfState = UTF_OneMore;
+        } else {
+          *dest++ = DEFAULT_ASCII_CHAR;
+          utfState = UTF_StartByte;
+        }
+        break;
+
+      case UTF_OneMore:
+        if ((*src & 0b11000000) == 0b10000000) {
+          utf8Code |= *src & 0b00111111;
+          ++src;
+
+          if (is4ByteChar) {
+            *dest++ = DEFAULT_ASCII_CHAR;
+          } else {
+            char c = DEFAULT_ASCII_CHAR;
+
+            if (useBinarySearch) {
+              utf2ascii_entry_t const* utf2ascii_entry = bsearch(
+                &utf8Code,
+                utf2ascii_lookup,
+                UTF2ASCII_LOOKUP_LENGTH,
+                sizeof(utf2ascii_entry_t),
+                &utf2ascii_compare
+              );
+
+              if (utf2ascii_entry) {
+                c = utf2ascii_entry->asciiCode;
+              }
+            } else {
+              utf2ascii_entry_t const* utf2ascii_entry = utf2ascii_lookup;
+
+              for (uint8_t i = 0; i < UTF2ASCII_LOOKUP_LENGTH; ++i) {
+                if (utf2ascii_entry->utf8Code < utf8Code) {
+                  ++utf2ascii_entry;
+                  continue;
+                }
+
+                if (utf2ascii_entry->utf8Code == utf8Code) {
+                  c = utf2ascii_entry->asciiCode;
+                }
+
+                break;
+              }
+            }
+
+            *dest++ = c;
+          }
+        } else {
+          *dest++ = DEFAULT_ASCII_CHAR;
+        }
+        utfState = UTF_StartByte;
+        break;
+    }
+  }
+
+  return str;
+}
+
+/*----------------------------------------------------------------------------*/
+
+static char* convertLinear(char* str) {
+  return originalUtf2ascii(str, false);
+}
+
+static char* convertBinarySearch(char* str) {
+  return originalUtf2ascii(str, true);
+}
+
+static char* (*const CONVERSIONS[])(char*) = {
+  convertLinear,
+  convertBinarySearch,
+  utf2ascii
+};
+
+static char const* const CONVERSION_NAMES[] = {
+  "Linear:",
+  "Binary search:",
+  "Table:"
+};
+
+#define CONVERSION_COUNT (sizeof(CONVERSIONS) / sizeof(CONVERSIONS[0]))
+
+static struct {
+  char converted[CONVERSION_COUNT][NAME_COUNT][MAX_NAME_LENGTH];
+  uint64_t bestTimes[CONVERSION_COUNT];
+} bench;
+
+static uint64_t getNanoseconds(void) {
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return (uint64_t)now.tv_sec * 1000000000ULL + (uint64_t)now.tv_nsec;
+}
+
+/**
+ * @return The time to convert ITERATIONS names (ns).
+ */
+static uint64_t benchConversion(char* (*volatile const convert)(char*), char converted[NAME_COUNT][MAX_NAME_LENGTH]) {
+  uint64_t const start = getNanoseconds();
+
+  for (uint32_t i = 0; i < ITERATIONS; ++i) {
+    uint8_t const index = (uint8_t)(i % NAME_COUNT);
+    strcpy(converted[index], NAMES[index]);
+    convert(converted[index]);
+  }
+
+  return getNanoseconds() - start;
+}
+
+/**
+ * Checks that the table converts every character that the original mapping
+ * covered the same, and that both searches convert everything the same.
+ */
+static void checkConversions(void) {
+  for (uint8_t i = 0; i < NAME_COUNT; ++i) {
+    char const* const linear = bench.converted[0][i];
+    char const* const binarySearch = bench.converted[1][i];
+    char const* const table = bench.converted[2][i];
+
+    if (strcmp(linear, binarySearch) || (strlen(linear) != strlen(table))) {
+      fprintf(stderr, "FAIL: \"%s\" converted differently\n", NAMES[i]);
+      exit(1);
+    }
+
+    for (uint8_t j = 0; linear[j]; ++j) {
+      if ((linear[j] != DEFAULT_ASCII_CHAR) && (linear[j] != table[j])) {
+        fprintf(stderr, "FAIL: \"%s\" char %u converted differently\n", NAMES[i], j);
+        exit(1);
+      }
+    }
+  }
+}
+
+int main(void) {
+  for (uint8_t i = 0; i < CONVERSION_COUNT; ++i) {
+    bench.bestTimes[i] = UINT64_MAX;
+  }
+
+  // Runs alternate between the conversions, so that all are equally affected
+  // by anything else that is running on the host
+  for (uint8_t run = 0; run < RUN_COUNT; ++run) {
+    for (uint8_t i = 0; i < CONVERSION_COUNT; ++i) {
+      uint64_t const time = benchConversion(CONVERSIONS[i], bench.converted[i]);
+
+      if (time < bench.bestTimes[i]) {
+        bench.bestTimes[i] = time;
+      }
+    }
+  }
+
+  checkConversions();
+
+  printf("%u contact names:\n", (unsigned int)NAME_COUNT);
+
+  for (uint8_t i = 0; i < CONVERSION_COUNT; ++i) {
+    printf("%-15s %6.1f ns per name\n", CONVERSION_NAMES[i], (double)bench.bestTimes[i] / ITERATIONS);
+  }
+
+  return 0;
+}
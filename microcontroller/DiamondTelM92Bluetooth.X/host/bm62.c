@@ -0,0 +1,207 @@
+/**
+ * @file
+ * @author Jeff Lau
+ *
+ * Simulated BM62 Bluetooth Module (see bm62.h).
+ */
+
+#include "bm62.h"
+#include "sim.h"
+#include "../src/bluetooth/bt_command_send.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define MAX_FRAME_SIZE (256)
+
+// Event IDs (see bt_command_decode.c)
+#define EVENT_ACK (0x00)
+#define EVENT_DEVICE_STATE (0x01)
+#define EVENT_REPORT_LINKED_DEVICE_INFO (0x17)
+#define EVENT_VENDOR_AT_CMD_RSP (0x1C)
+#define EVENT_UNKNOW_AT_RESULT (0x1D)
+
+// DEVICE_STATE states
+#define STATE_BT_ON (0x02)
+#define STATE_HFP_CONNECTED (0x05)
+#define STATE_ACL_CONNECTED (0x15)
+
+static struct {
+  BM62_Options options;
+  uint8_t frame[MAX_FRAME_SIZE];
+  uint16_t frameSize;
+  bool isConnected;
+  uint32_t commandCounts[256];
+} module;
+
+static void handleLinkBack(void) {
+  uint8_t const aclConnected[] = { EVENT_DEVICE_STATE, STATE_ACL_CONNECTED, 0x00 };
+  uint8_t const hfpConnected[] = { EVENT_DEVICE_STATE, STATE_HFP_CONNECTED, 0x00 };
+
+  if (!module.options.linkBackDelay || module.isConnected) {
+    return;
+  }
+
+  BM62_SendEvent(module.options.linkBackDelay, aclConnected, sizeof(aclConnected));
+  BM62_SendEvent(0, hfpConnected, sizeof(hfpConnected));
+  module.isConnected = true;
+}
+
+static void handleReadLinkedDeviceInfo(uint8_t const* command) {
+  uint8_t event[MAX_FRAME_SIZE] = { EVENT_REPORT_LINKED_DEVICE_INFO, command[1], 0x00 };
+  uint8_t const nameLength = (uint8_t)strlen(module.options.phoneName);
+
+  // Name (including its null terminator)
+  memcpy(&event[3], module.options.phoneName, nameLength + 1);
+  BM62_SendEvent(module.options.ackDelay, event, nameLength + 4);
+}
+
+/**
+ * Default handling of an AT command.
+ */
+static void handleAtCommand(char const* command) {
+  char result[128];
+  unsigned int first;
+  unsigned int last;
+
+  if (!strcmp(command, "+CPBR=?")) {
+    if (!module.options.phonebookCount) {
+      BM62_SendAtResponse(BM62_AtResponse_ERROR);
+      return;
+    }
+
+    snprintf(result, sizeof(result), "+CPBR: (1-%u),32,32", module.options.phonebookCount);
+    BM62_SendAtResult(result);
+  } else if (sscanf(command, "+CPBR=%u,%u", &first, &last) == 2) {
+    for (unsigned int index = first; (index <= last) && (index <= module.options.phonebookCount); ++index) {
+      char number[32];
+      char name[32];
+
+      module.options.getPhonebookEntry(index, number, name);
+      snprintf(result, sizeof(result), "+CPBR: %u,\"%s\",129,\"%s\"", index, number, name);
+      BM62_SendAtResult(result);
+    }
+  }
+
+  BM62_SendAtResponse(BM62_AtResponse_OK);
+}
+
+static void handleCommand(void) {
+  uint8_t const* const command = &module.frame[3];
+  uint8_t const length = module.frame[2];
+  uint8_t checksum = 0;
+
+  for (uint16_t i = 2; i < module.frameSize; ++i) {
+    checksum += module.frame[i];
+  }
+
+  if (checksum) {
+    fprintf(stderr, "[BM62] Command checksum error\n");
+    exit(1);
+  }
+
+  ++module.commandCounts[command[0]];
+
+  if (command[0] == MCU_SEND_EVENT_ACK) {
+    if (module.options.commandHandler) {
+      module.options.commandHandler(command, length);
+    }
+
+    return;
+  }
+
+  uint8_t const ackStatus = module.options.commandHandler ? module.options.commandHandler(command, length) : 0;
+
+  if (ackStatus == BM62_NO_ACK) {
+    return;
+  }
+
+  uint8_t const ack[] = { EVENT_ACK, command[0], ackStatus };
+  BM62_SendEvent(module.options.ackDelay, ack, sizeof(ack));
+
+  if (ackStatus) {
+    return;
+  }
+
+  switch (command[0]) {
+    case PROFILE_LINK_BACK:
+      handleLinkBack();
+      break;
+
+    case READ_LINKED_DEVICE_INFOR:
+      handleReadLinkedDeviceInfo(command);
+      break;
+
+    case VENDOR_AT_CMD: {
+      char atCommand[MAX_FRAME_SIZE];
+      memcpy(atCommand, &command[2], length - 2);
+      atCommand[length - 2] = 0;
+
+      if (!module.options.atCommandHandler || !module.options.atCommandHandler(atCommand)) {
+        handleAtCommand(atCommand);
+      }
+      break;
+    }
+  }
+}
+
+static void handleUart2Transmit(uint8_t data) {
+  if (((module.frameSize == 0) && (data != 0xAA)) || ((module.frameSize == 1) && (data != 0x00))) {
+    fprintf(stderr, "[BM62] Command header error\n");
+    exit(1);
+  }
+
+  module.frame[module.frameSize++] = data;
+
+  if ((module.frameSize > 3) && (module.frameSize == module.frame[2] + 4)) {
+    handleCommand();
+    module.frameSize = 0;
+  }
+}
+
+void BM62_Initialize(BM62_Options const* options) {
+  uint8_t const powerOn[] = { EVENT_DEVICE_STATE, STATE_BT_ON };
+
+  memset(&module, 0, sizeof(module));
+  module.options = *options;
+  HOST_SetUartTransmitHandler(2, handleUart2Transmit);
+  BM62_SendEvent(options->powerOnTime - (uint32_t)HOST_GetTime(), powerOn, sizeof(powerOn));
+}
+
+void BM62_SendEvent(uint32_t delay, uint8_t const* event, uint8_t length) {
+  uint8_t frame[MAX_FRAME_SIZE + 4];
+  uint8_t checksum = length;
+
+  frame[0] = 0xAA;
+  frame[1] = 0x00;
+  frame[2] = length;
+
+  for (uint8_t i = 0; i < length; ++i) {
+    frame[3 + i] = event[i];
+    checksum += event[i];
+  }
+
+  frame[3 + length] = (uint8_t)-checksum;
+  HOST_UartReceiveAfter(2, delay, frame, length + 4);
+}
+
+void BM62_SendAtResult(char const* result) {
+  uint8_t event[MAX_FRAME_SIZE] = { EVENT_UNKNOW_AT_RESULT, 0x00 };
+  uint8_t const resultLength = (uint8_t)strlen(result);
+
+  memcpy(&event[2], result, resultLength);
+  BM62_SendEvent(module.options.atResponseDelay, event, resultLength + 2);
+}
+
+void BM62_SendAtResponse(BM62_AtResponse response) {
+  uint8_t const event[] = { EVENT_VENDOR_AT_CMD_RSP, 0x00, (uint8_t)response };
+  BM62_SendEvent(module.options.atResponseDelay, event, sizeof(event));
+}
+
+bool BM62_IsConnected(void) {
+  return module.isConnected;
+}
+
+uint32_t BM62_GetCommandCount(uint8_t commandId) {
+  return module.commandCounts[commandId];
+}
@@ -0,0 +1,145 @@
+/**
+ * @file
+ * @author Jeff Lau
+ *
+ * Simulated BM62 Bluetooth Module (and the phone connected to it) on UART2,
+ * for tests and benchmarks of the host build.
+ *
+ * Decodes the commands sent by the firmware, ACKs each of them (except
+ * MCU_SEND_EVENT_ACK) after a fixed delay, and responds to a few commands
+ * like the real module:
+ * - Reports the power-on state (DEVICE_STATE: BT_ON) at a configured time.
+ * - PROFILE_LINK_BACK: Reports ACL and HFP connected after a configured
+ *   delay.
+ * - READ_LINKED_DEVICE_INFOR: Reports the phone's name.
+ * - VENDOR_AT_CMD: Passes the AT command to a handler, which responds with
+ *   BM62_SendAtResult()/BM62_SendAtResponse(). By default, "+CPBR=?" and
+ *   "+CPBR=<first>,<last>" are answered from a simulated phonebook, and every
+ *   other AT command is answered with OK.
+ *
+ * Everything sent by the module is queued in order, so a response never
+ * overtakes an earlier one.
+ */
+
+#ifndef BM62_H
+#define	BM62_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef	__cplusplus
+extern "C" {
+#endif
+
+/**
+ * Value returned by BM62_Options.commandHandler to not ACK a command.
+ */
+#define BM62_NO_ACK (0xFF)
+
+/**
+ * VENDOR_AT_CMD_RSP status values.
+ */
+typedef enum BM62_AtResponse {
+  BM62_AtResponse_OK = 0,
+  BM62_AtResponse_ERROR = 1,
+  BM62_AtResponse_NO_RESPONSE = 2
+} BM62_AtResponse;
+
+/**
+ * Options of the simulated module.
+ */
+typedef struct BM62_Options {
+  /**
+   * Simulated time that the module reports being powered on (us).
+   */
+  uint32_t powerOnTime;
+  /**
+   * Delay from receiving a command to sending its ACK (us).
+   */
+  uint32_t ackDelay;
+  /**
+   * Delay from receiving PROFILE_LINK_BACK to reporting that the phone is
+   * connected (us), or 0 to never connect.
+   */
+  uint32_t linkBackDelay;
+  /**
+   * Delay from receiving an AT command to responding to it (us).
+   */
+  uint32_t atResponseDelay;
+  /**
+   * Name of the connected phone.
+   */
+  char const* phoneName;
+  /**
+   * Number of entries in the phone's phonebook.
+   */
+  uint16_t phonebookCount;
+  /**
+   * Gets a phonebook entry (NULL if phonebookCount is 0).
+   *
+   * @param index - 1 to phonebookCount.
+   * @param number - Destination buffer of at least 32 chars.
+   * @param name - Destination buffer of at least 32 chars.
+   */
+  void (*getPhonebookEntry)(uint16_t index, char* number, char* name);
+  /**
+   * Called for each command received from the firmware (NULL if not needed).
+   *
+   * @param command - The command ID, followed by the parameters.
+   * @param length - Length of the command.
+   * @return The ACK status (0 for OK), or BM62_NO_ACK to not ACK the command.
+   *         Ignored for MCU_SEND_EVENT_ACK, which is never ACKed.
+   */
+  uint8_t (*commandHandler)(uint8_t const* command, uint8_t length);
+  /**
+   * Handles an AT command (NULL for the default handling).
+   *
+   * @param command - The AT command (without "AT").
+   * @return False for the default handling of the AT command.
+   */
+  bool (*atCommandHandler)(char const* command);
+} BM62_Options;
+
+/**
+ * Connects the simulated module to UART2.
+ *
+ * Must be called after HOST_Peripherals_Initialize().
+ */
+void BM62_Initialize(BM62_Options const* options);
+
+/**
+ * Sends an event to the firmware, after any events that are already queued.
+ *
+ * @param delay - Min delay from now (us).
+ * @param event - The event ID, followed by the parameters.
+ * @param length - Length of the event.
+ */
+void BM62_SendEvent(uint32_t delay, uint8_t const* event, uint8_t length);
+
+/**
+ * Sends a result line of the current AT command (UNKNOW_AT_RESULT).
+ */
+void BM62_SendAtResult(char const* result);
+
+/**
+ * Ends the current AT command (VENDOR_AT_CMD_RSP).
+ */
+void BM62_SendAtResponse(BM62_AtResponse response);
+
+/**
+ * Tests if the phone is connected (HFP connected was reported).
+ */
+bool BM62_IsConnected(void);
+
+/**
+ * Gets the number of commands received from the firmware.
+ *
+ * @param commandId - A command ID.
+ */
+uint32_t BM62_GetCommandCount(uint8_t commandId);
+
+#ifdef	__cplusplus
+}
+#endif
+
+#endif	/* BM62_H */
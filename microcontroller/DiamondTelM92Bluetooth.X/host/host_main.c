@@ -0,0 +1,52 @@
+/**
+ * @file
+ * @author Jeff Lau
+ *
+ * Entry point of the host build.
+ *
+ * Runs the unmodified firmware main() (compiled as FIRMWARE_main()) against
+ * the simulated peripherals for a fixed amount of simulated time, then prints
+ * a report (see sim.c).
+ *
+ * Usage: diamondtel_host [seconds] [main loop pass time in us]
+ */
+
+#include "sim.h"
+#include <stdio.h>
+#include <stdlib.h>
+
+/**
+ * Default amount of simulated time (seconds).
+ */
+#define DEFAULT_DURATION_SECONDS (60)
+
+/**
+ * Default simulated execution time of each pass of the main loop (us).
+ */
+#define DEFAULT_MAIN_LOOP_PASS_TIME (50)
+
+void FIRMWARE_main(void);
+
+int main(int argc, char** argv) {
+  HOST_Options options;
+
+  options.duration = (uint64_t)((argc > 1) ? strtoul(argv[1], NULL, 10) : DEFAULT_DURATION_SECONDS) * 1000000;
+  options.mainLoopPassTime = (argc > 2) ? (uint32_t)strtoul(argv[2], NULL, 10) : DEFAULT_MAIN_LOOP_PASS_TIME;
+  options.isFirmwareOutputEnabled = true;
+  options.isReportEnabled = true;
+  options.mainLoopPassHandler = NULL;
+  options.endHandler = NULL;
+
+  if (!options.duration || !options.mainLoopPassTime) {
+    fprintf(stderr, "Usage: %s [seconds] [main loop pass time in us]\n", argv[0]);
+    return 1;
+  }
+
+  HOST_Initialize(&options);
+  HOST_Peripherals_Initialize();
+
+  // Only returns by ending the simulation
+  FIRMWARE_main();
+
+  return 1;
+}
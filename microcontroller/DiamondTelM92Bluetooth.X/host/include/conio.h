@@ -0,0 +1,16 @@
+/**
+ * @file
+ * @author Jeff Lau
+ *
+ * Host build stand-in for the XC8 console I/O header.
+ *
+ * STDIO is not redirected on the host; it goes to the host's standard output
+ * instead of UART1.
+ */
+
+#ifndef CONIO_H
+#define	CONIO_H
+
+#include <stdio.h>
+
+#endif	/* CONIO_H */
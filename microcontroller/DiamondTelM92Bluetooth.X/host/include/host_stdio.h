@@ -0,0 +1,31 @@
+/**
+ * @file
+ * @author Jeff Lau
+ *
+ * Included ahead of every firmware source file in the host build (see
+ * -include in the Makefile).
+ *
+ * Routes the firmware's printf() (its debug output, which goes to UART1 on
+ * the hardware) through HOST_FirmwarePrintf(), so that the simulation can
+ * suppress it (see HOST_Options.isFirmwareOutputEnabled). <stdio.h> is
+ * included first, so that its own declarations are not renamed.
+ */
+
+#ifndef HOST_STDIO_H
+#define	HOST_STDIO_H
+
+#include <stdio.h>
+
+#ifdef	__cplusplus
+extern "C" {
+#endif
+
+int HOST_FirmwarePrintf(char const* format, ...);
+
+#define printf HOST_FirmwarePrintf
+
+#ifdef	__cplusplus
+}
+#endif
+
+#endif	/* HOST_STDIO_H */
@@ -0,0 +1,220 @@
+/**
+ * @file
+ * @author Jeff Lau
+ *
+ * Host build stand-in for the XC8 device header of the PIC18F27Q43.
+ *
+ * Only the special function registers (SFRs) that are used by the project's
+ * code (including the generated pin manager macros) are declared. Most of
+ * them are plain variables, but some are declared as accessor expressions so
+ * that the simulation (see sim.c) can react to them:
+ * - NVM registers: An operation started by setting NVMCON0bits.GO is
+ *   performed on the next access of any NVM register, and NVMCON0bits.GO
+ *   reads as 1 until the simulated duration of the operation has elapsed.
+ * - TMR1H/TMR1L: Count simulated microseconds while T1CONbits.ON is set.
+ * - DMA1 (through DMASELECT/DMAn*): Only the configuration used to send BT
+ *   commands to UART2 is simulated (see peripherals.c). DMAnSSA holds a full
+ *   host pointer, so it is wider than on the hardware.
+ *
+ * SLEEP() advances the simulated clock to the next interrupt event, and NOP()
+ * services pending interrupts if they are enabled (see sim.h). RESET() ends
+ * the simulation early.
+ */
+
+#ifndef XC_H
+#define	XC_H
+
+#include <stdint.h>
+
+#ifdef	__cplusplus
+extern "C" {
+#endif
+
+#define HOST_SFR_PORT_BITS(name, bitPrefix) \
+  typedef struct { \
+    unsigned bitPrefix##0:1; \
+    unsigned bitPrefix##1:1; \
+    unsigned bitPrefix##2:1; \
+    unsigned bitPrefix##3:1; \
+    unsigned bitPrefix##4:1; \
+    unsigned bitPrefix##5:1; \
+    unsigned bitPrefix##6:1; \
+    unsigned bitPrefix##7:1; \
+  } name##_t; \
+  extern volatile name##_t name
+
+HOST_SFR_PORT_BITS(PORTAbits, RA);
+HOST_SFR_PORT_BITS(PORTBbits, RB);
+HOST_SFR_PORT_BITS(PORTCbits, RC);
+HOST_SFR_PORT_BITS(LATAbits, LATA);
+HOST_SFR_PORT_BITS(LATBbits, LATB);
+HOST_SFR_PORT_BITS(LATCbits, LATC);
+HOST_SFR_PORT_BITS(TRISAbits, TRISA);
+HOST_SFR_PORT_BITS(TRISBbits, TRISB);
+HOST_SFR_PORT_BITS(TRISCbits, TRISC);
+HOST_SFR_PORT_BITS(ANSELAbits, ANSELA);
+HOST_SFR_PORT_BITS(ANSELBbits, ANSELB);
+HOST_SFR_PORT_BITS(ANSELCbits, ANSELC);
+HOST_SFR_PORT_BITS(WPUAbits, WPUA);
+HOST_SFR_PORT_BITS(WPUBbits, WPUB);
+HOST_SFR_PORT_BITS(WPUCbits, WPUC);
+HOST_SFR_PORT_BITS(ODCONAbits, ODCA);
+HOST_SFR_PORT_BITS(ODCONBbits, ODCB);
+HOST_SFR_PORT_BITS(ODCONCbits, ODCC);
+
+typedef union {
+  struct {
+    unsigned INT0EDG:1;
+    unsigned INT1EDG:1;
+    unsigned INT2EDG:1;
+    unsigned :2;
+    unsigned IPEN:1;
+    unsigned GIEL:1;
+    unsigned GIEH:1;
+  };
+  struct {
+    unsigned :7;
+    unsigned GIE:1;
+  };
+} INTCON0bits_t;
+extern volatile INTCON0bits_t INTCON0bits;
+
+typedef struct {
+  unsigned :7;
+  unsigned IDLEN:1;
+} CPUDOZEbits_t;
+extern volatile CPUDOZEbits_t CPUDOZEbits;
+
+typedef struct {
+  unsigned :1;
+  unsigned DMA1SCNTIF:1;
+  unsigned :6;
+} PIR2bits_t;
+extern volatile PIR2bits_t PIR2bits;
+
+typedef struct {
+  unsigned :1;
+  unsigned DMA1SCNTIE:1;
+  unsigned :6;
+} PIE2bits_t;
+extern volatile PIE2bits_t PIE2bits;
+
+typedef struct {
+  unsigned :1;
+  unsigned DMA1SCNTIP:1;
+  unsigned :6;
+} IPR2bits_t;
+extern volatile IPR2bits_t IPR2bits;
+
+typedef struct {
+  unsigned :1;
+  unsigned TMR2IE:1;
+  unsigned :6;
+} PIE3bits_t;
+extern volatile PIE3bits_t PIE3bits;
+
+typedef struct {
+  unsigned :4;
+  unsigned U2RXIE:1;
+  unsigned U2TXIE:1;
+  unsigned :2;
+} PIE8bits_t;
+extern volatile PIE8bits_t PIE8bits;
+
+extern volatile uint8_t U2TXB;
+
+typedef struct {
+  unsigned DMA1MD:1;
+  unsigned :7;
+} PMD8bits_t;
+extern volatile PMD8bits_t PMD8bits;
+
+typedef struct {
+  unsigned PRLOCKED:1;
+  unsigned :7;
+} PRLOCKbits_t;
+extern volatile PRLOCKbits_t PRLOCKbits;
+
+extern volatile uint8_t PRLOCK;
+extern volatile uint8_t ISRPR;
+extern volatile uint8_t MAINPR;
+extern volatile uint8_t DMA1PR;
+
+extern volatile uint8_t DMASELECT;
+extern volatile uint8_t DMAnCON0;
+extern volatile uint8_t DMAnCON1;
+extern volatile uintptr_t DMAnSSA;
+extern volatile uint16_t DMAnSSZ;
+extern volatile uint16_t DMAnDSA;
+extern volatile uint16_t DMAnDSZ;
+extern volatile uint8_t DMAnSIRQ;
+extern volatile uint8_t DMAnAIRQ;
+
+typedef struct {
+  unsigned :7;
+  unsigned GO:1;
+} NVMCON0bits_t;
+
+typedef struct {
+  unsigned NVMCMD:3;
+  unsigned :5;
+} NVMCON1bits_t;
+
+volatile NVMCON0bits_t* HOST_NvmCon0(void);
+volatile NVMCON1bits_t* HOST_NvmCon1(void);
+volatile uint8_t* HOST_NvmRegister(volatile uint8_t* reg);
+extern volatile uint8_t HOST_NVMADRU;
+extern volatile uint8_t HOST_NVMADRH;
+extern volatile uint8_t HOST_NVMADRL;
+extern volatile uint8_t HOST_NVMDATL;
+extern volatile uint8_t HOST_NVMDATH;
+extern volatile uint8_t HOST_NVMLOCK;
+
+#define NVMCON0bits (*HOST_NvmCon0())
+#define NVMCON1bits (*HOST_NvmCon1())
+#define NVMADRU (*HOST_NvmRegister(&HOST_NVMADRU))
+#define NVMADRH (*HOST_NvmRegister(&HOST_NVMADRH))
+#define NVMADRL (*HOST_NvmRegister(&HOST_NVMADRL))
+#define NVMDATL (*HOST_NvmRegister(&HOST_NVMDATL))
+#define NVMDATH (*HOST_NvmRegister(&HOST_NVMDATH))
+#define NVMLOCK (*HOST_NvmRegister(&HOST_NVMLOCK))
+
+typedef union {
+  uint8_t value;
+  struct {
+    unsigned ON:1;
+    unsigned RD16:1;
+    unsigned nSYNC:1;
+    unsigned :1;
+    unsigned CKPS:2;
+    unsigned :2;
+  };
+} T1CONbits_t;
+extern volatile T1CONbits_t T1CONbits;
+
+volatile uint8_t* HOST_Tmr1Register(uint8_t isHigh);
+
+extern volatile uint8_t T1GCON;
+extern volatile uint8_t T1CLK;
+
+#define T1CON (T1CONbits.value)
+#define TMR1H (*HOST_Tmr1Register(1))
+#define TMR1L (*HOST_Tmr1Register(0))
+
+void HOST_Sleep(void);
+void HOST_ServiceInterrupts(void);
+void HOST_Reset(void);
+
+#define SLEEP() HOST_Sleep()
+#define NOP() HOST_ServiceInterrupts()
+#define Nop() ((void)0)
+#define RESET() HOST_Reset()
+
+// Interrupt vectors are called directly by the simulation
+#define __interrupt(...)
+
+#ifdef	__cplusplus
+}
+#endif
+
+#endif	/* XC_H */
@@ -0,0 +1,793 @@
+/**
+ * @file
+ * @author Jeff Lau
+ *
+ * Host build stand-in for the generated peripheral drivers
+ * (mcc_generated_files), implemented on top of the simulation (see sim.h).
+ *
+ * The generated headers are used as-is; only the driver functions that are
+ * used by the project's code are implemented here, with the same behavior
+ * (including blocking) as the generated drivers:
+ * - TMR0/TMR2/TMR4/TMR6 interrupts are simulated at the configured periods
+ *   (100ms/10ms/1ms/100us), and the timers are running after
+ *   SYSTEM_Initialize(), as configured.
+ * - UARTs transmit one byte per byte time at their baud rates, from software
+ *   write buffers of the configured sizes. Bytes queued with
+ *   HOST_UartReceive() are received by the configured receive interrupt
+ *   handlers.
+ * - DMA1 sends BT commands to UART2, with the configuration used by
+ *   bt_command_send.c (source address incremented, destination U2TXB,
+ *   triggered by the UART2 Tx interrupt flag, SIRQEN cleared when the source
+ *   count is done). One byte is moved whenever the UART2 transmitter is idle,
+ *   and the DMA1SCNT interrupt handler is called after the last byte. Like
+ *   interrupts, transfers only happen while interrupts are enabled.
+ * - DAC1 and SPI1 (volume control) only record what is written to them
+ *   (DAC1 output can also be observed with HOST_SetDacOutputHandler()).
+ */
+
+#include "sim.h"
+#include "../mcc_generated_files/mcc.h"
+#include "../src/bluetooth/bt_command_send.h"
+#include "../src/bluetooth/bt_command_decode.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if UART_TX_USE_DMA
+void UART_DMA_TransferComplete_ISR(void);
+#endif
+
+#define UART_COUNT (4)
+#define MAX_UART_TX_BUFFER_SIZE (128)
+#define MAX_UART_RX_BUFFER_SIZE (32)
+#define UART_RX_QUEUE_SIZE (4096)
+
+#define DMA_CON0_EN (0x80)
+#define DMA_CON0_SIRQEN (0x40)
+/**
+ * DMAnCON1: SMODE incremented; SSTP (SIRQEN cleared when the source count is
+ * done).
+ */
+#define DMA_CON1_SUPPORTED (0x03)
+#define DMA_SIRQ_U2TX (0x45)
+
+typedef struct {
+  HOST_Event event;
+  uint32_t period;
+  uint8_t periodCounts;
+  bool isRunning;
+  /**
+   * Timer count while stopped.
+   */
+  uint8_t stoppedCount;
+  void (**handler)(void);
+  uint64_t runningSince;
+  uint64_t runningTime;
+} hostTimer_t;
+
+typedef struct {
+  HOST_Event txEvent;
+  HOST_Event rxEvent;
+  uint32_t byteTime;
+  /**
+   * Transmit interrupt enable, except for UART2 (see PIE8bits.U2TXIE).
+   */
+  bool isTxInterruptEnabled;
+  uint8_t txBufferSize;
+  uint8_t txBuffer[MAX_UART_TX_BUFFER_SIZE];
+  uint8_t txTail;
+  uint8_t txCount;
+  volatile uint8_t* txBufferRemaining;
+  uint8_t rxBufferSize;
+  uint8_t rxBuffer[MAX_UART_RX_BUFFER_SIZE];
+  uint8_t rxTail;
+  volatile uint8_t* rxCount;
+  void (**rxHandler)(void);
+  /**
+   * The byte received by the current receive interrupt.
+   */
+  uint8_t rxByte;
+  uint8_t rxQueue[UART_RX_QUEUE_SIZE];
+  /**
+   * Earliest time that each queued byte is received (0 if right after the
+   * previous byte).
+   */
+  uint64_t rxQueueTime[UART_RX_QUEUE_SIZE];
+  uint16_t rxQueueStart;
+  uint16_t rxQueueCount;
+  void (*txHandler)(uint8_t data);
+  uint32_t txBytes;
+  uint32_t rxBytes;
+  uint32_t rxOverruns;
+} hostUart_t;
+
+volatile uint8_t uart1TxBufferRemaining;
+volatile uint8_t uart1RxCount;
+volatile uint8_t uart2TxBufferRemaining;
+volatile uint8_t uart2RxCount;
+volatile uint8_t uart3TxBufferRemaining;
+volatile uint8_t uart3RxCount;
+volatile uint8_t uart4TxBufferRemaining;
+volatile uint8_t uart4RxCount;
+
+void (*TMR0_InterruptHandler)(void);
+void (*TMR2_InterruptHandler)(void);
+void (*TMR4_InterruptHandler)(void);
+void (*TMR6_InterruptHandler)(void);
+void (*IOCAF3_InterruptHandler)(void);
+void (*IOCBF5_InterruptHandler)(void);
+
+static hostTimer_t tmr0;
+static hostTimer_t tmr2;
+static hostTimer_t tmr4;
+static hostTimer_t tmr6;
+static hostUart_t uarts[UART_COUNT];
+
+static struct {
+  uint8_t const* dmaSourcePointer;
+  uint16_t dmaSourceCount;
+  uint32_t dmaBytes;
+  uint32_t dmaTransfers;
+  uint8_t dacOutput;
+  uint32_t dacWrites;
+  void (*dacOutputHandler)(uint8_t value);
+  uint32_t spiBytes;
+} module;
+
+static void handleTimerEvent(hostTimer_t* timer) {
+  uint64_t const now = HOST_GetTime();
+
+  // Missed periods are handled only once
+  do {
+    timer->event.time += timer->period;
+  } while (timer->event.time <= now);
+
+  if (*timer->handler) {
+    (*timer->handler)();
+  }
+}
+
+static void handleTmr0Event(void) {
+  handleTimerEvent(&tmr0);
+}
+
+static void handleTmr2Event(void) {
+  handleTimerEvent(&tmr2);
+}
+
+static void handleTmr4Event(void) {
+  handleTimerEvent(&tmr4);
+}
+
+static void handleTmr6Event(void) {
+  handleTimerEvent(&tmr6);
+}
+
+static bool isTmr2InterruptEnabled(void) {
+  return PIE3bits.TMR2IE;
+}
+
+static void initializeTimer(hostTimer_t* timer, char const* name, uint32_t period, uint8_t periodCounts, void (**handler)(void)) {
+  memset(timer, 0, sizeof(*timer));
+  timer->event.name = name;
+  timer->event.time = HOST_NEVER;
+  timer->period = period;
+  timer->periodCounts = periodCounts;
+  timer->handler = handler;
+}
+
+static uint8_t readTimer(hostTimer_t const* timer) {
+  if (!timer->isRunning) {
+    return timer->stoppedCount;
+  }
+
+  uint64_t const elapsed = timer->period - (timer->event.time - HOST_GetTime());
+  uint64_t const count = (elapsed * timer->periodCounts) / timer->period;
+
+  return (uint8_t)((count < timer->periodCounts) ? count : (timer->periodCounts - 1));
+}
+
+static void startTimer(hostTimer_t* timer) {
+  if (timer->isRunning) {
+    return;
+  }
+
+  timer->isRunning = true;
+  timer->runningSince = HOST_GetTime();
+  timer->event.time = HOST_GetTime() +
+      ((uint64_t)(timer->periodCounts - timer->stoppedCount) * timer->period) / timer->periodCounts;
+}
+
+static void stopTimer(hostTimer_t* timer) {
+  if (!timer->isRunning) {
+    return;
+  }
+
+  timer->stoppedCount = readTimer(timer);
+  timer->isRunning = false;
+  timer->runningTime += HOST_GetTime() - timer->runningSince;
+  timer->event.time = HOST_NEVER;
+}
+
+static void writeTimer(hostTimer_t* timer, uint8_t count) {
+  if (timer->isRunning) {
+    stopTimer(timer);
+    timer->stoppedCount = count;
+    startTimer(timer);
+  } else {
+    timer->stoppedCount = count;
+  }
+}
+
+static bool isUartTxInterruptEnabled(hostUart_t const* uart) {
+  return (uart == &uarts[1]) ? PIE8bits.U2TXIE : uart->isTxInterruptEnabled;
+}
+
+static void setUartTxInterruptEnabled(hostUart_t* uart, bool isEnabled) {
+  if (uart == &uarts[1]) {
+    PIE8bits.U2TXIE = isEnabled;
+  } else {
+    uart->isTxInterruptEnabled = isEnabled;
+  }
+}
+
+static void shiftOutUartByte(hostUart_t* uart, uint8_t data) {
+  uart->txEvent.time = HOST_GetTime() + uart->byteTime;
+  ++uart->txBytes;
+
+  if (uart->txHandler) {
+    uart->txHandler(data);
+  }
+}
+
+static bool isDma1TriggeredByUart2Tx(void) {
+  return !PMD8bits.DMA1MD &&
+      PRLOCKbits.PRLOCKED &&
+      (DMASELECT == 0) &&
+      (DMAnCON0 & DMA_CON0_EN) &&
+      (DMAnCON0 & DMA_CON0_SIRQEN) &&
+      (DMAnSIRQ == DMA_SIRQ_U2TX);
+}
+
+/**
+ * Moves the next byte from DMA1's source to U2TXB.
+ */
+static void transferDma1Byte(hostUart_t* uart) {
+  if (!module.dmaSourceCount) {
+    // Start of a new transfer (source pointer/count reloaded)
+    if ((DMAnCON1 != DMA_CON1_SUPPORTED) || (DMAnDSA != (uint16_t)(uintptr_t)&U2TXB) || (DMAnDSZ != 1) || !DMAnSSZ) {
+      fprintf(stderr, "[HOST] Unsupported DMA1 configuration\n");
+      exit(1);
+    }
+
+    module.dmaSourcePointer = (uint8_t const*)DMAnSSA;
+    module.dmaSourceCount = DMAnSSZ;
+    ++module.dmaTransfers;
+  }
+
+  U2TXB = *module.dmaSourcePointer++;
+  shiftOutUartByte(uart, U2TXB);
+  ++module.dmaBytes;
+
+  if (!--module.dmaSourceCount) {
+    DMAnCON0 &= (uint8_t)~DMA_CON0_SIRQEN;
+    PIR2bits.DMA1SCNTIF = 1;
+
+#if UART_TX_USE_DMA
+    if (PIE2bits.DMA1SCNTIE) {
+      UART_DMA_TransferComplete_ISR();
+    }
+#endif
+  }
+}
+
+/**
+ * Implements the generated UARTn_Transmit_ISR() functions (including the
+ * customization of UART2_Transmit_ISR()).
+ */
+static void handleUartTxEvent(hostUart_t* uart) {
+  if ((uart == &uarts[1]) && isDma1TriggeredByUart2Tx()) {
+    transferDma1Byte(uart);
+    return;
+  }
+
+  if (uart->txCount) {
+    shiftOutUartByte(uart, uart->txBuffer[uart->txTail]);
+    uart->txTail = (uart->txTail + 1) % uart->txBufferSize;
+    --uart->txCount;
+    ++*uart->txBufferRemaining;
+  } else {
+    setUartTxInterruptEnabled(uart, false);
+  }
+
+#if !UART_TX_USE_DMA
+  if (uart == &uarts[1]) {
+    UART_TransferNextByte();
+  }
+#endif
+}
+
+static void handleUartRxEvent(hostUart_t* uart) {
+  uart->rxByte = uart->rxQueue[uart->rxQueueStart];
+  uart->rxQueueStart = (uart->rxQueueStart + 1) % UART_RX_QUEUE_SIZE;
+  --uart->rxQueueCount;
+
+  if (uart->rxQueueCount) {
+    uart->rxEvent.time += uart->byteTime;
+
+    if (uart->rxEvent.time < uart->rxQueueTime[uart->rxQueueStart]) {
+      uart->rxEvent.time = uart->rxQueueTime[uart->rxQueueStart];
+    }
+  } else {
+    uart->rxEvent.time = HOST_NEVER;
+  }
+
+  ++uart->rxBytes;
+
+  if (*uart->rxHandler) {
+    (*uart->rxHandler)();
+  }
+}
+
+static void handleUart1TxEvent(void) {
+  handleUartTxEvent(&uarts[0]);
+}
+
+static void handleUart2TxEvent(void) {
+  handleUartTxEvent(&uarts[1]);
+}
+
+static void handleUart3TxEvent(void) {
+  if (UART3_TxInterruptHandler) {
+    UART3_TxInterruptHandler();
+  }
+}
+
+static void handleUart4TxEvent(void) {
+  if (UART4_TxInterruptHandler) {
+    UART4_TxInterruptHandler();
+  }
+}
+
+static bool isUart1TxInterruptEnabled(void) {
+  return isUartTxInterruptEnabled(&uarts[0]);
+}
+
+static bool isUart2TxInterruptEnabled(void) {
+  return isUartTxInterruptEnabled(&uarts[1]) || isDma1TriggeredByUart2Tx();
+}
+
+static bool isUart3TxInterruptEnabled(void) {
+  return isUartTxInterruptEnabled(&uarts[2]);
+}
+
+static bool isUart4TxInterruptEnabled(void) {
+  return isUartTxInterruptEnabled(&uarts[3]);
+}
+
+static void handleUart1RxEvent(void) {
+  handleUartRxEvent(&uarts[0]);
+}
+
+static void handleUart2RxEvent(void) {
+  handleUartRxEvent(&uarts[1]);
+}
+
+static void handleUart3RxEvent(void) {
+  handleUartRxEvent(&uarts[2]);
+}
+
+static void handleUart4RxEvent(void) {
+  handleUartRxEvent(&uarts[3]);
+}
+
+static bool isUart2RxInterruptEnabled(void) {
+  return PIE8bits.U2RXIE;
+}
+
+static void initializeUart(
+    hostUart_t* uart,
+    char const* txName,
+    char const* rxName,
+    uint32_t baudRate,
+    uint8_t txBufferSize,
+    volatile uint8_t* txBufferRemaining,
+    uint8_t rxBufferSize,
+    volatile uint8_t* rxCount,
+    void (**rxHandler)(void)
+    ) {
+  memset(uart, 0, sizeof(*uart));
+  uart->txEvent.name = txName;
+  // The transmitter is idle since the start of the simulation
+  uart->txEvent.time = 0;
+  uart->rxEvent.name = rxName;
+  uart->rxEvent.time = HOST_NEVER;
+  // Start bit + 8 data bits + stop bit
+  uart->byteTime = (10 * 1000000UL + baudRate - 1) / baudRate;
+  uart->txBufferSize = txBufferSize;
+  uart->txBufferRemaining = txBufferRemaining;
+  uart->rxBufferSize = rxBufferSize;
+  uart->rxCount = rxCount;
+  uart->rxHandler = rxHandler;
+}
+
+static void uartWrite(hostUart_t* uart, uint8_t data, bool isImmediate) {
+  while (!*uart->txBufferRemaining) {
+    HOST_WaitForInterrupt("UART write buffer is full");
+  }
+
+  if (!isUartTxInterruptEnabled(uart) && (HOST_GetTime() >= uart->txEvent.time)) {
+    // Transmitter is idle
+    shiftOutUartByte(uart, data);
+  } else {
+    if (isImmediate) {
+      uart->txTail = (uart->txTail + uart->txBufferSize - 1) % uart->txBufferSize;
+      uart->txBuffer[uart->txTail] = data;
+    } else {
+      uart->txBuffer[(uart->txTail + uart->txCount) % uart->txBufferSize] = data;
+    }
+
+    ++uart->txCount;
+    --*uart->txBufferRemaining;
+  }
+
+  setUartTxInterruptEnabled(uart, true);
+}
+
+static uint8_t uartRead(hostUart_t* uart) {
+  while (!*uart->rxCount) {
+    HOST_WaitForInterrupt("UART read without received data");
+  }
+
+  uint8_t const result = uart->rxBuffer[uart->rxTail];
+  uart->rxTail = (uart->rxTail + 1) % uart->rxBufferSize;
+  --*uart->rxCount;
+
+  return result;
+}
+
+static void uartReceive(hostUart_t* uart) {
+  if (*uart->rxCount == uart->rxBufferSize) {
+    ++uart->rxOverruns;
+    return;
+  }
+
+  uart->rxBuffer[(uart->rxTail + *uart->rxCount) % uart->rxBufferSize] = uart->rxByte;
+  ++*uart->rxCount;
+}
+
+static bool isUartTxDone(hostUart_t const* uart) {
+  HOST_Poll();
+  return !uart->txCount && (HOST_GetTime() >= uart->txEvent.time);
+}
+
+void HOST_Peripherals_Initialize(void) {
+  initializeTimer(&tmr0, "TMR0 (100ms)", 100000, 155, &TMR0_InterruptHandler);
+  tmr0.event.handler = handleTmr0Event;
+  HOST_RegisterEvent(&tmr0.event);
+
+  initializeTimer(&tmr2, "TMR2 (10ms)", 10000, 155, &TMR2_InterruptHandler);
+  tmr2.event.handler = handleTmr2Event;
+  tmr2.event.isEnabled = isTmr2InterruptEnabled;
+  HOST_RegisterEvent(&tmr2.event);
+
+  initializeTimer(&tmr4, "TMR4 (1ms)", 1000, 31, &TMR4_InterruptHandler);
+  tmr4.event.handler = handleTmr4Event;
+  HOST_RegisterEvent(&tmr4.event);
+
+  initializeTimer(&tmr6, "TMR6 (100us)", 100, 100, &TMR6_InterruptHandler);
+  tmr6.event.handler = handleTmr6Event;
+  HOST_RegisterEvent(&tmr6.event);
+
+  initializeUart(&uarts[0], "UART1 Tx", "UART1 Rx", 9600, 128, &uart1TxBufferRemaining, 8, &uart1RxCount, &UART1_RxInterruptHandler);
+  uarts[0].txEvent.handler = handleUart1TxEvent;
+  uarts[0].txEvent.isEnabled = isUart1TxInterruptEnabled;
+  uarts[0].rxEvent.handler = handleUart1RxEvent;
+
+  initializeUart(&uarts[1], "UART2 Tx", "UART2 Rx", 115200, 16, &uart2TxBufferRemaining, 8, &uart2RxCount, &UART2_RxInterruptHandler);
+  uarts[1].txEvent.handler = handleUart2TxEvent;
+  uarts[1].txEvent.isEnabled = isUart2TxInterruptEnabled;
+  uarts[1].rxEvent.handler = handleUart2RxEvent;
+  uarts[1].rxEvent.isEnabled = isUart2RxInterruptEnabled;
+
+  initializeUart(&uarts[2], "UART3 Tx", "UART3 Rx", 800, 8, &uart3TxBufferRemaining, 8, &uart3RxCount, &UART3_RxInterruptHandler);
+  uarts[2].txEvent.handler = handleUart3TxEvent;
+  uarts[2].txEvent.isEnabled = isUart3TxInterruptEnabled;
+  uarts[2].rxEvent.handler = handleUart3RxEvent;
+
+  initializeUart(&uarts[3], "UART4 Tx", "UART4 Rx", 800, 8, &uart4TxBufferRemaining, 32, &uart4RxCount, &UART4_RxInterruptHandler);
+  uarts[3].txEvent.handler = handleUart4TxEvent;
+  uarts[3].txEvent.isEnabled = isUart4TxInterruptEnabled;
+  uarts[3].rxEvent.handler = handleUart4RxEvent;
+
+  for (uint8_t i = 0; i < UART_COUNT; ++i) {
+    HOST_RegisterEvent(&uarts[i].txEvent);
+    HOST_RegisterEvent(&uarts[i].rxEvent);
+  }
+}
+
+void HOST_Peripherals_Report(uint64_t duration) {
+  hostTimer_t* const timers[] = { &tmr0, &tmr2, &tmr4, &tmr6 };
+
+  for (uint8_t i = 0; i < sizeof(timers) / sizeof(timers[0]); ++i) {
+    uint64_t runningTime = timers[i]->runningTime;
+
+    if (timers[i]->isRunning) {
+      runningTime += HOST_GetTime() - timers[i]->runningSince;
+    }
+
+    printf("[HOST] %-15s running %8.3f%%\n", timers[i]->event.name, 100.0 * (double)runningTime / (double)duration);
+  }
+
+  for (uint8_t i = 0; i < UART_COUNT; ++i) {
+    printf(
+        "[HOST] UART%u: %u bytes sent, %u bytes received, %u receive overruns\n",
+        i + 1,
+        uarts[i].txBytes,
+        uarts[i].rxBytes,
+        uarts[i].rxOverruns
+        );
+  }
+
+  printf("[HOST] DMA1: %u transfers, %u bytes\n", module.dmaTransfers, module.dmaBytes);
+  printf("[HOST] DAC1: %u writes; SPI1: %u bytes\n", module.dacWrites, module.spiBytes);
+}
+
+void HOST_UartReceive(uint8_t uartNumber, uint8_t const* data, uint16_t length) {
+  HOST_UartReceiveAfter(uartNumber, 0, data, length);
+}
+
+void HOST_UartReceiveAfter(uint8_t uartNumber, uint32_t delay, uint8_t const* data, uint16_t length) {
+  hostUart_t* const uart = &uarts[uartNumber - 1];
+  uint64_t time = HOST_GetTime() + delay + uart->byteTime;
+
+  if (uart->rxQueueCount + length > UART_RX_QUEUE_SIZE) {
+    fprintf(stderr, "[HOST] UART%u receive queue overflow\n", uartNumber);
+    exit(1);
+  }
+
+  if (!uart->rxQueueCount) {
+    uart->rxEvent.time = time;
+  }
+
+  while (length--) {
+    uint16_t const position = (uart->rxQueueStart + uart->rxQueueCount++) % UART_RX_QUEUE_SIZE;
+    uart->rxQueue[position] = *data++;
+    uart->rxQueueTime[position] = time;
+    time = 0;
+  }
+}
+
+void HOST_SetUartTransmitHandler(uint8_t uartNumber, void (*handler)(uint8_t data)) {
+  uarts[uartNumber - 1].txHandler = handler;
+}
+
+void HOST_SetDacOutputHandler(void (*handler)(uint8_t value)) {
+  module.dacOutputHandler = handler;
+}
+
+void SYSTEM_Initialize(void) {
+  INTCON0bits.GIEH = 0;
+  INTCON0bits.GIEL = 0;
+
+  // PWR button released; no external hands-free microphone
+  PORTBbits.RB5 = 1;
+  PORTAbits.RA3 = 0;
+
+  PIE3bits.TMR2IE = 1;
+  PIE8bits.U2RXIE = 1;
+  PIE8bits.U2TXIE = 0;
+
+  UART1_SetRxInterruptHandler(UART1_Receive_ISR);
+  UART2_SetRxInterruptHandler(UART2_Receive_ISR);
+  UART3_SetRxInterruptHandler(UART3_Receive_ISR);
+  UART4_SetRxInterruptHandler(UART4_Receive_ISR);
+  UART3_SetTxInterruptHandler(UART3_Transmit_ISR);
+  UART4_SetTxInterruptHandler(UART4_Transmit_ISR);
+  uart1TxBufferRemaining = uarts[0].txBufferSize;
+  uart2TxBufferRemaining = uarts[1].txBufferSize;
+  uart3TxBufferRemaining = uarts[2].txBufferSize;
+  uart4TxBufferRemaining = uarts[3].txBufferSize;
+
+  // The generated initialization leaves all timers running
+  startTimer(&tmr0);
+  startTimer(&tmr2);
+  startTimer(&tmr4);
+  startTimer(&tmr6);
+}
+
+void TMR0_SetInterruptHandler(void (* InterruptHandler)(void)) {
+  TMR0_InterruptHandler = InterruptHandler;
+}
+
+void TMR0_StartTimer(void) {
+  startTimer(&tmr0);
+}
+
+void TMR0_StopTimer(void) {
+  stopTimer(&tmr0);
+}
+
+void TMR0_WriteTimer(uint8_t timerVal) {
+  writeTimer(&tmr0, timerVal);
+}
+
+void TMR2_SetInterruptHandler(void (* InterruptHandler)(void)) {
+  TMR2_InterruptHandler = InterruptHandler;
+}
+
+void TMR2_StartTimer(void) {
+  startTimer(&tmr2);
+}
+
+void TMR4_SetInterruptHandler(void (* InterruptHandler)(void)) {
+  TMR4_InterruptHandler = InterruptHandler;
+}
+
+void TMR4_StartTimer(void) {
+  startTimer(&tmr4);
+}
+
+void TMR4_StopTimer(void) {
+  stopTimer(&tmr4);
+}
+
+uint8_t TMR4_ReadTimer(void) {
+  return readTimer(&tmr4);
+}
+
+void TMR4_WriteTimer(uint8_t timerVal) {
+  writeTimer(&tmr4, timerVal);
+}
+
+void TMR6_SetInterruptHandler(void (* InterruptHandler)(void)) {
+  TMR6_InterruptHandler = InterruptHandler;
+}
+
+void TMR6_StartTimer(void) {
+  startTimer(&tmr6);
+}
+
+void TMR6_StopTimer(void) {
+  stopTimer(&tmr6);
+}
+
+uint8_t TMR6_ReadTimer(void) {
+  return readTimer(&tmr6);
+}
+
+bool UART1_is_rx_ready(void) {
+  HOST_Poll();
+  return uart1RxCount != 0;
+}
+
+uint8_t UART1_Read(void) {
+  return uartRead(&uarts[0]);
+}
+
+void UART1_Write(uint8_t txData) {
+  uartWrite(&uarts[0], txData, false);
+}
+
+void UART1_Receive_ISR(void) {
+  uartReceive(&uarts[0]);
+}
+
+void UART1_SetRxInterruptHandler(void (* InterruptHandler)(void)) {
+  UART1_RxInterruptHandler = InterruptHandler;
+}
+
+void UART2_Write(uint8_t txData) {
+  uartWrite(&uarts[1], txData, false);
+}
+
+void UART2_Receive_ISR(void) {
+  BT_CommandDecode_RxByte(uarts[1].rxByte);
+}
+
+void UART2_SetRxInterruptHandler(void (* InterruptHandler)(void)) {
+  UART2_RxInterruptHandler = InterruptHandler;
+}
+
+bool UART3_is_rx_ready(void) {
+  HOST_Poll();
+  return uart3RxCount != 0;
+}
+
+bool UART3_is_tx_ready(void) {
+  HOST_Poll();
+  return uart3TxBufferRemaining != 0;
+}
+
+bool UART3_is_tx_done(void) {
+  return isUartTxDone(&uarts[2]);
+}
+
+uint8_t UART3_Read(void) {
+  return uartRead(&uarts[2]);
+}
+
+void UART3_Write(uint8_t txData) {
+  uartWrite(&uarts[2], txData, false);
+}
+
+void UART3_WriteImmediately(uint8_t txData) {
+  uartWrite(&uarts[2], txData, true);
+}
+
+void UART3_Receive_ISR(void) {
+  uartReceive(&uarts[2]);
+}
+
+void UART3_Transmit_ISR(void) {
+  handleUartTxEvent(&uarts[2]);
+}
+
+void UART3_SetRxInterruptHandler(void (* InterruptHandler)(void)) {
+  UART3_RxInterruptHandler = InterruptHandler;
+}
+
+void UART3_SetTxInterruptHandler(void (* InterruptHandler)(void)) {
+  UART3_TxInterruptHandler = InterruptHandler;
+}
+
+bool UART4_is_rx_ready(void) {
+  HOST_Poll();
+  return uart4RxCount != 0;
+}
+
+uint8_t UART4_Read(void) {
+  return uartRead(&uarts[3]);
+}
+
+void UART4_Write(uint8_t txData) {
+  uartWrite(&uarts[3], txData, false);
+}
+
+void UART4_Receive_ISR(void) {
+  uartReceive(&uarts[3]);
+}
+
+void UART4_Transmit_ISR(void) {
+  handleUartTxEvent(&uarts[3]);
+}
+
+void UART4_SetRxInterruptHandler(void (* InterruptHandler)(void)) {
+  UART4_RxInterruptHandler = InterruptHandler;
+}
+
+void UART4_SetTxInterruptHandler(void (* InterruptHandler)(void)) {
+  UART4_TxInterruptHandler = InterruptHandler;
+}
+
+void DAC1_SetOutput(uint8_t inputData) {
+  module.dacOutput = inputData;
+  ++module.dacWrites;
+
+  if (module.dacOutputHandler) {
+    module.dacOutputHandler(inputData);
+  }
+}
+
+uint8_t DAC1_GetOutput(void) {
+  return module.dacOutput;
+}
+
+bool SPI1_Open(spi1_modes_t spi1UniqueConfiguration) {
+  (void)spi1UniqueConfiguration;
+  return true;
+}
+
+uint8_t SPI1_ExchangeByte(uint8_t data) {
+  (void)data;
+  ++module.spiBytes;
+  return 0;
+}
+
+void IOCAF3_SetInterruptHandler(void (* InterruptHandler)(void)) {
+  IOCAF3_InterruptHandler = InterruptHandler;
+}
+
+void IOCBF5_SetInterruptHandler(void (* InterruptHandler)(void)) {
+  IOCBF5_InterruptHandler = InterruptHandler;
+}
@@ -0,0 +1,524 @@
+/**
+ * @file
+ * @author Jeff Lau
+ *
+ * See header file for module description.
+ */
+
+#include "sim.h"
+#include <xc.h>
+#include "../src/util/profile.h"
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/**
+ * Max number of registered interrupt sources.
+ */
+#define MAX_EVENTS (16)
+
+/**
+ * Simulated cost of polling a peripheral status once (us).
+ */
+#define POLL_TIME (1)
+
+/**
+ * Simulated durations of NVM operations (us). These are rough typical values;
+ * only their magnitude matters for the simulation.
+ */
+#define DFM_BYTE_WRITE_TIME (4000)
+#define PFM_PAGE_ERASE_TIME (10000)
+#define PFM_WORD_WRITE_TIME (50)
+
+#define DFM_ADDRESS (0x380000UL)
+#define DFM_SIZE (1024)
+#define PFM_SIZE (0x20000UL)
+#define PFM_PAGE_SIZE (256)
+
+volatile PORTAbits_t PORTAbits;
+volatile PORTBbits_t PORTBbits;
+volatile PORTCbits_t PORTCbits;
+volatile LATAbits_t LATAbits;
+volatile LATBbits_t LATBbits;
+volatile LATCbits_t LATCbits;
+volatile TRISAbits_t TRISAbits;
+volatile TRISBbits_t TRISBbits;
+volatile TRISCbits_t TRISCbits;
+volatile ANSELAbits_t ANSELAbits;
+volatile ANSELBbits_t ANSELBbits;
+volatile ANSELCbits_t ANSELCbits;
+volatile WPUAbits_t WPUAbits;
+volatile WPUBbits_t WPUBbits;
+volatile WPUCbits_t WPUCbits;
+volatile ODCONAbits_t ODCONAbits;
+volatile ODCONBbits_t ODCONBbits;
+volatile ODCONCbits_t ODCONCbits;
+volatile INTCON0bits_t INTCON0bits;
+volatile CPUDOZEbits_t CPUDOZEbits;
+volatile PIR2bits_t PIR2bits;
+volatile PIE2bits_t PIE2bits;
+volatile IPR2bits_t IPR2bits;
+volatile PIE3bits_t PIE3bits;
+volatile PIE8bits_t PIE8bits;
+volatile T1CONbits_t T1CONbits;
+volatile uint8_t U2TXB;
+volatile PMD8bits_t PMD8bits;
+volatile PRLOCKbits_t PRLOCKbits;
+volatile uint8_t PRLOCK;
+volatile uint8_t ISRPR;
+volatile uint8_t MAINPR;
+volatile uint8_t DMA1PR;
+volatile uint8_t DMASELECT;
+volatile uint8_t DMAnCON0;
+volatile uint8_t DMAnCON1;
+volatile uintptr_t DMAnSSA;
+volatile uint16_t DMAnSSZ;
+volatile uint16_t DMAnDSA;
+volatile uint16_t DMAnDSZ;
+volatile uint8_t DMAnSIRQ;
+volatile uint8_t DMAnAIRQ;
+volatile uint8_t T1GCON;
+volatile uint8_t T1CLK;
+
+volatile uint8_t HOST_NVMADRU;
+volatile uint8_t HOST_NVMADRH;
+volatile uint8_t HOST_NVMADRL;
+volatile uint8_t HOST_NVMDATL;
+volatile uint8_t HOST_NVMDATH;
+volatile uint8_t HOST_NVMLOCK;
+
+/**
+ * Module state.
+ */
+static struct {
+  HOST_Options options;
+  uint64_t now;
+  HOST_Event* events[MAX_EVENTS];
+  uint8_t eventCount;
+  bool isInInterrupt;
+
+  struct {
+    volatile NVMCON0bits_t con0;
+    volatile NVMCON1bits_t con1;
+    /**
+     * True while the operation started by NVMCON0bits.GO is in progress.
+     */
+    bool isBusy;
+    uint64_t busyUntil;
+    uint8_t dfm[DFM_SIZE];
+    uint8_t pfm[PFM_SIZE];
+  } nvm;
+
+  uint8_t tmr1[2];
+
+  struct {
+    uint32_t mainLoopPasses;
+    uint32_t sleeps;
+    uint64_t sleepTime;
+    uint64_t stallTime;
+    uint64_t pollTime;
+    uint32_t dfmReads;
+    uint32_t dfmWrites;
+    uint32_t pfmPageErases;
+    uint32_t pfmWordWrites;
+  } stats;
+} module;
+
+static void finish(void);
+
+static void checkEnd(void) {
+  if (module.now >= module.options.duration) {
+    finish();
+  }
+}
+
+static bool isEventEnabled(HOST_Event const* event) {
+  return (event->time != HOST_NEVER) && (!event->isEnabled || event->isEnabled());
+}
+
+/**
+ * Gets the enabled event that is due earliest.
+ *
+ * @param limit - Only events at or before this time are considered.
+ * @return The event, or NULL if there is none.
+ */
+static HOST_Event* getNextEvent(uint64_t limit) {
+  HOST_Event* result = NULL;
+
+  for (uint8_t i = 0; i < module.eventCount; ++i) {
+    HOST_Event* const event = module.events[i];
+
+    if (isEventEnabled(event) && (event->time <= limit) && (!result || (event->time < result->time))) {
+      result = event;
+    }
+  }
+
+  return result;
+}
+
+static void handleEvent(HOST_Event* event) {
+  module.isInInterrupt = true;
+  ++event->count;
+  event->handler();
+  module.isInInterrupt = false;
+}
+
+void HOST_Initialize(HOST_Options const* options) {
+  memset(&module, 0, sizeof(module));
+  module.options = *options;
+  memset(module.nvm.dfm, 0xFF, sizeof(module.nvm.dfm));
+  memset(module.nvm.pfm, 0xFF, sizeof(module.nvm.pfm));
+}
+
+void HOST_RegisterEvent(HOST_Event* event) {
+  if (module.eventCount == MAX_EVENTS) {
+    fprintf(stderr, "[HOST] Too many interrupt sources\n");
+    exit(1);
+  }
+
+  module.events[module.eventCount++] = event;
+}
+
+uint64_t HOST_GetTime(void) {
+  return module.now;
+}
+
+bool HOST_IsInterruptible(void) {
+  return INTCON0bits.GIE && !module.isInInterrupt;
+}
+
+void HOST_ServiceInterrupts(void) {
+  HOST_Event* event;
+
+  while (HOST_IsInterruptible() && (event = getNextEvent(module.now))) {
+    handleEvent(event);
+  }
+}
+
+void HOST_Advance(uint32_t time) {
+  uint64_t const target = module.now + time;
+  HOST_Event* event;
+
+  while (HOST_IsInterruptible() && (event = getNextEvent(target))) {
+    if (event->time > module.now) {
+      module.now = event->time;
+    }
+
+    handleEvent(event);
+  }
+
+  module.now = target;
+
+  if (!module.isInInterrupt) {
+    checkEnd();
+  }
+}
+
+void HOST_Stall(uint32_t time) {
+  module.now += time;
+  module.stats.stallTime += time;
+  HOST_ServiceInterrupts();
+}
+
+void HOST_Poll(void) {
+  module.stats.pollTime += POLL_TIME;
+  HOST_Advance(POLL_TIME);
+}
+
+void HOST_WaitForInterrupt(char const* reason) {
+  HOST_Event* const event = getNextEvent(HOST_NEVER);
+
+  if (!event || !HOST_IsInterruptible()) {
+    fprintf(stderr, "[HOST] Deadlock: %s\n", reason);
+    exit(1);
+  }
+
+  module.stats.pollTime += event->time - module.now;
+  HOST_Advance((uint32_t)(event->time - module.now));
+}
+
+void HOST_MainLoopPass(void) {
+  ++module.stats.mainLoopPasses;
+  HOST_Advance(module.options.mainLoopPassTime);
+}
+
+uint32_t HOST_GetMainLoopPassCount(void) {
+  return module.stats.mainLoopPasses;
+}
+
+uint32_t HOST_GetSleepCount(void) {
+  return module.stats.sleeps;
+}
+
+uint64_t HOST_GetSleepTime(void) {
+  return module.stats.sleepTime;
+}
+
+uint32_t HOST_GetDfmReadCount(void) {
+  return module.stats.dfmReads;
+}
+
+void HOST_End(void) {
+  finish();
+}
+
+void __real_APP_Task(void);
+
+/**
+ * Replaces the firmware's calls to APP_Task() (see -Wl,--wrap in the
+ * Makefile), so that every pass of the main loop is counted and costs
+ * simulated time, and is observed by the test afterwards (the main loop may
+ * sleep for a long time after a pass that completes some work).
+ */
+void __wrap_APP_Task(void) {
+  HOST_MainLoopPass();
+  __real_APP_Task();
+
+  if (module.options.mainLoopPassHandler) {
+    module.options.mainLoopPassHandler();
+  }
+}
+
+int HOST_FirmwarePrintf(char const* format, ...) {
+  int result = 0;
+
+  if (module.options.isFirmwareOutputEnabled) {
+    va_list args;
+    va_start(args, format);
+    result = vprintf(format, args);
+    va_end(args);
+  }
+
+  return result;
+}
+
+void HOST_Sleep(void) {
+  HOST_Event* const event = getNextEvent(HOST_NEVER);
+  uint64_t const wakeUpTime = (event && (event->time < module.options.duration))
+      ? event->time
+      : module.options.duration;
+
+  ++module.stats.sleeps;
+
+  if (wakeUpTime > module.now) {
+    module.stats.sleepTime += wakeUpTime - module.now;
+    module.now = wakeUpTime;
+  }
+
+  checkEnd();
+}
+
+void HOST_Reset(void) {
+  printf("[HOST] Firmware requested a reset\n");
+  finish();
+}
+
+static uint32_t getNvmAddress(void) {
+  return ((uint32_t)HOST_NVMADRU << 16) | ((uint32_t)HOST_NVMADRH << 8) | HOST_NVMADRL;
+}
+
+static void setNvmAddress(uint32_t address) {
+  HOST_NVMADRU = (uint8_t)(address >> 16);
+  HOST_NVMADRH = (uint8_t)(address >> 8);
+  HOST_NVMADRL = (uint8_t)address;
+}
+
+/**
+ * Gets the simulated memory at an NVM address.
+ *
+ * @param isFlash - Set to true if the address is in program flash memory.
+ * @return A pointer to the memory, or NULL if the address is not simulated.
+ */
+static uint8_t* getNvmMemory(uint32_t address, bool* isFlash) {
+  if ((address >= DFM_ADDRESS) && (address < DFM_ADDRESS + DFM_SIZE)) {
+    *isFlash = false;
+    return &module.nvm.dfm[address - DFM_ADDRESS];
+  }
+
+  if (address < PFM_SIZE) {
+    *isFlash = true;
+    return &module.nvm.pfm[address];
+  }
+
+  return NULL;
+}
+
+/**
+ * Performs the operation that was just started by setting NVMCON0bits.GO.
+ */
+static void startNvmOperation(void) {
+  uint32_t address = getNvmAddress();
+  bool isFlash;
+  uint8_t* const memory = getNvmMemory(address, &isFlash);
+  uint32_t duration = 0;
+
+  if (!memory) {
+    fprintf(stderr, "[HOST] NVM access to unsupported address 0x%06X\n", address);
+    exit(1);
+  }
+
+  if (isFlash) {
+    // Word operations use the even address
+    address &= ~1UL;
+  }
+
+  uint8_t* const word = isFlash ? &module.nvm.pfm[address] : memory;
+
+  switch (module.nvm.con1.NVMCMD) {
+    case 0b000:
+    case 0b001:
+      HOST_NVMDATL = word[0];
+      HOST_NVMDATH = isFlash ? word[1] : 0;
+
+      if (!isFlash) {
+        ++module.stats.dfmReads;
+      }
+
+      if (module.nvm.con1.NVMCMD == 0b001) {
+        setNvmAddress(address + (isFlash ? 2 : 1));
+      }
+      break;
+
+    case 0b011:
+    case 0b100:
+      if (isFlash) {
+        // Programming can only clear bits
+        word[0] &= HOST_NVMDATL;
+        word[1] &= HOST_NVMDATH;
+        duration = PFM_WORD_WRITE_TIME;
+        ++module.stats.pfmWordWrites;
+      } else {
+        word[0] = HOST_NVMDATL;
+        duration = DFM_BYTE_WRITE_TIME;
+        ++module.stats.dfmWrites;
+      }
+
+      if (module.nvm.con1.NVMCMD == 0b100) {
+        setNvmAddress(address + (isFlash ? 2 : 1));
+      }
+      break;
+
+    case 0b110:
+      if (!isFlash) {
+        fprintf(stderr, "[HOST] Page erase of data flash is not supported\n");
+        exit(1);
+      }
+
+      memset(&module.nvm.pfm[address & ~(PFM_PAGE_SIZE - 1UL)], 0xFF, PFM_PAGE_SIZE);
+      duration = PFM_PAGE_ERASE_TIME;
+      ++module.stats.pfmPageErases;
+      break;
+
+    default:
+      fprintf(stderr, "[HOST] Unsupported NVM command %u\n", module.nvm.con1.NVMCMD);
+      exit(1);
+  }
+
+  if (isFlash && duration) {
+    // The CPU stalls while program flash is erased/written
+    HOST_Stall(duration);
+    duration = 0;
+  }
+
+  module.nvm.isBusy = (duration != 0);
+  module.nvm.busyUntil = module.now + duration;
+}
+
+/**
+ * Updates the simulated NVM state before any NVM register is accessed.
+ */
+static void updateNvm(void) {
+  if (module.nvm.con0.GO && !module.nvm.isBusy) {
+    module.nvm.isBusy = true;
+    startNvmOperation();
+  }
+
+  if (module.nvm.isBusy && (module.now >= module.nvm.busyUntil)) {
+    module.nvm.isBusy = false;
+  }
+
+  module.nvm.con0.GO = module.nvm.isBusy;
+}
+
+volatile NVMCON0bits_t* HOST_NvmCon0(void) {
+  updateNvm();
+
+  if (module.nvm.isBusy) {
+    // Only a busy status is being polled; ready is the result of an operation
+    // that just completed.
+    HOST_Poll();
+    updateNvm();
+  }
+
+  return &module.nvm.con0;
+}
+
+volatile NVMCON1bits_t* HOST_NvmCon1(void) {
+  updateNvm();
+  return &module.nvm.con1;
+}
+
+volatile uint8_t* HOST_NvmRegister(volatile uint8_t* reg) {
+  updateNvm();
+  return reg;
+}
+
+volatile uint8_t* HOST_Tmr1Register(uint8_t isHigh) {
+  if (T1CONbits.ON) {
+    // 1us per count
+    module.tmr1[0] = (uint8_t)module.now;
+    module.tmr1[1] = (uint8_t)(module.now >> 8);
+  }
+
+  return &module.tmr1[isHigh];
+}
+
+static void printPercent(char const* label, uint64_t part, uint64_t whole) {
+  printf("[HOST] %-24s %8.3f%%\n", label, whole ? (100.0 * (double)part / (double)whole) : 0.0);
+}
+
+static void printReport(void) {
+  uint64_t const duration = module.now;
+  double const seconds = (double)duration / 1000000.0;
+
+  printf("\n[HOST] Simulated %.3f seconds\n", seconds);
+  printf("[HOST] %-24s %9.1f\n", "Main loop passes/s", module.stats.mainLoopPasses / seconds);
+  printf("[HOST] %-24s %9.1f\n", "SLEEPs/s", module.stats.sleeps / seconds);
+  printPercent("Active time", duration - module.stats.sleepTime, duration);
+  printPercent("Stalled (NVM)", module.stats.stallTime, duration);
+  printPercent("Busy-waiting", module.stats.pollTime, duration);
+  printf(
+      "[HOST] NVM: %u data flash byte writes, %u program flash page erases, %u word writes\n",
+      module.stats.dfmWrites,
+      module.stats.pfmPageErases,
+      module.stats.pfmWordWrites
+      );
+
+  for (uint8_t i = 0; i < module.eventCount; ++i) {
+    printf("[HOST] Interrupts/s %-15s %9.1f\n", module.events[i]->name, module.events[i]->count / seconds);
+  }
+
+  HOST_Peripherals_Report(duration);
+
+#ifdef PROFILE_ENABLED
+  // The profiler prints with the firmware's printf()
+  bool const isFirmwareOutputEnabled = module.options.isFirmwareOutputEnabled;
+  module.options.isFirmwareOutputEnabled = true;
+  PROFILE_Dump();
+  module.options.isFirmwareOutputEnabled = isFirmwareOutputEnabled;
+#endif
+}
+
+static void finish(void) {
+  if (module.options.isReportEnabled) {
+    printReport();
+  }
+
+  if (module.options.endHandler) {
+    module.options.endHandler();
+  }
+
+  fflush(stdout);
+  exit(0);
+}
@@ -0,0 +1,256 @@
+/**
+ * @file
+ * @author Jeff Lau
+ *
+ * Deterministic simulation of time and interrupts for the host build.
+ *
+ * Simulated time (in microseconds) only advances when the firmware does
+ * something that takes time on the real hardware:
+ * - Each pass of the main loop costs a fixed amount of time (see
+ *   HOST_MainLoopPass()).
+ * - SLEEP jumps ahead to the next interrupt event (see HOST_Sleep()).
+ * - Polling a busy/ready status of a peripheral costs a small amount of time,
+ *   so that busy-wait loops eventually see the status change.
+ * - Program flash erase/write operations stall the CPU for their duration.
+ *
+ * Interrupt handlers are only called at these points (never in the middle of
+ * arbitrary firmware code), and only while interrupts are enabled
+ * (INTCON0bits.GIE) and no other handler is executing. An interrupt event
+ * that is due while interrupts are disabled is handled as soon as they are
+ * enabled again (see HOST_ServiceInterrupts()), and multiple missed periods
+ * of a timer are handled only once, like a real interrupt flag.
+ *
+ * The simulation ends (and a report is printed) when the configured duration
+ * of simulated time has elapsed.
+ *
+ * The firmware's main loop is not modified for the host build. Instead, the
+ * host's link replaces APP_Task() with a wrapper (see -Wl,--wrap in the
+ * Makefile) that calls HOST_MainLoopPass() before each pass, and the
+ * mainLoopPassHandler after it.
+ */
+
+#ifndef SIM_H
+#define	SIM_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef	__cplusplus
+extern "C" {
+#endif
+
+/**
+ * Value of HOST_Event.time for an event that is not scheduled.
+ */
+#define HOST_NEVER (UINT64_MAX)
+
+/**
+ * A source of interrupts.
+ */
+typedef struct HOST_Event {
+  /**
+   * Display name for the report.
+   */
+  char const* name;
+  /**
+   * Simulated time of the next interrupt, or HOST_NEVER.
+   */
+  uint64_t time;
+  /**
+   * Tests if the interrupt is enabled (NULL if always enabled).
+   *
+   * A disabled interrupt can neither be handled nor wake the CPU from SLEEP.
+   */
+  bool (*isEnabled)(void);
+  /**
+   * Handles the interrupt. Must either reschedule or unschedule the event.
+   */
+  void (*handler)(void);
+  /**
+   * Number of times the interrupt was handled.
+   */
+  uint32_t count;
+} HOST_Event;
+
+/**
+ * Options of the simulation.
+ */
+typedef struct HOST_Options {
+  /**
+   * Total simulated time (us).
+   */
+  uint64_t duration;
+  /**
+   * Simulated execution time of each pass of the main loop (us).
+   */
+  uint32_t mainLoopPassTime;
+  /**
+   * True to print the firmware's debug output (printf()), which goes to UART1
+   * on the hardware.
+   */
+  bool isFirmwareOutputEnabled;
+  /**
+   * True to print the report when the simulation ends.
+   */
+  bool isReportEnabled;
+  /**
+   * Called at the end of each pass of the main loop, after APP_Task()
+   * (NULL if not needed). Used by tests to observe the firmware.
+   */
+  void (*mainLoopPassHandler)(void);
+  /**
+   * Called when the simulation ends, after the report (NULL if not needed).
+   * The process exits with status 0 if it returns.
+   */
+  void (*endHandler)(void);
+} HOST_Options;
+
+/**
+ * Initializes the simulation.
+ */
+void HOST_Initialize(HOST_Options const* options);
+
+/**
+ * Registers a source of interrupts.
+ *
+ * @param event - Must remain valid for the whole simulation.
+ */
+void HOST_RegisterEvent(HOST_Event* event);
+
+/**
+ * Gets the current simulated time.
+ *
+ * @return Simulated time (us) since the start of the simulation.
+ */
+uint64_t HOST_GetTime(void);
+
+/**
+ * Advances simulated time while the CPU is executing, handling interrupts that
+ * become due along the way (if enabled).
+ *
+ * @param time - Amount of time (us).
+ */
+void HOST_Advance(uint32_t time);
+
+/**
+ * Advances simulated time while the CPU is stalled (e.g., during a program
+ * flash erase). Interrupts that become due are handled afterward.
+ *
+ * @param time - Amount of time (us).
+ */
+void HOST_Stall(uint32_t time);
+
+/**
+ * Advances simulated time by the cost of polling a peripheral status once.
+ */
+void HOST_Poll(void);
+
+/**
+ * Advances simulated time to the next enabled interrupt event, handling it
+ * (and any others that are due) if interrupts are enabled.
+ *
+ * Used by blocking driver calls that must wait for an interrupt handler to
+ * make progress. Ends the simulation with an error if the wait can never end.
+ *
+ * @param reason - Description of the wait for the error message.
+ */
+void HOST_WaitForInterrupt(char const* reason);
+
+/**
+ * Called once per pass of the main loop (see the APP_Task() wrapper in
+ * sim.c).
+ *
+ * Advances simulated time by the configured main loop pass time.
+ */
+void HOST_MainLoopPass(void);
+
+/**
+ * Gets the number of passes of the main loop so far.
+ */
+uint32_t HOST_GetMainLoopPassCount(void);
+
+/**
+ * Gets the number of SLEEP instructions executed so far (each is ended by the
+ * next interrupt, so this is also the number of wake-ups from Idle mode).
+ */
+uint32_t HOST_GetSleepCount(void);
+
+/**
+ * Gets the total time spent in Idle mode (after SLEEP) so far.
+ *
+ * @return Simulated time (us).
+ */
+uint64_t HOST_GetSleepTime(void);
+
+/**
+ * Gets the number of bytes read from data flash (EEPROM) so far.
+ */
+uint32_t HOST_GetDfmReadCount(void);
+
+/**
+ * Ends the simulation now, as if the configured duration had elapsed.
+ */
+void HOST_End(void);
+
+/**
+ * Tests if interrupt handlers are currently allowed to execute.
+ *
+ * @return True if interrupts are enabled and no handler is executing.
+ */
+bool HOST_IsInterruptible(void);
+
+/**
+ * Resets all simulated peripherals to their power-on state (see
+ * mcc_generated_files.c).
+ */
+void HOST_Peripherals_Initialize(void);
+
+/**
+ * Prints the peripheral portion of the simulation report (see
+ * mcc_generated_files.c).
+ */
+void HOST_Peripherals_Report(uint64_t duration);
+
+/**
+ * Queues bytes to be received by a UART, one byte per byte time (at the
+ * UART's baud rate) after any bytes that are already queued.
+ *
+ * @param uart - The UART number (1-4).
+ * @param data - The bytes.
+ * @param length - Number of bytes.
+ */
+void HOST_UartReceive(uint8_t uart, uint8_t const* data, uint16_t length);
+
+/**
+ * Like HOST_UartReceive(), but the first byte is received no earlier than one
+ * byte time after a delay (e.g., the response time of a simulated device).
+ *
+ * @param uart - The UART number (1-4).
+ * @param delay - The delay (us).
+ * @param data - The bytes.
+ * @param length - Number of bytes.
+ */
+void HOST_UartReceiveAfter(uint8_t uart, uint32_t delay, uint8_t const* data, uint16_t length);
+
+/**
+ * Sets a function to be called with each byte that a UART starts to
+ * transmit (e.g., to simulate the device connected to it).
+ *
+ * @param uart - The UART number (1-4).
+ * @param handler - Called with each byte (NULL for none).
+ */
+void HOST_SetUartTransmitHandler(uint8_t uart, void (*handler)(uint8_t data));
+
+/**
+ * Sets a function to be called with each value that is written to DAC1 (the
+ * sound output, one sample per sound sample timer interrupt).
+ *
+ * @param handler - Called with each value (NULL for none).
+ */
+void HOST_SetDacOutputHandler(void (*handler)(uint8_t value));
+
+#ifdef	__cplusplus
+}
+#endif
+
+#endif	/* SIM_H */
@@ -0,0 +1,197 @@
+/**
+ * @file
+ * @author Jeff Lau
+ *
+ * Test of sending commands to the BM62 Bluetooth Module (bt_command_send.c)
+ * through UART2, with the configured transmit method (DMA1 by default, see
+ * UART_TX_USE_DMA) and send mode (see PIPELINED_CMD_WINDOW).
+ *
+ * After the module reports that it is powered on, and the firmware has sent
+ * its own commands in response (event ACK, event mask, link back), enough
+ * device name commands of varying lengths are queued to wrap around the
+ * command buffer several times. Every command must be received intact, in
+ * order.
+ *
+ * Halfway through, a volume command is queued, which the simulated module
+ * does not ACK (it has a different command ID, because ACKs are matched to
+ * commands by ID). The firmware gives up on that command (see
+ * BT_EVENT_CMD_SENT_NO_ACK in app.c) after ACK_TIME_OUT_MS, waits
+ * APP_INPUT_WAITING_TIME_OUT_MS, and then continues with the next command.
+ */
+
+#include "../sim.h"
+#include "../bm62.h"
+#include "../../src/bluetooth/bt_command_send.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define COMMAND_COUNT (200)
+#define FIRMWARE_COMMAND_COUNT (3)
+/**
+ * Number of device name commands before the volume command.
+ */
+#define NO_ACK_COMMAND (100)
+/**
+ * Range of the longest time between receiving two commands, which is after
+ * the volume command (us): ACK_TIME_OUT_MS plus APP_INPUT_WAITING_TIME_OUT_MS,
+ * minus the time taken by other commands that are still sent within the
+ * window in pipelined mode.
+ */
+#define NO_ACK_MIN_GAP (1050000)
+#define NO_ACK_MAX_GAP (1200000)
+
+static struct {
+  uint16_t commandsQueued;
+  uint16_t commandsReceived;
+  uint16_t firmwareCommandsReceived;
+  bool isNoAckCommandQueued;
+  bool isNoAckCommandReceived;
+  uint64_t maxGap;
+  uint64_t lastCommandTime;
+  bool isFailed;
+} test;
+
+static void getDeviceName(uint16_t index, char* name) {
+  // 1 to BT_MAX_DEVICE_NAME_LENGTH characters
+  uint8_t const length = 1 + (index % BT_MAX_DEVICE_NAME_LENGTH);
+
+  for (uint8_t i = 0; i < length; ++i) {
+    name[i] = 'A' + ((index + i) % 26);
+  }
+
+  name[length] = 0;
+}
+
+static void fail(char const* message) {
+  if (!test.isFailed) {
+    fprintf(stderr, "FAIL: %s (command %u)\n", message, test.commandsReceived);
+    test.isFailed = true;
+  }
+
+  HOST_End();
+}
+
+static void updateMaxGap(void) {
+  uint64_t const now = HOST_GetTime();
+
+  if (test.commandsReceived && (now - test.lastCommandTime > test.maxGap)) {
+    test.maxGap = now - test.lastCommandTime;
+  }
+
+  test.lastCommandTime = now;
+}
+
+static uint8_t handleCommand(uint8_t const* command, uint8_t length) {
+  if (command[0] == SET_HF_GAIN_LEVEL) {
+    updateMaxGap();
+    test.isNoAckCommandReceived = true;
+    return BM62_NO_ACK;
+  }
+
+  if (command[0] != CONFIGURE_VENDOR_PARAMETER) {
+    ++test.firmwareCommandsReceived;
+    return 0;
+  }
+
+  char name[BT_MAX_DEVICE_NAME_LENGTH + 1];
+  getDeviceName(test.commandsReceived, name);
+
+  if ((length != strlen(name) + 4) || (command[3] != strlen(name)) || memcmp(&command[4], name, strlen(name))) {
+    fail("wrong device name command");
+    return 0;
+  }
+
+  updateMaxGap();
+  ++test.commandsReceived;
+
+  return 0;
+}
+
+static void handleMainLoopPass(void) {
+  if (test.firmwareCommandsReceived < FIRMWARE_COMMAND_COUNT) {
+    return;
+  }
+
+  // Keep the queue as full as it allows
+  while (test.commandsQueued < COMMAND_COUNT) {
+    if ((test.commandsQueued == NO_ACK_COMMAND) && !test.isNoAckCommandQueued) {
+      uint8_t command[7] = { 0xAA, 0x00, 0x03, SET_HF_GAIN_LEVEL, 0x00, 0x0F };
+      command[6] = BT_CalculateCmdChecksum(&command[2], &command[5]);
+
+      if (!BT_SendBytesAsCompleteCommand(command, sizeof(command))) {
+        break;
+      }
+
+      test.isNoAckCommandQueued = true;
+    }
+
+    char name[BT_MAX_DEVICE_NAME_LENGTH + 1];
+    getDeviceName(test.commandsQueued, name);
+
+    if (!BT_SetDeviceName(name)) {
+      break;
+    }
+
+    ++test.commandsQueued;
+  }
+
+  if (test.commandsReceived == COMMAND_COUNT) {
+    HOST_End();
+  }
+}
+
+static void handleEnd(void) {
+  if (!test.isFailed && (test.commandsReceived != COMMAND_COUNT)) {
+    fprintf(stderr, "FAIL: %u of %u commands received\n", test.commandsReceived, COMMAND_COUNT);
+    test.isFailed = true;
+  }
+
+  if (!test.isFailed && !test.isNoAckCommandReceived) {
+    fprintf(stderr, "FAIL: volume command not received\n");
+    test.isFailed = true;
+  }
+
+  if (!test.isFailed && ((test.maxGap < NO_ACK_MIN_GAP) || (test.maxGap > NO_ACK_MAX_GAP))) {
+    fprintf(stderr, "FAIL: %.3f s gap after the command that was not ACKed\n", (double)test.maxGap / 1000000.0);
+    test.isFailed = true;
+  }
+
+  if (test.isFailed) {
+    exit(1);
+  }
+
+  printf(
+      "PASS: %u commands (+%u from the firmware) received; %.3f s gap after the command that was not ACKed\n",
+      test.commandsReceived,
+      test.firmwareCommandsReceived,
+      (double)test.maxGap / 1000000.0
+      );
+}
+
+void FIRMWARE_main(void);
+
+int main(void) {
+  HOST_Options options;
+  BM62_Options bm62Options;
+
+  options.duration = 30 * 1000000ULL;
+  options.mainLoopPassTime = 50;
+  options.isFirmwareOutputEnabled = false;
+  options.isReportEnabled = false;
+  options.mainLoopPassHandler = handleMainLoopPass;
+  options.endHandler = handleEnd;
+
+  memset(&bm62Options, 0, sizeof(bm62Options));
+  bm62Options.powerOnTime = 1000000;
+  bm62Options.ackDelay = 1000;
+  bm62Options.commandHandler = handleCommand;
+
+  HOST_Initialize(&options);
+  HOST_Peripherals_Initialize();
+  BM62_Initialize(&bm62Options);
+
+  FIRMWARE_main();
+
+  return 1;
+}
@@ -0,0 +1,225 @@
+/**
+ * @file
+ * @author Jeff Lau
+ *
+ * Fuzz test of the CSV field views (scanNextCsvField(), skipCsvFields() and
+ * copyCsvField() in string.c) against the original copying CSV parser.
+ *
+ * Pseudo-random AT result payloads (up to the max AT result length, made
+ * mostly of quotes, commas, escaped quotes and null terminators) are parsed
+ * field by field, with random destination buffer sizes:
+ * - parseNextCsvField() must produce the same value and next field pointer as
+ *   the original parser.
+ * - Each field view must be within the result, and its copied value must be
+ *   the original parser's value (with the largest buffer).
+ * - Skipping any number of fields must end on the same field as scanning
+ *   them one at a time.
+ * - Every field must move forward, or end the result.
+ */
+
+#include "../../src/util/string.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define ITERATIONS (1000000UL)
+
+/**
+ * Max length of an AT result (see ATCMD_ResponseCallback).
+ */
+#define MAX_RESULT_LENGTH (255)
+
+/**
+ * Max size of a destination buffer (a field of the max result length is
+ * truncated the same way by both parsers).
+ */
+#define MAX_FIELD_SIZE (255)
+
+/**
+ * Max number of fields in a result (every char is a comma).
+ */
+#define MAX_FIELD_COUNT (MAX_RESULT_LENGTH + 1)
+
+static struct {
+  uint32_t randomState;
+  char result[MAX_RESULT_LENGTH];
+  uint8_t resultLength;
+  char const* fields[MAX_FIELD_COUNT + 1];
+  uint16_t fieldCount;
+  uint32_t totalFieldCount;
+} test;
+
+/*------------------------------------------------------------------------------
+ * Original CSV parser (copies every field)
+ *----------------------------------------------------------------------------*/
+
+static char const* originalParseNextCsvField(char* dest, uint8_t destSize, char const* csv, char const* csvEnd) {
+  char* const destEnd = dest + destSize - 1;
+
+  if ((csv >= csvEnd) || !*csv) {
+    *dest = 0;
+    return csvEnd;
+  }
+
+  bool isQuoted = (*csv == '"');
+
+  if (isQuoted) {
+    ++csv;
+  }
+
+  while (true) {
+    if ((csv == csvEnd) || !*csv) {
+      csv = csvEnd;
+      break;
+    }
+
+    if (isQuoted && (*csv == '"')) {
+      char const next = (csv + 1 == csvEnd) ? 0 : csv[1];
+
+      if (next == '"') {
+        if (dest != destEnd) {
+          *dest++ = '"';
+        }
+        csv += 2;
+        continue;
+      } else if (next == ',') {
+        csv += 2;
+        break;
+      } else if (!next) {
+        csv = csvEnd;
+        break;
+      }
+    }
+
+    if (!isQuoted && (*csv == ',')) {
+      ++csv;
+      break;
+    }
+
+    if (dest != destEnd) {
+      *dest++ = *csv;
+    }
+    ++csv;
+  }
+
+  *dest = 0;
+
+  return csv;
+}
+
+/*----------------------------------------------------------------------------*/
+
+static uint32_t getRandom(void) {
+  test.randomState = test.randomState * 1103515245UL + 12345;
+  return test.randomState >> 8;
+}
+
+static void fail(char const* message, uint16_t fieldIndex) {
+  fprintf(stderr, "FAIL: %s (field %u of result: ", message, fieldIndex);
+
+  for (uint8_t i = 0; i < test.resultLength; ++i) {
+    char const c = test.result[i];
+    fprintf(stderr, (c >= ' ') && (c <= '~') ? "%c" : "\\x%02X", (unsigned char)c);
+  }
+
+  fprintf(stderr, ")\n");
+  exit(1);
+}
+
+/**
+ * Generates a result that is mostly made of the chars that matter to CSV
+ * parsing.
+ */
+static void generateResult(void) {
+  static char const CHARS[] = "\"\",,,,aZ0 +";
+
+  // Mostly short results, like real AT results, but up to the max length
+  test.resultLength = (uint8_t)((getRandom() & 3)
+      ? getRandom() % 64
+      : getRandom() % (MAX_RESULT_LENGTH + 1));
+
+  for (uint8_t i = 0; i < test.resultLength; ++i) {
+    uint32_t const random = getRandom();
+
+    test.result[i] = (random % 97)
+        ? CHARS[random % (sizeof(CHARS) - 1)]
+        : '\0';
+  }
+}
+
+static void checkResult(void) {
+  char const* const resultEnd = test.result + test.resultLength;
+  char const* csv = test.result;
+  char value[MAX_FIELD_SIZE];
+  char originalValue[MAX_FIELD_SIZE];
+
+  test.fieldCount = 0;
+
+  do {
+    uint8_t const destSize = (uint8_t)(1 + getRandom() % 32);
+    csv_field_t field;
+
+    test.fields[test.fieldCount] = csv;
+
+    char const* const originalNext = originalParseNextCsvField(originalValue, destSize, csv, resultEnd);
+    char const* const next = parseNextCsvField(value, destSize, csv, resultEnd);
+
+    if ((next != originalNext) || strcmp(value, originalValue)) {
+      fail("parsed field differs", test.fieldCount);
+    }
+
+    if (scanNextCsvField(&field, csv, resultEnd) != next) {
+      fail("scanned field ends elsewhere", test.fieldCount);
+    }
+
+    if ((field.start < csv) || (field.start + field.length > resultEnd)) {
+      fail("field view outside of the result", test.fieldCount);
+    }
+
+    originalParseNextCsvField(originalValue, sizeof(originalValue), csv, resultEnd);
+
+    if (strcmp(copyCsvField(value, sizeof(value), &field), originalValue)) {
+      fail("copied field differs", test.fieldCount);
+    }
+
+    if ((next > resultEnd) || ((next <= csv) && (next != resultEnd))) {
+      fail("field did not move forward", test.fieldCount);
+    }
+
+    if (++test.fieldCount > MAX_FIELD_COUNT) {
+      fail("too many fields", test.fieldCount);
+    }
+
+    csv = next;
+  } while (csv != resultEnd);
+
+  test.fields[test.fieldCount] = resultEnd;
+  test.totalFieldCount += test.fieldCount;
+
+  for (uint16_t i = 0; i < test.fieldCount; ++i) {
+    uint16_t count = (uint16_t)(getRandom() % (test.fieldCount - i + 2));
+
+    if (count > UINT8_MAX) {
+      count = UINT8_MAX;
+    }
+
+    uint16_t const expectedIndex = (i + count < test.fieldCount) ? i + count : test.fieldCount;
+
+    if (skipCsvFields(test.fields[i], resultEnd, (uint8_t)count) != test.fields[expectedIndex]) {
+      fail("skipped fields end elsewhere", i);
+    }
+  }
+}
+
+int main(void) {
+  test.randomState = 1;
+
+  for (uint32_t i = 0; i < ITERATIONS; ++i) {
+    generateResult();
+    checkResult();
+  }
+
+  printf("PASS: %lu results (%lu fields) parsed the same as the original parser\n", ITERATIONS, (unsigned long)test.totalFieldCount);
+
+  return 0;
+}
@@ -0,0 +1,124 @@
+/**
+ * @file
+ * @author Jeff Lau
+ *
+ * Test of the Handset command queue (handset.c) when commands are written
+ * faster than UART3 can send them.
+ *
+ * Text is printed, followed by more commands than the command queue and the
+ * list of deferred commands can hold, without running HANDSET_Task() in
+ * between. Writing commands must never wait for UART3. After HANDSET_Task()
+ * has sent everything, the Handset must have received the text first, then
+ * the commands that fit, in order (with the text re-printed between them),
+ * and none of the dropped commands.
+ */
+
+#include "../sim.h"
+#include "../../mcc_generated_files/mcc.h"
+#include "../../src/telephone/handset.h"
+#include <xc.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/**
+ * Number of commands written (more than the command queue and the deferred
+ * command list can hold together).
+ */
+#define COMMAND_COUNT (80)
+
+/**
+ * First command byte written by the test (a range of commands that are not
+ * text and have no effect on the test).
+ */
+#define FIRST_COMMAND (0x80)
+
+static struct {
+  uint8_t received[256];
+  uint16_t receivedCount;
+} test;
+
+static void handleUart3Transmit(uint8_t data) {
+  if (test.receivedCount < sizeof(test.received)) {
+    test.received[test.receivedCount] = data;
+  }
+
+  ++test.receivedCount;
+}
+
+static void handleHandsetEvent(HANDSET_Event const* event) {
+}
+
+static void fail(char const* message) {
+  fprintf(stderr, "FAIL: %s\n", message);
+  exit(1);
+}
+
+int main(void) {
+  HOST_Options options;
+
+  memset(&options, 0, sizeof(options));
+  options.duration = 10 * 1000000ULL;
+
+  HOST_Initialize(&options);
+  HOST_Peripherals_Initialize();
+  SYSTEM_Initialize();
+  HOST_SetUartTransmitHandler(3, handleUart3Transmit);
+  INTERRUPT_GlobalInterruptHighEnable();
+  INTERRUPT_GlobalInterruptLowEnable();
+
+  HANDSET_Initialize(handleHandsetEvent);
+  HANDSET_PrintString("HELLO");
+
+  uint64_t const startTime = HOST_GetTime();
+
+  for (uint8_t i = 0; i < COMMAND_COUNT; ++i) {
+    HANDSET_SendArbitraryCommand(FIRST_COMMAND + i);
+  }
+
+  if (HOST_GetTime() != startTime) {
+    fail("writing commands waited for UART3");
+  }
+
+  // Send everything
+  for (uint16_t i = 0; i < 1000; ++i) {
+    HANDSET_Task();
+    HOST_Advance(1000);
+  }
+
+  // Each command is preceded by a re-print of the text (an arbitrary command
+  // may change the display in unknown ways, so the text is re-printed before
+  // the next command that is sent with the text queue empty), followed by the
+  // commands that were not dropped, in order
+  uint8_t const text[] = { HANDSET_UartCmd_DELETE_ALL_TEXT, 'H', 'E', 'L', 'L', 'O' };
+  uint16_t commandCount = 0;
+  uint16_t i = 0;
+
+  if ((test.receivedCount < sizeof(text)) || memcmp(test.received, text, sizeof(text))) {
+    fail("text not received first");
+  }
+
+  while (i < test.receivedCount) {
+    if ((test.receivedCount - i >= sizeof(text)) && !memcmp(&test.received[i], text, sizeof(text))) {
+      i += sizeof(text);
+    } else if (test.received[i] == FIRST_COMMAND + commandCount) {
+      ++commandCount;
+      ++i;
+    } else {
+      fail("commands received out of order");
+    }
+  }
+
+  if ((commandCount == 0) || (commandCount >= COMMAND_COUNT)) {
+    fail("wrong number of commands received");
+  }
+
+  printf(
+      "PASS: %u of %u commands received (%u dropped) after the text, without waiting\n",
+      commandCount,
+      COMMAND_COUNT,
+      COMMAND_COUNT - commandCount
+      );
+
+  return 0;
+}
@@ -0,0 +1,270 @@
+/**
+ * @file
+ * @author Jeff Lau
+ *
+ * Test of the timing of sound effect notes (sound.c and the tracks of
+ * tone.c) while the main loop is busy.
+ *
+ * The firmware runs without a Bluetooth module. After boot, several songs are
+ * played one after another on the foreground channel. After each main loop
+ * pass, the main loop is kept busy for a pseudo-random amount of time (up to
+ * MAX_BUSY_TIME), like a pass that writes EEPROM or handles UART traffic.
+ *
+ * Note onsets are found in the rendered sound output (DAC1): a note starts on
+ * the first non-silent sample after a silence. Only notes that follow a rest
+ * (including the space after a spaced note) can be found this way. The sample
+ * position of each onset, relative to the first onset of the song, must be
+ * exactly the sum of the preceding note durations of the song. (The notes of
+ * each song are checked against the original note tables by
+ * tests/song_decode.)
+ */
+
+#include "../sim.h"
+#include "../../src/sound/song.h"
+#include "../../src/sound/sound.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/**
+ * Time after power-up until the first song is started (us).
+ */
+#define SETTLE_TIME (5 * 1000000ULL)
+
+/**
+ * Time between the end of one song and the start of the next (us).
+ */
+#define SONG_GAP_TIME (1000000ULL)
+
+/**
+ * Max time that the main loop is kept busy after a pass (us).
+ */
+#define MAX_BUSY_TIME (25000)
+
+/**
+ * Number of output samples per 1ms.
+ */
+#define SAMPLES_PER_MS (10)
+
+/**
+ * DAC1 value of a silent sample.
+ */
+#define SILENT_SAMPLE (128)
+
+/**
+ * Number of consecutive silent samples before a non-silent sample that make
+ * it a note onset (longer than any run of silent samples within a note).
+ */
+#define MIN_SILENT_SAMPLES (10)
+
+#define MAX_ONSETS (512)
+
+/**
+ * Songs of all sound effects (see sound.c).
+ */
+extern uint8_t const* const effects[];
+
+static SOUND_Effect const SONGS[] = {
+  SOUND_Effect_AXEL_F,
+  SOUND_Effect_NOKIA,
+  SOUND_Effect_MEGALOVANIA,
+  SOUND_Effect_CARPHONE,
+  SOUND_Effect_TETRIS_MUSIC
+};
+
+#define SONG_COUNT (sizeof(SONGS) / sizeof(SONGS[0]))
+
+typedef struct {
+  uint32_t onsets[MAX_ONSETS];
+  uint16_t onsetCount;
+} onsets_t;
+
+static struct {
+  uint8_t songIndex;
+  bool isPlaying;
+  uint64_t nextStartTime;
+  uint32_t randomState;
+  onsets_t expected;
+  onsets_t rendered;
+  uint32_t sampleCount;
+  uint32_t silentSampleCount;
+  uint16_t totalOnsetCount;
+  uint32_t maxBusyTime;
+} test;
+
+static void fail(char const* message, uint16_t onset) {
+  fprintf(stderr, "FAIL: sound effect %u, onset %u: %s\n", SONGS[test.songIndex], onset, message);
+  exit(1);
+}
+
+static void addOnset(onsets_t* onsets, uint32_t sample) {
+  if (onsets->onsetCount == MAX_ONSETS) {
+    fail("too many onsets", onsets->onsetCount);
+  }
+
+  onsets->onsets[onsets->onsetCount++] = sample;
+}
+
+/**
+ * Finds the expected note onsets of a song.
+ *
+ * @return The duration of the song (samples).
+ */
+static uint32_t getExpectedOnsets(SOUND_Effect soundEffect, onsets_t* onsets) {
+  song_player_t player;
+  song_note_t note;
+  uint32_t sample = 0;
+  bool isSilent = true;
+
+  onsets->onsetCount = 0;
+  SONG_Start(&player, effects[soundEffect]);
+
+  while (SONG_GetNextNote(&player, false, &note)) {
+    bool const isNoteSilent = !note.tone1 && !note.tone2;
+
+    if (isSilent && !isNoteSilent) {
+      addOnset(onsets, sample);
+    }
+
+    isSilent = isNoteSilent;
+    sample += (uint32_t)note.duration * SAMPLES_PER_MS;
+  }
+
+  return sample;
+}
+
+static void handleDacOutput(uint8_t value) {
+  ++test.sampleCount;
+
+  if (value == SILENT_SAMPLE) {
+    ++test.silentSampleCount;
+    return;
+  }
+
+  if (test.isPlaying && (test.silentSampleCount >= MIN_SILENT_SAMPLES)) {
+    addOnset(&test.rendered, test.sampleCount - 1);
+  }
+
+  test.silentSampleCount = 0;
+}
+
+/**
+ * Compares the rendered onsets of the current song with its expected onsets.
+ */
+static void checkOnsets(void) {
+  onsets_t const* const expected = &test.expected;
+  onsets_t const* const rendered = &test.rendered;
+
+  if (rendered->onsetCount != expected->onsetCount) {
+    fprintf(
+        stderr,
+        "FAIL: sound effect %u: %u onsets rendered, %u expected\n",
+        SONGS[test.songIndex],
+        rendered->onsetCount,
+        expected->onsetCount
+        );
+    exit(1);
+  }
+
+  for (uint16_t i = 1; i < expected->onsetCount; ++i) {
+    int32_t const error =
+        (int32_t)(rendered->onsets[i] - rendered->onsets[0]) -
+        (int32_t)(expected->onsets[i] - expected->onsets[0]);
+
+    if (error) {
+      fprintf(
+          stderr,
+          "FAIL: sound effect %u, onset %u: %+d samples from the song's timing\n",
+          SONGS[test.songIndex],
+          i,
+          error
+          );
+      exit(1);
+    }
+  }
+
+  test.totalOnsetCount += expected->onsetCount;
+}
+
+static uint32_t getRandomBusyTime(void) {
+  test.randomState = test.randomState * 1103515245UL + 12345;
+  return (test.randomState >> 8) % (MAX_BUSY_TIME + 1);
+}
+
+static void handleMainLoopPass(void) {
+  uint64_t const now = HOST_GetTime();
+
+  if (now >= test.nextStartTime) {
+    if (test.isPlaying) {
+      checkOnsets();
+
+      if (++test.songIndex == SONG_COUNT) {
+        HOST_End();
+        return;
+      }
+    }
+
+    uint32_t const duration = getExpectedOnsets(SONGS[test.songIndex], &test.expected);
+
+    test.rendered.onsetCount = 0;
+    test.isPlaying = true;
+    // Includes time for the handset audio output to be switched
+    test.nextStartTime = now + (uint64_t)duration * (1000 / SAMPLES_PER_MS) + SONG_GAP_TIME;
+
+    SOUND_PlayEffect(
+        SOUND_Channel_FOREGROUND,
+        SOUND_Target_SPEAKER,
+        VOLUME_Mode_SPEAKER,
+        SONGS[test.songIndex],
+        false
+        );
+  }
+
+  if (test.isPlaying) {
+    uint32_t const busyTime = getRandomBusyTime();
+
+    if (busyTime > test.maxBusyTime) {
+      test.maxBusyTime = busyTime;
+    }
+
+    HOST_Advance(busyTime);
+  }
+}
+
+static void handleEnd(void) {
+  if (test.songIndex != SONG_COUNT) {
+    fprintf(stderr, "FAIL: only %u of %u songs played\n", test.songIndex, (unsigned int)SONG_COUNT);
+    exit(1);
+  }
+
+  printf(
+      "PASS: %u note onsets of %u songs exact to the sample, with the main loop busy for up to %.1f ms per pass\n",
+      test.totalOnsetCount,
+      (unsigned int)SONG_COUNT,
+      (double)test.maxBusyTime / 1000.0
+      );
+}
+
+void FIRMWARE_main(void);
+
+int main(void) {
+  HOST_Options options;
+
+  options.duration = 600 * 1000000ULL;
+  options.mainLoopPassTime = 50;
+  options.isFirmwareOutputEnabled = false;
+  options.isReportEnabled = false;
+  options.mainLoopPassHandler = handleMainLoopPass;
+  options.endHandler = handleEnd;
+
+  test.nextStartTime = SETTLE_TIME;
+  test.randomState = 1;
+
+  HOST_Initialize(&options);
+  HOST_Peripherals_Initialize();
+  HOST_SetDacOutputHandler(handleDacOutput);
+
+  FIRMWARE_main();
+
+  return 1;
+}
@@ -0,0 +1,177 @@
+/**
+ * @file
+ * @author Jeff Lau
+ *
+ * Test of syncing a 2,000-entry phonebook from the phone into program flash
+ * (phonebook.c), with a simulated BM62 Bluetooth Module (see bm62.h).
+ *
+ * After the sync and both indexes are complete, every entry must be
+ * accessible through the sorted name index, in alphabetic order (case
+ * insensitive), exactly once; alpha scan must find the first name for each
+ * letter; and caller ID lookup must find every entry by its phone number.
+ */
+
+#include "../sim.h"
+#include "../bm62.h"
+#include "../../src/storage/phonebook.h"
+#include <ctype.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+
+#define PHONEBOOK_COUNT (2000)
+
+static struct {
+  bool isEntrySeen[PHONEBOOK_COUNT + 1];
+} test;
+
+/**
+ * Names are a pseudo-random word (with a lower or upper case first letter),
+ * followed by the phonebook index, so that each name is unique and identifies
+ * its entry.
+ */
+static void getPhonebookEntry(uint16_t index, char* number, char* name) {
+  uint32_t hash = index * 2654435761UL;
+  uint8_t const wordLength = 3 + (index % 5);
+
+  for (uint8_t i = 0; i < wordLength; ++i) {
+    name[i] = (char)('a' + (hash >> 8) % 26);
+    hash = hash * 1103515245UL + 12345;
+  }
+
+  if (index & 1) {
+    name[0] = (char)toupper(name[0]);
+  }
+
+  sprintf(name + wordLength, " %u", index);
+  sprintf(number, "(555) %03u-%04u", index / 1000, (index * 7919U) % 10000);
+}
+
+static void fail(char const* message, uint16_t position) {
+  fprintf(stderr, "FAIL: %s (position %u)\n", message, position);
+  exit(1);
+}
+
+static void handleMainLoopPass(void) {
+  if (BM62_IsConnected() && !PHONEBOOK_IsSyncing() && PHONEBOOK_IsIndexed()) {
+    HOST_End();
+  }
+}
+
+static void checkSortedNameIndex(void) {
+  char previousName[PHONEBOOK_MAX_NAME_LENGTH + 1] = "";
+
+  for (uint16_t position = 0; position < PHONEBOOK_COUNT; ++position) {
+    char name[PHONEBOOK_MAX_NAME_LENGTH + 1];
+    char expectedName[32];
+    char number[MAX_EXTENDED_PHONE_NUMBER_LENGTH + 1];
+    char expectedNumber[32];
+
+    PHONEBOOK_GetName(position, name);
+    char const* const indexText = strchr(name, ' ');
+    unsigned int const index = indexText ? (unsigned int)atoi(indexText + 1) : 0;
+
+    if (!index || (index > PHONEBOOK_COUNT) || test.isEntrySeen[index]) {
+      fail("missing or duplicate entry", position);
+    }
+
+    test.isEntrySeen[index] = true;
+    getPhonebookEntry(index, expectedNumber, expectedName);
+
+    if (strcmp(name, expectedName)) {
+      fail("wrong name", position);
+    }
+
+    if (strncasecmp(previousName, name, PHONEBOOK_MAX_NAME_LENGTH) > 0) {
+      fail("names out of order", position);
+    }
+
+    strcpy(previousName, name);
+
+    // Caller ID lookup by the number as received from the phone
+    if (!PHONEBOOK_FindName(expectedNumber, name) || strcmp(name, expectedName)) {
+      fail("caller ID lookup failed", position);
+    }
+
+    if (!PHONEBOOK_GetNumber(position, number)[0]) {
+      fail("no number", position);
+    }
+  }
+}
+
+static void checkAlphaScan(void) {
+  for (char letter = 'a'; letter <= 'z'; ++letter) {
+    uint16_t const position = PHONEBOOK_GetFirstPositionForLetter(letter);
+    char name[PHONEBOOK_MAX_NAME_LENGTH + 1];
+
+    if (position == PHONEBOOK_NO_POSITION) {
+      fail("no position for letter", letter);
+    }
+
+    // Every letter is used by some names, so the first name for the letter
+    // must start with it, and the name before it must not.
+    if (tolower(PHONEBOOK_GetName(position, name)[0]) != letter) {
+      fail("wrong first name for letter", position);
+    }
+
+    if (position && (tolower(PHONEBOOK_GetName(position - 1, name)[0]) >= letter)) {
+      fail("not the first name for letter", position);
+    }
+  }
+}
+
+static void handleEnd(void) {
+  if (!PHONEBOOK_IsIndexed() || (PHONEBOOK_GetCount() != PHONEBOOK_COUNT)) {
+    fprintf(stderr, "FAIL: %u of %u entries synced and indexed\n", PHONEBOOK_GetCount(), PHONEBOOK_COUNT);
+    exit(1);
+  }
+
+  char name[PHONEBOOK_MAX_NAME_LENGTH + 1];
+
+  checkSortedNameIndex();
+  checkAlphaScan();
+
+  if (PHONEBOOK_FindName("5550000000", name)) {
+    fprintf(stderr, "FAIL: found a number that is not in the phonebook\n");
+    exit(1);
+  }
+
+  printf(
+      "PASS: %u entries synced and indexed after %.3f s (%u main loop passes)\n",
+      PHONEBOOK_COUNT,
+      (double)HOST_GetTime() / 1000000.0,
+      HOST_GetMainLoopPassCount()
+      );
+}
+
+void FIRMWARE_main(void);
+
+int main(void) {
+  HOST_Options options;
+  BM62_Options bm62Options;
+
+  options.duration = 600 * 1000000ULL;
+  options.mainLoopPassTime = 50;
+  options.isFirmwareOutputEnabled = false;
+  options.isReportEnabled = false;
+  options.mainLoopPassHandler = handleMainLoopPass;
+  options.endHandler = handleEnd;
+
+  memset(&bm62Options, 0, sizeof(bm62Options));
+  bm62Options.powerOnTime = 500000;
+  bm62Options.ackDelay = 2000;
+  bm62Options.linkBackDelay = 1000000;
+  bm62Options.atResponseDelay = 20000;
+  bm62Options.phoneName = "Host Phone";
+  bm62Options.phonebookCount = PHONEBOOK_COUNT;
+  bm62Options.getPhonebookEntry = getPhonebookEntry;
+
+  HOST_Initialize(&options);
+  HOST_Peripherals_Initialize();
+  BM62_Initialize(&bm62Options);
+
+  FIRMWARE_main();
+
+  return 1;
+}
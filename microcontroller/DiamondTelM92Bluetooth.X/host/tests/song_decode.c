@@ -0,0 +1,807 @@
+/**
+ * @file
+ * @author Jeff Lau
+ *
+ * Test of the song format and player (song.h) against the sound effect tables
+ * that they replaced.
+ *
+ * Each sound effect is decoded from its song (sound.c), both once and
+ * looping, and must produce exactly the same sequence of notes (tones and
+ * durations) as the original table of notes and repeat rule of the same sound
+ * effect, as they were stepped through by the original SOUND_Task().
+ *
+ * A song with repeated sections that are nested deeper than SONG_REPEAT_DEPTH
+ * must play the sections that are nested too deeply only once, and otherwise
+ * repeat as normal.
+ */
+
+#include "../../src/sound/song.h"
+#include "../../src/sound/sound.h"
+#include <stdio.h>
+#include <stdlib.h>
+
+/**
+ * Number of notes that are compared for a looping sound effect (several
+ * times through the longest song).
+ */
+#define LOOPING_NOTE_COUNT (5000)
+
+/**
+ * Max number of notes that are compared for a sound effect that is played
+ * once.
+ */
+#define MAX_NOTE_COUNT (2000)
+
+/**
+ * Songs of all sound effects (see sound.c).
+ */
+extern uint8_t const* const effects[];
+
+/*----------------------------------------------------------------------------
+ * Original sound effect tables and note stepping (sound.c before song.h),
+ * with the table of sound effects renamed to originalEffects[]
+ *--------------------------------------------------------------------------*/
+
+typedef struct Note {
+  tone_t tone1;
+  tone_t tone2;
+  uint16_t duration;
+} Note;
+
+typedef struct Repeat {
+  uint8_t count;
+  uint8_t afterIndex;
+  uint8_t returnToIndex;
+} Repeat;
+
+typedef struct {
+  Note const* notes;
+  uint8_t length;
+  Repeat repeat;
+} SoundEffect;
+
+typedef struct {
+  bool on;
+  SoundEffect const* effect;
+  uint8_t noteIndex;
+  uint8_t internalRepeatCount;
+  bool repeatEffect;
+} SoundEffectState;
+
+static Note const TONE_LOW_CONTINUOUS_NOTES[] = {
+  { TONE_LOW, TONE_OFF, 0 }    
+};
+
+static Note const TONE_HIGH_CONTINUOUS_NOTES[] = {
+  { TONE_HIGH, TONE_OFF, 0 }    
+};
+
+static Note const TONE_DUAL_CONTINUOUS_NOTES[] = {
+  { TONE_LOW, TONE_HIGH, 0 }    
+};
+
+static Note const ALERT_NOTES[] = {
+  { TONE_HIGH, TONE_LOW, 25 },
+  { TONE_OFF, TONE_OFF, 25 }    
+};
+
+static Note const REORDER_TONE_NOTES[] = {
+  { TONE_HIGH, TONE_OFF, 250 },
+  { TONE_LOW, TONE_OFF, 250 }    
+};
+
+static Note const BT_CONNECT_NOTES[] = {
+  { TONE_LOW, TONE_OFF, 250 },
+  { TONE_HIGH, TONE_OFF, 250 }
+};
+
+static Note const BT_DISCONNECT_NOTES[] = {
+  { TONE_HIGH, TONE_OFF, 250 },
+  { TONE_LOW, TONE_OFF, 250 }    
+};
+
+static Note const CALL_DISCONNECT_NOTES[] = {
+  { TONE_LOW, TONE_OFF, 250 },
+  { TONE_OFF, TONE_OFF, 250 },    
+};
+
+static Note const CLASSIC_RINGTONE_NOTES[] = {
+  { TONE_HIGH, TONE_LOW, 25 },
+  { TONE_OFF, TONE_OFF, 25 },    
+  { TONE_OFF, TONE_OFF, 3000 },    
+};
+
+static Note const SMOOTH_RINGTONE_NOTES[] = {
+  { TONE_HIGH, TONE_OFF, 25 },
+  { TONE_LOW, TONE_OFF, 25 },    
+  { TONE_OFF, TONE_OFF, 3000 },    
+};
+
+
+#define SPACE (50)
+#define NOTE(note, duration) { TONE_##note, TONE_OFF, duration - SPACE }, { TONE_OFF, TONE_OFF, SPACE }
+#define DUAL_NOTE(note1, note2, duration) { TONE_##note1, TONE_##note2, duration - SPACE }, { TONE_OFF, TONE_OFF, SPACE }
+#define NOTE_SLUR(note, duration) { TONE_##note, TONE_OFF, duration }
+#define DUAL_NOTE_SLUR(note1, note2, duration) { TONE_##note1, TONE_##note2, duration }
+#define REST(duration) { TONE_OFF, TONE_OFF, duration }
+
+static Note const AXEL_F_NOTES[] = {
+  // Measure 1
+  NOTE(F5, 500),
+  NOTE(GS5, 250 + 125),
+  NOTE(F5, 250),
+  NOTE(F5, 125),
+  NOTE(AS5, 250),
+  NOTE(F5, 250),
+  NOTE(DS5, 250),
+
+  // Measure 2
+  NOTE(F5, 500),
+  NOTE(C6, 250 + 125),
+  NOTE(F5, 250),
+  NOTE(F5, 125),
+  NOTE(CS6, 250),
+  NOTE(C6, 250),
+  NOTE(GS5, 250),
+
+  // Measure 3
+  NOTE(F5, 250),
+  NOTE(C6, 250),
+  NOTE(F6, 250),
+  NOTE(F5, 125),
+  NOTE(DS5, 250),
+  NOTE(DS5, 125),
+  NOTE(C5, 250),
+  NOTE(G5, 250),
+  NOTE_SLUR(F5, 250),
+  
+  // Measure 4
+  NOTE(F5, 1000),
+  REST(1000),
+};
+
+static Note const NOKIA_NOTES[] = {
+  NOTE_SLUR(E6, 125),
+  NOTE_SLUR(D6, 125),
+  NOTE_SLUR(FS5, 250),
+  NOTE_SLUR(GS5, 250),
+  
+  NOTE_SLUR(CS6, 125),
+  NOTE_SLUR(B5, 125),
+  NOTE_SLUR(D5, 250),
+  NOTE_SLUR(E5, 250),
+
+  NOTE_SLUR(B5, 125),
+  NOTE_SLUR(A5, 125),
+  NOTE_SLUR(CS5, 250),
+  NOTE_SLUR(E5, 250),
+  
+  NOTE_SLUR(A5, 750),
+  
+  REST(750),
+};
+
+static Note const MEGALOVANIA_NOTES[] = {
+  // Measure 1
+  DUAL_NOTE(D4, D5, 125),
+  DUAL_NOTE(D4, D5, 125),
+  DUAL_NOTE(D5, D6, 125),
+  REST(125),
+  DUAL_NOTE(A4, A5, 125),
+  REST(125),
+  REST(125),
+  DUAL_NOTE(GS4, GS5, 125),
+  REST(125),
+  DUAL_NOTE(G4, G5, 125),
+  REST(125),
+  DUAL_NOTE(F4, F5, 250),
+  DUAL_NOTE(D4, D5, 125),
+  DUAL_NOTE(F4, F5, 125),
+  DUAL_NOTE(F4, F5, 125),
+
+  // Measure 2
+  DUAL_NOTE(C4, C5, 125),
+  DUAL_NOTE(C4, C5, 125),
+  DUAL_NOTE(D5, D6, 125),
+  REST(125),
+  DUAL_NOTE(A4, A5, 125),
+  REST(125),
+  REST(125),
+  DUAL_NOTE(GS4, GS5, 125),
+  REST(125),
+  DUAL_NOTE(G4, G5, 125),
+  REST(125),
+  DUAL_NOTE(F4, F5, 250),
+  DUAL_NOTE(D4, D5, 125),
+  DUAL_NOTE(F4, F5, 125),
+  DUAL_NOTE(F4, F5, 125),
+
+  // Measure 3
+  DUAL_NOTE(B3, B4, 125),
+  DUAL_NOTE(B3, B4, 125),
+  DUAL_NOTE(D5, D6, 125),
+  REST(125),
+  DUAL_NOTE(A4, A5, 125),
+  REST(125),
+  REST(125),
+  DUAL_NOTE(GS4, GS5, 125),
+  REST(125),
+  DUAL_NOTE(G4, G5, 125),
+  REST(125),
+  DUAL_NOTE(F4, F5, 250),
+  DUAL_NOTE(D4, D5, 125),
+  DUAL_NOTE(F4, F5, 125),
+  DUAL_NOTE(F4, F5, 125),
+
+  // Measure 4
+  DUAL_NOTE(AS3, AS4, 125),
+  DUAL_NOTE(AS3, AS4, 125),
+  DUAL_NOTE(D5, D6, 125),
+  REST(125),
+  DUAL_NOTE(A4, A5, 125),
+  REST(125),
+  REST(125),
+  DUAL_NOTE(GS4, GS5, 125),
+  REST(125),
+  DUAL_NOTE(G4, G5, 125),
+  REST(125),
+  DUAL_NOTE(F4, F5, 250),
+  DUAL_NOTE(D4, D5, 125),
+  DUAL_NOTE(F4, F5, 125),
+  DUAL_NOTE(F4, F5, 125),
+};
+
+static Note const CARPHONE_NOTES[] = {
+  // Measure 1
+  DUAL_NOTE(DS5, DS6, 220), // Call-
+  DUAL_NOTE(DS5, DS6, 220), // -ing
+  DUAL_NOTE(DS5, DS6, 220), // an-
+  DUAL_NOTE(DS5, DS6, 220), // -y-
+  DUAL_NOTE(DS5, DS6, 440), // -one
+  DUAL_NOTE(DS5, DS6, 220), // an-
+  DUAL_NOTE(DS5, DS6, 220), // y-
+  
+  DUAL_NOTE_SLUR(DS5, DS6, 220), // -one
+  DUAL_NOTE(D5, D6, 220),   // I
+  DUAL_NOTE(D5, D6, 440),   // want
+  DUAL_NOTE(D5, D6, 220),   // when
+  DUAL_NOTE(D5, D6, 220),   // I'm
+  DUAL_NOTE(D5, D6, 220),   // on
+  DUAL_NOTE(D5, D6, 220),   // my
+  
+  DUAL_NOTE(DS5, DS6, 440), // car
+  DUAL_NOTE(AS4, AS5, 440), // phone
+  REST(220),
+  DUAL_NOTE(AS4, AS5, 220), // my
+  DUAL_NOTE(DS5, DS6, 440), // car
+  
+  DUAL_NOTE(AS4, AS5, 440), // phone
+  REST(440),
+  REST(880),
+
+  // Measure 2
+  DUAL_NOTE(DS5, DS6, 220), // I
+  DUAL_NOTE(DS5, DS6, 220), // can
+  DUAL_NOTE(DS5, DS6, 440), // call
+  DUAL_NOTE(DS5, DS6, 220), // an-
+  DUAL_NOTE(DS5, DS6, 220), // -y-
+  DUAL_NOTE(DS5, DS6, 220), // -one
+  DUAL_NOTE_SLUR(DS5, DS6, 220), // I
+  
+  DUAL_NOTE(D5, D6, 440),   // want
+  REST(440),
+  DUAL_NOTE(D5, D6, 220),   // when
+  DUAL_NOTE(D5, D6, 220),   // I'm
+  DUAL_NOTE(D5, D6, 220),   // on
+  DUAL_NOTE(D5, D6, 220),   // my
+  
+  DUAL_NOTE(DS5, DS6, 440), // car
+  DUAL_NOTE(AS4, AS5, 440), // phone
+  REST(220),
+  DUAL_NOTE(AS4, AS5, 220), // my
+  DUAL_NOTE(DS5, DS6, 440), // car
+  
+  DUAL_NOTE(AS4, AS5, 440), // phone
+  REST(440),
+  REST(880),
+
+  // Measure 3
+  DUAL_NOTE(DS5, DS6, 220), // Call-
+  DUAL_NOTE(DS5, DS6, 220), // -ing
+  DUAL_NOTE(DS5, DS6, 220), // an-
+  DUAL_NOTE(DS5, DS6, 220), // -y-
+  DUAL_NOTE(DS5, DS6, 440), // -one
+  DUAL_NOTE(DS5, DS6, 220), // an-
+  DUAL_NOTE(DS5, DS6, 220), // y-
+  
+  DUAL_NOTE_SLUR(DS5, DS6, 220), // -one
+  DUAL_NOTE(F5, F6, 220),   // I
+  DUAL_NOTE(F5, F6, 440),   // want
+  DUAL_NOTE(F5, F6, 220),   // when
+  DUAL_NOTE(F5, F6, 220),   // I'm
+  DUAL_NOTE(F5, F6, 220),   // on
+  DUAL_NOTE(F5, F6, 220),   // my
+  
+  DUAL_NOTE(FS5, FS6, 440), // car
+  DUAL_NOTE(DS5, DS6, 440), // phone
+  REST(220),
+  DUAL_NOTE(DS5, DS6, 220), // my
+  DUAL_NOTE(F5, F6, 440),   // car
+  
+  DUAL_NOTE_SLUR(AS5, AS6, 660), // pho-
+  DUAL_NOTE_SLUR(GS5, GS6, 220), // -o-
+  DUAL_NOTE(FS5, FS6, 440),      // -one
+  REST(440),
+};
+
+static Note const TETRIS_USER_MOVE_NOTES[] = {
+  { TONE_A5, 0, 25 }
+};
+
+static Note const TETRIS_USER_ROTATE_NOTES[] = {
+  { TONE_E6, TONE_E5, 20 },
+  { 0, 0, 20 },
+  { TONE_E6, TONE_E5, 20 }
+};
+
+static Note const TETRIS_PIECE_PLACED_NOTES[] = {
+  { TONE_G5, TONE_G4, 25 },
+  { TONE_F5, TONE_F4, 25 }
+};
+
+static Note const TETRIS_CLEAR_2_LINES_NOTES[] = {
+  { TONE_G5, 0, 50 },
+  { TONE_A5, 0, 50 },
+  { TONE_D6, 0, 50 },
+};
+
+static Note const TETRIS_CLEAR_3_LINES_NOTES[] = {
+  { TONE_F5, 0, 50 },
+  { TONE_G5, 0, 50 },
+  { TONE_A5, 0, 50 },
+  { TONE_G5, 0, 50 },
+  { TONE_A5, 0, 50 },
+  { TONE_D6, 0, 50 },
+};
+
+static Note const TETRIS_LOSE_NOTES[] = {
+  { TONE_G5, TONE_G4, 25 },
+  { TONE_F5, TONE_F4, 25 }
+};
+
+static Note const TETRIS_MUSIC_NOTES[] = {
+  // Measure 1
+  DUAL_NOTE(B4, E5, 400),
+  DUAL_NOTE(GS4, B4, 200),
+  DUAL_NOTE(A4, C5, 200),
+  DUAL_NOTE(B4, D5, 200),
+  NOTE(E5, 100),
+  NOTE(D5, 100),
+  DUAL_NOTE(A4, C5, 200),
+  DUAL_NOTE(GS4, B4, 200),
+  
+  // Measure 2
+  DUAL_NOTE(E4, A4, 400),
+  DUAL_NOTE(E4, A4, 200),
+  DUAL_NOTE(A4, C5, 200),
+  DUAL_NOTE(C5, E5, 400),
+  DUAL_NOTE(B4, D5, 200),
+  DUAL_NOTE(A4, C5, 200),
+  
+  // Measure 3
+  DUAL_NOTE_SLUR(GS4, B4, 100),
+  DUAL_NOTE_SLUR(GS4, B4, 100),
+  DUAL_NOTE(E4, B4, 200),
+  NOTE(GS4, 200),
+  DUAL_NOTE(A4, C5, 200),
+  DUAL_NOTE(B4, D5, 400),
+  DUAL_NOTE(C5, E5, 400),
+  
+  // Measure 4
+  DUAL_NOTE(A4, C5, 400),
+  DUAL_NOTE(E4, A4, 400),
+  DUAL_NOTE(E4, A4, 400),
+  DUAL_NOTE(B3, B3, 200),
+  DUAL_NOTE(C4, C4, 200),
+  
+  // Measure 5
+  DUAL_NOTE(D4, D4, 200),
+  DUAL_NOTE(F4, D5, 400),
+  DUAL_NOTE(A4, F5, 200),
+  DUAL_NOTE(C5, A5, 200),
+  DUAL_NOTE(C5, A5, 100),
+  DUAL_NOTE(C5, A5, 100),
+  DUAL_NOTE(B4, G5, 200),
+  DUAL_NOTE(A4, F5, 200),
+
+  // Measure 6
+  DUAL_NOTE(G4, E5, 400),
+  REST(200),
+  DUAL_NOTE(E4, C5, 200),
+  DUAL_NOTE_SLUR(G4, E5, 200),
+  DUAL_NOTE_SLUR(A4, E5, 100),
+  DUAL_NOTE(G4, E5, 100),
+  DUAL_NOTE(F4, D5, 200),
+  DUAL_NOTE(E4, C5, 200),
+  
+  // Measure 7
+  DUAL_NOTE_SLUR(GS4, B4, 200),
+  DUAL_NOTE(E4, B4, 200),
+  DUAL_NOTE(GS4, B4, 200),
+  DUAL_NOTE(A4, C4, 200),
+  DUAL_NOTE_SLUR(B4, D5, 200),
+  DUAL_NOTE(GS4, D5, 200),
+  DUAL_NOTE_SLUR(C5, E5, 200),
+  DUAL_NOTE(GS4, E5, 200),
+  
+  // Measure 8
+  DUAL_NOTE_SLUR(A4, C5, 100),
+  DUAL_NOTE_SLUR(C5, C5, 100),
+  DUAL_NOTE(E4, C5, 200),
+  DUAL_NOTE(E4, A4, 400),
+  DUAL_NOTE(E4, A4, 400),
+  REST(400),
+  
+  // Measure 9
+  DUAL_NOTE_SLUR(A3, E5, 200),
+  DUAL_NOTE_SLUR(E4, E5, 200),
+  DUAL_NOTE_SLUR(A3, E5, 200),
+  DUAL_NOTE(E4, E5, 200),
+  DUAL_NOTE_SLUR(A3, C5, 200),
+  DUAL_NOTE_SLUR(E4, C5, 200),
+  DUAL_NOTE_SLUR(A3, C5, 200),
+  DUAL_NOTE(E4, C5, 200),
+  
+  // Measure 10
+  DUAL_NOTE_SLUR(GS3, D5, 200),
+  DUAL_NOTE_SLUR(E4, D5, 200),
+  DUAL_NOTE_SLUR(GS3, D5, 200),
+  DUAL_NOTE(E4, D5, 200),
+  DUAL_NOTE_SLUR(GS3, B4, 200),
+  DUAL_NOTE_SLUR(E4, B4, 200),
+  DUAL_NOTE_SLUR(GS3, B4, 200),
+  DUAL_NOTE(E4, B4, 200),
+  
+  // Measure 11
+  DUAL_NOTE_SLUR(A3, C5, 200),
+  DUAL_NOTE_SLUR(E4, C5, 200),
+  DUAL_NOTE_SLUR(A3, C5, 200),
+  DUAL_NOTE(E4, C5, 200),
+  DUAL_NOTE_SLUR(A3, A4, 200),
+  DUAL_NOTE_SLUR(E4, A4, 200),
+  DUAL_NOTE_SLUR(A3, A4, 200),
+  DUAL_NOTE(E4, A4, 200),
+  
+  // Measure 12
+  DUAL_NOTE_SLUR(GS3, GS4, 200),
+  DUAL_NOTE_SLUR(E4, GS4, 200),
+  DUAL_NOTE_SLUR(GS3, GS4, 200),
+  DUAL_NOTE(E4, GS4, 200),
+  DUAL_NOTE_SLUR(GS3, B4, 400),
+  REST(400),
+  
+  // Measure 13
+  DUAL_NOTE_SLUR(A3, E5, 200),
+  DUAL_NOTE_SLUR(E4, E5, 200),
+  DUAL_NOTE_SLUR(A3, E5, 200),
+  DUAL_NOTE(E4, E5, 200),
+  DUAL_NOTE_SLUR(A3, C5, 200),
+  DUAL_NOTE_SLUR(E4, C5, 200),
+  DUAL_NOTE_SLUR(A3, C5, 200),
+  DUAL_NOTE(E4, C5, 200),
+  
+  // Measure 14
+  DUAL_NOTE_SLUR(GS3, D5, 200),
+  DUAL_NOTE_SLUR(E4, D5, 200),
+  DUAL_NOTE_SLUR(GS3, D5, 200),
+  DUAL_NOTE(E4, D5, 200),
+  DUAL_NOTE_SLUR(GS3, B4, 200),
+  DUAL_NOTE_SLUR(E4, B4, 200),
+  DUAL_NOTE_SLUR(GS3, B4, 200),
+  DUAL_NOTE(E4, B4, 200),
+  
+  // Measure 15
+  DUAL_NOTE_SLUR(A3, C5, 200),
+  DUAL_NOTE(E4, C5, 200),
+  DUAL_NOTE_SLUR(A3, E5, 200),
+  DUAL_NOTE(E4, E5, 200),
+  DUAL_NOTE_SLUR(A3, A5, 200),
+  DUAL_NOTE_SLUR(E4, A5, 200),
+  DUAL_NOTE_SLUR(A3, A5, 200),
+  DUAL_NOTE(E4, A5, 200),
+  
+  // Measure 16
+  DUAL_NOTE_SLUR(GS3, GS5, 200),
+  DUAL_NOTE_SLUR(E4, GS5, 200),
+  DUAL_NOTE_SLUR(GS3, GS5, 200),
+  DUAL_NOTE(E4, GS5, 200),
+  DUAL_NOTE(GS3, GS5, 400),
+  REST(400)
+};
+
+static SoundEffect const originalEffects[] = {
+  {
+    NULL,
+    0
+  },
+  {
+    TONE_LOW_CONTINUOUS_NOTES,
+    sizeof(TONE_LOW_CONTINUOUS_NOTES) / sizeof(Note)
+  },
+  {
+    TONE_HIGH_CONTINUOUS_NOTES,
+    sizeof(TONE_HIGH_CONTINUOUS_NOTES) / sizeof(Note)
+  },
+  {
+    TONE_DUAL_CONTINUOUS_NOTES,
+    sizeof(TONE_DUAL_CONTINUOUS_NOTES) / sizeof(Note)
+  },
+  {
+    ALERT_NOTES,
+    sizeof(ALERT_NOTES) / sizeof(Note),
+  },
+  {
+    REORDER_TONE_NOTES,
+    sizeof(REORDER_TONE_NOTES) / sizeof(Note)
+  },
+  {
+    BT_CONNECT_NOTES,
+    sizeof(BT_CONNECT_NOTES) / sizeof(Note)
+  },
+  {
+    BT_DISCONNECT_NOTES,
+    sizeof(BT_DISCONNECT_NOTES) / sizeof(Note)
+  },
+  {
+    CALL_DISCONNECT_NOTES,
+    sizeof(CALL_DISCONNECT_NOTES) / sizeof(Note),
+    {
+      2
+    }
+  },
+  {
+    CLASSIC_RINGTONE_NOTES,
+    sizeof(CLASSIC_RINGTONE_NOTES) / sizeof(Note),
+    {
+      19,
+      1
+    }
+  },
+  {
+    SMOOTH_RINGTONE_NOTES,
+    sizeof(SMOOTH_RINGTONE_NOTES) / sizeof(Note),
+    {
+      19,
+      1
+    }
+  },
+  {
+    AXEL_F_NOTES,
+    sizeof(AXEL_F_NOTES) / sizeof(Note)
+  },
+  {
+    NOKIA_NOTES,
+    sizeof(NOKIA_NOTES) / sizeof(Note)
+  },
+  {
+    MEGALOVANIA_NOTES,
+    sizeof(MEGALOVANIA_NOTES) / sizeof(Note)
+  },
+  {
+    CARPHONE_NOTES,
+    sizeof(CARPHONE_NOTES) / sizeof(Note)
+  },
+  {
+    TETRIS_USER_MOVE_NOTES,
+    sizeof(TETRIS_USER_MOVE_NOTES) / sizeof(Note)
+  },
+  {
+    TETRIS_USER_ROTATE_NOTES,
+    sizeof(TETRIS_USER_ROTATE_NOTES) / sizeof(Note)
+  },
+  {
+    TETRIS_PIECE_PLACED_NOTES,
+    sizeof(TETRIS_PIECE_PLACED_NOTES) / sizeof(Note)
+  },
+  {
+    TETRIS_CLEAR_2_LINES_NOTES,
+    sizeof(TETRIS_CLEAR_2_LINES_NOTES) / sizeof(Note),
+  },
+  {
+    TETRIS_CLEAR_3_LINES_NOTES,
+    sizeof(TETRIS_CLEAR_3_LINES_NOTES) / sizeof(Note),
+  },
+  {
+    TETRIS_LOSE_NOTES,
+    sizeof(TETRIS_LOSE_NOTES) / sizeof(Note),
+    {
+      7
+    }
+  },
+  {
+    TETRIS_MUSIC_NOTES,
+    sizeof(TETRIS_MUSIC_NOTES) / sizeof(Note),
+    {
+      1,
+      100
+    }
+  }
+};
+
+/**
+ * Steps to the next note, the same way as soundEffectStateTask() did when a
+ * note ended.
+ */
+static void originalNextNote(SoundEffectState* effectState) {
+  if (effectState->effect) {
+    if (
+        effectState->noteIndex != 0 &&
+        (effectState->noteIndex == effectState->effect->repeat.afterIndex) &&
+        (effectState->internalRepeatCount < effectState->effect->repeat.count)
+        ) {
+      effectState->noteIndex = effectState->effect->repeat.returnToIndex;
+      ++effectState->internalRepeatCount;
+    } else if (++effectState->noteIndex == effectState->effect->length) {
+      if (
+          (effectState->internalRepeatCount < effectState->effect->repeat.count) &&
+          (effectState->effect->repeat.afterIndex == 0)
+          ) {
+        effectState->noteIndex = effectState->effect->repeat.returnToIndex;
+        ++effectState->internalRepeatCount;
+      } else if (effectState->repeatEffect) {
+        effectState->noteIndex = 0;
+        effectState->internalRepeatCount = 0;
+      } else {
+        effectState->on = false;
+      }
+    }
+  } else {
+    effectState->on = false;
+  }
+}
+
+/*----------------------------------------------------------------------------
+ * Test
+ *--------------------------------------------------------------------------*/
+
+#define NOTE_100(note) SONG_KIND_NOTE | SONG_Duration_MS_100, SONG_Pitch_##note
+#define REPEAT(count) SONG_KIND_CONTROL | SONG_OP_REPEAT, count
+#define REPEAT_END SONG_KIND_CONTROL | SONG_OP_REPEAT_END
+#define END SONG_KIND_CONTROL | SONG_OP_END
+
+/**
+ * Song with three (3) levels of repeated sections.
+ */
+static uint8_t const NESTED_SONG[] = {
+  REPEAT(1),
+    NOTE_100(C4),
+    REPEAT(1),
+      NOTE_100(D4),
+      REPEAT(1),
+        NOTE_100(E4),
+      REPEAT_END,
+      NOTE_100(F4),
+    REPEAT_END,
+  REPEAT_END,
+  NOTE_100(G4),
+  END
+};
+
+/**
+ * Expected notes of NESTED_SONG, with the innermost section played once.
+ */
+static tone_t const NESTED_SONG_TONES[] = {
+  TONE_C4, TONE_D4, TONE_E4, TONE_F4, TONE_D4, TONE_E4, TONE_F4,
+  TONE_C4, TONE_D4, TONE_E4, TONE_F4, TONE_D4, TONE_E4, TONE_F4,
+  TONE_G4
+};
+
+static void fail(SOUND_Effect soundEffect, bool isLooping, uint16_t noteCount, char const* message) {
+  fprintf(
+      stderr,
+      "FAIL: sound effect %u (%s), note %u: %s\n",
+      soundEffect,
+      isLooping ? "looping" : "once",
+      noteCount,
+      message
+      );
+  exit(1);
+}
+
+/**
+ * Compares the notes of a sound effect from its song and its original table.
+ *
+ * @return The number of notes that were compared.
+ */
+static uint16_t testSoundEffect(SOUND_Effect soundEffect, bool isLooping) {
+  SoundEffectState original = {
+    true,
+    &originalEffects[soundEffect],
+    0,
+    0,
+    isLooping
+  };
+  song_player_t player;
+  uint16_t const maxNoteCount = isLooping ? LOOPING_NOTE_COUNT : MAX_NOTE_COUNT;
+  uint16_t noteCount;
+
+  SONG_Start(&player, effects[soundEffect]);
+
+  for (noteCount = 0; noteCount < maxNoteCount; ++noteCount) {
+    song_note_t note;
+    bool const isNote = SONG_GetNextNote(&player, isLooping, &note);
+
+    if (!original.on) {
+      if (isNote) {
+        fail(soundEffect, isLooping, noteCount, "song did not end");
+      }
+
+      return noteCount;
+    }
+
+    if (!isNote) {
+      fail(soundEffect, isLooping, noteCount, "song ended early");
+    }
+
+    Note const* expected = &original.effect->notes[original.noteIndex];
+
+    if (
+        (note.tone1 != expected->tone1) ||
+        (note.tone2 != expected->tone2) ||
+        (note.duration != expected->duration)
+        ) {
+      fail(soundEffect, isLooping, noteCount, "note differs");
+    }
+
+    originalNextNote(&original);
+  }
+
+  if (!isLooping) {
+    fail(soundEffect, isLooping, noteCount, "original did not end");
+  }
+
+  return noteCount;
+}
+
+static void testNestedSong(void) {
+  song_player_t player;
+  song_note_t note;
+
+  SONG_Start(&player, NESTED_SONG);
+
+  for (uint8_t i = 0; i < sizeof(NESTED_SONG_TONES) / sizeof(NESTED_SONG_TONES[0]); ++i) {
+    if (!SONG_GetNextNote(&player, false, &note)) {
+      fprintf(stderr, "FAIL: nested song ended early, note %u\n", i);
+      exit(1);
+    }
+
+    if ((note.tone1 != NESTED_SONG_TONES[i]) || (note.duration != 100)) {
+      fprintf(stderr, "FAIL: nested song, note %u differs\n", i);
+      exit(1);
+    }
+  }
+
+  if (SONG_GetNextNote(&player, false, &note)) {
+    fprintf(stderr, "FAIL: nested song did not end\n");
+    exit(1);
+  }
+}
+
+int main(void) {
+  uint32_t noteCount = 0;
+
+  for (SOUND_Effect soundEffect = SOUND_Effect_TONE_LOW_CONTINUOUS; soundEffect <= SOUND_Effect_TETRIS_MUSIC; ++soundEffect) {
+    noteCount += testSoundEffect(soundEffect, false);
+    noteCount += testSoundEffect(soundEffect, true);
+  }
+
+  testNestedSong();
+
+  printf(
+      "PASS: %u sound effects decoded bit-exact against the original tables (%lu notes); nested repeats\n",
+      SOUND_Effect_TETRIS_MUSIC,
+      (unsigned long)noteCount
+      );
+
+  return 0;
+}
@@ -43,6 +43,70 @@
 
 #include "mcc_generated_files/mcc.h"
 #include "src/app.h"
+#include "src/util/profile.h"
+#include "src/util/scheduler.h"
+#include "src/power.h"
+
+static void uart1Receive_Interrupt(void) {
+  UART1_Receive_ISR();
+  SCHEDULER_MarkRunnable(SCHEDULER_Task_HANDSET);
+}
+
+static void uart3Receive_Interrupt(void) {
+  UART3_Receive_ISR();
+  SCHEDULER_MarkRunnable(SCHEDULER_Task_HANDSET);
+}
+
+static void uart4Receive_Interrupt(void) {
+  UART4_Receive_ISR();
+  SCHEDULER_MarkRunnable(SCHEDULER_Task_TRANSCEIVER);
+}
+
+/**
+ * The Handset command queue is passed to UART3 as it makes room, so 
+ * HANDSET_Task() must run again after each sent byte. The interrupt is only 
+ * enabled while there are bytes to send.
+ */
+static void uart3Transmit_Interrupt(void) {
+  UART3_Transmit_ISR();
+  SCHEDULER_MarkRunnable(SCHEDULER_Task_HANDSET);
+}
+
+/**
+ * Simulated button presses are passed to UART4 as it makes room (see 
+ * TRANSCEIVER_Task()).
+ */
+static void uart4Transmit_Interrupt(void) {
+  UART4_Transmit_ISR();
+  SCHEDULER_MarkRunnable(SCHEDULER_Task_TRANSCEIVER);
+}
+
+/**
+ * Tasks only read one received byte per main loop execution, so their tasks
+ * must remain runnable while there are still received bytes to be read.
+ * 
+ * NOTE: UART2 (Bluetooth) is excluded, because it is decoded into complete
+ *       frames directly within its interrupt handler.
+ */
+static void markRunnableIfReceivedDataPending(void) {
+  if (UART1_is_rx_ready() || UART3_is_rx_ready()) {
+    SCHEDULER_MarkRunnable(SCHEDULER_Task_HANDSET);
+  }
+  
+  if (UART4_is_rx_ready()) {
+    SCHEDULER_MarkRunnable(SCHEDULER_Task_TRANSCEIVER);
+  }
+}
+
+#ifdef PROFILE_ENABLED
+static void profileTimer10MS_Interrupt(void) {
+  PROFILE_CALL(PROFILE_Id_TIMER_10MS_INTERRUPT, APP_Timer10MS_Interrupt());
+}
+
+static void profileTimer1MS_Interrupt(void) {
+  PROFILE_CALL(PROFILE_Id_TIMER_1MS_INTERRUPT, APP_Timer1MS_Interrupt());
+}
+#endif
 
 /*
                          Main application
@@ -52,20 +116,43 @@ void main(void)
     // Initialize the device
     SYSTEM_Initialize();
     
+#ifdef PROFILE_ENABLED
+    PROFILE_Initialize();
+#endif
+    
+    SCHEDULER_Initialize();
     APP_Initialize();
 
+    UART1_SetRxInterruptHandler(uart1Receive_Interrupt);
+    UART3_SetRxInterruptHandler(uart3Receive_Interrupt);
+    UART4_SetRxInterruptHandler(uart4Receive_Interrupt);
+    UART3_SetTxInterruptHandler(uart3Transmit_Interrupt);
+    UART4_SetTxInterruptHandler(uart4Transmit_Interrupt);
+
     INTERRUPT_GlobalInterruptHighEnable();
     INTERRUPT_GlobalInterruptLowEnable();
 
+#ifdef PROFILE_ENABLED
+    TMR2_SetInterruptHandler(profileTimer10MS_Interrupt);
+#else
     TMR2_SetInterruptHandler(APP_Timer10MS_Interrupt);
+#endif
     TMR2_StartTimer();
     
+#ifdef PROFILE_ENABLED
+    TMR4_SetInterruptHandler(profileTimer1MS_Interrupt);
+#else
     TMR4_SetInterruptHandler(APP_Timer1MS_Interrupt);
+#endif
     TMR4_StartTimer();
+    POWER_Initialize();
 
     while (1)
     {
-      APP_Task();
+      PROFILE_CALL(PROFILE_Id_MAIN_LOOP, APP_Task());
+      POWER_Task();
+      markRunnableIfReceivedDataPending();
+      SCHEDULER_WaitUntilRunnable();
     }
 }
 /**
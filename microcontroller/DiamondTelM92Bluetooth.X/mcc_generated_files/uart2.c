@@ -55,7 +55,7 @@
   Section: Macro Declarations
 */
 #define UART2_TX_BUFFER_SIZE 16
-#define UART2_RX_BUFFER_SIZE 255
+#define UART2_RX_BUFFER_SIZE 8
 
 /**
   Section: Global Variables
@@ -230,7 +230,7 @@ void __interrupt(irq(U2RX),base(8),low_priority) UART2_rx_vect_isr()
 }
 
 
-extern void UART_TransferNextByte( void );
+#include "../src/bluetooth/bt_command_send.h"
 
 void UART2_Transmit_ISR(void)
 {
@@ -243,12 +243,16 @@ void UART2_Transmit_ISR(void)
             uart2TxTail = 0;
         }
         uart2TxBufferRemaining++;
+#if !UART_TX_USE_DMA
         UART_TransferNextByte();
+#endif
     }
     else
     {
         PIE8bits.U2TXIE = 0;
+#if !UART_TX_USE_DMA
         UART_TransferNextByte();
+#endif
     }
     
     // or set custom function using UART2_SetTxInterruptHandler()
@@ -278,14 +282,12 @@ void UART2_Receive_ISR(void)
     // or set custom function using UART2_SetRxInterruptHandler()
 }
 
+extern void BT_CommandDecode_RxByte(uint8_t rxByte);
+
 void UART2_RxDataHandler(void){
-    // use this default receive interrupt handler code
-    uart2RxBuffer[uart2RxHead++] = U2RXB;
-    if(sizeof(uart2RxBuffer) <= uart2RxHead)
-    {
-        uart2RxHead = 0;
-    }
-    uart2RxCount++;
+    // Received bytes are decoded into complete frames directly within the 
+    // interrupt, rather than being buffered for UART2_Read().
+    BT_CommandDecode_RxByte(U2RXB);
 }
 
 void UART2_DefaultFramingErrorHandler(void){}
@@ -54,7 +54,7 @@
 /**
   Section: Macro Declarations
 */
-#define UART3_TX_BUFFER_SIZE 64
+#define UART3_TX_BUFFER_SIZE 8
 #define UART3_RX_BUFFER_SIZE 8
 
 /**
@@ -18,6 +18,7 @@
 #include "sound/ringtone.h"
 #include "storage/eeprom.h"
 #include "storage/storage.h"
+#include "storage/phonebook.h"
 #include "bluetooth/bt_command_decode.h"
 #include "bluetooth/bt_command_send.h"
 #include "bluetooth/atcmd.h"
@@ -39,6 +40,9 @@
 #include "util/string.h"
 #include "util/timeout.h"
 #include "util/interval.h"
+#include "util/timer_wheel.h"
+#include "util/scheduler.h"
+#include "util/profile.h"
 
 static enum {
   APP_CALL_IDLE,
@@ -114,6 +118,12 @@ static enum {
 
 static int lastAppState;
 
+/**
+ * True if the phonebook task is runnable, but has not been executed yet
+ * (see APP_Task()).
+ */
+static bool isPhonebookTaskPending;
+
 static char const* const appStateLabel[] = {
   "INIT_START",
   "INIT_SET_LCD_ANGLE",
@@ -346,6 +356,11 @@ interval_t lowBatteryBeepInterval;
 
 #define BROWSE_DIRECTORY_SCAN_INTERVAL (100)
 static bool isDirectoryScanNameMode;
+/**
+ * True if the synced phonebook is being browsed (instead of the directory).
+ */
+static bool isBrowsingPhonebook;
+static uint16_t phonebookPosition;
 
 #define NUMBER_INPUT_MAX_LENGTH (MAX_EXTENDED_PHONE_NUMBER_LENGTH)
 static char numberInput[NUMBER_INPUT_MAX_LENGTH + 1];
@@ -381,7 +396,7 @@ static void NumberInput_PushDigit(char digit) {
     numberInput[numberInputLength++] = digit;
     numberInput[numberInputLength] = 0;
   } else {
-    memcpy(numberInput, numberInput + 1, NUMBER_INPUT_MAX_LENGTH - 1);
+    memmove(numberInput, numberInput + 1, NUMBER_INPUT_MAX_LENGTH - 1);
     numberInput[NUMBER_INPUT_MAX_LENGTH - 1] = digit;
   }
   numberInputIsStale = false;
@@ -567,8 +582,20 @@ static bool startVoiceCommand(void) {
 static void NumberInput_SendCurrentNumberAsDtmf(void) {
   hideCallTimer();
   numberInputIsStale = true;
-  numberInputNextDtmfSendIndex = 0;
-  ATCMD_SendDTMFDigitString(numberInput);
+
+  // Send up to the first pause. The rest is sent by pressing SEND
+  // (see NumberInput_SendNextDTMFString()).
+  char const* const firstPause = strpbrk(numberInput, "PM");
+
+  if (firstPause) {
+    size_t const len = firstPause - numberInput;
+    strncpy(tempNumberBuffer, numberInput, len)[len] = 0;
+    numberInputNextDtmfSendIndex = len;
+    ATCMD_SendDTMFDigitString(tempNumberBuffer);
+  } else {
+    numberInputNextDtmfSendIndex = 0;
+    ATCMD_SendDTMFDigitString(numberInput);
+  }
 }
 
 static void NumberInput_CallCurrentNumber(void) {
@@ -744,10 +771,31 @@ static void startAlphaStoreNameInput(bool reset) {
 }
 
 static void recallAddress(uint8_t addr, bool isNameMode);
+static void recallPhonebookEntry(uint16_t position, bool isNameMode);
 
 static void handleAlphaScanCharInput(char c) {
   HANDSET_SetIndicator(HANDSET_Indicator_FCN, false);
-  recallAddress(STORAGE_GetFirstNamedDirectoryIndexForLetter(c), true);  
+  
+  uint8_t const index = STORAGE_GetFirstNamedDirectoryIndexForLetter(c);
+  
+  // The directory takes priority, but only if it has a name that starts with
+  // the letter. Otherwise, scan the synced phonebook (if any).
+  if (index < STORAGE_DIRECTORY_SIZE) {
+    STORAGE_GetDirectoryName(index, alphaInput);
+    
+    if (tolower(alphaInput[0]) == tolower(c)) {
+      recallAddress(index, true);
+      return;
+    }
+  }
+  
+  uint16_t const position = PHONEBOOK_GetFirstPositionForLetter(c);
+  
+  if (position != PHONEBOOK_NO_POSITION) {
+    recallPhonebookEntry(position, true);
+  } else {
+    recallAddress(index, true);  
+  }
 }
 
 static void startAlphaStoreNumberInput(bool reset) {
@@ -886,6 +934,44 @@ static void recallNumber(char const* number) {
   }
 }
 
+/**
+ * Displays a recalled directory/phonebook entry (from `alphaInput` or 
+ * `tempNumberBuffer`), and starts browsing.
+ * 
+ * @param label - 2-char label of the entry (e.g., the directory address).
+ * @param isNameMode - True to display the name instead of the number.
+ */
+static void displayRecalledEntry(char const* label, bool isNameMode) {
+  HANDSET_DisableTextDisplay();
+  HANDSET_ClearText();
+  HANDSET_PrintString(label);
+  HANDSET_PrintChar(':');
+
+  if (isNameMode) {
+    size_t length = strlen(alphaInput);
+
+    if (length <= 11) {
+      HANDSET_PrintCharN(' ', 11 - length);
+      HANDSET_PrintString(alphaInput);
+    } else {
+      HANDSET_PrintStringN(alphaInput, 11);
+    }
+  } else {
+    size_t length = strlen(tempNumberBuffer);
+
+    if (length <= 11) {
+      HANDSET_PrintCharN(' ', 11 - strlen(tempNumberBuffer));
+      HANDSET_PrintString(tempNumberBuffer);
+    } else {
+      HANDSET_PrintString(tempNumberBuffer + length - 11);
+    }
+  }
+
+  HANDSET_EnableTextDisplay();
+  isDirectoryScanNameMode = isNameMode;
+  appState = APP_State_BROWSE_DIRECTORY_IDLE;
+}
+
 static void recallAddress(uint8_t addr, bool isNameMode) {
   if (addr > STORAGE_DIRECTORY_SIZE) {
     displayEmptyMessage();
@@ -902,45 +988,83 @@ static void recallAddress(uint8_t addr, bool isNameMode) {
   if (tempNumberBuffer[0]) {
     char buf[3];
     
-    HANDSET_DisableTextDisplay();
-    HANDSET_ClearText();
-      HANDSET_PrintString(uint2str(
-      buf,
-      addr + 1,
-      2,
-      2
-      ));
-    HANDSET_PrintChar(':');
-
     if (isNameMode) {
       STORAGE_GetDirectoryName(addr, alphaInput);
-      size_t length = strlen(alphaInput);
-      
-      if (length <= 11) {
-        HANDSET_PrintCharN(' ', 11 - length);
-        HANDSET_PrintString(alphaInput);
-      } else {
-        HANDSET_PrintStringN(alphaInput, 11);
-      }
-    } else {
-      size_t length = strlen(tempNumberBuffer);
-      
-      if (length <= 11) {
-        HANDSET_PrintCharN(' ', 11 - strlen(tempNumberBuffer));
-        HANDSET_PrintString(tempNumberBuffer);
-      } else {
-        HANDSET_PrintString(tempNumberBuffer + length - 11);
-      }
     }
     
-    HANDSET_EnableTextDisplay();
-    isDirectoryScanNameMode = isNameMode;
-    appState = APP_State_BROWSE_DIRECTORY_IDLE;
+    displayRecalledEntry(uint2str(buf, addr + 1, 2, 2), isNameMode);
+    isBrowsingPhonebook = false;
+  } else {
+    displayEmptyMessage();
+  }
+}
+
+/**
+ * Recalls an entry of the synced phonebook, and browses the phonebook with 
+ * the same controls as the directory.
+ * 
+ * @param position - Sorted position of the phonebook entry.
+ * @param isNameMode - True to display the name instead of the number.
+ */
+static void recallPhonebookEntry(uint16_t position, bool isNameMode) {
+  CALL_TIMER_DisableDisplayUpdate();
+  INDICATOR_StopFlashing(HANDSET_Indicator_FCN, false);
+  PHONEBOOK_GetNumber(position, tempNumberBuffer);
+
+  NumberInput_Overwrite(tempNumberBuffer);
+
+  if (tempNumberBuffer[0]) {
+    PHONEBOOK_GetName(position, alphaInput);
+    displayRecalledEntry("PB", isNameMode);
+    isBrowsingPhonebook = true;
+    phonebookPosition = position;
   } else {
     displayEmptyMessage();
   }
 }
 
+/**
+ * Recalls the directory/phonebook entry that is being browsed.
+ */
+static void recallBrowsedEntry(bool isNameMode) {
+  if (isBrowsingPhonebook) {
+    recallPhonebookEntry(phonebookPosition, isNameMode);
+  } else {
+    recallAddress(STORAGE_GetDirectoryIndex(), isNameMode);
+  }
+}
+
+/**
+ * Recalls the next directory/phonebook entry in the browsing order (alphabetic
+ * in name mode), wrapping around at the end.
+ * 
+ * @param forward - True to browse in the forward direction.
+ */
+static void recallNextBrowsedEntry(bool forward) {
+  if (isBrowsingPhonebook) {
+    uint16_t const count = PHONEBOOK_GetCount();
+    uint16_t position = phonebookPosition;
+    
+    if (forward) {
+      position = (position + 1 < count) ? (position + 1) : 0;
+    } else {
+      position = position ? (position - 1) : (count - 1);
+    }
+    
+    recallPhonebookEntry(position, isDirectoryScanNameMode);
+    return;
+  }
+  
+  uint8_t index = STORAGE_GetDirectoryIndex();
+  if (isDirectoryScanNameMode) {
+    index = STORAGE_GetNextNamedDirectoryIndex(index, forward);
+  } else {
+    index = STORAGE_GetNextPopulatedDirectoryIndex(index, forward);
+  }
+
+  recallAddress(index, isDirectoryScanNameMode);
+}
+
 static uint8_t creditCardIndex;
 
 static void recallCreditCardNumber(uint8_t index) {
@@ -1203,47 +1327,64 @@ static void startVolumeAdjust(VOLUME_Mode volumeMode, bool up) {
   appState = APP_State_ADJUST_VOLUME;
 }
 
-static char nameInput[STORAGE_MAX_DIRECTORY_NAME_LENGTH + 1] = {0};
-static char nameInputLength = 0;
 
+/**
+ * Sets the Caller ID from the number and name of a call, as reported by the 
+ * phone.
+ * 
+ * @param phoneNumber - The phone number (may be empty).
+ * @param buffer - The name ("alpha") reported by the phone (may be empty). 
+ *        Also used as a temporary buffer, so it must be at least 48 chars.
+ */
+static void setCallerIdFromCallInfo(char const* phoneNumber, char* buffer) {
+  // If "alpha" is populated, then use it as Caller ID
+  if (*buffer && ((STORAGE_GetCallerIdMode() == CALLER_ID_Mode_NAME) || !*phoneNumber)) {
+    setCallerId(buffer);
+  } else if (
+      *phoneNumber && 
+      (STORAGE_GetCallerIdMode() == CALLER_ID_Mode_NAME) && 
+      (STORAGE_FindDirectoryName(phoneNumber, buffer) || PHONEBOOK_FindName(phoneNumber, buffer))
+      ) {
+    // The phone did not provide a name, but it's in the directory or
+    // the synced phonebook
+    setCallerId(buffer);
+  } else if (*phoneNumber) {
+    formatPhoneNumber(buffer, phoneNumber);
+    setCallerId(buffer);
+  } else {
+    setCallerId("Unknown Caller");
+  }
+}
 
-void handleCallListAtResponse(ATCMD_Response response, char const* result) {
+void handleCallListAtResponse(ATCMD_Response response, char const* result, uint8_t resultLength) {
+  SCHEDULER_MarkRunnable(SCHEDULER_Task_APP);
+  
   if (response == ATCMD_Response_RESULT) {
+    char const* const resultEnd = result + resultLength;
     char phoneNumber[24];
     char buffer[48];
+    csv_field_t field;
 
-    // id
-    char const* nextField = parseNextCsvField(buffer, result + 7);
-    // dir
-    nextField = parseNextCsvField(buffer, nextField);
+    // Skip id, dir
+    char const* nextField = skipCsvFields(result + 7, resultEnd, 2);
     // stat
-    nextField = parseNextCsvField(buffer, nextField);
-    char const stat = *buffer;
-    // mode
-    nextField = parseNextCsvField(buffer, nextField);
-    // mpty
-    nextField = parseNextCsvField(buffer, nextField);
+    nextField = scanNextCsvField(&field, nextField, resultEnd);
+    char const stat = field.length ? *field.start : 0;
+    // Skip mode, mpty
+    nextField = skipCsvFields(nextField, resultEnd, 2);
     // number
-    nextField = parseNextCsvField(phoneNumber, nextField);
-    // type
-    nextField = parseNextCsvField(buffer, nextField);
+    nextField = parseNextCsvField(phoneNumber, sizeof(phoneNumber), nextField, resultEnd);
+    // Skip type
+    nextField = skipCsvFields(nextField, resultEnd, 1);
     // alpha
-    nextField = parseNextCsvField(buffer, nextField);
+    parseNextCsvField(buffer, sizeof(buffer), nextField, resultEnd);
 
     switch (BT_CallStatus) {
       case BT_CALL_INCOMING:
       case BT_CALL_ACTIVE_WITH_CALL_WAITING:
         // Process incoming or call waiting result to get caller ID
         if ((stat == '4') || (stat == '5')) {
-          // If "alpha" is populated, then use it as Caller ID
-          if (*buffer && ((STORAGE_GetCallerIdMode() == CALLER_ID_Mode_NAME) || !*phoneNumber)) {
-            setCallerId(buffer);
-          } else if (*phoneNumber) {
-            formatPhoneNumber(buffer, phoneNumber);
-            setCallerId(buffer);
-          } else {
-            setCallerId("Unknown Caller");
-          }
+          setCallerIdFromCallInfo(phoneNumber, buffer);
         }
         break;
         
@@ -1579,7 +1720,7 @@ static uint8_t getCreditCardMemoryIndexFromButton(HANDSET_Button button) {
 
 void handle_HANDSET_Event(HANDSET_Event const* event);
 void handle_TRANSCEIVER_Event(TRANSCEIVER_EventType event);
-void handle_ATCMD_UnsolicitedResult(char const* result);
+void handle_ATCMD_UnsolicitedResult(ATCMD_ResultCode resultCode, char const* result, uint8_t resultLength);
 
 void APP_Initialize(void) {
   IO_BT_RESET_SetLow();
@@ -1589,6 +1730,7 @@ void APP_Initialize(void) {
   BT_CallStatus = BT_CALL_IDLE;
 
   EEPROM_Initialize();
+  PHONEBOOK_Initialize();
   TONE_Initialize();
   HANDSET_Initialize(handle_HANDSET_Event);
   TRANSCEIVER_Initialize(handle_TRANSCEIVER_Event);
@@ -1599,38 +1741,89 @@ void APP_Initialize(void) {
   ATCMD_Initialize(handle_ATCMD_UnsolicitedResult);
   MARQUEE_Initialize();
   CLR_CODES_Initialize();
-  INTERVAL_Initialize(&lowBatteryBeepInterval, LOW_BATTERY_BEEP_INTERVAL);
+  INTERVAL_InitializeOnTimerWheel(&lowBatteryBeepInterval, LOW_BATTERY_BEEP_INTERVAL);
+  TIMEOUT_InitializeOnTimerWheel(&idleTimeout);
+  TIMEOUT_InitializeOnTimerWheel(&fcnTimeout);
+  TIMEOUT_InitializeOnTimerWheel(&callActionTimeout);
+  TIMEOUT_InitializeOnTimerWheel(&autoAnswerTimeout);
+  TIMEOUT_InitializeOnTimerWheel(&pendingCallStatusTimeout);
+  TIMEOUT_InitializeOnTimerWheel(&linkbackRetryTimeout);
+  TIMEOUT_InitializeOnTimerWheel(&cellPhoneState.initialBatteryLevelReportTimeout);
 }
 
 void APP_Task(void) {
-  if (appState != lastAppState) {
-    lastAppState = appState;
-    printf("[App State] %s\r\n", appStateLabel[appState]);
+  // Tasks with their own events only execute when they are runnable
+  if (SCHEDULER_TakeRunnable(SCHEDULER_Task_EEPROM)) {
+    PROFILE_CALL(PROFILE_Id_EEPROM_TASK, EEPROM_Task());
+  }
+  
+  if (SCHEDULER_TakeRunnable(SCHEDULER_Task_BT_COMMAND_DECODE)) {
+    PROFILE_CALL(PROFILE_Id_BT_COMMAND_DECODE_TASK, BT_CommandDecode_Task());
   }
   
-  EEPROM_Task();
-  VOLUME_Task();
-  SOUND_Task();
-  INDICATOR_Task();
-  MARQUEE_Task();
-  BT_CommandDecode_Task();
-  BT_CommandSend_Task();
-  HANDSET_Task();
-  TRANSCEIVER_Task();
-  EXTERNAL_MIC_Task();
+  if (SCHEDULER_TakeRunnable(SCHEDULER_Task_BT_COMMAND_SEND)) {
+    PROFILE_CALL(PROFILE_Id_BT_COMMAND_SEND_TASK, BT_CommandSend_Task());
+  }
+  
+  if (SCHEDULER_TakeRunnable(SCHEDULER_Task_HANDSET)) {
+    PROFILE_CALL(PROFILE_Id_HANDSET_TASK, HANDSET_Task());
+  }
+  
+  if (SCHEDULER_TakeRunnable(SCHEDULER_Task_TRANSCEIVER)) {
+    PROFILE_CALL(PROFILE_Id_TRANSCEIVER_TASK, TRANSCEIVER_Task());
+  }
+  
+  if (SCHEDULER_TakeRunnable(SCHEDULER_Task_EXTERNAL_MIC)) {
+    PROFILE_CALL(PROFILE_Id_EXTERNAL_MIC_TASK, EXTERNAL_MIC_Task());
+  }
+  
+  if (SCHEDULER_TakeRunnable(SCHEDULER_Task_PHONEBOOK)) {
+    isPhonebookTaskPending = true;
+  }
+  
+  // Everything else is the application, which is runnable after any event 
+  // that was dispatched to it, and after any of its timeouts/intervals 
+  // expire.
+  bool const isAppRunnable = SCHEDULER_TakeRunnable(SCHEDULER_Task_APP);
+  
+  if (isAppRunnable) {
+    if (appState != lastAppState) {
+      lastAppState = appState;
+      printf("[App State] %s\r\n", appStateLabel[appState]);
+    }
+
+    PROFILE_CALL(PROFILE_Id_VOLUME_TASK, VOLUME_Task());
+    PROFILE_CALL(PROFILE_Id_SOUND_TASK, SOUND_Task());
+    PROFILE_CALL(PROFILE_Id_INDICATOR_TASK, INDICATOR_Task());
+    PROFILE_CALL(PROFILE_Id_MARQUEE_TASK, MARQUEE_Task());
+  }
   
   switch (appState) {
     case APP_State_PROGRAMMING:
       return;
       
     case APP_State_SOUND_TEST:
-      SOUND_TEST_Task();
+      if (isAppRunnable) {
+        SOUND_TEST_Task();
+      }
       return;
   }
 
-  CALL_TIMER_Task();
-  ATCMD_Task();
-  CLR_CODES_Task();
+  // Phonebook sync erases/writes flash, which stalls the CPU, so only sync
+  // while there's no call. The end of a call is a Bluetooth event, which 
+  // executes this again.
+  if (isPhonebookTaskPending && (BT_CallStatus == BT_CALL_IDLE)) {
+    isPhonebookTaskPending = false;
+    PROFILE_CALL(PROFILE_Id_PHONEBOOK_TASK, PHONEBOOK_Task());
+  }
+  
+  if (!isAppRunnable) {
+    return;
+  }
+
+  PROFILE_CALL(PROFILE_Id_CALL_TIMER_TASK, CALL_TIMER_Task());
+  PROFILE_CALL(PROFILE_Id_ATCMD_TASK, ATCMD_Task());
+  PROFILE_CALL(PROFILE_Id_CLR_CODES_TASK, CLR_CODES_Task());
   
   TIMEOUT_Task(&appStateTimeout);
   TIMEOUT_Task(&statusBeepCooldownTimeout);
@@ -1856,14 +2049,7 @@ void APP_Task(void) {
       
     case APP_State_BROWSE_DIRECTORY_UP:
       if (!TIMEOUT_IsPending(&appStateTimeout)) {
-        uint8_t index = STORAGE_GetDirectoryIndex();
-        if (isDirectoryScanNameMode) {
-          index = STORAGE_GetNextNamedDirectoryIndex(index, true);
-        } else {
-          index = STORAGE_GetNextPopulatedDirectoryIndex(index, true);
-        }
-        
-        recallAddress(index, isDirectoryScanNameMode);
+        recallNextBrowsedEntry(true);
         appState = APP_State_BROWSE_DIRECTORY_UP;
         TIMEOUT_Start(&appStateTimeout, BROWSE_DIRECTORY_SCAN_INTERVAL);
       }
@@ -1871,14 +2057,7 @@ void APP_Task(void) {
       
     case APP_State_BROWSE_DIRECTORY_DOWN:
       if (!TIMEOUT_IsPending(&appStateTimeout)) {
-        uint8_t index = STORAGE_GetDirectoryIndex();
-        if (isDirectoryScanNameMode) {
-          index = STORAGE_GetNextNamedDirectoryIndex(index, false);
-        } else {
-          index = STORAGE_GetNextPopulatedDirectoryIndex(index, false);
-        }
-        
-        recallAddress(index, isDirectoryScanNameMode);
+        recallNextBrowsedEntry(false);
         appState = APP_State_BROWSE_DIRECTORY_DOWN;
         TIMEOUT_Start(&appStateTimeout, BROWSE_DIRECTORY_SCAN_INTERVAL);
       }
@@ -1903,20 +2082,33 @@ void APP_Task(void) {
       break;
       
     case APP_State_REBOOT:
-      if (!TIMEOUT_IsPending(&appStateTimeout) && EEPROM_IsDoneWriting()) {
-        RESET();
+      if (!TIMEOUT_IsPending(&appStateTimeout)) {
+        if (EEPROM_IsDoneWriting()) {
+          RESET();
+        }
+        
+        // EEPROM writes complete without any event for the application
+        SCHEDULER_MarkRunnable(SCHEDULER_Task_APP);
       }
       break;
-  }    
+  }
+  
+  // A new state may have work to do before any further event
+  if (appState != lastAppState) {
+    SCHEDULER_MarkRunnable(SCHEDULER_Task_APP);
+  }
 }
 
 void APP_Timer1MS_Interrupt(void) {
+  TONE_Timer1MS_Interrupt();
   SOUND_Timer1MS_Interrupt();
   BT_CommandSend_Timer1MS_Interrupt();
   HANDSET_Timer1MS_Interrupt();
 }
 
 void APP_Timer10MS_Interrupt(void) {
+  // Tasks are only marked runnable by the timeouts/intervals/timers that
+  // expire (see TIMER_WHEEL_Expire()), not by every tick.
   switch (appState) {
     case APP_State_PROGRAMMING:
       return;
@@ -1956,37 +2148,31 @@ void APP_Timer10MS_Interrupt(void) {
       break;
   }
 
-  ATCMD_Timer10ms_Interrupt();
-  TRANSCEIVER_Timer10MS_Interrupt();
-  EXTERNAL_MIC_Timer10MS_Interrupt();
-  INDICATOR_Timer10MS_Interrupt();
-  MARQUEE_Timer10MS_Interrupt();
-  CLR_CODES_Timer10MS_Interrupt();
-  VOLUME_Timer10MS_Interrupt();
-  
-  TIMEOUT_Timer_Interrupt(&idleTimeout);
-  TIMEOUT_Timer_Interrupt(&fcnTimeout);
-  TIMEOUT_Timer_Interrupt(&callActionTimeout);
-  TIMEOUT_Timer_Interrupt(&autoAnswerTimeout);
-  TIMEOUT_Timer_Interrupt(&pendingCallStatusTimeout);
-  TIMEOUT_Timer_Interrupt(&linkbackRetryTimeout);
-  TIMEOUT_Timer_Interrupt(&cellPhoneState.initialBatteryLevelReportTimeout);
-  INTERVAL_Timer_Interrupt(&lowBatteryBeepInterval);
+  // Advances all timeouts/intervals that were initialized on the timer wheel
+  // (including those of the ATCMD, TRANSCEIVER, EXTERNAL_MIC, INDICATOR, 
+  // MARQUEE, CLR_CODES and VOLUME modules).
+  TIMER_WHEEL_Timer_Interrupt();
   
   if (!callFailedTimerExpired && callFailedTimer) {
     if (!--callFailedTimer) {
       callFailedTimerExpired = true;
+      SCHEDULER_MarkRunnable(SCHEDULER_Task_APP);
     }
   }
   
   if (rcl2ndDigitTimer) {
     if (!--rcl2ndDigitTimer) {
       rcl2ndDigitTimerExpired = true;
+      SCHEDULER_MarkRunnable(SCHEDULER_Task_APP);
     }
   }
 }
 
 void handle_HANDSET_Event(HANDSET_Event const* event) {
+  // Every event handler marks the application runnable, because APP_Task() 
+  // may have to react to changes made by the handler.
+  SCHEDULER_MarkRunnable(SCHEDULER_Task_APP);
+  
   bool wasDisplayingNonNumberInput = false;
   bool isButtonDown = event->type == HANDSET_EventType_BUTTON_DOWN;
   bool isButtonUp = event->type == HANDSET_EventType_BUTTON_UP;
@@ -2291,15 +2477,7 @@ void handle_HANDSET_Event(HANDSET_Event const* event) {
       
       case APP_State_BROWSE_DIRECTORY_IDLE: {
         SOUND_PlayButtonBeep(button, false);
-        
-        uint8_t index = STORAGE_GetDirectoryIndex();
-        if (isDirectoryScanNameMode) {
-          index = STORAGE_GetNextNamedDirectoryIndex(index, up);
-        } else {
-          index = STORAGE_GetNextPopulatedDirectoryIndex(index, up);
-        }
-        
-        recallAddress(index, isDirectoryScanNameMode);
+        recallNextBrowsedEntry(up);
         return;
       }
     }
@@ -2946,18 +3124,21 @@ void handle_HANDSET_Event(HANDSET_Event const* event) {
       
     case APP_State_BROWSE_DIRECTORY_SHOW_OVERFLOW: 
       if (isButtonUp && (button == HANDSET_Button_RCL)) {
-        recallAddress(STORAGE_GetDirectoryIndex(), isDirectoryScanNameMode);
+        recallBrowsedEntry(isDirectoryScanNameMode);
       }
       break;
       
     case APP_State_BROWSE_DIRECTORY_IDLE:
       if (isButtonDown) {
         if (button == HANDSET_Button_FCN) {
-          uint8_t const index = STORAGE_GetDirectoryIndex();
-
-          if (isDirectoryScanNameMode || !STORAGE_IsDirectoryNameEmpty(index)) {
+          // Phonebook entries always have a name
+          if (
+              isDirectoryScanNameMode || 
+              isBrowsingPhonebook || 
+              !STORAGE_IsDirectoryNameEmpty(STORAGE_GetDirectoryIndex())
+              ) {
             SOUND_PlayButtonBeep(button, false);
-            recallAddress(index, !isDirectoryScanNameMode);
+            recallBrowsedEntry(!isDirectoryScanNameMode);
           }
         } else if (button == HANDSET_Button_RCL) {
           if (isDirectoryScanNameMode && strlen(alphaInput) > 11) {
@@ -3059,6 +3240,8 @@ void handle_HANDSET_Event(HANDSET_Event const* event) {
 }
 
 void handle_TRANSCEIVER_Event(TRANSCEIVER_EventType event) {
+  SCHEDULER_MarkRunnable(SCHEDULER_Task_APP);
+  
   switch (event)  {
     case TRANSCEIVER_EventType_BATTERY_LEVEL_CHANGED:
       if (appState == APP_State_DISPLAY_BATTERY_LEVEL) {
@@ -3104,13 +3287,9 @@ static char const* linkbackTypeLabel[] = {
   "SPP"
 };
 
-static char const* atResponseStatusLabel[] = {
-  "OK",
-  "Error",
-  "No Response"
-};
-
 void APP_BT_EventHandler(uint8_t event, uint16_t para, uint8_t* para_full) {
+  SCHEDULER_MarkRunnable(SCHEDULER_Task_APP);
+  
   switch (event) {
     case BT_EVENT_SYS_POWER_ON: 
       BT_isReady = true;
@@ -3235,6 +3414,7 @@ void APP_BT_EventHandler(uint8_t event, uint16_t para, uint8_t* para_full) {
       cellPhoneState.isConnected = true;
       
       TIMEOUT_Start(&cellPhoneState.initialBatteryLevelReportTimeout, INITIAL_BATTERY_LEVEL_REPORT_DELAY);
+      PHONEBOOK_StartSync();
       break;
 
     case BT_EVENT_HFP_DISCONNECTED:
@@ -3247,6 +3427,7 @@ void APP_BT_EventHandler(uint8_t event, uint16_t para, uint8_t* para_full) {
       HANDSET_SetIndicator(HANDSET_Indicator_IN_USE, false);
       cellPhoneState.isConnected = false;
       cellPhoneState.isScoConnected = false;
+      PHONEBOOK_CancelSync();
       cellPhoneState.hasService = false;
       cellPhoneState.maxSignalStrength = 0;
       cellPhoneState.signalStrength = 0;
@@ -3360,6 +3541,56 @@ void APP_BT_EventHandler(uint8_t event, uint16_t para, uint8_t* para_full) {
   }
 }
 
-void handle_ATCMD_UnsolicitedResult(char const* result) {
-  printf("[UNSCOLICITED AT RESULT] %s\r\n", result);
+/**
+ * Handles an unsolicited +CLIP (incoming call) or +CCWA (call waiting) result,
+ * which starts with the caller's number, and has the caller's name ("alpha") 
+ * at a later field.
+ * 
+ * This provides the Caller ID if it has not already been received from the
+ * call list (see handleCallListAtResponse()). Phones repeat +CLIP with every 
+ * ring, so it is ignored once the Caller ID is known.
+ * 
+ * @param alphaFieldIndex - Index of the "alpha" field.
+ */
+static void handleCallerIdResult(char const* result, uint8_t resultLength, uint8_t alphaFieldIndex) {
+  if (callerIdText[0] || !STORAGE_GetCallerIdMode()) {
+    return;
+  }
+  
+  char const* const resultEnd = result + resultLength;
+  char phoneNumber[24];
+  char buffer[48];
+
+  // number
+  char const* nextField = parseNextCsvField(phoneNumber, sizeof(phoneNumber), result + 7, resultEnd);
+  // Skip the fields before alpha
+  nextField = skipCsvFields(nextField, resultEnd, alphaFieldIndex - 1);
+  // alpha
+  parseNextCsvField(buffer, sizeof(buffer), nextField, resultEnd);
+  
+  setCallerIdFromCallInfo(phoneNumber, buffer);
+}
+
+void handle_ATCMD_UnsolicitedResult(ATCMD_ResultCode resultCode, char const* result, uint8_t resultLength) {
+  SCHEDULER_MarkRunnable(SCHEDULER_Task_APP);
+  
+  switch (resultCode) {
+    case ATCMD_ResultCode_CLIP:
+      // +CLIP: <number>,<type>[,<subaddr>,<satype>,<alpha>[,<CLI validity>]]
+      if (BT_CallStatus == BT_CALL_INCOMING) {
+        handleCallerIdResult(result, resultLength, 4);
+      }
+      break;
+      
+    case ATCMD_ResultCode_CCWA:
+      // +CCWA: <number>,<type>,<class>[,<alpha>[,<CLI validity>]]
+      if (BT_CallStatus == BT_CALL_ACTIVE_WITH_CALL_WAITING) {
+        handleCallerIdResult(result, resultLength, 3);
+      }
+      break;
+      
+    default:
+      printf("[UNSCOLICITED AT RESULT] %.*s\r\n", resultLength, result);
+      break;
+  }
 }
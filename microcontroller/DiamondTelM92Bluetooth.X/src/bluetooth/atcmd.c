@@ -6,8 +6,8 @@
 #include "atcmd.h"
 #include "bt_command_send.h"
 #include "bt_command_decode.h"
-#include "../util/string.h"
 #include "../util/timeout.h"
+#include "../util/scheduler.h"
 #include "../constants.h"
 #include "../telephone/handset.h"
 #include <stdio.h>
@@ -17,13 +17,84 @@
 typedef struct ATCMD_CmdInfo {
   uint16_t cmdBufferPos;
   uint8_t cmdLen;
-  char resultPrefix[32];
+  ATCMD_ResultCode resultCode;
   ATCMD_ResponseCallback responseCallback;
 } ATCMD_CmdInfo;
 
+#define RESULT_CODE_PREFIX(code, prefix) prefix,
+
+/**
+ * Command/result prefix of each result code, indexed by ATCMD_ResultCode.
+ */
+static char const* const resultCodePrefixes[ATCMD_ResultCode_COUNT] = {
+  "",
+  ATCMD_RESULT_CODES(RESULT_CODE_PREFIX)
+};
+
+/**
+ * Finds the result code for a command/result prefix.
+ * 
+ * @param prefix - The prefix (not necessarily null-terminated).
+ * @param prefixLength - The length of the prefix.
+ * @return The result code, or ATCMD_ResultCode_NONE if not found.
+ */
+static ATCMD_ResultCode findResultCode(char const* prefix, uint8_t prefixLength) {
+  if (prefixLength < 2) {
+    return ATCMD_ResultCode_NONE;
+  }
+  
+  // All known prefixes start with '+', followed by a distinct character in
+  // most cases, so mismatches are rejected quickly.
+  for (uint8_t i = ATCMD_ResultCode_NONE + 1; i < ATCMD_ResultCode_COUNT; ++i) {
+    char const* const candidate = resultCodePrefixes[i];
+
+    if ((candidate[1] == prefix[1]) && 
+        !strncmp(candidate, prefix, prefixLength) && 
+        !candidate[prefixLength]) {
+      return (ATCMD_ResultCode)i;
+    }
+  }
+  
+  return ATCMD_ResultCode_NONE;
+}
+
 #define COMMAND_INFO_BUFFER_SIZE (32)
 #define COMMAND_BUFFER_SIZE (512)
 
+/**
+ * Max number of DTMF digits to send in a single "+VTS" command while batching.
+ * Set to 1 to always send one digit per command.
+ */
+#define DTMF_BATCH_MAX_DIGITS (16)
+
+/**
+ * Max number of batched DTMF commands that may be queued/pending at the same
+ * time, once the phone is known to accept batched digits.
+ */
+#define DTMF_PIPELINE_DEPTH (2)
+
+/**
+ * Delay after each successfully sent DTMF digit when sending one digit per 
+ * command (10ms units).
+ */
+#define DTMF_DIGIT_INTERVAL (10)
+
+/**
+ * Whether the phone accepts multiple DTMF digits in a single "+VTS" command.
+ */
+typedef enum DTMFBatchSupport {
+  /**
+   * Not yet known. Only one batched command is sent at a time until the
+   * phone responds.
+   */
+  DTMFBatchSupport_UNKNOWN,
+  DTMFBatchSupport_SUPPORTED,
+  /**
+   * The phone rejected a batched command. Digits are sent one per command.
+   */
+  DTMFBatchSupport_REJECTED
+} DTMFBatchSupport;
+
 static struct {
   ATCMD_UnsolicitedResultHandler unsolicitedResultHandler;
   
@@ -42,12 +113,22 @@ static struct {
   } cmdBuffer;
   
   struct {
-    bool isDigitPending;
     timeout_t nextDigitTimeout;
     char buffer[MAX_EXTENDED_PHONE_NUMBER_LENGTH];
     uint8_t head;
     uint8_t tail;
     uint8_t bufferSize;
+    // Number of digits at the tail of the buffer that have been sent, but 
+    // not yet acknowledged.
+    uint8_t sentSize;
+    // Number of digits in each sent command that has not yet been 
+    // acknowledged, oldest first.
+    uint8_t pendingCmdLengths[DTMF_PIPELINE_DEPTH];
+    uint8_t pendingCmdCount;
+    // Number of responses to ignore for commands that were sent before
+    // the DTMF digits were cancelled.
+    uint8_t ignoredResponseCount;
+    DTMFBatchSupport batchSupport;
   } dtmfState;
 } module;
 
@@ -90,39 +171,94 @@ static void sendNextCommand(void) {
   BT_SendBytesAsCompleteCommand(command, len + 6);    
 }
 
-static void handleDTMFDigitAtResponse(ATCMD_Response response, char const* result) {
-  if (response != ATCMD_Response_OK) {
-    // If the command failed, then cancel all remaining pending DTMF digits.
-    // This is most likely caused by no longer being in a call.
-    ATCMD_CancelDTMFDigits();
-  } else {
-    module.dtmfState.isDigitPending = false;
-    TIMEOUT_Start(&module.dtmfState.nextDigitTimeout, 10);
+static uint8_t getDTMFBufferIndex(uint8_t offset) {
+  uint8_t index = module.dtmfState.tail + offset;
+  
+  if (index >= MAX_EXTENDED_PHONE_NUMBER_LENGTH) {
+    index -= MAX_EXTENDED_PHONE_NUMBER_LENGTH;
   }
+  
+  return index;
 }
 
-static bool sendDTMFDigitAtCmd(char digit) {
-  char command[] = "+VTS=?";
-  command[5] = digit;
-  return ATCMD_Send(command, handleDTMFDigitAtResponse);
+static void removeDTMFDigits(uint8_t count) {
+  module.dtmfState.tail = getDTMFBufferIndex(count);
+  module.dtmfState.bufferSize -= count;
 }
 
-static void sendNextDTMFStringDigit(void) {
-  if (
-      !module.dtmfState.bufferSize || 
-      module.dtmfState.isDigitPending || 
-      TIMEOUT_IsPending(&module.dtmfState.nextDigitTimeout)
-      ) {
+static void handleDTMFAtResponse(ATCMD_Response response, char const* result, uint8_t resultLength) {
+  if (response == ATCMD_Response_RESULT) {
+    return;
+  }
+  
+  if (module.dtmfState.ignoredResponseCount) {
+    --module.dtmfState.ignoredResponseCount;
     return;
   }
   
-  if (sendDTMFDigitAtCmd(module.dtmfState.buffer[module.dtmfState.tail])) {
-    module.dtmfState.isDigitPending = true;
+  uint8_t const length = module.dtmfState.pendingCmdLengths[0];
+  
+  --module.dtmfState.pendingCmdCount;
+  for (uint8_t i = 0; i < module.dtmfState.pendingCmdCount; ++i) {
+    module.dtmfState.pendingCmdLengths[i] = module.dtmfState.pendingCmdLengths[i + 1];
+  }
+  
+  if (response == ATCMD_Response_OK) {
+    if (length > 1) {
+      module.dtmfState.batchSupport = DTMFBatchSupport_SUPPORTED;
+    }
 
-    --module.dtmfState.bufferSize;
-    if (++module.dtmfState.tail == MAX_EXTENDED_PHONE_NUMBER_LENGTH) {
-      module.dtmfState.tail = 0;
+    removeDTMFDigits(length);
+    module.dtmfState.sentSize -= length;
+    
+    if (module.dtmfState.batchSupport == DTMFBatchSupport_REJECTED) {
+      TIMEOUT_Start(&module.dtmfState.nextDigitTimeout, DTMF_DIGIT_INTERVAL);
     }
+  } else if ((length > 1) && (module.dtmfState.batchSupport == DTMFBatchSupport_UNKNOWN)) {
+    // The phone may not accept multiple digits in one command. Send all of 
+    // the same digits again, one per command. If that also fails, then it 
+    // will be handled below.
+    // NOTE: There are no other pending commands, because only one batched 
+    //       command is sent at a time until batching is known to be supported.
+    printf("[ATCMD] DTMF batch rejected; sending one digit at a time\r\n");
+    module.dtmfState.batchSupport = DTMFBatchSupport_REJECTED;
+    module.dtmfState.sentSize = 0;
+  } else {
+    // If the command failed, then cancel all remaining pending DTMF digits.
+    // This is most likely caused by no longer being in a call.
+    ATCMD_CancelDTMFDigits();
+  }
+}
+
+static void sendNextDTMFCommand(void) {
+  uint8_t const unsentSize = module.dtmfState.bufferSize - module.dtmfState.sentSize;
+  
+  if (!unsentSize || TIMEOUT_IsPending(&module.dtmfState.nextDigitTimeout)) {
+    return;
+  }
+  
+  uint8_t const maxPendingCmdCount = 
+      (module.dtmfState.batchSupport == DTMFBatchSupport_SUPPORTED) ? DTMF_PIPELINE_DEPTH : 1;
+  
+  if (module.dtmfState.pendingCmdCount >= maxPendingCmdCount) {
+    return;
+  }
+  
+  uint8_t const maxLength = 
+      (module.dtmfState.batchSupport == DTMFBatchSupport_REJECTED) ? 1 : DTMF_BATCH_MAX_DIGITS;
+  char command[sizeof("+VTS=") + DTMF_BATCH_MAX_DIGITS] = "+VTS=";
+  char* nextChar = command + sizeof("+VTS=") - 1;
+  uint8_t length = 0;
+  
+  while ((length < unsentSize) && (length < maxLength)) {
+    *nextChar++ = module.dtmfState.buffer[getDTMFBufferIndex(module.dtmfState.sentSize + length)];
+    ++length;
+  }
+  *nextChar = 0;
+  
+  if (ATCMD_Send(command, handleDTMFAtResponse)) {
+    module.dtmfState.pendingCmdLengths[module.dtmfState.pendingCmdCount++] = length;
+    module.dtmfState.sentSize += length;
   } else {
     ATCMD_CancelDTMFDigits();
   }
@@ -137,20 +273,19 @@ void ATCMD_Initialize(ATCMD_UnsolicitedResultHandler unsolicitedResultHandler) {
   module.cmdInfoBuffer.head = module.cmdInfoBuffer.tail = 0;
   module.cmdInfoBuffer.remaining = COMMAND_INFO_BUFFER_SIZE;
 
+  module.dtmfState.pendingCmdCount = 0;
+  module.dtmfState.ignoredResponseCount = 0;
+  TIMEOUT_InitializeOnTimerWheel(&module.dtmfState.nextDigitTimeout);
   ATCMD_CancelDTMFDigits();
 }
 
 void ATCMD_Task(void) {
   TIMEOUT_Task(&module.dtmfState.nextDigitTimeout);
   
-  sendNextDTMFStringDigit();
+  sendNextDTMFCommand();
   sendNextCommand();
 }
 
-void ATCMD_Timer10ms_Interrupt(void) {
-  TIMEOUT_Timer_Interrupt(&module.dtmfState.nextDigitTimeout);
-}
-
 bool ATCMD_Send(char const *cmd, ATCMD_ResponseCallback responseCallback) {
   printf("[ATCMD] Queuing: %s\r\n", cmd);
   
@@ -176,10 +311,7 @@ bool ATCMD_Send(char const *cmd, ATCMD_ResponseCallback responseCallback) {
   cmdInfo->cmdLen = (uint8_t)len;
   cmdInfo->responseCallback = responseCallback;
 
-  size_t prefixLen = strcspn(cmd, "?=");
-  memcpy(cmdInfo->resultPrefix, cmd, prefixLen);
-  cmdInfo->resultPrefix[prefixLen] = ':';
-  cmdInfo->resultPrefix[prefixLen + 1] = 0;
+  cmdInfo->resultCode = findResultCode(cmd, (uint8_t)strcspn(cmd, "?="));
   
   --module.cmdInfoBuffer.remaining;
   if (++module.cmdInfoBuffer.head == COMMAND_INFO_BUFFER_SIZE) {
@@ -198,6 +330,9 @@ bool ATCMD_Send(char const *cmd, ATCMD_ResponseCallback responseCallback) {
   }
   module.cmdBuffer.head = pos;
   
+  // Sent by ATCMD_Task()
+  SCHEDULER_MarkRunnable(SCHEDULER_Task_APP);
+  
   return true;
 }
 
@@ -216,6 +351,7 @@ bool ATCMD_SendDTMFDigit(char digit) {
   }
   
   ++module.dtmfState.bufferSize;
+  SCHEDULER_MarkRunnable(SCHEDULER_Task_APP);
   
   return true;
 }
@@ -229,26 +365,30 @@ void ATCMD_SendDTMFDigitString(char const* dtmfString) {
 void ATCMD_CancelDTMFDigits(void) {
   module.dtmfState.tail = module.dtmfState.head = 0;
   module.dtmfState.bufferSize = 0;
-  module.dtmfState.isDigitPending = false;
+  module.dtmfState.sentSize = 0;
+  module.dtmfState.ignoredResponseCount += module.dtmfState.pendingCmdCount;
+  module.dtmfState.pendingCmdCount = 0;
+  // A failure may have been caused by something other than batching (e.g., 
+  // the call ended), so find out again next time.
+  module.dtmfState.batchSupport = DTMFBatchSupport_UNKNOWN;
   TIMEOUT_Cancel(&module.dtmfState.nextDigitTimeout);
 }
 
 void ATCMD_BT_ResultHandler(char const* result, uint8_t length) {
   ATCMD_CmdInfo const* pendingCmd = module.cmdInfoBuffer.pendingCmd;
+  char const* const separator = memchr(result, ':', length);
+  ATCMD_ResultCode const resultCode = separator 
+      ? findResultCode(result, (uint8_t)(separator - result)) 
+      : ATCMD_ResultCode_NONE;
   
-  char resultBuffer[255];
-
-  memcpy(resultBuffer, result, length);
-  resultBuffer[length] = 0;
-  
-  printf("[ATCMD] Result: %s\r\n", resultBuffer);
+  printf("[ATCMD] Result: %.*s\r\n", length, result);
   
-  if (pendingCmd && strstart(resultBuffer, pendingCmd->resultPrefix)) {
+  if (pendingCmd && (resultCode != ATCMD_ResultCode_NONE) && (resultCode == pendingCmd->resultCode)) {
     if (pendingCmd->responseCallback) {
-      pendingCmd->responseCallback(ATCMD_Response_RESULT, resultBuffer);
+      pendingCmd->responseCallback(ATCMD_Response_RESULT, result, length);
     }
   } else {
-    module.unsolicitedResultHandler(resultBuffer);
+    module.unsolicitedResultHandler(resultCode, result, length);
   }
 }
 
@@ -273,7 +413,7 @@ void ATCMD_BT_ResponseHandler(ATCMD_Response response) {
   ATCMD_ResponseCallback responseCallback = pendingCmd->responseCallback;
   
   if (responseCallback) {
-    responseCallback(response, NULL);
+    responseCallback(response, NULL, 0);
   }
   
   module.cmdBuffer.remaining += pendingCmd->cmdLen;
@@ -284,4 +424,9 @@ void ATCMD_BT_ResponseHandler(ATCMD_Response response) {
   
   ++module.cmdInfoBuffer.remaining;
   module.cmdInfoBuffer.pendingCmd = NULL;
+  
+  // The next command can now be sent by ATCMD_Task(), and there is room for 
+  // another command from the application or the phonebook.
+  SCHEDULER_MarkRunnable(SCHEDULER_Task_APP);
+  SCHEDULER_MarkRunnable(SCHEDULER_Task_PHONEBOOK);
 }
@@ -21,22 +21,96 @@ typedef enum ATCMD_Response {
   ATCMD_Response_RESULT
 } ATCMD_Response;
 
-typedef void (*ATCMD_ResponseCallback)(ATCMD_Response response, char const* result);
-
-typedef void (*ATCMD_UnsolicitedResultHandler)(char const* result);
+/**
+ * Known AT result codes, as X(code, prefix) entries: the ATCMD_ResultCode 
+ * name suffix and the command/result prefix.
+ * 
+ * Both the ATCMD_ResultCode enum and the table of prefixes in atcmd.c are 
+ * generated from this list.
+ */
+#define ATCMD_RESULT_CODES(X) \
+  X(CLCC, "+CLCC") \
+  X(CIEV, "+CIEV") \
+  X(CLIP, "+CLIP") \
+  X(CCWA, "+CCWA") \
+  X(BTRH, "+BTRH") \
+  X(CNUM, "+CNUM") \
+  X(COPS, "+COPS") \
+  X(CIND, "+CIND") \
+  X(CHLD, "+CHLD") \
+  X(BVRA, "+BVRA") \
+  X(BSIR, "+BSIR") \
+  X(VGS, "+VGS") \
+  X(VGM, "+VGM") \
+  X(CPBR, "+CPBR") \
+  X(CME_ERROR, "+CME ERROR")
+
+#define ATCMD_RESULT_CODE_ENUM_VALUE(code, prefix) ATCMD_ResultCode_##code,
+
+/**
+ * Known AT result codes.
+ * 
+ * Each queued command stores the code of the results it expects, and each
+ * received result is routed by its code, instead of by comparing strings.
+ */
+typedef enum ATCMD_ResultCode {
+  /**
+   * Unknown result code, or a command that produces no results.
+   */
+  ATCMD_ResultCode_NONE,
+  ATCMD_RESULT_CODES(ATCMD_RESULT_CODE_ENUM_VALUE)
+  ATCMD_ResultCode_COUNT
+} ATCMD_ResultCode;
+
+/**
+ * Callback for the response to a command.
+ * 
+ * @param response - The type of response.
+ * @param result - For ATCMD_Response_RESULT, the result text. This points 
+ *        directly into the received event data, so it is NOT null-terminated 
+ *        and is only valid for the duration of the callback. Otherwise, NULL.
+ * @param resultLength - The length of the result text.
+ */
+typedef void (*ATCMD_ResponseCallback)(ATCMD_Response response, char const* result, uint8_t resultLength);
+
+/**
+ * Handler for results that do not match the currently pending command.
+ * 
+ * @param resultCode - The result code of the result.
+ * @param result - The result text. This points directly into the received 
+ *        event data, so it is NOT null-terminated and is only valid for the 
+ *        duration of the handler.
+ * @param resultLength - The length of the result text.
+ */
+typedef void (*ATCMD_UnsolicitedResultHandler)(ATCMD_ResultCode resultCode, char const* result, uint8_t resultLength);
 
 void ATCMD_Initialize(ATCMD_UnsolicitedResultHandler unsolicitedResultCallback);
 
 void ATCMD_Task(void);
 
-void ATCMD_Timer10ms_Interrupt(void);
-
 bool ATCMD_Send(char const *cmd, ATCMD_ResponseCallback responseCallback);
 
+/**
+ * Queues a DTMF digit to be sent.
+ * 
+ * Queued digits are sent in batches of multiple digits per command if the 
+ * phone accepts it, otherwise one digit per command.
+ * 
+ * @param digit - A DTMF digit.
+ * @return True if the digit was queued.
+ */
 bool ATCMD_SendDTMFDigit(char digit);
 
+/**
+ * Queues all DTMF digits in a string to be sent (see ATCMD_SendDTMFDigit()).
+ * 
+ * @param dtmfString - A null-terminated string of DTMF digits.
+ */
 void ATCMD_SendDTMFDigitString(char const* dtmfString);
 
+/**
+ * Cancels all queued DTMF digits that have not yet been sent.
+ */
 void ATCMD_CancelDTMFDigits(void);
 
 void ATCMD_BT_ResultHandler(char const* result, uint8_t length);
@@ -23,11 +23,18 @@
 #include "bt_command_decode.h"
 #include "bt_command_send.h"
 #include "atcmd.h"
-#include "../../mcc_generated_files/uart2.h"
 #include "../app.h"
+#include "../util/scheduler.h"
+#include <stdio.h>
 
 #define BT_CMD_SIZE_MAX				200
 
+/**
+ * Number of complete received frames that can be queued up for processing
+ * by BT_CommandDecode_Task(). Must be a power of 2.
+ */
+#define FRAME_QUEUE_SIZE      4
+
 //command decode state machine
 typedef enum {
 	RX_DECODE_CMD_SYNC_AA,
@@ -157,101 +164,164 @@ enum
 /*======================*/
 /*  external variables  */
 /*======================*/
-uint8_t  BT_CmdDecodedFlag;
-uint8_t  BT_CmdBuffer[BT_CMD_SIZE_MAX	];
 uint8_t  BT_linkIndex = 0;
 
 /*======================================*/
 /*  internal variables          */
 /*======================================*/
+//complete frame received and verified by the UART2 Rx interrupt
+typedef struct {
+    uint8_t length;
+    uint8_t data[BT_CMD_SIZE_MAX];
+} RX_FRAME;
+
+//queue of received frames; written by the UART2 Rx interrupt, read by BT_CommandDecode_Task()
+static struct {
+    RX_FRAME frames[FRAME_QUEUE_SIZE];
+    volatile uint8_t head;              //free-running count of frames added (written only by interrupt)
+    volatile uint8_t tail;              //free-running count of frames processed (written only by main loop)
+} BT_FrameQueue;
+
+//decode state (accessed only by the UART2 Rx interrupt after initialization)
 static RX_DECODE_MODE  BT_CmdDecodeState;
-static uint8_t  BT_CmdDecodeCmdLength;
 static uint8_t  BT_CmdDecodeChecksum;			
 static uint8_t  BT_CmdDecodeDataCnt;                    //temporary variable in decoding
-static unsigned short BT_CmdBufferPt;                    //
+static uint8_t* BT_CmdDecodeDataPt;                     //destination of decoded data; NULL if the frame is being dropped
+
+//statistics (written only by the UART2 Rx interrupt)
+static volatile uint16_t BT_DroppedFrameCount;          //frames discarded because the queue was full
+static volatile uint16_t BT_ChecksumFailureCount;       //frames discarded because of a bad checksum
+static volatile uint8_t  BT_FrameQueueHighWaterMark;    //max number of frames queued at once
+
+//last reported statistics
+static uint16_t BT_ReportedDroppedFrameCount;
+static uint16_t BT_ReportedChecksumFailureCount;
+static uint8_t  BT_ReportedFrameQueueHighWaterMark;
+
+//frame currently being processed by BT_CommandDecode()
+static uint8_t* BT_CmdBuffer;
+static uint8_t  BT_CmdDecodeCmdLength;
 
 /*======================================*/
 /*  function implemention       */
 /*======================================*/
 void BT_CommandDecode_Initialize(void)
 {
-    BT_CmdDecodedFlag = 0;
+    PIE8bits.U2RXIE = 0;
     BT_CmdDecodeState = RX_DECODE_CMD_SYNC_AA;
-    while(uart2RxCount)
-    {
-        UART2_Read();
-    }
+    BT_FrameQueue.head = 0;
+    BT_FrameQueue.tail = 0;
+    BT_DroppedFrameCount = 0;
+    BT_ChecksumFailureCount = 0;
+    BT_FrameQueueHighWaterMark = 0;
+    BT_ReportedDroppedFrameCount = 0;
+    BT_ReportedChecksumFailureCount = 0;
+    BT_ReportedFrameQueueHighWaterMark = 0;
+    PIE8bits.U2RXIE = 1;
     // BT_SPPBuffClear();
 }
 
 void BT_CommandDecode_Task(void)
 {
-	BT_CommandHandler();
-	if(BT_CmdDecodedFlag)
-	{
-            BT_CommandDecode();
-            BT_CmdDecodedFlag = 0;
-	}
-}
-
-extern volatile uint8_t uart2RxCount;
+    //process every frame that is queued up
+    while (BT_FrameQueue.tail != BT_FrameQueue.head)
+    {
+        RX_FRAME* frame = &BT_FrameQueue.frames[BT_FrameQueue.tail & (FRAME_QUEUE_SIZE - 1)];
+        BT_CmdBuffer = frame->data;
+        BT_CmdDecodeCmdLength = frame->length;
+        BT_CommandDecode();
+        //release the frame slot back to the interrupt
+        BT_FrameQueue.tail++;
+    }
 
-void BT_CommandHandler(void) {
-    uint8_t current_byte;
+    //read 16-bit counters with the interrupt disabled to avoid a torn read
+    PIE8bits.U2RXIE = 0;
+    uint16_t droppedFrameCount = BT_DroppedFrameCount;
+    uint16_t checksumFailureCount = BT_ChecksumFailureCount;
+    PIE8bits.U2RXIE = 1;
 
-    while (uart2RxCount) {
-        current_byte = UART2_Read();
+    if (droppedFrameCount != BT_ReportedDroppedFrameCount) {
+        BT_ReportedDroppedFrameCount = droppedFrameCount;
+        printf("[BT] Dropped frames (queue full): %u\r\n", droppedFrameCount);
+    }
 
-        switch (BT_CmdDecodeState) {
-            case RX_DECODE_CMD_SYNC_AA:
-                if (current_byte == 0xaa)
-                    BT_CmdDecodeState = RX_DECODE_CMD_SYNC_00;
-                break;
+    if (checksumFailureCount != BT_ReportedChecksumFailureCount) {
+        BT_ReportedChecksumFailureCount = checksumFailureCount;
+        printf("[BT] Checksum failures: %u\r\n", checksumFailureCount);
+    }
 
-            case RX_DECODE_CMD_SYNC_00:
-                if (current_byte == 0x00)
-                    BT_CmdDecodeState = RX_DECODE_CMD_LENGTH;
-                else
-                    BT_CmdDecodeState = RX_DECODE_CMD_SYNC_AA;
-                break;
+    if (BT_FrameQueueHighWaterMark != BT_ReportedFrameQueueHighWaterMark) {
+        BT_ReportedFrameQueueHighWaterMark = BT_FrameQueueHighWaterMark;
+        printf("[BT] Frame queue high water mark: %u\r\n", BT_ReportedFrameQueueHighWaterMark);
+    }
+}
 
-            case RX_DECODE_CMD_LENGTH:
-                BT_CmdDecodedFlag = 0; //command receive flag clear
-                BT_CmdBufferPt = 0; //buffer reset for command parameter
-                BT_CmdDecodeCmdLength = current_byte;
-                BT_CmdDecodeChecksum = current_byte; //checksum calculation start!
-                BT_CmdDecodeDataCnt = current_byte; //save bytes number, use to check where is command end
-                BT_CmdDecodeState = RX_DECODE_CMD_DATA; //next state
-                break;
+void BT_CommandDecode_RxByte(uint8_t current_byte) {
+    switch (BT_CmdDecodeState) {
+        case RX_DECODE_CMD_SYNC_AA:
+            if (current_byte == 0xaa)
+                BT_CmdDecodeState = RX_DECODE_CMD_SYNC_00;
+            break;
 
-            case RX_DECODE_CMD_DATA:
-                BT_CmdDecodeChecksum += current_byte;
-                BT_CmdDecodeDataCnt--;
-                BT_CmdBuffer[BT_CmdBufferPt++] = current_byte;
-                if (BT_CmdDecodeDataCnt == 0) //no data remained?
-                    BT_CmdDecodeState = RX_DECODE_CMD_CHECKSUM; //yes, next mode: checksum
-                break;
+        case RX_DECODE_CMD_SYNC_00:
+            if (current_byte == 0x00)
+                BT_CmdDecodeState = RX_DECODE_CMD_LENGTH;
+            else
+                BT_CmdDecodeState = RX_DECODE_CMD_SYNC_AA;
+            break;
 
-            case RX_DECODE_CMD_CHECKSUM:
-                if ((uint8_t) (BT_CmdDecodeChecksum + current_byte) == 0) {
-                    BT_CmdDecodedFlag = 1;
-                } else {
-                }
+        case RX_DECODE_CMD_LENGTH:
+            if (current_byte == 0 || current_byte > BT_CMD_SIZE_MAX) {
+                //invalid length; discard and wait for the next sync
                 BT_CmdDecodeState = RX_DECODE_CMD_SYNC_AA;
                 break;
-            default:
-                break;
-        }
+            }
+            if ((uint8_t)(BT_FrameQueue.head - BT_FrameQueue.tail) == FRAME_QUEUE_SIZE) {
+                //no free frame slot; still decode the frame to stay in sync, but drop the data
+                BT_CmdDecodeDataPt = NULL;
+            } else {
+                RX_FRAME* frame = &BT_FrameQueue.frames[BT_FrameQueue.head & (FRAME_QUEUE_SIZE - 1)];
+                frame->length = current_byte;
+                BT_CmdDecodeDataPt = frame->data;
+            }
+            BT_CmdDecodeChecksum = current_byte; //checksum calculation start!
+            BT_CmdDecodeDataCnt = current_byte; //save bytes number, use to check where is command end
+            BT_CmdDecodeState = RX_DECODE_CMD_DATA; //next state
+            break;
 
-        if (BT_CmdDecodedFlag) {
+        case RX_DECODE_CMD_DATA:
+            BT_CmdDecodeChecksum += current_byte;
+            BT_CmdDecodeDataCnt--;
+            if (BT_CmdDecodeDataPt)
+                *BT_CmdDecodeDataPt++ = current_byte;
+            if (BT_CmdDecodeDataCnt == 0) //no data remained?
+                BT_CmdDecodeState = RX_DECODE_CMD_CHECKSUM; //yes, next mode: checksum
+            break;
+
+        case RX_DECODE_CMD_CHECKSUM:
+            if ((uint8_t) (BT_CmdDecodeChecksum + current_byte) != 0) {
+                if (BT_ChecksumFailureCount != UINT16_MAX)
+                    BT_ChecksumFailureCount++;
+            } else if (!BT_CmdDecodeDataPt) {
+                if (BT_DroppedFrameCount != UINT16_MAX)
+                    BT_DroppedFrameCount++;
+            } else {
+                //publish the frame to the main loop
+                uint8_t queued = (uint8_t)(++BT_FrameQueue.head - BT_FrameQueue.tail);
+                if (queued > BT_FrameQueueHighWaterMark)
+                    BT_FrameQueueHighWaterMark = queued;
+                SCHEDULER_MarkRunnable(SCHEDULER_Task_BT_COMMAND_DECODE);
+            }
+            BT_CmdDecodeState = RX_DECODE_CMD_SYNC_AA;
+            break;
+        default:
             break;
-        }
     }
 }
 
 void BT_CommandDecode( void )
 {
-    uint8_t spp_type, cmdInfo = CMD_INFO_IGNORE;
+    uint8_t cmdInfo = CMD_INFO_IGNORE;
     uint16_t spp_total_length;
     uint16_t spp_payload_length;
     uint16_t para;
@@ -333,7 +403,7 @@ void BT_CommandDecode( void )
         break;
       
       case UNKNOW_AT_RESULT:
-        ATCMD_BT_ResultHandler(&BT_CmdBuffer[2], BT_CmdDecodeCmdLength - 2);
+        ATCMD_BT_ResultHandler((char const*)&BT_CmdBuffer[2], BT_CmdDecodeCmdLength - 2);
         break;
       
       case REPORT_LINKED_DEVICE_INFO:
@@ -582,8 +652,6 @@ void BT_CommandDecode( void )
                         
         case REPORT_SPP_DATA:
  
-            spp_type = BT_CmdBuffer[2];
-
             spp_total_length = (uint16_t)BT_CmdBuffer[3];
             spp_total_length <<= 8;
             spp_total_length |= (uint16_t)BT_CmdBuffer[4];
@@ -132,10 +132,12 @@ typedef enum
 
 uint8_t BT_linkIndex;
 
-void BT_CommandHandler(void);
 void BT_CommandDecode( void );
 
 void BT_CommandDecode_Initialize(void);
 void BT_CommandDecode_Task(void);
 
+//called from the UART2 Rx interrupt for each received byte
+void BT_CommandDecode_RxByte(uint8_t rxByte);
+
 #endif
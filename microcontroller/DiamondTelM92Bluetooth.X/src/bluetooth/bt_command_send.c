@@ -28,14 +28,29 @@
 #include "../../mcc_generated_files/uart2.h"
 #include "../../mcc_generated_files/pin_manager.h"
 #include "../app.h"
+#include "../util/scheduler.h"
 
 #define ACK_TIME_OUT_MS                 1000
 #define APP_INPUT_WAITING_TIME_OUT_MS   100
 #define INTERVAL_AFTER_ACK_CMD          20
 #define QUEQUED_CMD_MAX                 20
 
+//Max number of sent commands that may be waiting for an ACK at the same time.
+//Set to 0 to use strict mode instead, where each command must be ACKed, 
+//followed by a delay, before the next command is sent.
+#ifndef PIPELINED_CMD_WINDOW
+#define PIPELINED_CMD_WINDOW            4
+#endif
+//Min interval between sending commands in pipelined mode
+#define PIPELINED_CMD_INTERVAL_MS       2
+
+//DMA trigger: UART2 Tx interrupt vector number
+#define UART_TX_DMA_SIRQ                0x45
+
 static struct {
     uint8_t SendingCmdNum;
+    uint8_t SentCmdNum;                 //number of commands at the front of the array that have been sent (pipelined mode only)
+    uint8_t TransmitIndex;              //index of the command being sent by UART_TransferFirstByte() (always 0 in strict mode)
     struct{
         uint16_t startBufPt;
         uint16_t endBufPt;
@@ -47,10 +62,21 @@ static struct {
 } BT_SendingCmd;
 
 #define UR_TX_BUF_SIZE              400
+#if UART_TX_USE_DMA
+//Max size of a single command. The start of the buffer is mirrored into this 
+//many extra bytes past the end of the buffer so that every command can be 
+//sent by DMA as one contiguous block, even if it wraps around the buffer.
+#define UR_TX_CMD_SIZE_MAX          136
+#define UR_TX_BUF_MIRROR_SIZE       (UR_TX_CMD_SIZE_MAX - 1)
+static uint8_t          UR_TxBuf[UR_TX_BUF_SIZE + UR_TX_BUF_MIRROR_SIZE];
+#else
 static uint8_t          UR_TxBuf[UR_TX_BUF_SIZE];
+#endif
 static uint16_t         UR_TxBufHead;
 static uint16_t         UR_TxBufTail;
+#if !UART_TX_USE_DMA
 static uint16_t         UR_TxBufTail2;
+#endif
 typedef enum {
 	TXRX_BUF_EMPTY,
 	TXRX_BUF_OK,
@@ -72,10 +98,22 @@ uint16_t BT_commandOverRun=0;
 uint16_t BT_bufferOverRun=0;
 uint8_t gatt_status_code=0;
 
-static bool copyCommandToBuffer(uint8_t* data, uint16_t size, uint8_t cmdInfo);
+#if PIPELINED_CMD_WINDOW
+static volatile bool     BT_isTransmitting;         //true while the UART Tx interrupt/DMA is sending a command
+#if !UART_TX_USE_DMA
+static volatile uint16_t BT_TxEndBufPt;             //end of the command being sent by the UART Tx interrupt
+#endif
+static bool              BT_isTxCompletionPending;  //true until BT_CommandSend_Task() handles completion of the last sent command
+static volatile uint16_t BT_AckTimer;               //timeout for the oldest sent command that is waiting for an ACK
+#endif
+
+static bool copyCommandToBuffer(uint8_t const* data, uint16_t size, uint8_t cmdInfo);
 static bool StartRegisterNewCommand(uint16_t start_index, uint16_t cmd_size, uint8_t cmd_id, uint8_t cmd_info);
 static bool EndRegisterNewCommand(uint16_t end_index);
 static bool RemoveFirstCommand(void);
+#if UART_TX_USE_DMA
+static void UART_DMA_Initialize(void);
+#endif
 
 /*======================================*/
 /*  function implemention  */
@@ -83,15 +121,16 @@ static bool RemoveFirstCommand(void);
 void BT_GiveUpThisCommand( void )
 {
     RemoveFirstCommand();
+    SCHEDULER_MarkRunnable(SCHEDULER_Task_BT_COMMAND_SEND);
 }
 /*------------------------------------------------------------*/
 
 /*------------------------------------------------------------*/
-bool copySendingCommandToBuffer(uint8_t* data, uint16_t size)
+bool copySendingCommandToBuffer(uint8_t const* data, uint16_t size)
 {
 	return copyCommandToBuffer(data, size, CMD_INFO_MCU);
 }
-static bool copyCommandToBuffer(uint8_t* data, uint16_t size, uint8_t cmdInfo)
+static bool copyCommandToBuffer(uint8_t const* data, uint16_t size, uint8_t cmdInfo)
 {
     bool buf_result = true;
     uint8_t ur_tx_buf_status_save = UR_TxBufStatus;
@@ -114,6 +153,14 @@ static bool copyCommandToBuffer(uint8_t* data, uint16_t size, uint8_t cmdInfo)
 		}
 	}
 
+#if UART_TX_USE_DMA
+    if(size > UR_TX_CMD_SIZE_MAX)
+    {
+        BT_bufferOverRun++;
+        return false;
+    }
+#endif
+
     if(UR_TxBufStatus !=  TXRX_BUF_FULL)
     {
         if(!StartRegisterNewCommand(UR_TxBufHead, size, data[3], cmdInfo))
@@ -123,6 +170,10 @@ static bool copyCommandToBuffer(uint8_t* data, uint16_t size, uint8_t cmdInfo)
         
         while(size--)
         {
+#if UART_TX_USE_DMA
+            if(UR_TxBufHead < UR_TX_BUF_MIRROR_SIZE)
+                UR_TxBuf[UR_TX_BUF_SIZE + UR_TxBufHead] = *data;
+#endif
             UR_TxBuf[UR_TxBufHead++] = *data++;
 
             if(UR_TxBufHead >= UR_TX_BUF_SIZE)
@@ -174,9 +225,9 @@ uint8_t BT_CalculateCmdChecksum(uint8_t const* startByte, uint8_t const* endByte
     return checksum;
 }
 
-void BT_SendBytesAsCompleteCommand(uint8_t const* command, uint8_t command_length)
+bool BT_SendBytesAsCompleteCommand(uint8_t const* command, uint8_t command_length)
 {
-    copySendingCommandToBuffer(command, command_length);
+    return copySendingCommandToBuffer(command, command_length);
 }
 
 /*------------------------------------------------------------*/
@@ -417,11 +468,150 @@ void BT_CommandSend_Initialize( void )
     UR_TxBufTail = 0;
     UR_TxBufStatus = TXRX_BUF_EMPTY;
     BT_SendingCmd.SendingCmdNum = 0;
+    BT_SendingCmd.SentCmdNum = 0;
+    BT_SendingCmd.TransmitIndex = 0;
+#if UART_TX_USE_DMA
+    UART_DMA_Initialize();
+#endif
 }
 
 /*------------------------------------------------------------*/
+#if PIPELINED_CMD_WINDOW
+static void SendNoAckForOldestCommand(void)
+{
+    BT_SendingCmd.SendingCmdArray[0].cmdStatus = ERROR_NO_ACK;
+    APP_BT_EventHandler(BT_EVENT_CMD_SENT_NO_ACK, (uint16_t)(BT_SendingCmd.SendingCmdArray[0].cmdID),  0);        //send event to user application layer with command id, and event type
+
+    if (BT_SendingCmd.SendingCmdArray[0].cmdID == VENDOR_AT_CMD) {
+        ATCMD_BT_ResponseHandler(ATCMD_Response_FAILED);
+    }
+}
+
+//sends (or re-sends) the command at the index, which must be at most SentCmdNum - 1
+static void StartSendingCommand(uint8_t index)
+{
+#if !UART_TX_USE_DMA
+    uint8_t txie;
+#endif
+
+    BT_SendingCmd.TransmitIndex = index;
+    BT_SendingCmd.SendingCmdArray[index].cmdStatus = IN_SENDING;
+    BT_isTxCompletionPending = true;
+
+    if (index == 0)
+        BT_AckTimer = ACK_TIME_OUT_MS;
+
+#if UART_TX_USE_DMA
+    BT_isTransmitting = true;
+    UART_TransferFirstByte();
+#else
+    //The Tx interrupt may still be running to finish the previous command,
+    //so it must be disabled while updating its variables.
+    txie = PIE8bits.U2TXIE;
+    PIE8bits.U2TXIE = 0;
+    UR_TxBufTail2 = BT_SendingCmd.SendingCmdArray[index].startBufPt;
+    BT_TxEndBufPt = BT_SendingCmd.SendingCmdArray[index].endBufPt;
+    BT_isTransmitting = true;
+
+    if (txie)
+        PIE8bits.U2TXIE = 1;        //Tx interrupt will continue with this command
+    else
+        UART_TransferNextByte();    //send the first byte, which also enables the Tx interrupt
+#endif
+}
+
+static void PipelinedTask(void)
+{
+    //handle completion of sending the last sent command
+    if (BT_isTxCompletionPending && !BT_isTransmitting)
+    {
+        BT_isTxCompletionPending = false;
+
+        if (BT_SendingCmd.SendingCmdArray[BT_SendingCmd.TransmitIndex].cmdID == MCU_SEND_EVENT_ACK)
+            BT_SendingCmd.SendingCmdArray[BT_SendingCmd.TransmitIndex].cmdStatus = STS_OK;     //no ACK for an ACK
+
+        BT_CommandSendTimer = PIPELINED_CMD_INTERVAL_MS;
+    }
+
+    //release commands from the front of the queue, in order, as they are completed
+    //(a command without an ACK stays until it is re-sent or given up by the app)
+    while (BT_SendingCmd.SentCmdNum && 
+            BT_SendingCmd.SendingCmdArray[0].cmdStatus != IN_SENDING &&
+            BT_SendingCmd.SendingCmdArray[0].cmdStatus != ERROR_NO_ACK &&
+            !(BT_isTxCompletionPending && BT_SendingCmd.TransmitIndex == 0))
+    {
+        RemoveFirstCommand();
+        BT_AckTimer = ACK_TIME_OUT_MS;
+    }
+
+    //the oldest command gave up waiting for an ACK; same as strict mode from here:
+    //wait, then re-send it (unless the app gave up on it), before sending anything new
+    if (BT_SendingCmd.SentCmdNum && !BT_AckTimer &&
+            BT_SendingCmd.SendingCmdArray[0].cmdStatus == IN_SENDING &&
+            !(BT_isTxCompletionPending && BT_SendingCmd.TransmitIndex == 0))
+    {
+        SendNoAckForOldestCommand();
+        BT_AckTimer = ACK_TIME_OUT_MS;
+        BT_CommandSendTimer = APP_INPUT_WAITING_TIME_OUT_MS;
+        BT_CMD_SendState = BT_CMD_SEND_ACK_ERROR;
+        return;
+    }
+
+    switch(BT_CMD_SendState)
+    {
+        case BT_CMD_SEND_STATE_IDLE:
+            if(BT_SendingCmd.SendingCmdNum)
+            {
+                IO_BT_MFB_SetHigh();
+                BT_CommandSendTimer = 3;      //wait 2 - 3ms
+                BT_CMD_SendState = BT_CMD_SEND_MFB_HIGH_WAITING;
+            }
+            break;
+
+        case BT_CMD_SEND_MFB_HIGH_WAITING:
+            if(!BT_CommandSendTimer)
+                BT_CMD_SendState = BT_CMD_SEND_DATA_SENDING;
+            break;
+
+        case BT_CMD_SEND_DATA_SENDING:
+            if (BT_isTxCompletionPending || BT_CommandSendTimer)
+                break;
+
+            if (BT_SendingCmd.SendingCmdNum > BT_SendingCmd.SentCmdNum)
+            {
+                if (BT_SendingCmd.SentCmdNum < PIPELINED_CMD_WINDOW)
+                    StartSendingCommand(BT_SendingCmd.SentCmdNum++);
+            }
+            else if (!BT_SendingCmd.SendingCmdNum)
+            {
+                IO_BT_MFB_SetLow();
+                BT_CMD_SendState = BT_CMD_SEND_STATE_IDLE;
+            }
+            break;
+
+        case BT_CMD_SEND_ACK_ERROR:
+            if (BT_isTxCompletionPending || BT_CommandSendTimer)
+                break;
+
+            if (BT_SendingCmd.SentCmdNum && BT_SendingCmd.SendingCmdArray[0].cmdStatus == ERROR_NO_ACK)
+                StartSendingCommand(0);
+
+            BT_CMD_SendState = BT_CMD_SEND_DATA_SENDING;
+            break;
+
+        default:
+            break;
+    }
+}
+#endif
+
 void BT_CommandSend_Task( void )
 {
+    uint8_t const lastSendState = BT_CMD_SendState;
+
+#if PIPELINED_CMD_WINDOW
+    PipelinedTask();
+#else
     switch(BT_CMD_SendState)
     {
         case BT_CMD_SEND_STATE_IDLE:
@@ -491,6 +681,11 @@ void BT_CommandSend_Task( void )
         default:
             break;
     }
+#endif
+
+    //a new state may have work to do before any timer expires
+    if (BT_CMD_SendState != lastSendState)
+        SCHEDULER_MarkRunnable(SCHEDULER_Task_BT_COMMAND_SEND);
 }
 
 /*------------------------------------------------------------*/
@@ -500,7 +695,34 @@ uint8_t BT_UpdateAckStatusWhenReceived(uint8_t command_id, uint8_t ack_status)
     command_id, ack_status
   };
   
-    uint16_t temp;
+  SCHEDULER_MarkRunnable(SCHEDULER_Task_BT_COMMAND_SEND);
+  
+#if PIPELINED_CMD_WINDOW
+    //match the ACK to the oldest sent command with the same command ID
+    uint8_t i;
+    for (i = 0; i < BT_SendingCmd.SentCmdNum; i++)
+    {
+        if (BT_SendingCmd.SendingCmdArray[i].cmdID == command_id &&
+                BT_SendingCmd.SendingCmdArray[i].cmdStatus == IN_SENDING)
+        {
+            BT_SendingCmd.SendingCmdArray[i].cmdStatus = ack_status;
+            if (i == 0)
+                BT_AckTimer = ACK_TIME_OUT_MS;     //the timeout is only for the oldest command
+
+            if(command_id == GATT_CTRL)
+                gatt_status_code = ack_status;
+
+            APP_BT_EventHandler(ack_status == 0 ? BT_EVENT_CMD_SENT_ACK_OK : BT_EVENT_CMD_SENT_ACK_ERROR, (uint16_t)command_id, params);        //send event to user application layer with command id, and event type
+
+            if ((ack_status != 0) && (command_id == VENDOR_AT_CMD)) {
+                ATCMD_BT_ResponseHandler(ATCMD_Response_FAILED);
+            }
+
+            return BT_SendingCmd.SendingCmdArray[i].cmdInfo;
+        }
+    }
+	return CMD_INFO_IGNORE;
+#else
     if( BT_CMD_SendState == BT_CMD_SEND_ACK_WAITING )
     {
         if(command_id == BT_SendingCmd.SendingCmdArray[0].cmdID)
@@ -522,22 +744,114 @@ uint8_t BT_UpdateAckStatusWhenReceived(uint8_t command_id, uint8_t ack_status)
 		return BT_SendingCmd.SendingCmdArray[0].cmdInfo;
     }
 	return CMD_INFO_IGNORE;
+#endif
 }
 
 /*------------------------------------------------------------*/
 void BT_CommandSend_Timer1MS_Interrupt(void)
 {
+    //BT_CommandSend_Task() only needs to run when a timer expires
     if( BT_CommandSendTimer/*BT_CommandStartMFBWaitTimer*/)
     {
-        -- BT_CommandSendTimer/*BT_CommandStartMFBWaitTimer*/;
+        if (!-- BT_CommandSendTimer/*BT_CommandStartMFBWaitTimer*/)
+            SCHEDULER_MarkRunnable(SCHEDULER_Task_BT_COMMAND_SEND);
+    }
+#if PIPELINED_CMD_WINDOW
+    if (BT_AckTimer)
+    {
+        if (!-- BT_AckTimer)
+            SCHEDULER_MarkRunnable(SCHEDULER_Task_BT_COMMAND_SEND);
+    }
+#endif
+}
+
+bool BT_CommandSend_IsTimer1MSInterruptRequired(void)
+{
+    //the timers are only used while there are commands to be sent/acknowledged
+    return (BT_CMD_SendState != BT_CMD_SEND_STATE_IDLE) || BT_SendingCmd.SendingCmdNum;
+}
+
+/*------------------------------------------------------------*/
+//called from interrupt when the last byte of the command being sent has been passed to the UART
+static void CommandTransferComplete( void )
+{
+    SCHEDULER_MarkRunnable(SCHEDULER_Task_BT_COMMAND_SEND);
+#if PIPELINED_CMD_WINDOW
+    BT_isTransmitting = false;
+#else
+    if(BT_CMD_SendState == BT_CMD_SEND_DATA_SENDING)
+    {
+        if(BT_SendingCmd.SendingCmdArray[0].cmdID != MCU_SEND_EVENT_ACK)
+        {
+            BT_CommandSendTimer =  ACK_TIME_OUT_MS;
+            BT_CMD_SendState = BT_CMD_SEND_ACK_WAITING;
+        }
+        else        //just sent is ACK_TO_EVENT command
+        {
+            BT_CommandSendTimer = INTERVAL_AFTER_ACK_CMD;
+            BT_SendingCmd.SendingCmdArray[0].cmdStatus = STS_OK;
+            BT_CMD_SendState = BT_CMD_SEND_ACK_OK;
+        }
     }
+#endif
+}
+
+#if UART_TX_USE_DMA
+/*------------------------------------------------------------*/
+static void UART_DMA_Initialize( void )
+{
+    uint8_t GIEBitValue;
+
+    PMD8bits.DMA1MD = 0;            //enable DMA1 module
+
+    //System arbiter priorities (lower value = higher priority).
+    //Priorities must be locked before the DMA can access memory.
+    ISRPR = 1;
+    MAINPR = 2;
+    DMA1PR = 0;
+    GIEBitValue = INTCON0bits.GIE;
+    INTCON0bits.GIE = 0;
+    PRLOCK = 0x55;
+    PRLOCK = 0xAA;
+    PRLOCKbits.PRLOCKED = 1;
+    INTCON0bits.GIE = GIEBitValue;
+
+    DMASELECT = 0x00;               //DMA1
+    DMAnCON0 = 0x00;
+    //DMODE unchanged; DSTP not cleared; SMR SFR/GPR; SMODE incremented; SSTP SIRQEN cleared when source count reloads
+    DMAnCON1 = 0x03;
+    DMAnDSA = (uint16_t)(uintptr_t)&U2TXB;
+    DMAnDSZ = 1;
+    DMAnSIRQ = UART_TX_DMA_SIRQ;
+    DMAnAIRQ = 0;
+
+    PIR2bits.DMA1SCNTIF = 0;
+    IPR2bits.DMA1SCNTIP = 0;
+    PIE2bits.DMA1SCNTIE = 1;
+}
+
+/*------------------------------------------------------------*/
+//sends the entire command with DMA
+void UART_TransferFirstByte( void )
+{
+    DMASELECT = 0x00;               //DMA1
+    DMAnSSA = (uintptr_t)&UR_TxBuf[BT_SendingCmd.SendingCmdArray[BT_SendingCmd.TransmitIndex].startBufPt];
+    DMAnSSZ = BT_SendingCmd.SendingCmdArray[BT_SendingCmd.TransmitIndex].cmdSize;
+    DMAnCON0 = 0xC0;                //EN enabled; SIRQEN enabled
 }
 
+/*------------------------------------------------------------*/
+void __interrupt(irq(DMA1SCNT),base(8),low_priority) UART_DMA_TransferComplete_ISR( void )
+{
+    PIR2bits.DMA1SCNTIF = 0;
+    CommandTransferComplete();
+}
+#else
 /*------------------------------------------------------------*/
 void UART_TransferFirstByte( void )
 {
     uint8_t data;
-    UR_TxBufTail2 = BT_SendingCmd.SendingCmdArray[0].startBufPt;
+    UR_TxBufTail2 = BT_SendingCmd.SendingCmdArray[BT_SendingCmd.TransmitIndex].startBufPt;
     data = UR_TxBuf[UR_TxBufTail2++];
     if(UR_TxBufTail2 >= UR_TX_BUF_SIZE)
             UR_TxBufTail2 = 0;
@@ -548,22 +862,13 @@ void UART_TransferFirstByte( void )
 void UART_TransferNextByte( void )
 {
     uint8_t data;
+#if PIPELINED_CMD_WINDOW
+    if(UR_TxBufTail2 == BT_TxEndBufPt)
+#else
     if(UR_TxBufTail2 == BT_SendingCmd.SendingCmdArray[0].endBufPt)
+#endif
     {
-        if(BT_CMD_SendState == BT_CMD_SEND_DATA_SENDING)
-        {
-            if(BT_SendingCmd.SendingCmdArray[0].cmdID != MCU_SEND_EVENT_ACK)
-            {
-                BT_CommandSendTimer =  ACK_TIME_OUT_MS;
-                BT_CMD_SendState = BT_CMD_SEND_ACK_WAITING;
-            }
-            else        //just sent is ACK_TO_EVENT command
-            {
-                BT_CommandSendTimer = INTERVAL_AFTER_ACK_CMD;
-                BT_SendingCmd.SendingCmdArray[0].cmdStatus = STS_OK;
-                BT_CMD_SendState = BT_CMD_SEND_ACK_OK;
-            }
-        }
+        CommandTransferComplete();
     }
     else
     {
@@ -573,6 +878,7 @@ void UART_TransferNextByte( void )
         UART2_Write(data);
     }
 }
+#endif
 
 static bool StartRegisterNewCommand(uint16_t start_index, uint16_t cmd_size, uint8_t cmd_id, uint8_t cmdInfo)
 {
@@ -604,6 +910,7 @@ static bool EndRegisterNewCommand(uint16_t end_index)
         BT_SendingCmd.SendingCmdArray[BT_SendingCmd.SendingCmdNum].endBufPt = end_index;
         BT_SendingCmd.SendingCmdArray[BT_SendingCmd.SendingCmdNum].cmdStatus = IN_QUEUE;
         BT_SendingCmd.SendingCmdNum++;
+        SCHEDULER_MarkRunnable(SCHEDULER_Task_BT_COMMAND_SEND);
     }
     return true;
 }
@@ -614,10 +921,16 @@ static bool RemoveFirstCommand(void)//index starting from 0
     if(!BT_SendingCmd.SendingCmdNum)
         return false;            //parameter error
     
+    //release the command's data from the buffer
+    UR_TxBufTail = BT_SendingCmd.SendingCmdArray[0].endBufPt;
+    if (BT_SendingCmd.SentCmdNum)
+        BT_SendingCmd.SentCmdNum--;
+    if (BT_SendingCmd.TransmitIndex)
+        BT_SendingCmd.TransmitIndex--;
+
     if(BT_SendingCmd.SendingCmdNum == 1)
     {
         BT_SendingCmd.SendingCmdNum--;
-        UR_TxBufTail = UR_TxBufTail2;
         if (UR_TxBufHead == UR_TxBufTail)
             UR_TxBufStatus = TXRX_BUF_EMPTY;
         else
@@ -637,7 +950,6 @@ static bool RemoveFirstCommand(void)//index starting from 0
 
     }
     BT_SendingCmd.SendingCmdNum--;
-    UR_TxBufTail = UR_TxBufTail2;
     if (UR_TxBufHead == UR_TxBufTail)
         UR_TxBufStatus = TXRX_BUF_EMPTY;
     else
@@ -153,7 +153,7 @@ enum
 
 void BT_GiveUpThisCommand( void );
 uint8_t BT_CalculateCmdChecksum(uint8_t const* startByte, uint8_t const* endByte);
-void BT_SendBytesAsCompleteCommand(uint8_t const* command, uint8_t command_length);
+bool BT_SendBytesAsCompleteCommand(uint8_t const* command, uint8_t command_length);
 
 void BT_ResetEEPROM(void);
 void BT_SetEventMask(void);
@@ -185,9 +185,19 @@ void BT_SetAecEnabled(bool isEnabled);
 void BT_CommandSend_Initialize(void);
 void BT_CommandSend_Task( void );
 void BT_CommandSend_Timer1MS_Interrupt(void);
+bool BT_CommandSend_IsTimer1MSInterruptRequired(void);
+
+//Set to 1 to send each command to UART2 with DMA1, directly from the command
+//buffer, with one interrupt per command.
+//Set to 0 to send one byte at a time from the UART2 Tx interrupt.
+#ifndef UART_TX_USE_DMA
+#define UART_TX_USE_DMA                 1
+#endif
 
 void UART_TransferFirstByte( void );
+#if !UART_TX_USE_DMA
 void UART_TransferNextByte( void );
+#endif
 
 //-----------------------------------------
 typedef enum {
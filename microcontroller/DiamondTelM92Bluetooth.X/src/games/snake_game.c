@@ -10,6 +10,7 @@
 #include "../util/string.h"
 #include "../util/timeout.h"
 #include "../util/interval.h"
+#include "../util/scheduler.h"
 #include "../../mcc_generated_files/tmr6.h"
 #include "../../mcc_generated_files/tmr4.h"
 #include <string.h>
@@ -61,8 +62,24 @@ static struct {
   uint8_t foodPosition;
   char tiles[HANDSET_TEXT_DISPLAY_LENGTH];
   Direction direction;
+  bool isRedrawPending;
 } module;
 
+/**
+ * Tests if the handset command queue has room to redraw the entire display 
+ * without deferring commands. Otherwise, redraws wait for a later task pass.
+ */
+static bool isReadyToRedraw(void) {
+  if (HANDSET_GetCommandQueueRoom() >= HANDSET_FULL_REDRAW_QUEUE_ROOM) {
+    return true;
+  }
+  
+  // Room is made by HANDSET_Task() without any event for the application, 
+  // so check again in the next pass.
+  SCHEDULER_MarkRunnable(SCHEDULER_Task_APP);
+  return false;
+}
+
 static void displayTitle(void) {
   INTERVAL_Cancel(&module.stateInterval);
   
@@ -124,12 +141,10 @@ static void displayGameTiles(void) {
 }
 
 static void resumeGame(void) {
-  displayGameTiles();
-  
-  HANDSET_PrintCharAt('3', 3);
-  
+  // The game tiles are displayed, and the countdown is started, by 
+  // SNAKE_GAME_Task()
+  module.isRedrawPending = true;
   INTERVAL_Initialize(&module.stateInterval, 75);
-  INTERVAL_Start(&module.stateInterval, false);
   module.state = State_STARTING_1;
 }
 
@@ -265,6 +280,17 @@ void SNAKE_GAME_Start(SNAKE_GAME_ReturnCallback returnCallback) {
 void SNAKE_GAME_Task(void) {
   switch (module.state) {
     case State_STARTING_1:
+      if (module.isRedrawPending) {
+        if (isReadyToRedraw()) {
+          displayGameTiles();
+          HANDSET_PrintCharAt('3', 3);
+          INTERVAL_Start(&module.stateInterval, false);
+          module.isRedrawPending = false;
+        }
+        break;
+      }
+      // fall through
+      
     case State_STARTING_2:
       if (INTERVAL_Task(&module.stateInterval)) {
         HANDSET_PrintCharAt('2' - (module.state - State_STARTING_1), 3);
@@ -291,7 +317,7 @@ void SNAKE_GAME_Task(void) {
       break;
       
     case State_GAME_OVER_1: 
-      if (INTERVAL_Task(&module.stateInterval)) {
+      if (isReadyToRedraw() && INTERVAL_Task(&module.stateInterval)) {
         HANDSET_DisableTextDisplay();
         HANDSET_ClearText();
         HANDSET_PrintString(module.snakeLength == HANDSET_TEXT_DISPLAY_LENGTH ? "You    Win! " : "Game   Over ");
@@ -301,7 +327,7 @@ void SNAKE_GAME_Task(void) {
       break;
 
     case State_GAME_OVER_2: 
-      if (INTERVAL_Task(&module.stateInterval)) {
+      if (isReadyToRedraw() && INTERVAL_Task(&module.stateInterval)) {
         char scoreStr[3];
         
         uint2str(scoreStr, module.score, 3, 3);
@@ -316,7 +342,7 @@ void SNAKE_GAME_Task(void) {
       break;
       
     case State_GAME_OVER_3: 
-      if (INTERVAL_Task(&module.stateInterval)) {
+      if (isReadyToRedraw() && INTERVAL_Task(&module.stateInterval)) {
         HANDSET_DisableTextDisplay();
         HANDSET_PrintString("#:Again*:New  ");
         HANDSET_EnableTextDisplay();
@@ -325,7 +351,7 @@ void SNAKE_GAME_Task(void) {
       break;
 
     case State_GAME_OVER_4: 
-      if (INTERVAL_Task(&module.stateInterval)) {
+      if (isReadyToRedraw() && INTERVAL_Task(&module.stateInterval)) {
         displayGameTiles();
         module.state = State_GAME_OVER_1;
       }
@@ -13,6 +13,7 @@
 #include "../util/string.h"
 #include "../util/timeout.h"
 #include "../util/interval.h"
+#include "../util/scheduler.h"
 #include "../ui/security_code.h"
 #include "../ui/string_input.h"
 #include <stdlib.h>
@@ -133,11 +134,27 @@ static struct {
   uint16_t score;
   uint16_t totalLinesCleared;
   bool isFastDrop;
+  bool isRedrawPending;
   bool isHighScore;
   bool isHighScoreInitialsEntered;
   char highScoreInitialsBuffer[4];
 } module;
 
+/**
+ * Tests if the handset command queue has room to redraw the entire display 
+ * without deferring commands. Otherwise, redraws wait for a later task pass.
+ */
+static bool isReadyToRedraw(void) {
+  if (HANDSET_GetCommandQueueRoom() >= HANDSET_FULL_REDRAW_QUEUE_ROOM) {
+    return true;
+  }
+  
+  // Room is made by HANDSET_Task() without any event for the application, 
+  // so check again in the next pass.
+  SCHEDULER_MarkRunnable(SCHEDULER_Task_APP);
+  return false;
+}
+
 static void startMusic(void) {
   if (!module.isMusicPlaying) {
     SOUND_PlayEffect(
@@ -625,7 +642,8 @@ static void promptHighScoreInitials(void) {
 
 static void resumeGame(void) {
   startMusic();
-  drawFullGameBoard();
+  // The game board is drawn by TETRIS_GAME_Task()
+  module.isRedrawPending = true;
   module.isFastDrop = false;
   INTERVAL_Initialize(&module.stateInterval, module.lineClearCount ? LINE_FLASH_INTERVAL : INTERVALS_BY_LEVEL_INDEX[module.level]);
   INTERVAL_Start(&module.stateInterval, false);
@@ -713,13 +731,22 @@ void TETRIS_GAME_Task(void) {
   
   switch (module.state) {
     case State_PLAYING:
+      if (module.isRedrawPending) {
+        if (!isReadyToRedraw()) {
+          break;
+        }
+        
+        drawFullGameBoard();
+        module.isRedrawPending = false;
+      }
+      
       if (INTERVAL_Task(&module.stateInterval)) {
         gameLoop();
       }
       break;
     
     case State_GAME_OVER_1: 
-      if (INTERVAL_Task(&module.stateInterval)) {
+      if (isReadyToRedraw() && INTERVAL_Task(&module.stateInterval)) {
         if (module.isHighScore && !module.isHighScoreInitialsEntered) {
           promptHighScoreInitials();
         } else {
@@ -733,7 +760,7 @@ void TETRIS_GAME_Task(void) {
       break;
 
     case State_GAME_OVER_2: 
-      if (INTERVAL_Task(&module.stateInterval)) {
+      if (isReadyToRedraw() && INTERVAL_Task(&module.stateInterval)) {
         HANDSET_DisableTextDisplay();
         HANDSET_PrintString(" Level   ");
         HANDSET_PrintChar('1' + module.startLevel);
@@ -746,7 +773,7 @@ void TETRIS_GAME_Task(void) {
       break;
 
     case State_GAME_OVER_3: 
-      if (INTERVAL_Task(&module.stateInterval)) {
+      if (isReadyToRedraw() && INTERVAL_Task(&module.stateInterval)) {
         char scoreStr[5];
         
         uint2str(scoreStr, module.score, 5, 3);
@@ -761,14 +788,14 @@ void TETRIS_GAME_Task(void) {
       break;
       
     case State_GAME_OVER_4: 
-      if (INTERVAL_Task(&module.stateInterval)) {
+      if (isReadyToRedraw() && INTERVAL_Task(&module.stateInterval)) {
         printHighScore();
         ++module.state;
       }
       break;
       
     case State_GAME_OVER_5: 
-      if (INTERVAL_Task(&module.stateInterval)) {
+      if (isReadyToRedraw() && INTERVAL_Task(&module.stateInterval)) {
         HANDSET_DisableTextDisplay();
         HANDSET_PrintString("#:Again*:New  ");
         HANDSET_EnableTextDisplay();
@@ -777,7 +804,7 @@ void TETRIS_GAME_Task(void) {
       break;
       
     case State_GAME_OVER_6: 
-      if (INTERVAL_Task(&module.stateInterval)) {
+      if (isReadyToRedraw() && INTERVAL_Task(&module.stateInterval)) {
         drawFullGameBoard();
         module.state = State_GAME_OVER_1;
       }
@@ -0,0 +1,60 @@
+/**
+ * @file
+ * @author Jeff Lau
+ *
+ * Power management of timer interrupts.
+ *
+ * The 1ms timer (TMR4) is stopped while no module needs it. No module relies 
+ * on timer interrupts to wake the main loop: background work that is not 
+ * driven by the 1ms timer (e.g., pending EEPROM writes, phonebook sync) keeps
+ * its own task runnable with SCHEDULER_MarkRunnable() (see EEPROM_Task()). 
+ * Work that is driven by the 1ms timer must never be added to 
+ * APP_Timer1MS_Interrupt() without also being checked here.
+ */
+
+#include "power.h"
+#include "../mcc_generated_files/tmr4.h"
+#include "sound/tone.h"
+#include "sound/sound.h"
+#include "telephone/handset.h"
+#include "bluetooth/bt_command_send.h"
+#include <stdbool.h>
+
+/**
+ * Module state.
+ */
+static struct {
+  /**
+   * True while the 1ms timer is running.
+   */
+  bool isTimer1MSRunning;
+} module;
+
+void POWER_Initialize(void) {
+  module.isTimer1MSRunning = true;
+}
+
+void POWER_Task(void) {
+  // Every module that is driven by APP_Timer1MS_Interrupt() must be checked.
+  // The 1ms timer is only started by this function, and the requirement of
+  // each module only changes from false to true within the main loop, so
+  // no 1ms timing can be missed.
+  bool const isTimer1MSRequired =
+      TONE_IsTimer1MSInterruptRequired() ||
+      SOUND_IsTimer1MSInterruptRequired() ||
+      BT_CommandSend_IsTimer1MSInterruptRequired() ||
+      HANDSET_IsTimer1MSInterruptRequired();
+
+  if (isTimer1MSRequired == module.isTimer1MSRunning) {
+    return;
+  }
+
+  if (isTimer1MSRequired) {
+    TMR4_WriteTimer(0);
+    TMR4_StartTimer();
+  } else {
+    TMR4_StopTimer();
+  }
+
+  module.isTimer1MSRunning = isTimer1MSRequired;
+}
@@ -0,0 +1,50 @@
+/**
+ * @file
+ * @author Jeff Lau
+ *
+ * Power management of timer interrupts.
+ *
+ * The phone spends most of its time on hook and idle, when the only things
+ * that happen are occasional UART data, button presses, and slow (10ms
+ * resolution) timeouts. Every timer interrupt wakes the CPU from Idle mode
+ * (see util/scheduler.h), even when it only goes back to sleep because no 
+ * task was marked runnable, so timers that are not currently needed are 
+ * stopped:
+ * - The sound sample timer (TMR6) is stopped by the TONE module while all
+ *   voices are silent (see tone.h).
+ * - The 1ms timer (TMR4) is stopped by this module while none of the modules
+ *   that are driven by APP_Timer1MS_Interrupt() require it.
+ * - The 100ms call timer (TMR0) is stopped by the CALL_TIMER module while no
+ *   call time is being counted (see call_timer.c).
+ *
+ * The 10ms timer (TMR2) always runs, because it drives all timeouts/intervals.
+ */
+
+#ifndef POWER_H
+#define	POWER_H
+
+#ifdef	__cplusplus
+extern "C" {
+#endif
+
+/**
+ * Initializes this module.
+ *
+ * Must be called after the 1ms timer has been started.
+ */
+void POWER_Initialize(void);
+
+/**
+ * Starts/stops the 1ms timer, depending on whether it is currently required.
+ *
+ * Must be called from the main loop after every execution of APP_Task(), so
+ * that any 1ms timing that was started by a task is not delayed.
+ */
+void POWER_Task(void);
+
+#ifdef	__cplusplus
+}
+#endif
+
+#endif	/* POWER_H */
+
@@ -6,6 +6,7 @@
  */
 #include "external_mic.h"
 #include "../util/timeout.h"
+#include "../util/scheduler.h"
 #include "../../mcc_generated_files/pin_manager.h"
 #include <stdio.h>
 
@@ -40,6 +41,7 @@ static struct {
  */
 static void inputPinChangeHandler(void) {
   module.isInputPinChangeDetected = true;
+  SCHEDULER_MarkRunnable(SCHEDULER_Task_EXTERNAL_MIC);
 }
 
 void EXTERNAL_MIC_Initialize(EXTERNAL_MIC_EventHandler eventHandler) {
@@ -47,7 +49,8 @@ void EXTERNAL_MIC_Initialize(EXTERNAL_MIC_EventHandler eventHandler) {
   module.isInputPinChangeDetected = false;
   module.isConnected = IO_MIC_HF_DETECT_GetValue();
   printf("[EXTERNAL MIC] Initial: %s\r\n", module.isConnected ? "Connected" : "Disconnected");
-  TIMEOUT_Cancel(&module.debounceTimeout);
+  TIMEOUT_InitializeOnTimerWheel(&module.debounceTimeout);
+  TIMEOUT_SetTask(&module.debounceTimeout, SCHEDULER_Task_EXTERNAL_MIC);
   IOCAF3_SetInterruptHandler(inputPinChangeHandler);
 }
 
@@ -73,10 +76,6 @@ void EXTERNAL_MIC_Task(void) {
   }
 }
 
-void EXTERNAL_MIC_Timer10MS_Interrupt(void) {
-  TIMEOUT_Timer_Interrupt(&module.debounceTimeout);
-}
-
 bool EXTERNAL_MIC_IsConnected(void) {
   return module.isConnected;
 }
@@ -52,13 +52,6 @@ void EXTERNAL_MIC_Initialize(EXTERNAL_MIC_EventHandler eventHandler);
  */
 void EXTERNAL_MIC_Task(void);
 
-/**
- * Timer event handler for the EXTERNAL_MIC module.
- * 
- * Must be called from a timer interrupt every 10 milliseconds.
- */
-void EXTERNAL_MIC_Timer10MS_Interrupt(void);
-
 /**
  * Test if an external microphone is currently connected.
  * 
@@ -0,0 +1,218 @@
+/**
+ * @file
+ * @author Jeff Lau
+ *
+ * A compact format for sequences of dual-tone notes, and a player that
+ * decodes it one note at a time.
+ */
+
+#include "song.h"
+#include <stddef.h>
+
+/**
+ * Tones of all SONG_Pitch values, in the same order.
+ */
+static tone_t const pitches[] = {
+  TONE_OFF,
+  TONE_LOW,
+  TONE_HIGH,
+  TONE_F3,
+  TONE_FS3,
+  TONE_G3,
+  TONE_GS3,
+  TONE_A3,
+  TONE_AS3,
+  TONE_B3,
+  TONE_C4,
+  TONE_CS4,
+  TONE_D4,
+  TONE_DS4,
+  TONE_E4,
+  TONE_F4,
+  TONE_FS4,
+  TONE_G4,
+  TONE_GS4,
+  TONE_A4,
+  TONE_AS4,
+  TONE_B4,
+  TONE_C5,
+  TONE_CS5,
+  TONE_D5,
+  TONE_DS5,
+  TONE_E5,
+  TONE_F5,
+  TONE_FS5,
+  TONE_G5,
+  TONE_GS5,
+  TONE_A5,
+  TONE_AS5,
+  TONE_B5,
+  TONE_C6,
+  TONE_CS6,
+  TONE_D6,
+  TONE_DS6,
+  TONE_E6,
+  TONE_F6,
+  TONE_FS6,
+  TONE_G6,
+  TONE_GS6,
+  TONE_A6,
+  TONE_AS6,
+  TONE_B6,
+  TONE_C7,
+  TONE_CS7,
+  TONE_D7,
+  TONE_DS7,
+  TONE_E7,
+  TONE_F7,
+  TONE_FS7,
+  TONE_G7,
+  TONE_GS7,
+  TONE_A7
+};
+
+/**
+ * Durations (ms) of all SONG_Duration values, in the same order.
+ */
+static uint16_t const durations[] = {
+  0,
+  20,
+  25,
+  50,
+  100,
+  125,
+  200,
+  220,
+  250,
+  375,
+  400,
+  440,
+  500,
+  660,
+  750,
+  880,
+  1000,
+  3000
+};
+
+void SONG_Start(song_player_t* player, uint8_t const* song) {
+  static uint8_t const EMPTY_SONG[] = { SONG_KIND_CONTROL | SONG_OP_END };
+
+  player->_song = song ? song : EMPTY_SONG;
+  player->_next = player->_song;
+  player->_repeatDepth = 0;
+  player->_skippedRepeatDepth = 0;
+  player->_isSpacePending = false;
+}
+
+/**
+ * Handles a control event.
+ *
+ * @param player - Pointer to a song player, with _next pointing to the byte
+ *        after the header of the control event.
+ * @param op - The SONG_OP_* operation of the control event.
+ * @param isLooping - True if the song starts over after it ends.
+ * @return False if the song has ended.
+ */
+static bool handleControlEvent(song_player_t* player, uint8_t op, bool isLooping) {
+  switch (op) {
+    case SONG_OP_REPEAT: {
+      uint8_t const count = *player->_next++;
+
+      // Sections that are nested too deeply are only played once
+      if (player->_repeatDepth == SONG_REPEAT_DEPTH) {
+        ++player->_skippedRepeatDepth;
+      } else {
+        player->_repeatStart[player->_repeatDepth] = player->_next;
+        player->_repeatRemaining[player->_repeatDepth] = count;
+        ++player->_repeatDepth;
+      }
+      break;
+    }
+
+    case SONG_OP_REPEAT_END:
+      if (player->_skippedRepeatDepth) {
+        // End of a section that was only played once
+        --player->_skippedRepeatDepth;
+      } else if (player->_repeatDepth) {
+        uint8_t const top = player->_repeatDepth - 1;
+
+        if (player->_repeatRemaining[top]) {
+          --player->_repeatRemaining[top];
+          player->_next = player->_repeatStart[top];
+        } else {
+          player->_repeatDepth = top;
+        }
+      }
+      break;
+
+    default:
+      if (!isLooping) {
+        // Stay on the end of the song
+        --player->_next;
+        return false;
+      }
+
+      player->_next = player->_song;
+      player->_repeatDepth = 0;
+      player->_skippedRepeatDepth = 0;
+      break;
+  }
+
+  return true;
+}
+
+bool SONG_GetNextNote(song_player_t* player, bool isLooping, song_note_t* note) {
+  if (player->_isSpacePending) {
+    player->_isSpacePending = false;
+    note->tone1 = TONE_OFF;
+    note->tone2 = TONE_OFF;
+    note->duration = SONG_SPACE_DURATION;
+    return true;
+  }
+
+  // A looping song that starts over without producing a note (has no notes)
+  // must not be decoded forever.
+  bool isStartedOver = false;
+
+  while (true) {
+    uint8_t const header = *player->_next++;
+    uint8_t const code = header & SONG_CODE_MASK;
+
+    switch (header & SONG_KIND_MASK) {
+      case SONG_KIND_CONTROL:
+        if (!handleControlEvent(player, code, isLooping && !isStartedOver)) {
+          return false;
+        }
+
+        if (player->_next == player->_song) {
+          isStartedOver = true;
+        }
+        continue;
+
+      case SONG_KIND_DUAL_NOTE:
+        note->tone1 = pitches[*player->_next++];
+        note->tone2 = pitches[*player->_next++];
+        break;
+
+      case SONG_KIND_NOTE:
+        note->tone1 = pitches[*player->_next++];
+        note->tone2 = TONE_OFF;
+        break;
+
+      default:
+        note->tone1 = TONE_OFF;
+        note->tone2 = TONE_OFF;
+        break;
+    }
+
+    note->duration = durations[code];
+
+    if (header & SONG_FLAG_SPACED) {
+      note->duration -= SONG_SPACE_DURATION;
+      player->_isSpacePending = true;
+    }
+
+    return true;
+  }
+}
@@ -0,0 +1,247 @@
+/**
+ * @file
+ * @author Jeff Lau
+ *
+ * A compact format for sequences of dual-tone notes (songs and other sound
+ * effects), and a player that decodes it one note at a time.
+ *
+ * A song is a sequence of bytes, terminated by SONG_END. Each event starts
+ * with a header byte:
+ * - Bits 7-6: The kind of event (SONG_KIND_*).
+ * - Bit 5: (notes only) SONG_FLAG_SPACED.
+ * - Bits 4-0: (notes/rests) A SONG_Duration code, or (control events) a
+ *   SONG_OP_* operation.
+ *
+ * A note header is followed by one (1) or two (2) SONG_Pitch bytes, and a
+ * SONG_OP_REPEAT header is followed by a repeat count byte.
+ *
+ * Pitches and durations are indexes into small tables that are shared by all
+ * songs, so a single note is only 1-3 bytes. A pitch/duration that is not yet
+ * in a table must be added to both its enum and its table (in the same order).
+ *
+ * Songs are written in C source with macros that encode each event at
+ * compile time (see sound.c).
+ */
+
+#ifndef SONG_H
+#define	SONG_H
+
+#include "tone.h"
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef	__cplusplus
+extern "C" {
+#endif
+
+/**
+ * Pitches that can be played by a song.
+ */
+typedef enum SONG_Pitch {
+  SONG_Pitch_OFF,
+  SONG_Pitch_LOW,
+  SONG_Pitch_HIGH,
+  SONG_Pitch_F3,
+  SONG_Pitch_FS3,
+  SONG_Pitch_G3,
+  SONG_Pitch_GS3,
+  SONG_Pitch_A3,
+  SONG_Pitch_AS3,
+  SONG_Pitch_B3,
+  SONG_Pitch_C4,
+  SONG_Pitch_CS4,
+  SONG_Pitch_D4,
+  SONG_Pitch_DS4,
+  SONG_Pitch_E4,
+  SONG_Pitch_F4,
+  SONG_Pitch_FS4,
+  SONG_Pitch_G4,
+  SONG_Pitch_GS4,
+  SONG_Pitch_A4,
+  SONG_Pitch_AS4,
+  SONG_Pitch_B4,
+  SONG_Pitch_C5,
+  SONG_Pitch_CS5,
+  SONG_Pitch_D5,
+  SONG_Pitch_DS5,
+  SONG_Pitch_E5,
+  SONG_Pitch_F5,
+  SONG_Pitch_FS5,
+  SONG_Pitch_G5,
+  SONG_Pitch_GS5,
+  SONG_Pitch_A5,
+  SONG_Pitch_AS5,
+  SONG_Pitch_B5,
+  SONG_Pitch_C6,
+  SONG_Pitch_CS6,
+  SONG_Pitch_D6,
+  SONG_Pitch_DS6,
+  SONG_Pitch_E6,
+  SONG_Pitch_F6,
+  SONG_Pitch_FS6,
+  SONG_Pitch_G6,
+  SONG_Pitch_GS6,
+  SONG_Pitch_A6,
+  SONG_Pitch_AS6,
+  SONG_Pitch_B6,
+  SONG_Pitch_C7,
+  SONG_Pitch_CS7,
+  SONG_Pitch_D7,
+  SONG_Pitch_DS7,
+  SONG_Pitch_E7,
+  SONG_Pitch_F7,
+  SONG_Pitch_FS7,
+  SONG_Pitch_G7,
+  SONG_Pitch_GS7,
+  SONG_Pitch_A7,
+
+  SONG_Pitch_GF3 = SONG_Pitch_FS3,
+  SONG_Pitch_AF3 = SONG_Pitch_GS3,
+  SONG_Pitch_BF3 = SONG_Pitch_AS3,
+  SONG_Pitch_DF4 = SONG_Pitch_CS4,
+  SONG_Pitch_EF4 = SONG_Pitch_DS4,
+  SONG_Pitch_GF4 = SONG_Pitch_FS4,
+  SONG_Pitch_AF4 = SONG_Pitch_GS4,
+  SONG_Pitch_BF4 = SONG_Pitch_AS4,
+  SONG_Pitch_DF5 = SONG_Pitch_CS5,
+  SONG_Pitch_EF5 = SONG_Pitch_DS5,
+  SONG_Pitch_GF5 = SONG_Pitch_FS5,
+  SONG_Pitch_AF5 = SONG_Pitch_GS5,
+  SONG_Pitch_BF5 = SONG_Pitch_AS5,
+  SONG_Pitch_DF6 = SONG_Pitch_CS6,
+  SONG_Pitch_EF6 = SONG_Pitch_DS6,
+  SONG_Pitch_GF6 = SONG_Pitch_FS6,
+  SONG_Pitch_AF6 = SONG_Pitch_GS6,
+  SONG_Pitch_BF6 = SONG_Pitch_AS6,
+  SONG_Pitch_DF7 = SONG_Pitch_CS7,
+  SONG_Pitch_EF7 = SONG_Pitch_DS7,
+  SONG_Pitch_GF7 = SONG_Pitch_FS7,
+  SONG_Pitch_AF7 = SONG_Pitch_GS7
+} SONG_Pitch;
+
+/**
+ * Durations (ms) of notes/rests in a song.
+ *
+ * A duration of zero (0) lasts until the song is stopped.
+ *
+ * There can be no more than 32 durations.
+ */
+typedef enum SONG_Duration {
+  SONG_Duration_MS_0,
+  SONG_Duration_MS_20,
+  SONG_Duration_MS_25,
+  SONG_Duration_MS_50,
+  SONG_Duration_MS_100,
+  SONG_Duration_MS_125,
+  SONG_Duration_MS_200,
+  SONG_Duration_MS_220,
+  SONG_Duration_MS_250,
+  SONG_Duration_MS_375,
+  SONG_Duration_MS_400,
+  SONG_Duration_MS_440,
+  SONG_Duration_MS_500,
+  SONG_Duration_MS_660,
+  SONG_Duration_MS_750,
+  SONG_Duration_MS_880,
+  SONG_Duration_MS_1000,
+  SONG_Duration_MS_3000
+} SONG_Duration;
+
+#define SONG_KIND_REST (0x00)
+#define SONG_KIND_NOTE (0x40)
+#define SONG_KIND_DUAL_NOTE (0x80)
+#define SONG_KIND_CONTROL (0xC0)
+#define SONG_KIND_MASK (0xC0)
+
+/**
+ * The note is followed by a short silence of SONG_SPACE_DURATION, which is
+ * included in the duration of the note, so that consecutive notes of the same
+ * pitch are heard as separate notes. The duration of a spaced note must be
+ * longer than SONG_SPACE_DURATION.
+ */
+#define SONG_FLAG_SPACED (0x20)
+
+#define SONG_CODE_MASK (0x1F)
+
+/**
+ * Duration (ms) of the silence at the end of a spaced note.
+ */
+#define SONG_SPACE_DURATION (50)
+
+/**
+ * End of the song.
+ */
+#define SONG_OP_END (0x00)
+
+/**
+ * Start of a section of the song that is repeated. Followed by the number of
+ * times to repeat the section (in addition to playing it once).
+ */
+#define SONG_OP_REPEAT (0x01)
+
+/**
+ * End of a section of the song that is repeated.
+ */
+#define SONG_OP_REPEAT_END (0x02)
+
+/**
+ * Max number of repeated sections that can be nested within each other.
+ * Sections that are nested more deeply are only played once.
+ */
+#define SONG_REPEAT_DEPTH (2)
+
+/**
+ * A decoded note of a song.
+ */
+typedef struct {
+  tone_t tone1;
+  tone_t tone2;
+  /**
+   * Duration of the note (ms). Zero (0) lasts until the song is stopped.
+   */
+  uint16_t duration;
+} song_note_t;
+
+/**
+ * State of playback of a song.
+ *
+ * Must be initialized with SONG_Start(). All members are private.
+ */
+typedef struct {
+  uint8_t const* _song;
+  uint8_t const* _next;
+  uint8_t const* _repeatStart[SONG_REPEAT_DEPTH];
+  uint8_t _repeatRemaining[SONG_REPEAT_DEPTH];
+  uint8_t _repeatDepth;
+  /**
+   * Number of open repeated sections that are nested deeper than
+   * SONG_REPEAT_DEPTH (and are only played once).
+   */
+  uint8_t _skippedRepeatDepth;
+  bool _isSpacePending;
+} song_player_t;
+
+/**
+ * Starts playback of a song from its beginning.
+ *
+ * @param player - Pointer to a song player.
+ * @param song - Pointer to a song. NULL is handled as an empty song.
+ */
+void SONG_Start(song_player_t* player, uint8_t const* song);
+
+/**
+ * Decodes the next note of a song.
+ *
+ * @param player - Pointer to a started song player.
+ * @param isLooping - True if the song starts over after it ends.
+ * @param note - Pointer to a note that is populated with the next note.
+ * @return False if the song has ended (the note is not populated).
+ */
+bool SONG_GetNextNote(song_player_t* player, bool isLooping, song_note_t* note);
+
+#ifdef	__cplusplus
+}
+#endif
+
+#endif	/* SONG_H */
+
@@ -1,10 +1,15 @@
 /** 
  * @file
  * @author Jeff Lau
+ * 
+ * Each sound channel plays its notes on the TONE track of the same number, 
+ * so that note timing is sample-accurate. The note that follows the current
+ * note is always queued on the track in advance by SOUND_Task().
  */
 
 #include "sound.h"
 #include "tone.h"
+#include "song.h"
 #include "volume.h"
 #include "../util/timeout.h"
 #include "../../mcc_generated_files/pin_manager.h"
@@ -20,35 +25,19 @@ typedef enum SpeakerMode {
   SpeakerMode_SPEAKER    
 } SpeakerMode;
 
-typedef struct Note {
-  tone_t tone1;
-  tone_t tone2;
-  uint16_t duration;
-} Note;
-
-typedef struct Repeat {
-  uint8_t count;
-  uint8_t afterIndex;
-  uint8_t returnToIndex;
-} Repeat;
-
-typedef struct {
-  Note const* notes;
-  uint8_t length;
-  Repeat repeat;
-} SoundEffect;
-
-extern SoundEffect const effects[];
+/**
+ * Songs (see song.h) of all sound effects, indexed by SOUND_Effect.
+ */
+extern uint8_t const* const effects[];
 
 typedef struct {
   bool on;
-  tone_t tone1;
-  tone_t tone2;
-  SoundEffect const* effect;
-  uint8_t noteIndex;
-  uint8_t internalRepeatCount;
-  volatile uint16_t noteTimer;
-  volatile bool noteTimerExpired;
+  song_player_t player;
+  /**
+   * True if there are no more notes to be queued, so the sound ends when the
+   * track stops playing.
+   */
+  bool isLastNoteQueued;
   bool repeatEffect;
   SOUND_Target target;
   VOLUME_Mode volumeMode;
@@ -77,30 +66,30 @@ static bool isSoundEffectOnAndNotMuted(SoundEffectState const* soundEffectState)
   return VOLUME_GetLevel(soundEffectState->volumeMode) != VOLUME_Level_OFF;
 }
 
-static bool playCurrentSoundEffectStateTone(SoundEffectState const* soundEffectState) {
-  if (isSoundEffectOnAndNotMuted(soundEffectState)) {
-    if (soundEffectState->effect) {
-      Note const* note = soundEffectState->effect->notes + soundEffectState->noteIndex;
-      TONE_PlayDualTone(note->tone1, note->tone2);
-    } else {
-      TONE_PlayDualTone(soundEffectState->tone1, soundEffectState->tone2);
-    }
+static bool playCurrentSoundEffectStateTone(SOUND_Channel channel) {
+  if (isSoundEffectOnAndNotMuted(&soundEffectState[channel])) {
+    TONE_SetAudibleTrack(channel);
     return true;
   }
   
   return false;
 }
 
+static void stopTone(void) {
+  TONE_SetAudibleTrack(TONE_NO_TRACK);
+  TONE_Stop();
+}
+
 static void playCurrentTone(void) {
-  if (playCurrentSoundEffectStateTone(foregroundEffectState)) {
+  if (playCurrentSoundEffectStateTone(SOUND_Channel_FOREGROUND)) {
     return;
   }
 
-  if (playCurrentSoundEffectStateTone(backgroundEffectState)) {
+  if (playCurrentSoundEffectStateTone(SOUND_Channel_BACKGROUND)) {
     return;
   }
   
-  TONE_Stop();
+  stopTone();
 }
 
 static void setHandsetAudioOutput(void) {
@@ -134,7 +123,7 @@ static void setHandsetAudioOutput(void) {
   // by the time the handset receives processes the commands to change the
   // sound/speaker status, helping avoid an audio "click".
   if (!isPlayingSound) {
-    TONE_Stop();
+    stopTone();
   }
   
   SpeakerMode newSpeakerMode = isDisabled 
@@ -197,6 +186,9 @@ static void setHandsetAudioOutput(void) {
           : 20
     );
     
+    // Notes do not advance until the audio output change is finished
+    TONE_SetTracksPaused(true);
+    
     currentSpeakerMode = newSpeakerMode;
   } else if (!TIMEOUT_IsPending(&finishSetHandsetAudioOutputTimeout)) {
     VOLUME_SetMode(currentVolumeMode);
@@ -232,49 +224,40 @@ static void setHandsetAudioOutput(void) {
 static void finishSetHandsetAudioOutput(void) {
   VOLUME_SetMode(currentVolumeMode);
   VOLUME_Enable();
+  TONE_SetTracksPaused(false);
   playCurrentTone();
 }
 
 static bool soundEffectStateTask(SOUND_Channel channel) {
   SoundEffectState* effectState = &soundEffectState[channel];
   
-  if (effectState->on && effectState->noteTimerExpired) {
-    if (effectState->effect) {
-      if (
-          effectState->noteIndex != 0 &&
-          (effectState->noteIndex == effectState->effect->repeat.afterIndex) &&
-          (effectState->internalRepeatCount < effectState->effect->repeat.count)
-          ) {
-        effectState->noteIndex = effectState->effect->repeat.returnToIndex;
-        ++effectState->internalRepeatCount;
-      } else if (++effectState->noteIndex == effectState->effect->length) {
-        if (
-            (effectState->internalRepeatCount < effectState->effect->repeat.count) &&
-            (effectState->effect->repeat.afterIndex == 0)
-            ) {
-          effectState->noteIndex = effectState->effect->repeat.returnToIndex;
-          ++effectState->internalRepeatCount;
-        } else if (effectState->repeatEffect) {
-          effectState->noteIndex = 0;
-          effectState->internalRepeatCount = 0;
-        } else {
-          effectState->on = false;
-        }
-      }
-    } else {
-      effectState->on = false;
+  if (!effectState->on) {
+    return false;
+  }
+  
+  while (!effectState->isLastNoteQueued && !TONE_IsTrackNoteQueued(channel)) {
+    song_note_t note;
+    
+    if (!SONG_GetNextNote(&effectState->player, effectState->repeatEffect, &note)) {
+      effectState->isLastNoteQueued = true;
+    } else if (!TONE_QueueTrackNote(channel, note.tone1, note.tone2, note.duration)) {
+      // The track is not playing: either this is the first note, or the track
+      // ran out of notes before this note was queued (the main loop fell far 
+      // behind), so this note starts late.
+      TONE_StartTrack(channel, note.tone1, note.tone2, note.duration);
     }
+  }
+  
+  if (effectState->isLastNoteQueued && !TONE_IsTrackPlaying(channel)) {
+    // The last note has ended
+    effectState->on = false;
 
-    if (effectState->on) {
-      effectState->noteTimer = effectState->effect->notes[effectState->noteIndex].duration;
-    } else if (channel == SOUND_Channel_FOREGROUND) {
+    if (channel == SOUND_Channel_FOREGROUND) {
       currentButtonBeep = HANDSET_Button_NONE;
     }
-    
-    effectState->noteTimerExpired = false;
-    
+
     return true;
-  }  
+  }
   
   return false;
 }
@@ -332,24 +315,11 @@ void SOUND_Timer1MS_Interrupt(void) {
     return;
   }
   
-  
   TIMEOUT_Timer_Interrupt(&finishSetHandsetAudioOutputTimeout);
-  
-  if (TIMEOUT_IsPending(&finishSetHandsetAudioOutputTimeout)) {
-    return;
-  }
-  
-  if (!backgroundEffectState->noteTimerExpired && backgroundEffectState->noteTimer) {
-    if (!--backgroundEffectState->noteTimer) {
-      backgroundEffectState->noteTimerExpired = true;
-    }
-  }
+}
 
-  if (!foregroundEffectState->noteTimerExpired && foregroundEffectState->noteTimer) {
-    if (!--foregroundEffectState->noteTimer) {
-      foregroundEffectState->noteTimerExpired = true;
-    }
-  }
+bool SOUND_IsTimer1MSInterruptRequired(void) {
+  return isInitialized && TIMEOUT_IsPending(&finishSetHandsetAudioOutputTimeout);
 }
 
 void SOUND_Task(void) {
@@ -396,25 +366,23 @@ void SOUND_PlayEffect(SOUND_Channel channel, SOUND_Target target, VOLUME_Mode vo
   
   SoundEffectState* const state = &soundEffectState[channel];
 
-  state->noteTimerExpired = true;
   state->on = true;
-  state->effect = &effects[soundEffect];
-  state->tone1 = TONE_OFF;
-  state->tone2 = TONE_OFF;
-  state->noteIndex = 0;
-  state->internalRepeatCount = 0;
-  state->noteTimer = state->effect->notes->duration;
   state->repeatEffect = repeat;
   state->target = target;
   state->volumeMode = volumeMode;
 
+  // The first note is started (and the next note queued) by 
+  // soundEffectStateTask() once the track is stopped
+  SONG_Start(&state->player, effects[soundEffect]);
+  TONE_StopTrack(channel);
+  state->isLastNoteQueued = false;
+  soundEffectStateTask(channel);
+
   setHandsetAudioOutput();
   
   if (currentButtonBeep && (channel == SOUND_Channel_FOREGROUND)) {
     currentButtonBeep = HANDSET_Button_NONE;
   }
-
-  state->noteTimerExpired = false;
 }
 
 void SOUND_PlayDualTone(SOUND_Channel channel, SOUND_Target target, VOLUME_Mode volumeMode, tone_t tone1, tone_t tone2, uint16_t duration) {
@@ -425,24 +393,19 @@ void SOUND_PlayDualTone(SOUND_Channel channel, SOUND_Target target, VOLUME_Mode
   
   SoundEffectState* const state = &soundEffectState[channel];
   
-  state->noteTimerExpired = true;
   state->on = true;
-  state->effect = NULL;
-  state->tone1 = tone1;
-  state->tone2 = tone2;
-  state->noteIndex = 0;
-  state->noteTimer = duration;
   state->repeatEffect = false;
   state->target = target;
   state->volumeMode = volumeMode;
   
+  TONE_StartTrack(channel, tone1, tone2, duration);
+  state->isLastNoteQueued = true;
+  
   setHandsetAudioOutput();
   
   if (currentButtonBeep && (channel == SOUND_Channel_FOREGROUND)) {
     currentButtonBeep = HANDSET_Button_NONE;
   }
-  
-  state->noteTimerExpired = false;
 }
 
 void SOUND_PlaySingleTone(SOUND_Channel channel, SOUND_Target target, VOLUME_Mode volumeMode, tone_t tone, uint16_t duration) {
@@ -571,8 +534,8 @@ void SOUND_Stop(SOUND_Channel channel) {
     return;
   }
   
-  soundEffectState[channel].noteTimerExpired = true;
   soundEffectState[channel].on = false;  
+  TONE_StopTrack(channel);
 
   setHandsetAudioOutput();
 
@@ -593,67 +556,90 @@ void SOUND_SetVolumeLevel(VOLUME_Mode mode, VOLUME_Level level) {
   }
 }
 
-static Note const TONE_LOW_CONTINUOUS_NOTES[] = {
-  { TONE_LOW, TONE_OFF, 0 }    
+/**
+ * Macros for writing songs (see song.h) as a sequence of byte values.
+ * 
+ * Pitch names (e.g., GS4) are pasted directly, so that they are not expanded
+ * as unrelated macros (e.g., HIGH/LOW).
+ */
+#define NOTE(note, duration) SONG_KIND_NOTE | SONG_FLAG_SPACED | SONG_Duration_MS_##duration, SONG_Pitch_##note
+#define DUAL_NOTE(note1, note2, duration) SONG_KIND_DUAL_NOTE | SONG_FLAG_SPACED | SONG_Duration_MS_##duration, SONG_Pitch_##note1, SONG_Pitch_##note2
+#define NOTE_SLUR(note, duration) SONG_KIND_NOTE | SONG_Duration_MS_##duration, SONG_Pitch_##note
+#define DUAL_NOTE_SLUR(note1, note2, duration) SONG_KIND_DUAL_NOTE | SONG_Duration_MS_##duration, SONG_Pitch_##note1, SONG_Pitch_##note2
+#define REST(duration) SONG_KIND_REST | SONG_Duration_MS_##duration
+#define REPEAT(count) SONG_KIND_CONTROL | SONG_OP_REPEAT, count
+#define REPEAT_END SONG_KIND_CONTROL | SONG_OP_REPEAT_END
+#define END SONG_KIND_CONTROL | SONG_OP_END
+
+static uint8_t const TONE_LOW_CONTINUOUS_NOTES[] = {
+  NOTE_SLUR(LOW, 0),
+  END
 };
 
-static Note const TONE_HIGH_CONTINUOUS_NOTES[] = {
-  { TONE_HIGH, TONE_OFF, 0 }    
+static uint8_t const TONE_HIGH_CONTINUOUS_NOTES[] = {
+  NOTE_SLUR(HIGH, 0),
+  END
 };
 
-static Note const TONE_DUAL_CONTINUOUS_NOTES[] = {
-  { TONE_LOW, TONE_HIGH, 0 }    
+static uint8_t const TONE_DUAL_CONTINUOUS_NOTES[] = {
+  DUAL_NOTE_SLUR(LOW, HIGH, 0),
+  END
 };
 
-static Note const ALERT_NOTES[] = {
-  { TONE_HIGH, TONE_LOW, 25 },
-  { TONE_OFF, TONE_OFF, 25 }    
+static uint8_t const ALERT_NOTES[] = {
+  DUAL_NOTE_SLUR(HIGH, LOW, 25),
+  REST(25),
+  END
 };
 
-static Note const REORDER_TONE_NOTES[] = {
-  { TONE_HIGH, TONE_OFF, 250 },
-  { TONE_LOW, TONE_OFF, 250 }    
+static uint8_t const REORDER_TONE_NOTES[] = {
+  NOTE_SLUR(HIGH, 250),
+  NOTE_SLUR(LOW, 250),
+  END
 };
 
-static Note const BT_CONNECT_NOTES[] = {
-  { TONE_LOW, TONE_OFF, 250 },
-  { TONE_HIGH, TONE_OFF, 250 }
+static uint8_t const BT_CONNECT_NOTES[] = {
+  NOTE_SLUR(LOW, 250),
+  NOTE_SLUR(HIGH, 250),
+  END
 };
 
-static Note const BT_DISCONNECT_NOTES[] = {
-  { TONE_HIGH, TONE_OFF, 250 },
-  { TONE_LOW, TONE_OFF, 250 }    
+static uint8_t const BT_DISCONNECT_NOTES[] = {
+  NOTE_SLUR(HIGH, 250),
+  NOTE_SLUR(LOW, 250),
+  END
 };
 
-static Note const CALL_DISCONNECT_NOTES[] = {
-  { TONE_LOW, TONE_OFF, 250 },
-  { TONE_OFF, TONE_OFF, 250 },    
+static uint8_t const CALL_DISCONNECT_NOTES[] = {
+  REPEAT(2),
+  NOTE_SLUR(LOW, 250),
+  REST(250),
+  REPEAT_END,
+  END
 };
 
-static Note const CLASSIC_RINGTONE_NOTES[] = {
-  { TONE_HIGH, TONE_LOW, 25 },
-  { TONE_OFF, TONE_OFF, 25 },    
-  { TONE_OFF, TONE_OFF, 3000 },    
+static uint8_t const CLASSIC_RINGTONE_NOTES[] = {
+  REPEAT(19),
+  DUAL_NOTE_SLUR(HIGH, LOW, 25),
+  REST(25),    
+  REPEAT_END,
+  REST(3000),
+  END
 };
 
-static Note const SMOOTH_RINGTONE_NOTES[] = {
-  { TONE_HIGH, TONE_OFF, 25 },
-  { TONE_LOW, TONE_OFF, 25 },    
-  { TONE_OFF, TONE_OFF, 3000 },    
+static uint8_t const SMOOTH_RINGTONE_NOTES[] = {
+  REPEAT(19),
+  NOTE_SLUR(HIGH, 25),
+  NOTE_SLUR(LOW, 25),    
+  REPEAT_END,
+  REST(3000),
+  END
 };
 
-
-#define SPACE (50)
-#define NOTE(note, duration) { TONE_##note, TONE_OFF, duration - SPACE }, { TONE_OFF, TONE_OFF, SPACE }
-#define DUAL_NOTE(note1, note2, duration) { TONE_##note1, TONE_##note2, duration - SPACE }, { TONE_OFF, TONE_OFF, SPACE }
-#define NOTE_SLUR(note, duration) { TONE_##note, TONE_OFF, duration }
-#define DUAL_NOTE_SLUR(note1, note2, duration) { TONE_##note1, TONE_##note2, duration }
-#define REST(duration) { TONE_OFF, TONE_OFF, duration }
-
-static Note const AXEL_F_NOTES[] = {
+static uint8_t const AXEL_F_NOTES[] = {
   // Measure 1
   NOTE(F5, 500),
-  NOTE(GS5, 250 + 125),
+  NOTE(GS5, 375),
   NOTE(F5, 250),
   NOTE(F5, 125),
   NOTE(AS5, 250),
@@ -662,7 +648,7 @@ static Note const AXEL_F_NOTES[] = {
 
   // Measure 2
   NOTE(F5, 500),
-  NOTE(C6, 250 + 125),
+  NOTE(C6, 375),
   NOTE(F5, 250),
   NOTE(F5, 125),
   NOTE(CS6, 250),
@@ -683,9 +669,10 @@ static Note const AXEL_F_NOTES[] = {
   // Measure 4
   NOTE(F5, 1000),
   REST(1000),
+  END
 };
 
-static Note const NOKIA_NOTES[] = {
+static uint8_t const NOKIA_NOTES[] = {
   NOTE_SLUR(E6, 125),
   NOTE_SLUR(D6, 125),
   NOTE_SLUR(FS5, 250),
@@ -704,9 +691,10 @@ static Note const NOKIA_NOTES[] = {
   NOTE_SLUR(A5, 750),
   
   REST(750),
+  END
 };
 
-static Note const MEGALOVANIA_NOTES[] = {
+static uint8_t const MEGALOVANIA_NOTES[] = {
   // Measure 1
   DUAL_NOTE(D4, D5, 125),
   DUAL_NOTE(D4, D5, 125),
@@ -774,9 +762,10 @@ static Note const MEGALOVANIA_NOTES[] = {
   DUAL_NOTE(D4, D5, 125),
   DUAL_NOTE(F4, F5, 125),
   DUAL_NOTE(F4, F5, 125),
+  END
 };
 
-static Note const CARPHONE_NOTES[] = {
+static uint8_t const CARPHONE_NOTES[] = {
   // Measure 1
   DUAL_NOTE(DS5, DS6, 220), // Call-
   DUAL_NOTE(DS5, DS6, 220), // -ing
@@ -857,44 +846,55 @@ static Note const CARPHONE_NOTES[] = {
   DUAL_NOTE_SLUR(GS5, GS6, 220), // -o-
   DUAL_NOTE(FS5, FS6, 440),      // -one
   REST(440),
+  END
 };
 
-static Note const TETRIS_USER_MOVE_NOTES[] = {
-  { TONE_A5, 0, 25 }
+static uint8_t const TETRIS_USER_MOVE_NOTES[] = {
+  NOTE_SLUR(A5, 25),
+  END
 };
 
-static Note const TETRIS_USER_ROTATE_NOTES[] = {
-  { TONE_E6, TONE_E5, 20 },
-  { 0, 0, 20 },
-  { TONE_E6, TONE_E5, 20 }
+static uint8_t const TETRIS_USER_ROTATE_NOTES[] = {
+  DUAL_NOTE_SLUR(E6, E5, 20),
+  REST(20),
+  DUAL_NOTE_SLUR(E6, E5, 20),
+  END
 };
 
-static Note const TETRIS_PIECE_PLACED_NOTES[] = {
-  { TONE_G5, TONE_G4, 25 },
-  { TONE_F5, TONE_F4, 25 }
+static uint8_t const TETRIS_PIECE_PLACED_NOTES[] = {
+  DUAL_NOTE_SLUR(G5, G4, 25),
+  DUAL_NOTE_SLUR(F5, F4, 25),
+  END
 };
 
-static Note const TETRIS_CLEAR_2_LINES_NOTES[] = {
-  { TONE_G5, 0, 50 },
-  { TONE_A5, 0, 50 },
-  { TONE_D6, 0, 50 },
+static uint8_t const TETRIS_CLEAR_2_LINES_NOTES[] = {
+  NOTE_SLUR(G5, 50),
+  NOTE_SLUR(A5, 50),
+  NOTE_SLUR(D6, 50),
+  END
 };
 
-static Note const TETRIS_CLEAR_3_LINES_NOTES[] = {
-  { TONE_F5, 0, 50 },
-  { TONE_G5, 0, 50 },
-  { TONE_A5, 0, 50 },
-  { TONE_G5, 0, 50 },
-  { TONE_A5, 0, 50 },
-  { TONE_D6, 0, 50 },
+static uint8_t const TETRIS_CLEAR_3_LINES_NOTES[] = {
+  NOTE_SLUR(F5, 50),
+  NOTE_SLUR(G5, 50),
+  NOTE_SLUR(A5, 50),
+  NOTE_SLUR(G5, 50),
+  NOTE_SLUR(A5, 50),
+  NOTE_SLUR(D6, 50),
+  END
 };
 
-static Note const TETRIS_LOSE_NOTES[] = {
-  { TONE_G5, TONE_G4, 25 },
-  { TONE_F5, TONE_F4, 25 }
+static uint8_t const TETRIS_LOSE_NOTES[] = {
+  REPEAT(7),
+  DUAL_NOTE_SLUR(G5, G4, 25),
+  DUAL_NOTE_SLUR(F5, F4, 25),
+  REPEAT_END,
+  END
 };
 
-static Note const TETRIS_MUSIC_NOTES[] = {
+static uint8_t const TETRIS_MUSIC_NOTES[] = {
+  REPEAT(1),
+  
   // Measure 1
   DUAL_NOTE(B4, E5, 400),
   DUAL_NOTE(GS4, B4, 200),
@@ -967,6 +967,8 @@ static Note const TETRIS_MUSIC_NOTES[] = {
   DUAL_NOTE(E4, A4, 400),
   REST(400),
   
+  REPEAT_END,
+  
   // Measure 9
   DUAL_NOTE_SLUR(A3, E5, 200),
   DUAL_NOTE_SLUR(E4, E5, 200),
@@ -1041,114 +1043,31 @@ static Note const TETRIS_MUSIC_NOTES[] = {
   DUAL_NOTE_SLUR(GS3, GS5, 200),
   DUAL_NOTE(E4, GS5, 200),
   DUAL_NOTE(GS3, GS5, 400),
-  REST(400)
+  REST(400),
+  END
 };
 
-SoundEffect const effects[] = {
-  {
-    NULL,
-    0
-  },
-  {
-    TONE_LOW_CONTINUOUS_NOTES,
-    sizeof(TONE_LOW_CONTINUOUS_NOTES) / sizeof(Note)
-  },
-  {
-    TONE_HIGH_CONTINUOUS_NOTES,
-    sizeof(TONE_HIGH_CONTINUOUS_NOTES) / sizeof(Note)
-  },
-  {
-    TONE_DUAL_CONTINUOUS_NOTES,
-    sizeof(TONE_DUAL_CONTINUOUS_NOTES) / sizeof(Note)
-  },
-  {
-    ALERT_NOTES,
-    sizeof(ALERT_NOTES) / sizeof(Note),
-  },
-  {
-    REORDER_TONE_NOTES,
-    sizeof(REORDER_TONE_NOTES) / sizeof(Note)
-  },
-  {
-    BT_CONNECT_NOTES,
-    sizeof(BT_CONNECT_NOTES) / sizeof(Note)
-  },
-  {
-    BT_DISCONNECT_NOTES,
-    sizeof(BT_DISCONNECT_NOTES) / sizeof(Note)
-  },
-  {
-    CALL_DISCONNECT_NOTES,
-    sizeof(CALL_DISCONNECT_NOTES) / sizeof(Note),
-    {
-      2
-    }
-  },
-  {
-    CLASSIC_RINGTONE_NOTES,
-    sizeof(CLASSIC_RINGTONE_NOTES) / sizeof(Note),
-    {
-      19,
-      1
-    }
-  },
-  {
-    SMOOTH_RINGTONE_NOTES,
-    sizeof(SMOOTH_RINGTONE_NOTES) / sizeof(Note),
-    {
-      19,
-      1
-    }
-  },
-  {
-    AXEL_F_NOTES,
-    sizeof(AXEL_F_NOTES) / sizeof(Note)
-  },
-  {
-    NOKIA_NOTES,
-    sizeof(NOKIA_NOTES) / sizeof(Note)
-  },
-  {
-    MEGALOVANIA_NOTES,
-    sizeof(MEGALOVANIA_NOTES) / sizeof(Note)
-  },
-  {
-    CARPHONE_NOTES,
-    sizeof(CARPHONE_NOTES) / sizeof(Note)
-  },
-  {
-    TETRIS_USER_MOVE_NOTES,
-    sizeof(TETRIS_USER_MOVE_NOTES) / sizeof(Note)
-  },
-  {
-    TETRIS_USER_ROTATE_NOTES,
-    sizeof(TETRIS_USER_ROTATE_NOTES) / sizeof(Note)
-  },
-  {
-    TETRIS_PIECE_PLACED_NOTES,
-    sizeof(TETRIS_PIECE_PLACED_NOTES) / sizeof(Note)
-  },
-  {
-    TETRIS_CLEAR_2_LINES_NOTES,
-    sizeof(TETRIS_CLEAR_2_LINES_NOTES) / sizeof(Note),
-  },
-  {
-    TETRIS_CLEAR_3_LINES_NOTES,
-    sizeof(TETRIS_CLEAR_3_LINES_NOTES) / sizeof(Note),
-  },
-  {
-    TETRIS_LOSE_NOTES,
-    sizeof(TETRIS_LOSE_NOTES) / sizeof(Note),
-    {
-      7
-    }
-  },
-  {
-    TETRIS_MUSIC_NOTES,
-    sizeof(TETRIS_MUSIC_NOTES) / sizeof(Note),
-    {
-      1,
-      100
-    }
-  }
+uint8_t const* const effects[] = {
+  NULL,
+  TONE_LOW_CONTINUOUS_NOTES,
+  TONE_HIGH_CONTINUOUS_NOTES,
+  TONE_DUAL_CONTINUOUS_NOTES,
+  ALERT_NOTES,
+  REORDER_TONE_NOTES,
+  BT_CONNECT_NOTES,
+  BT_DISCONNECT_NOTES,
+  CALL_DISCONNECT_NOTES,
+  CLASSIC_RINGTONE_NOTES,
+  SMOOTH_RINGTONE_NOTES,
+  AXEL_F_NOTES,
+  NOKIA_NOTES,
+  MEGALOVANIA_NOTES,
+  CARPHONE_NOTES,
+  TETRIS_USER_MOVE_NOTES,
+  TETRIS_USER_ROTATE_NOTES,
+  TETRIS_PIECE_PLACED_NOTES,
+  TETRIS_CLEAR_2_LINES_NOTES,
+  TETRIS_CLEAR_3_LINES_NOTES,
+  TETRIS_LOSE_NOTES,
+  TETRIS_MUSIC_NOTES
 };
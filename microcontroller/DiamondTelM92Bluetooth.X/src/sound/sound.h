@@ -68,6 +68,8 @@ void SOUND_SetDefaultAudioSource(SOUND_AudioSource audioSource);
 
 void SOUND_Timer1MS_Interrupt(void);
 
+bool SOUND_IsTimer1MSInterruptRequired(void);
+
 void SOUND_Task(void);
 
 void SOUND_HANDSET_EventHandler(HANDSET_Event const* event);
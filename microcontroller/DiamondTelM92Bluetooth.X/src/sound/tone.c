@@ -4,15 +4,33 @@
  *
  * Tools for producing basic sound tones, output through DAC1.
  * 
- * Produces pure sine wave tones at a wide range of frequencies, and
- * supports producing dual-tone sounds, or playing single tones on two 
- * independent channels without affecting each other.
+ * Produces tones at a wide range of frequencies on TONE_VOICE_COUNT 
+ * independent voices, each with its own waveform, volume level, and 
+ * attack/release envelope. The voices are mixed together with saturation.
+ * 
+ * The original two tone channels (TONE_PlayTone1(), etc.) are voices 0 and 1,
+ * playing sine waves at half volume, so that two tones mixed together never 
+ * saturate.
+ * 
+ * Sound samples are calculated ahead of time in small blocks by 
+ * TONE_Timer1MS_Interrupt() into a sample buffer, so the sound sample timer 
+ * interrupt only needs to output the next sample from the buffer to the DAC.
+ * 
+ * The sound sample timer is stopped while all voices are silent, so that it
+ * does not interrupt (and wake up the CPU) thousands of times per second
+ * while there is nothing to play.
+ * 
+ * Tracks are timed by counting each sample as it is calculated. Every 
+ * calculated sample is output by exactly one sound sample timer interrupt, so 
+ * this is the same as counting sound sample timer interrupts (delayed by the 
+ * length of the sample buffer).
  */
 
 #include "tone.h"
 #include "../../mcc_generated_files/interrupt_manager.h"
 #include "../../mcc_generated_files/tmr6.h"
 #include "../../mcc_generated_files/dac1.h"
+#include "../util/scheduler.h"
 #include <xc.h>
 #include <stddef.h>
 
@@ -37,14 +55,42 @@
        console.log(result.join(", "));
      }
  */
-uint8_t const SINE_DATA[] = { 128, 131, 134, 137, 140, 143, 146, 149, 152, 155, 158, 162, 165, 167, 170, 173, 176, 179, 182, 185, 188, 190, 193, 196, 198, 201, 203, 206, 208, 211, 213, 215, 218, 220, 222, 224, 226, 228, 230, 232, 234, 235, 237, 238, 240, 241, 243, 244, 245, 246, 248, 249, 250, 250, 251, 252, 253, 253, 254, 254, 254, 255, 255, 255, 255, 255, 255, 255, 254, 254, 254, 253, 253, 252, 251, 250, 250, 249, 248, 246, 245, 244, 243, 241, 240, 238, 237, 235, 234, 232, 230, 228, 226, 224, 222, 220, 218, 215, 213, 211, 208, 206, 203, 201, 198, 196, 193, 190, 188, 185, 182, 179, 176, 173, 170, 167, 165, 162, 158, 155, 152, 149, 146, 143, 140, 137, 134, 131, 128, 124, 121, 118, 115, 112, 109, 106, 103, 100, 97, 93, 90, 88, 85, 82, 79, 76, 73, 70, 67, 65, 62, 59, 57, 54, 52, 49, 47, 44, 42, 40, 37, 35, 33, 31, 29, 27, 25, 23, 21, 20, 18, 17, 15, 14, 12, 11, 10, 9, 7, 6, 5, 5, 4, 3, 2, 2, 1, 1, 1, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 2, 2, 3, 4, 5, 5, 6, 7, 9, 10, 11, 12, 14, 15, 17, 18, 20, 21, 23, 25, 27, 29, 31, 33, 35, 37, 40, 42, 44, 47, 49, 52, 54, 57, 59, 62, 65, 67, 70, 73, 76, 79, 82, 85, 88, 90, 93, 97, 100, 103, 106, 109, 112, 115, 118, 121, 124 };
+uint8_t const TONE_WAVEFORM_SINE[] = { 128, 131, 134, 137, 140, 143, 146, 149, 152, 155, 158, 162, 165, 167, 170, 173, 176, 179, 182, 185, 188, 190, 193, 196, 198, 201, 203, 206, 208, 211, 213, 215, 218, 220, 222, 224, 226, 228, 230, 232, 234, 235, 237, 238, 240, 241, 243, 244, 245, 246, 248, 249, 250, 250, 251, 252, 253, 253, 254, 254, 254, 255, 255, 255, 255, 255, 255, 255, 254, 254, 254, 253, 253, 252, 251, 250, 250, 249, 248, 246, 245, 244, 243, 241, 240, 238, 237, 235, 234, 232, 230, 228, 226, 224, 222, 220, 218, 215, 213, 211, 208, 206, 203, 201, 198, 196, 193, 190, 188, 185, 182, 179, 176, 173, 170, 167, 165, 162, 158, 155, 152, 149, 146, 143, 140, 137, 134, 131, 128, 124, 121, 118, 115, 112, 109, 106, 103, 100, 97, 93, 90, 88, 85, 82, 79, 76, 73, 70, 67, 65, 62, 59, 57, 54, 52, 49, 47, 44, 42, 40, 37, 35, 33, 31, 29, 27, 25, 23, 21, 20, 18, 17, 15, 14, 12, 11, 10, 9, 7, 6, 5, 5, 4, 3, 2, 2, 1, 1, 1, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 2, 2, 3, 4, 5, 5, 6, 7, 9, 10, 11, 12, 14, 15, 17, 18, 20, 21, 23, 25, 27, 29, 31, 33, 35, 37, 40, 42, 44, 47, 49, 52, 54, 57, 59, 62, 65, 67, 70, 73, 76, 79, 82, 85, 88, 90, 93, 97, 100, 103, 106, 109, 112, 115, 118, 121, 124 };
+
+/**
+ * Triangle waveform lookup table.
+ * 
+ * Same scale and phase as TONE_WAVEFORM_SINE.
+ * 
+ * JavaScript function for generating this table:
+ * 
+     function makeTriangleTable(samples, min, max) {
+       const result = [];
+
+       for (i = 0; i < samples; ++i) {
+         const p = i / samples;
+         const t = (p < 0.25) ? p * 4 : (p < 0.75) ? 2 - p * 4 : p * 4 - 4;
+         result.push(Math.round((t + 1) * ((max - min) / 2) + min));
+       }
+
+       console.log(result.join(", "));
+     }
+ */
+uint8_t const TONE_WAVEFORM_TRIANGLE[] = { 128, 129, 131, 133, 135, 137, 139, 141, 143, 145, 147, 149, 151, 153, 155, 157, 159, 161, 163, 165, 167, 169, 171, 173, 175, 177, 179, 181, 183, 185, 187, 189, 191, 193, 195, 197, 199, 201, 203, 205, 207, 209, 211, 213, 215, 217, 219, 221, 223, 225, 227, 229, 231, 233, 235, 237, 239, 241, 243, 245, 247, 249, 251, 253, 255, 253, 251, 249, 247, 245, 243, 241, 239, 237, 235, 233, 231, 229, 227, 225, 223, 221, 219, 217, 215, 213, 211, 209, 207, 205, 203, 201, 199, 197, 195, 193, 191, 189, 187, 185, 183, 181, 179, 177, 175, 173, 171, 169, 167, 165, 163, 161, 159, 157, 155, 153, 151, 149, 147, 145, 143, 141, 139, 137, 135, 133, 131, 129, 128, 126, 124, 122, 120, 118, 116, 114, 112, 110, 108, 106, 104, 102, 100, 98, 96, 94, 92, 90, 88, 86, 84, 82, 80, 78, 76, 74, 72, 70, 68, 66, 64, 62, 60, 58, 56, 54, 52, 50, 48, 46, 44, 42, 40, 38, 36, 34, 32, 30, 28, 26, 24, 22, 20, 18, 16, 14, 12, 10, 8, 6, 4, 2, 0, 2, 4, 6, 8, 10, 12, 14, 16, 18, 20, 22, 24, 26, 28, 30, 32, 34, 36, 38, 40, 42, 44, 46, 48, 50, 52, 54, 56, 58, 60, 62, 64, 66, 68, 70, 72, 74, 76, 78, 80, 82, 84, 86, 88, 90, 92, 94, 96, 98, 100, 102, 104, 106, 108, 110, 112, 114, 116, 118, 120, 122, 124, 126 };
+
+/**
+ * Square waveform lookup table.
+ * 
+ * Same scale and phase as TONE_WAVEFORM_SINE.
+ */
+uint8_t const TONE_WAVEFORM_SQUARE[] = { 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0 };
 
 /**
- * The midpoint value of the sine waveform.
+ * The midpoint value of the waveforms.
  * 
  * This is used to output "nothing" as tone output sample. 
  */
-#define SINE_MIDPOINT_VALUE (128)
+#define WAVEFORM_MIDPOINT_VALUE (128)
 
 /**
  * The DAC output sample rate (Hz)
@@ -52,7 +98,35 @@ uint8_t const SINE_DATA[] = { 128, 131, 134, 137, 140, 143, 146, 149, 152, 155,
 #define OUTPUT_SAMPLE_RATE (10000)
 
 /**
- * 16-bit unsigned fixed point integer index into the SINE_DATA table.
+ * Number of output samples per 1ms.
+ */
+#define SAMPLES_PER_MS (OUTPUT_SAMPLE_RATE / 1000)
+
+/**
+ * Number of samples in the sample buffer. Must be a power of 2, no larger
+ * than 128.
+ * 
+ * The buffer is refilled every 1ms (10 samples), so this allows the 1ms timer 
+ * interrupt to be delayed by up to 2ms without running out of samples.
+ */
+#define SAMPLE_BUFFER_SIZE (32)
+
+/**
+ * Number of consecutive 1ms blocks without any active voices before the 
+ * sound sample timer is stopped.
+ * 
+ * This is long enough for the whole sample buffer to be output, so the 
+ * buffer contains only silence when the timer is stopped.
+ */
+#define SILENT_BLOCKS_BEFORE_STOP ((SAMPLE_BUFFER_SIZE / 10) + 1)
+
+/**
+ * Volume level of the voices used by the original two tone channels.
+ */
+#define CHANNEL_LEVEL (128)
+
+/**
+ * 16-bit unsigned fixed point integer index into a waveform table.
  * Used to keep track of fractional increments through the table.
  */
 typedef union {
@@ -71,31 +145,56 @@ typedef union {
      */
     uint8_t integer: 8;
   };
-} sine_index_t;
+} waveform_index_t;
 
 /**
- * Used to set the next tone(s) to be output starting on the next
- * sound sample output.
+ * Settings of a voice, as passed to TONE_PlayVoice().
+ */
+typedef struct {
+  tone_t tone;
+  uint8_t const* waveform;
+  uint8_t level;
+  uint8_t attack;
+  uint8_t release;
+} voiceSettings_t;
+
+/**
+ * Used to set the next voice settings to be picked up when the next block
+ * of samples is calculated.
  */
 static volatile struct {
   /**
-   * The tone to play on channel 1.
+   * The settings for each voice.
    */
-  tone_t tone1;
+  voiceSettings_t voices[TONE_VOICE_COUNT];
   /**
-   * The tone to play on channel 2.
+   * Bit flags of voices whose settings will be picked up when the next block 
+   * of samples is calculated (bit N = voice N).
+   * 
+   * Each bit is set back to 0 after the voice's settings have been consumed.
    */
-  tone_t tone2;
+  uint8_t stagedVoices;
   /**
-   * If true, then the tone1 and tone2 values will be picked up at the next
-   * sound sample timer interrupt.
-   * 
-   * Set back to false after the values have been consumed.
-   * 
-   * Do not modify tone1 or tone2 while this is true!
+   * True while voice settings are being modified. The staged settings are 
+   * not picked up while this is true, and will instead be picked up for the 
+   * following block of samples.
    */
-  bool isStaged;
-} stagedTones;
+  bool isUpdating;
+} staged;
+
+/**
+ * Buffer of calculated sound samples waiting to be output.
+ * 
+ * Samples are added only by TONE_Timer1MS_Interrupt() and removed only by 
+ * the sound sample timer interrupt handler. The head/tail indexes are 
+ * free-running (masked when used to access the buffer), so the number of 
+ * samples in the buffer is always (head - tail).
+ */
+static volatile struct {
+  uint8_t samples[SAMPLE_BUFFER_SIZE];
+  uint8_t head;
+  uint8_t tail;
+} sampleBuffer;
 
 typedef struct {
   /**
@@ -105,182 +204,533 @@ typedef struct {
    */
   tone_t tone;
   /**
-   * Current index into the sine lookup table this tone.
+   * Waveform lookup table of this voice.
+   */
+  uint8_t const* waveform;
+  /**
+   * Current index into the waveform lookup table for this voice.
+   */
+  waveform_index_t index;
+  /**
+   * Current volume level (envelope output).
    */
-  sine_index_t index;
+  uint8_t level;
   /**
-   * True if the tone is on its way to stopping 
-   * (when the waveform next crosses the mid-point).
+   * Volume level that the envelope is moving towards.
+   */
+  uint8_t targetLevel;
+  /**
+   * Increase of level per 1ms (0 = immediately).
+   */
+  uint8_t attack;
+  /**
+   * Decrease of level per 1ms (0 = immediately).
+   */
+  uint8_t release;
+  /**
+   * True if the tone is on its way to stopping (when the level reaches zero,
+   * or the waveform next crosses the mid-point if there is no release).
    */
   bool isStopping;  
-} toneState_t;
+} voiceState_t;
 
 /**
- * State of the sound sample output generator.
- * This structure must ONLY be read/written by the timer interrupt handler.
+ * State of the sound sample generator.
+ * This structure must ONLY be read/written by TONE_Timer1MS_Interrupt().
  */
 static struct {
+  voiceState_t voices[TONE_VOICE_COUNT];
+  /**
+   * Number of consecutive blocks of samples calculated without any active 
+   * voices (saturates at SILENT_BLOCKS_BEFORE_STOP).
+   */
+  uint8_t silentBlockCount;
+} state;
+
+/**
+ * True while the sound sample timer is running.
+ * 
+ * Only written by TONE_Timer1MS_Interrupt() (after initialization).
+ */
+static volatile bool isSampleTimerRunning;
+
+/**
+ * A dual-tone note of a track.
+ */
+typedef struct {
+  tone_t tone1;
+  tone_t tone2;
+  /**
+   * Duration (samples). Zero (0) if the note plays indefinitely.
+   */
+  uint32_t duration;
+} trackNote_t;
+
+/**
+ * State of a track.
+ */
+typedef struct {
   /**
-   * The sound sample value to be output at the next timer interrupt.
+   * The current note.
    */
-  uint8_t nextSample;  
+  trackNote_t note;
   /**
-   * The current tone being played on channel 1.
+   * The note that follows the current note (only if isNextNoteQueued).
    */
-  toneState_t tone1;
+  trackNote_t nextNote;
   /**
-   * The current tone being played on channel 2.
+   * Number of samples remaining in the current note. Zero (0) if the current
+   * note plays indefinitely.
    */
-  toneState_t tone2;
-} state;
+  uint32_t remainingSamples;
+  /**
+   * True while the track is playing.
+   */
+  bool isPlaying;
+  /**
+   * True if nextNote is queued.
+   * 
+   * Only set by the main loop (after nextNote is written), and only cleared 
+   * by TONE_Timer1MS_Interrupt() (after nextNote is consumed).
+   */
+  bool isNextNoteQueued;
+} trackState_t;
 
 /**
- * Initialize a tone state to begin playing a specified tone.
- * @param toneState - Pointer to a tone state.
- * @param tone - The tone to play.
+ * State of the note sequencer.
  */
-static void initToneState(toneState_t* toneState, tone_t tone) {
-  if (tone) {
-    toneState->tone = tone;
-    toneState->isStopping = false;
-  } else if (toneState->tone) {
-    // The tone state is changing from a tone to no tone.
+static volatile struct {
+  trackState_t tracks[TONE_TRACK_COUNT];
+  /**
+   * The track that is played on voices 0 and 1 (or TONE_NO_TRACK).
+   */
+  uint8_t audibleTrack;
+  /**
+   * True if the current note of the audible track must be applied to 
+   * voices 0 and 1 when the next block of samples is calculated.
+   */
+  bool isAudibleTrackChanged;
+  /**
+   * True while the timing of all tracks is paused.
+   */
+  bool isPaused;
+} sequencer;
+
+/**
+ * Initialize a voice state from staged voice settings.
+ * @param voiceState - Pointer to a voice state.
+ * @param settings - Pointer to the staged voice settings.
+ */
+static void initVoiceState(voiceState_t* voiceState, voiceSettings_t const volatile* settings) {
+  voiceState->attack = settings->attack;
+  voiceState->release = settings->release;
+
+  if (settings->tone) {
+    if (!voiceState->tone) {
+      // Start from silence. A voice that is already playing continues
+      // from its current level, for a smooth change of tone.
+      voiceState->level = settings->attack ? 0 : settings->level;
+    }
+
+    voiceState->tone = settings->tone;
+    voiceState->waveform = settings->waveform;
+    voiceState->targetLevel = settings->level;
+    voiceState->isStopping = false;
+  } else if (voiceState->tone) {
+    // The voice state is changing from a tone to no tone.
     // We don't want to immediately start outputting nothing, because this 
     // can cause a "pop" in the sound if the previous tone is near a
-    // high or low point in the sine wave and suddenly jumps to the midpoint.
+    // high or low point in the waveform and suddenly jumps to the midpoint.
     //
     // Instead, we set a flag to indicate we want to stop this tone, and it 
-    // will continue playing until it crosses the midpoint.
-    toneState->isStopping = true;
+    // will continue playing until its release completes, or until it crosses 
+    // the midpoint.
+    voiceState->targetLevel = 0;
+    voiceState->isStopping = true;
   }
 }
 
 /**
- * Advances the index of a tone state and returns its next sine wave sample value.
+ * Advances the envelope of a voice by 1ms.
  * 
- * @param toneState - Pointer to a tone state.
- * @return The next sine wave sample value for the tone.
+ * @param voiceState - Pointer to a voice state.
  */
-static uint16_t getNextToneSample(toneState_t* toneState) {
-  if (!toneState->tone) {
-    return SINE_MIDPOINT_VALUE;
+static void updateVoiceEnvelope(voiceState_t* voiceState) {
+  uint8_t const level = voiceState->level;
+  uint8_t const targetLevel = voiceState->targetLevel;
+
+  if (level < targetLevel) {
+    voiceState->level = (!voiceState->attack || (targetLevel - level <= voiceState->attack))
+        ? targetLevel
+        : level + voiceState->attack;
+  } else if (level > targetLevel) {
+    if (voiceState->release) {
+      voiceState->level = (level - targetLevel <= voiceState->release)
+          ? targetLevel
+          : level - voiceState->release;
+    } else if (!voiceState->isStopping) {
+      voiceState->level = targetLevel;
+    }
+    // Otherwise, the tone is stopping without a release, so it keeps its 
+    // level until it crosses the midpoint (see getNextVoiceSample()).
+  } else if (voiceState->isStopping) {
+    // The release has completed
+    voiceState->tone = 0;
+    voiceState->index.value = 0;
+    voiceState->isStopping = false;
   }
-  
+}
+
+/**
+ * Advances the index of a voice and returns its next sample value, scaled
+ * by the voice's current level.
+ * 
+ * @param voiceState - Pointer to a voice state that is playing a tone.
+ * @return The next sample value for the voice, relative to the midpoint
+ *         (-128 to 127).
+ */
+static int8_t getNextVoiceSample(voiceState_t* voiceState) {
   /**
-   * The index of the previous sample output for this tone.
+   * The index of the previous sample output for this voice.
    */
-  uint8_t const lastIndex = toneState->index.integer;
+  uint8_t const lastIndex = voiceState->index.integer;
   
-  // Advance the index of this tone
-  toneState->index.value += toneState->tone;
+  // Advance the index of this voice
+  voiceState->index.value += voiceState->tone;
   
   /**
-   * The index of the next sample to output for this tone.
+   * The index of the next sample to output for this voice.
    */
-  uint8_t const newIndex = toneState->index.integer;
+  uint8_t const newIndex = voiceState->index.integer;
 
-  // If the tone is in the process of stopping, then check to see if this sample 
-  // would be crossing the midpoint, which is when we want to actually stop 
-  // the tone (to minimize "popping" in the sound when stopping a tone).
+  // If the tone is in the process of stopping without a release, then check 
+  // to see if this sample would be crossing the midpoint, which is when we 
+  // want to actually stop the tone (to minimize "popping" in the sound when 
+  // stopping a tone).
   //
-  // The sine lookup table has 256 indexes, and the sine wave crosses the 
+  // The waveform lookup tables have 256 indexes, and the waveforms cross the 
   // midpoint and index 0 (0b00000000) and at index 128 (0b10000000). So if the 
   // MSB of the previous index is different than the MSB of the new index, then
   // this means that the tone sample is crossing the midpoint.
-  if (toneState->isStopping 
+  if (voiceState->isStopping 
+      && !voiceState->release
       && ((lastIndex & 0b10000000) != (newIndex & 0b10000000))
       ) {
-    toneState->tone = 0;
-    toneState->index.value = 0;
-    toneState->isStopping = false;
+    voiceState->tone = 0;
+    voiceState->index.value = 0;
+    voiceState->isStopping = false;
 
-    return SINE_MIDPOINT_VALUE;
+    return 0;
   } else {
-    return SINE_DATA[newIndex];
+    int8_t const sample = (int8_t)(voiceState->waveform[newIndex] - WAVEFORM_MIDPOINT_VALUE);
+    return (int8_t)(((int16_t)sample * voiceState->level) >> 8);
+  }
+}
+
+/**
+ * Applies the current note of the audible track to voices 0 and 1 
+ * (or stops them if the audible track is not playing).
+ * 
+ * Must only be called by TONE_Timer1MS_Interrupt().
+ */
+static void applyAudibleTrackNote(void) {
+  trackState_t const volatile* const track = &sequencer.tracks[sequencer.audibleTrack];
+  voiceSettings_t settings;
+
+  settings.waveform = TONE_WAVEFORM_SINE;
+  settings.level = CHANNEL_LEVEL;
+  settings.attack = 0;
+  settings.release = 0;
+
+  settings.tone = track->isPlaying ? track->note.tone1 : TONE_OFF;
+  initVoiceState(&state.voices[0], &settings);
+
+  settings.tone = track->isPlaying ? track->note.tone2 : TONE_OFF;
+  initVoiceState(&state.voices[1], &settings);
+}
+
+/**
+ * Tests if any track is currently counting samples towards the end of a note.
+ * 
+ * @return True if any track is advancing.
+ */
+static bool isAnyTrackAdvancing(void) {
+  if (sequencer.isPaused) {
+    return false;
+  }
+
+  for (uint8_t i = 0; i < TONE_TRACK_COUNT; ++i) {
+    if (sequencer.tracks[i].isPlaying && sequencer.tracks[i].remainingSamples) {
+      return true;
+    }
+  }
+
+  return false;
+}
+
+/**
+ * Advances all tracks by one sample, starting the next note of each track 
+ * whose current note ends.
+ * 
+ * Must only be called by TONE_Timer1MS_Interrupt().
+ * 
+ * @return True if the note of the audible track changed.
+ */
+static bool advanceTracks(void) {
+  bool isAudibleNoteChanged = false;
+
+  for (uint8_t i = 0; i < TONE_TRACK_COUNT; ++i) {
+    trackState_t volatile* const track = &sequencer.tracks[i];
+
+    if (!track->isPlaying || !track->remainingSamples || --track->remainingSamples) {
+      continue;
+    }
+
+    if (track->isNextNoteQueued) {
+      track->note = track->nextNote;
+      track->remainingSamples = track->note.duration;
+      track->isNextNoteQueued = false;
+    } else {
+      track->isPlaying = false;
+    }
+
+    // The owner of the track must queue its next note (or observe its end)
+    SCHEDULER_MarkRunnable(SCHEDULER_Task_APP);
+
+    if (i == sequencer.audibleTrack) {
+      isAudibleNoteChanged = true;
+    }
   }
+
+  return isAudibleNoteChanged;
 }
 
 /**
- * Outputs the sound sample value to the DAC, then calculates the next
- * sound sample.
+ * Gets the bit flags of voices that are currently playing a tone.
+ * 
+ * @return Bit flags of active voices (bit N = voice N).
+ */
+static uint8_t getActiveVoices(void) {
+  uint8_t activeVoices = 0;
+
+  for (uint8_t i = 0; i < TONE_VOICE_COUNT; ++i) {
+    if (state.voices[i].tone) {
+      activeVoices |= (uint8_t)(1 << i);
+    }
+  }
+
+  return activeVoices;
+}
+
+/**
+ * Outputs the next sound sample value from the sample buffer to the DAC.
  * 
  * Used as a timer interrupt handler for a timer that triggers at the desired 
  * sound sampling rate.
  */
-static void outputSoundSampleAndCalculateNextSample(void) {
-  // Write the DAC output of the previous calculated sample.
-  // This is done first to guarantee consistent sample rate of the output.
-  DAC1_SetOutput(state.nextSample);
-  
-  if (stagedTones.isStaged) {
-    // Load up the staged tones
-    initToneState(&state.tone1, stagedTones.tone1);
-    initToneState(&state.tone2, stagedTones.tone2);
-    stagedTones.isStaged = false;
+static void outputNextSoundSample(void) {
+  uint8_t const tail = sampleBuffer.tail;
+
+  // If the buffer ran empty, then the DAC simply keeps outputting the 
+  // previous sample.
+  if (tail != sampleBuffer.head) {
+    DAC1_SetOutput(sampleBuffer.samples[tail & (SAMPLE_BUFFER_SIZE - 1)]);
+    sampleBuffer.tail = tail + 1;
   }
+}
 
-  // Add up the sample from both tones and divide by 2 to guarantee the result
-  // is in the range of 0-255.
-  uint16_t const nextOutputCalc = 
-      (getNextToneSample(&state.tone1) +
-      getNextToneSample(&state.tone2)) >> 1;
+/**
+ * Stages new settings for a voice.
+ * 
+ * @param voice - The voice number.
+ * @param tone - The tone to play.
+ * @param waveform - The waveform lookup table.
+ * @param level - The volume level.
+ * @param attack - Increase of level per 1ms.
+ * @param release - Decrease of level per 1ms.
+ */
+static void stageVoice(uint8_t voice, tone_t tone, uint8_t const* waveform, uint8_t level, uint8_t attack, uint8_t release) {
+  voiceSettings_t volatile* const settings = &staged.voices[voice];
 
-  state.nextSample = (uint8_t)nextOutputCalc;
+  settings->tone = tone;
+  
+  // When stopping, leave the previous waveform and level unchanged so the 
+  // tone fades out as-is
+  if (tone) {
+    settings->waveform = waveform;
+    settings->level = level;
+    settings->attack = attack;
+  }
+  
+  settings->release = release;
+  staged.stagedVoices |= (uint8_t)(1 << voice);
 }
 
 void TONE_Initialize(void) {
-  stagedTones.isStaged = false;
-  stagedTones.tone1 = 0;
-  stagedTones.tone2 = 0;
+  staged.isUpdating = false;
+  staged.stagedVoices = 0;
+  
+  for (uint8_t i = 0; i < TONE_VOICE_COUNT; ++i) {
+    staged.voices[i].tone = TONE_OFF;
+    staged.voices[i].waveform = TONE_WAVEFORM_SINE;
+    staged.voices[i].level = 0;
+    staged.voices[i].attack = 0;
+    staged.voices[i].release = 0;
 
-  state.tone1.tone = TONE_OFF;
-  state.tone1.index.value = 0;
-  state.tone1.isStopping = false;
+    state.voices[i].tone = TONE_OFF;
+    state.voices[i].waveform = TONE_WAVEFORM_SINE;
+    state.voices[i].index.value = 0;
+    state.voices[i].level = 0;
+    state.voices[i].targetLevel = 0;
+    state.voices[i].attack = 0;
+    state.voices[i].release = 0;
+    state.voices[i].isStopping = false;
+  }
   
-  state.tone2.tone = TONE_OFF;
-  state.tone2.index.value = 0;
-  state.tone2.isStopping = false;
+  state.silentBlockCount = 0;
   
-  state.nextSample = SINE_MIDPOINT_VALUE;
+  for (uint8_t i = 0; i < TONE_TRACK_COUNT; ++i) {
+    sequencer.tracks[i].isPlaying = false;
+    sequencer.tracks[i].isNextNoteQueued = false;
+  }
+  
+  sequencer.audibleTrack = TONE_NO_TRACK;
+  sequencer.isAudibleTrackChanged = false;
+  sequencer.isPaused = false;
+  
+  sampleBuffer.head = 0;
+  sampleBuffer.tail = 0;
+  DAC1_SetOutput(WAVEFORM_MIDPOINT_VALUE);
 
-  TMR6_SetInterruptHandler(&outputSoundSampleAndCalculateNextSample);
+  TMR6_SetInterruptHandler(&outputNextSoundSample);
   TMR6_StartTimer();
+  isSampleTimerRunning = true;
+}
+
+void TONE_Timer1MS_Interrupt(void) {
+  for (uint8_t i = 0; i < TONE_VOICE_COUNT; ++i) {
+    if (!staged.isUpdating && (staged.stagedVoices & (1 << i))) {
+      // Load up the staged voice settings
+      initVoiceState(&state.voices[i], &staged.voices[i]);
+      staged.stagedVoices &= (uint8_t)~(1 << i);
+    }
+  }
+  
+  if (sequencer.isAudibleTrackChanged) {
+    sequencer.isAudibleTrackChanged = false;
+    
+    if (sequencer.audibleTrack != TONE_NO_TRACK) {
+      applyAudibleTrackNote();
+    }
+  }
+  
+  for (uint8_t i = 0; i < TONE_VOICE_COUNT; ++i) {
+    if (state.voices[i].tone) {
+      updateVoiceEnvelope(&state.voices[i]);
+    }
+  }
+  
+  uint8_t activeVoices = getActiveVoices();
+  bool const isSequencing = isAnyTrackAdvancing();
+  
+  // The sound sample timer also keeps running while tracks are advancing 
+  // (even if silent), because the tracks are timed by the samples.
+  if (activeVoices || isSequencing) {
+    state.silentBlockCount = 0;
+    
+    if (!isSampleTimerRunning) {
+      TMR6_StartTimer();
+      isSampleTimerRunning = true;
+    }
+  } else if (state.silentBlockCount < SILENT_BLOCKS_BEFORE_STOP) {
+    ++state.silentBlockCount;
+  } else if (isSampleTimerRunning) {
+    // The DAC keeps outputting the last (silent) sample
+    TMR6_StopTimer();
+    isSampleTimerRunning = false;
+  }
+  
+  uint8_t head = sampleBuffer.head;
+  
+  while ((uint8_t)(head - sampleBuffer.tail) < SAMPLE_BUFFER_SIZE) {
+    int16_t mix = 0;
+    
+    for (uint8_t i = 0; i < TONE_VOICE_COUNT; ++i) {
+      if (activeVoices & (1 << i)) {
+        mix += getNextVoiceSample(&state.voices[i]);
+      }
+    }
+    
+    // Saturate to the range of the DAC
+    if (mix > 127) {
+      mix = 127;
+    } else if (mix < -128) {
+      mix = -128;
+    }
+
+    sampleBuffer.samples[head & (SAMPLE_BUFFER_SIZE - 1)] = (uint8_t)(mix + WAVEFORM_MIDPOINT_VALUE);
+    // Only make the sample available for output after it is written
+    sampleBuffer.head = ++head;
+    
+    // Count the sample towards the end of the current notes, so that the next
+    // note of the audible track starts on the exact sample at which the 
+    // current note ends.
+    if (isSequencing && advanceTracks()) {
+      applyAudibleTrackNote();
+      activeVoices = getActiveVoices();
+    }
+  }
+}
+
+bool TONE_IsTimer1MSInterruptRequired(void) {
+  return isSampleTimerRunning || staged.stagedVoices || 
+      sequencer.isAudibleTrackChanged || isAnyTrackAdvancing();
 }
 
 tone_t TONE_CalculateToneFromFrequency(uint16_t freq) {
   return (tone_t)((((uint32_t)freq) << 16) / OUTPUT_SAMPLE_RATE);
 }
 
-void TONE_PlayTone1(tone_t tone) {
-  // This prevents corruption of tone state data if the timer interrupt
-  // occurs in the middle up this function.
-  while (stagedTones.isStaged);
+void TONE_PlayVoice(uint8_t voice, tone_t tone, uint8_t const* waveform, uint8_t level, uint8_t attack, uint8_t release) {
+  if (voice >= TONE_VOICE_COUNT) {
+    return;
+  }
   
-  // NOTE: Leave stagedTones.tone2 unchanged so that the previously played tone
+  // This prevents the timer interrupt from picking up partially updated 
+  // settings if it occurs in the middle of this function.
+  staged.isUpdating = true;
+  stageVoice(voice, tone, waveform, level, attack, release);
+  staged.isUpdating = false;
+}
+
+void TONE_StopVoice(uint8_t voice) {
+  if (voice >= TONE_VOICE_COUNT) {
+    return;
+  }
+  
+  staged.isUpdating = true;
+  stageVoice(voice, TONE_OFF, NULL, 0, 0, staged.voices[voice].release);
+  staged.isUpdating = false;
+}
+
+void TONE_PlayTone1(tone_t tone) {
+  // NOTE: Leave voice 1 unchanged so that the previously played tone
   //       on channel 2 continues playing as-is.
-  stagedTones.tone1 = tone;
-  stagedTones.isStaged = true;
+  TONE_PlayVoice(0, tone, TONE_WAVEFORM_SINE, CHANNEL_LEVEL, 0, 0);
 }
 
 void TONE_PlayTone2(tone_t tone) {
-  // This prevents corruption of tone state data if the timer interrupt
-  // occurs in the middle up this function.
-  while (stagedTones.isStaged);
-  
-  // NOTE: Leave stagedTones.tone1 unchanged so that the previously played tone
+  // NOTE: Leave voice 0 unchanged so that the previously played tone
   //       on channel 1 continues playing as-is.
-  stagedTones.tone2 = tone;
-  stagedTones.isStaged = true;
+  TONE_PlayVoice(1, tone, TONE_WAVEFORM_SINE, CHANNEL_LEVEL, 0, 0);
 }
 
 void TONE_PlayDualTone(tone_t tone1, tone_t tone2) {
-  // This prevents corruption of tone state data if the timer interrupt
-  // occurs in the middle up this function.
-  while (stagedTones.isStaged);
-  
-  stagedTones.tone1 = tone1;
-  stagedTones.tone2 = tone2;
-  stagedTones.isStaged = true;
+  // Both tones are staged together so that they start on the same sample.
+  staged.isUpdating = true;
+  stageVoice(0, tone1, TONE_WAVEFORM_SINE, CHANNEL_LEVEL, 0, 0);
+  stageVoice(1, tone2, TONE_WAVEFORM_SINE, CHANNEL_LEVEL, 0, 0);
+  staged.isUpdating = false;
 }
 
 void TONE_PlaySingleTone(tone_t tone) {
@@ -298,3 +748,89 @@ void TONE_StopTone2(void) {
 void TONE_Stop(void) {
   TONE_PlayDualTone(TONE_OFF, TONE_OFF);
 }
+
+void TONE_StartTrack(uint8_t track, tone_t tone1, tone_t tone2, uint16_t duration) {
+  if (track >= TONE_TRACK_COUNT) {
+    return;
+  }
+  
+  trackState_t volatile* const trackState = &sequencer.tracks[track];
+
+  uint8_t GIEBitValue = INTCON0bits.GIE;
+  INTCON0bits.GIE = 0;
+
+  trackState->note.tone1 = tone1;
+  trackState->note.tone2 = tone2;
+  trackState->note.duration = (uint32_t)duration * SAMPLES_PER_MS;
+  trackState->remainingSamples = trackState->note.duration;
+  trackState->isNextNoteQueued = false;
+  trackState->isPlaying = true;
+  
+  if (track == sequencer.audibleTrack) {
+    sequencer.isAudibleTrackChanged = true;
+  }
+
+  INTCON0bits.GIE = GIEBitValue;
+}
+
+bool TONE_QueueTrackNote(uint8_t track, tone_t tone1, tone_t tone2, uint16_t duration) {
+  if (track >= TONE_TRACK_COUNT) {
+    return false;
+  }
+  
+  trackState_t volatile* const trackState = &sequencer.tracks[track];
+  
+  if (trackState->isNextNoteQueued) {
+    return false;
+  }
+  
+  // The next note is not accessed by the timer interrupt until it is 
+  // flagged as queued.
+  trackState->nextNote.tone1 = tone1;
+  trackState->nextNote.tone2 = tone2;
+  trackState->nextNote.duration = (uint32_t)duration * SAMPLES_PER_MS;
+  
+  // The current note may end at any time, so the track must be tested as 
+  // playing in the same step as the note is flagged as queued.
+  uint8_t GIEBitValue = INTCON0bits.GIE;
+  INTCON0bits.GIE = 0;
+  
+  bool const isQueued = trackState->isPlaying;
+  trackState->isNextNoteQueued = isQueued;
+  
+  INTCON0bits.GIE = GIEBitValue;
+  
+  return isQueued;
+}
+
+bool TONE_IsTrackNoteQueued(uint8_t track) {
+  return (track < TONE_TRACK_COUNT) && sequencer.tracks[track].isNextNoteQueued;
+}
+
+bool TONE_IsTrackPlaying(uint8_t track) {
+  return (track < TONE_TRACK_COUNT) && sequencer.tracks[track].isPlaying;
+}
+
+void TONE_StopTrack(uint8_t track) {
+  if (track >= TONE_TRACK_COUNT) {
+    return;
+  }
+
+  uint8_t GIEBitValue = INTCON0bits.GIE;
+  INTCON0bits.GIE = 0;
+  sequencer.tracks[track].isPlaying = false;
+  sequencer.tracks[track].isNextNoteQueued = false;
+  INTCON0bits.GIE = GIEBitValue;
+}
+
+void TONE_SetAudibleTrack(uint8_t track) {
+  uint8_t GIEBitValue = INTCON0bits.GIE;
+  INTCON0bits.GIE = 0;
+  sequencer.audibleTrack = (track < TONE_TRACK_COUNT) ? track : TONE_NO_TRACK;
+  sequencer.isAudibleTrackChanged = true;
+  INTCON0bits.GIE = GIEBitValue;
+}
+
+void TONE_SetTracksPaused(bool isPaused) {
+  sequencer.isPaused = isPaused;
+}
@@ -4,9 +4,21 @@
  *
  * Tools for producing basic sound tones, output through DAC1.
  * 
- * Produces pure sine wave tones at a wide range of frequencies, and
- * supports producing dual-tone sounds, or playing single tones on two 
- * independent channels without affecting each other.
+ * Produces tones at a wide range of frequencies on TONE_VOICE_COUNT 
+ * independent voices, each with its own waveform, volume level, and 
+ * attack/release envelope.
+ * 
+ * The original two tone "channels" are voices 0 and 1, which play sine waves
+ * at half volume. They support producing dual-tone sounds, or playing single 
+ * tones on two independent channels without affecting each other.
+ * 
+ * Sequences of dual-tone notes can be played on voices 0 and 1 by "tracks"
+ * (see TONE_StartTrack()). Each track plays one note at a time, with the 
+ * following note queued in advance. Note boundaries are counted in samples 
+ * as the samples are calculated, so the next note starts on the exact sample 
+ * at which the previous note ends, regardless of when the main loop gets 
+ * around to queuing notes. Multiple tracks can play at the same time (each 
+ * keeps its own time), but only one of them is audible.
  */
 
 #ifndef TONE_H
@@ -52,6 +64,38 @@ typedef uint16_t tone_t;
     
 #define TONE_OFF (0)
 
+/**
+ * Number of independent voices.
+ * 
+ * Voices 0 and 1 are also used as channels 1 and 2 (TONE_PlayTone1(), etc.).
+ * Every sound is currently a single or dual tone (a foreground sound replaces
+ * the background sound rather than playing over it), so no more voices are 
+ * needed. Each voice adds to the cost of every calculated sample.
+ */
+#define TONE_VOICE_COUNT (2)
+
+/**
+ * Number of independent tracks.
+ */
+#define TONE_TRACK_COUNT (2)
+
+/**
+ * Track number that identifies no track (see TONE_SetAudibleTrack()).
+ */
+#define TONE_NO_TRACK (0xFF)
+
+/**
+ * Waveform lookup tables for TONE_PlayVoice().
+ * 
+ * Any other table of 256 samples for a single complete wave can also be used
+ * (e.g., a sampled waveform). Values must be scaled such that the midpoint 0 
+ * is represented by 128, and the wave should cross the midpoint at index 0 and 
+ * index 128 for stopping tones without a "pop".
+ */
+extern uint8_t const TONE_WAVEFORM_SINE[256];
+extern uint8_t const TONE_WAVEFORM_TRIANGLE[256];
+extern uint8_t const TONE_WAVEFORM_SQUARE[256];
+
 // Standard DTMF frequencies
 // See: https://en.wikipedia.org/wiki/Dual-tone_multi-frequency_signaling#Keypad
 #define TONE_DTMF_ROW1 (4568) // 697 Hz
@@ -171,6 +215,23 @@ typedef uint16_t tone_t;
  */
 void TONE_Initialize(void);
 
+/**
+ * Calculates the next block of sound samples, picking up any tone changes.
+ * 
+ * Must be called every 1ms from a low priority timer interrupt.
+ */
+void TONE_Timer1MS_Interrupt(void);
+
+/**
+ * Tests if TONE_Timer1MS_Interrupt() must currently be called.
+ * 
+ * It is not required while all voices are silent and no voice settings are
+ * waiting to be picked up.
+ * 
+ * @return True if the 1ms timer interrupt is required.
+ */
+bool TONE_IsTimer1MSInterruptRequired(void);
+
 /**
  * Calculate the tone_t value for a given tone frequency.
  * 
@@ -179,6 +240,37 @@ void TONE_Initialize(void);
  */
 tone_t TONE_CalculateToneFromFrequency(uint16_t freq);
 
+/**
+ * Start playing a tone on a voice.
+ * 
+ * If the voice is already playing a tone, then the voice changes to the new 
+ * tone without restarting its envelope.
+ * 
+ * The outputs of all voices are added together, and saturate if the total is 
+ * out of range. A level of 255 on a single voice uses the full output range.
+ * 
+ * NOTE a tone_t value of zero (a.k.a., TONE_OFF) stops the voice (see 
+ *      TONE_StopVoice()).
+ * 
+ * @param voice - The voice number (less than TONE_VOICE_COUNT).
+ * @param tone - The tone to play.
+ * @param waveform - The waveform lookup table (e.g., TONE_WAVEFORM_SINE).
+ * @param level - The volume level (0-255).
+ * @param attack - Increase of the volume level per 1ms when starting the 
+ *        tone (0 = start immediately at full level).
+ * @param release - Decrease of the volume level per 1ms when stopping the 
+ *        tone (0 = stop at the next midpoint crossing).
+ */
+void TONE_PlayVoice(uint8_t voice, tone_t tone, uint8_t const* waveform, uint8_t level, uint8_t attack, uint8_t release);
+
+/**
+ * Stop the current tone that is playing on a voice, using the release of the
+ * last played tone.
+ * 
+ * @param voice - The voice number (less than TONE_VOICE_COUNT).
+ */
+void TONE_StopVoice(uint8_t voice);
+
 /**
  * Start playing a tone on channel 1.
  * 
@@ -240,6 +332,83 @@ void TONE_StopTone2(void);
  */
 void TONE_Stop(void);
 
+/**
+ * Start playing a dual-tone note on a track, replacing anything that was 
+ * playing and queued on the track.
+ * 
+ * @param track - The track number (less than TONE_TRACK_COUNT).
+ * @param tone1 - The tone to play on channel 1.
+ * @param tone2 - The tone to play on channel 2.
+ * @param duration - Duration of the note (ms). Zero (0) plays the note until
+ *        the track is stopped/restarted.
+ */
+void TONE_StartTrack(uint8_t track, tone_t tone1, tone_t tone2, uint16_t duration);
+
+/**
+ * Queue the dual-tone note that follows the current note of a track.
+ * 
+ * The note starts on the exact sample at which the current note ends. If no
+ * note is queued when the current note ends, then the track stops playing.
+ * 
+ * @param track - The track number (less than TONE_TRACK_COUNT).
+ * @param tone1 - The tone to play on channel 1.
+ * @param tone2 - The tone to play on channel 2.
+ * @param duration - Duration of the note (ms). Zero (0) plays the note until
+ *        the track is stopped/restarted.
+ * @return False if the track is not playing, or already has a queued note
+ *         (the note is not queued).
+ */
+bool TONE_QueueTrackNote(uint8_t track, tone_t tone1, tone_t tone2, uint16_t duration);
+
+/**
+ * Tests if a track has a queued note that has not started playing yet.
+ * 
+ * @param track - The track number (less than TONE_TRACK_COUNT).
+ * @return True if the track has a queued note.
+ */
+bool TONE_IsTrackNoteQueued(uint8_t track);
+
+/**
+ * Tests if a track is playing.
+ * 
+ * @param track - The track number (less than TONE_TRACK_COUNT).
+ * @return True if the track is playing (it has not been stopped, and has not 
+ *         run out of notes).
+ */
+bool TONE_IsTrackPlaying(uint8_t track);
+
+/**
+ * Stop playing a track, and discard its queued note.
+ * 
+ * Does not affect the channels, even if the track is audible.
+ * 
+ * @param track - The track number (less than TONE_TRACK_COUNT).
+ */
+void TONE_StopTrack(uint8_t track);
+
+/**
+ * Select the track that is played on channels 1 and 2.
+ * 
+ * The current note of the selected track is played immediately, and every 
+ * following note of the track is played as it starts. If the track is not 
+ * playing, or stops playing, then both channels are stopped.
+ * 
+ * @param track - The track number (less than TONE_TRACK_COUNT), or 
+ *        TONE_NO_TRACK to stop controlling the channels from any track 
+ *        (the channels are not changed).
+ */
+void TONE_SetAudibleTrack(uint8_t track);
+
+/**
+ * Pause/resume the timing of all tracks.
+ * 
+ * While paused, the current note of each track does not advance towards its 
+ * end.
+ * 
+ * @param isPaused - True to pause.
+ */
+void TONE_SetTracksPaused(bool isPaused);
+
 #ifdef	__cplusplus
 }
 #endif
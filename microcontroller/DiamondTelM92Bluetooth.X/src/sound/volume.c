@@ -125,7 +125,7 @@ void VOLUME_Initialize(void) {
   SPI1_Open(SPI1_DEFAULT);
   module.currentLevel = 0xFF;
   module.currentMode = 0xFF;
-  TIMEOUT_Cancel(&module.deferredStoreTimeout);
+  TIMEOUT_InitializeOnTimerWheel(&module.deferredStoreTimeout);
   VOLUME_Disable();
   VOLUME_SetMode(VOLUME_Mode_SPEAKER);
 }
@@ -136,10 +136,6 @@ void VOLUME_Task(void) {
   }
 }
 
-void VOLUME_Timer10MS_Interrupt(void) {
-  TIMEOUT_Timer_Interrupt(&module.deferredStoreTimeout);
-}
-
 void VOLUME_Enable(void) {
   module.isEnabled = true;
   setPotentiometerLevel(VOLUME_GetLevel(module.currentMode));
@@ -60,13 +60,6 @@ void VOLUME_Initialize(void);
  */
 void VOLUME_Task(void);
 
-/**
- * 10 millisecond timer event handler for the this module.
- * 
- * This must be called from a timer interrupt with a 10 millisecond period.
- */
-void VOLUME_Timer10MS_Interrupt(void);
-
 /**
  * Enable audio output to the handset.
  * 
@@ -6,6 +6,8 @@
  */
 
 #include "eeprom.h"
+#include "../util/profile.h"
+#include "../util/scheduler.h"
 #include <xc.h>
 #include <stdio.h>
 
@@ -17,6 +19,13 @@
  */
 #define EEPROM_WRITE_BUFFER_SIZE (512)
 
+/**
+ * Max number of buffered bytes that EEPROM_Task() will skip in a single 
+ * execution because EEPROM already contains the value, before returning to 
+ * allow other tasks to run.
+ */
+#define EEPROM_MAX_SKIPPED_BYTES_PER_TASK (16)
+
 /**
  * Header structure for an entry in the write buffer.
  * 
@@ -106,11 +115,156 @@ static struct {
   uint8_t repeatingByte;
 } asyncWriteState;
 
+#ifdef PROFILE_ENABLED
+/**
+ * Handler that is called for each byte physically written to EEPROM.
+ */
+static EEPROM_ByteWriteHandler byteWriteHandler;
+
+/**
+ * Counts of bytes handled by async writes, for profiling.
+ */
+static struct {
+  /**
+   * Number of bytes physically written to EEPROM.
+   */
+  uint32_t written;
+  /**
+   * Number of buffered bytes that were not written because EEPROM already
+   * contained the value.
+   */
+  uint32_t skipped;
+  /**
+   * Number of bytes that were trimmed from the start/end of a write before
+   * being buffered, because EEPROM already contained the value.
+   */
+  uint32_t trimmed;
+} asyncByteCounts;
+#endif
+
 /**
  * The size (in bytes) of the header for a single buffered write.
  */
 #define EEPROM_WRITE_BUFFER_HEADER_SIZE (sizeof(write_buffer_header_t))
 
+/**
+ * Gets the buffer index of a byte at an offset from the tail of the 
+ * EEPROM write buffer.
+ * 
+ * @param offset - Offset from the tail of the buffer. 
+ *        Must be less than EEPROM_WRITE_BUFFER_SIZE.
+ * @return The buffer index.
+ */
+static uint16_t getWriteBufferIndex(uint16_t offset) {
+  uint16_t index = writeBufferState.tail + offset;
+  
+  if (index >= EEPROM_WRITE_BUFFER_SIZE) {
+    index -= EEPROM_WRITE_BUFFER_SIZE;
+  }
+  
+  return index;
+}
+
+/**
+ * Reads a buffered write header at an offset from the tail of the EEPROM
+ * write buffer, without removing anything from the buffer.
+ * 
+ * @param offset - Offset from the tail of the buffer.
+ * @param header - Pointer to destination header that will be updated with the
+ *        data from the buffer.
+ */
+static void peekHeaderInWriteBuffer(uint16_t offset, write_buffer_header_t* header) {
+  uint8_t* headerBytes = (uint8_t*)header;
+  
+  for (uint8_t i = 0; i < EEPROM_WRITE_BUFFER_HEADER_SIZE; ++i) {
+    *headerBytes++ = writeBufferState.buffer[getWriteBufferIndex(offset++)];
+  }
+}
+
+/**
+ * Overwrites a buffered write header at an offset from the tail of the EEPROM
+ * write buffer.
+ * 
+ * @param offset - Offset from the tail of the buffer.
+ * @param header - Pointer to header that will be written to the buffer.
+ */
+static void pokeHeaderInWriteBuffer(uint16_t offset, write_buffer_header_t const* header) {
+  uint8_t const* headerBytes = (uint8_t const*)header;
+  
+  for (uint8_t i = 0; i < EEPROM_WRITE_BUFFER_HEADER_SIZE; ++i) {
+    writeBufferState.buffer[getWriteBufferIndex(offset++)] = *headerBytes++;
+  }
+}
+
+/**
+ * Gets the target EEPROM address of a buffered write header.
+ * 
+ * @param header - A buffered write header.
+ * @return The target EEPROM address.
+ */
+static uint16_t getHeaderAddress(write_buffer_header_t const* header) {
+  return ((uint16_t)header->addressHigh << 8) + header->addressLow;
+}
+
+/**
+ * Gets the size of data to write of a buffered write header.
+ * 
+ * @param header - A buffered write header.
+ * @return The size of data to write.
+ */
+static uint16_t getHeaderSize(write_buffer_header_t const* header) {
+  return ((uint16_t)header->sizeHigh << 8) + header->sizeLow;
+}
+
+/**
+ * Sets the target EEPROM address and size of data to write of a buffered 
+ * write header.
+ * 
+ * @param header - A buffered write header.
+ * @param address - The target EEPROM address.
+ * @param size - The size of data to write.
+ */
+static void setHeaderAddressAndSize(write_buffer_header_t* header, uint16_t address, uint16_t size) {
+  header->addressLow = address & 0x00FF;
+  header->addressHigh = (address & 0x0300) >> 8;
+  header->sizeLow = size & 0x00FF;
+  header->sizeHigh = (size & 0x0700) >> 8;
+}
+
+/**
+ * Replaces the superseded bytes of a pending buffered write of bytes with the
+ * overlapping bytes of a new write.
+ * 
+ * @param dataOffset - Offset from the tail of the buffer of the pending write's
+ *        data.
+ * @param pendingAddress - The EEPROM address of the pending write.
+ * @param pendingSize - The number of bytes of the pending write.
+ * @param address - The EEPROM address of the new write.
+ * @param data - The data of the new write.
+ * @param size - The number of bytes of the new write.
+ * @return True if the pending write covers the entire new write.
+ */
+static bool replaceSupersededBytes(
+    uint16_t dataOffset, 
+    uint16_t pendingAddress,
+    uint16_t pendingSize,
+    uint16_t address, 
+    uint8_t const* data, 
+    uint16_t size
+    ) {
+  uint16_t const start = (address > pendingAddress) ? address : pendingAddress;
+  uint16_t const end = ((address + size) < (pendingAddress + pendingSize)) 
+      ? (address + size) 
+      : (pendingAddress + pendingSize);
+  
+  for (uint16_t a = start; a < end; ++a) {
+    writeBufferState.buffer[getWriteBufferIndex(dataOffset + (a - pendingAddress))] = 
+        data[a - address];
+  }
+  
+  return (start == address) && (end == address + size);
+}
+
 /**
  * Read the next byte out of the EEPROM write buffer.
  * 
@@ -160,7 +314,7 @@ static void writeByteToWriteBuffer(uint8_t value) {
  *        data from the buffer.
  */
 static void readHeaderFromWriteBuffer(write_buffer_header_t* header) {
-  uint8_t* headerBytes = header;
+  uint8_t* headerBytes = (uint8_t*)header;
   
   for (uint8_t i = 0; i < EEPROM_WRITE_BUFFER_HEADER_SIZE; ++i) {
     *headerBytes++ = readByteFromWriteBuffer();
@@ -176,11 +330,14 @@ static void readHeaderFromWriteBuffer(write_buffer_header_t* header) {
  * @param header - Pointer to header that will be written to the buffer.
  */
 static void writeHeaderToWriteBuffer(write_buffer_header_t const* header) {
-  uint8_t const* headerBytes = header;
+  uint8_t const* headerBytes = (uint8_t const*)header;
   
   for (uint8_t i = 0; i < EEPROM_WRITE_BUFFER_HEADER_SIZE; ++i) {
     writeByteToWriteBuffer(*headerBytes++);
   }
+  
+  // A new run of bytes is waiting for EEPROM_Task()
+  SCHEDULER_MarkRunnable(SCHEDULER_Task_EEPROM);
 }
 
 /**
@@ -215,6 +372,12 @@ static bool writeByteWithoutWaitingForCompletion(uint16_t address, uint8_t value
   if (NVMDATL == value) {
     return false;
   }  
+
+#ifdef PROFILE_ENABLED
+  if (byteWriteHandler) {
+    byteWriteHandler(address);
+  }
+#endif
   
   // Set the NVMCMD control bits for DFM Byte Write operation
   NVMCON1bits.NVMCMD = 0b011;
@@ -248,13 +411,22 @@ void EEPROM_Initialize(void) {
 }
 
 void EEPROM_Task(void) {
+  // Completion of an EEPROM write does not trigger an interrupt, so keep the 
+  // main loop running (instead of sleeping until the next timer interrupt) 
+  // until all pending writes are done.
+  if (!EEPROM_IsDoneWriting()) {
+    SCHEDULER_MarkRunnable(SCHEDULER_Task_EEPROM);
+  }
+  
   if (NVMCON0bits.GO) {
     // There's already an EEPROM write in progress, so return 
     // and allow other tasks to run while it completes.
     return;
   }
   
-  if (asyncWriteState.writeSize) {
+  uint8_t skippedCount = 0;
+  
+  while (asyncWriteState.writeSize) {
     // There's more bytes to be written to EEPROM.
     // Start writing the next byte and return so that other tasks
     // can run while the byte is being written.
@@ -262,13 +434,29 @@ void EEPROM_Task(void) {
         ? asyncWriteState.repeatingByte 
         : readByteFromWriteBuffer();
 
-    writeByteWithoutWaitingForCompletion(
+    bool const isWriting = writeByteWithoutWaitingForCompletion(
         asyncWriteState.writeAddress++,
         nextByte
         );
     
     --asyncWriteState.writeSize;
-    return;
+
+    if (isWriting) {
+#ifdef PROFILE_ENABLED
+      ++asyncByteCounts.written;
+#endif
+      return;
+    }
+    
+    // EEPROM already contains this byte, so there's no write to wait for.
+    // Continue straight to the next byte (but not forever).
+#ifdef PROFILE_ENABLED
+    ++asyncByteCounts.skipped;
+#endif
+
+    if (++skippedCount == EEPROM_MAX_SKIPPED_BYTES_PER_TASK) {
+      return;
+    }
   }
   
   // At this point, there's no pending EEPROM write, and we haven't started 
@@ -299,7 +487,73 @@ void EEPROM_Task(void) {
   }
 }
 
-uint8_t EEPROM_ReadByte(uint16_t address) {
+/**
+ * Applies pending async writes (in the order they will be written) to data 
+ * that was read from EEPROM.
+ * 
+ * @param address - The EEPROM address that the data was read from.
+ * @param dest - The data that was read from EEPROM.
+ * @param size - The number of bytes of data.
+ */
+static void applyPendingWrites(uint16_t address, uint8_t* dest, uint16_t size) {
+  uint16_t const usedSize = EEPROM_WRITE_BUFFER_SIZE - writeBufferState.remaining;
+  uint16_t offset = 0;
+  uint16_t pendingAddress = 0;
+  uint16_t pendingSize = 0;
+  bool isRepeatingByte = false;
+  uint8_t repeatingByte = 0;
+  
+  if (asyncWriteState.writeSize) {
+    // The current run (with no header in the buffer)
+    pendingAddress = asyncWriteState.writeAddress;
+    pendingSize = asyncWriteState.writeSize;
+    isRepeatingByte = asyncWriteState.isRepeatingByte;
+    repeatingByte = asyncWriteState.repeatingByte;
+  } else if (!usedSize) {
+    return;
+  }
+  
+  while (true) {
+    uint16_t const start = (address > pendingAddress) ? address : pendingAddress;
+    uint16_t const end = ((address + size) < (pendingAddress + pendingSize)) 
+        ? (address + size) 
+        : (pendingAddress + pendingSize);
+    
+    for (uint16_t a = start; a < end; ++a) {
+      dest[a - address] = isRepeatingByte 
+          ? repeatingByte 
+          : writeBufferState.buffer[getWriteBufferIndex(offset + (a - pendingAddress))];
+    }
+    
+    if (!isRepeatingByte) {
+      offset += pendingSize;
+    }
+    
+    if (offset >= usedSize) {
+      return;
+    }
+    
+    write_buffer_header_t header;
+    peekHeaderInWriteBuffer(offset, &header);
+    offset += EEPROM_WRITE_BUFFER_HEADER_SIZE;
+    
+    pendingAddress = getHeaderAddress(&header);
+    pendingSize = getHeaderSize(&header);
+    isRepeatingByte = header.isRepeatingByte;
+    
+    if (isRepeatingByte) {
+      repeatingByte = writeBufferState.buffer[getWriteBufferIndex(offset++)];
+    }
+  }
+}
+
+/**
+ * Read a single byte from EEPROM, NOT including pending async writes.
+ * 
+ * @param address - The EEPROM address to read.
+ * @return The byte value currently in EEPROM.
+ */
+static uint8_t readByteFromEeprom(uint16_t address) {
   // Ensure that EEPROM is ready for a new operation
   while(NVMCON0bits.GO);
   
@@ -315,6 +569,12 @@ uint8_t EEPROM_ReadByte(uint16_t address) {
   return NVMDATL;
 }
 
+uint8_t EEPROM_ReadByte(uint16_t address) {
+  uint8_t value = readByteFromEeprom(address);
+  applyPendingWrites(address, &value, 1);
+  return value;
+}
+
 void* EEPROM_ReadBytes(uint16_t address, void* dest, uint16_t size) {
   if (size == 0) {
     return dest;
@@ -337,11 +597,13 @@ void* EEPROM_ReadBytes(uint16_t address, void* dest, uint16_t size) {
   uint8_t* byteDest = dest;
   
   // Read all bytes out of EEPROM into the destination
-  while (size--) {
+  for (uint16_t i = 0; i < size; ++i) {
     NVMCON0bits.GO = 1;
     *byteDest++ = NVMDATL;
   } 
   
+  applyPendingWrites(address, dest, size);
+  
   return dest;
 }
 
@@ -383,6 +645,11 @@ void EEPROM_WriteBytes(uint16_t address, void const* data, uint16_t size) {
 
     // Check if the existing byte in EEPROM is different than what we want to write
     if (NVMDATL != nextByte) {
+#ifdef PROFILE_ENABLED
+      if (byteWriteHandler) {
+        byteWriteHandler(((uint16_t)NVMADRH << 8) | NVMADRL);
+      }
+#endif
       
       // Set the NVMCMD control bits for DFM Byte Write operation, post increment
       NVMCON1bits.NVMCMD = 0b100;
@@ -454,6 +721,144 @@ bool EEPROM_AsyncWriteBytes(uint16_t address, void const* data, uint8_t size) {
   if (size == 0) {
     return true;
   }
+  
+  uint8_t const* byteData = data;
+  
+  // Combine this write with pending writes:
+  // - Superseded bytes of all overlapping pending writes of bytes are replaced
+  //   with the new values, so they are never written to EEPROM.
+  // - If this write is entirely covered by pending writes of bytes, then 
+  //   nothing more is needed (unless a pending write of a repeating byte also 
+  //   overlaps, because it may need to be overwritten again afterward).
+  // - If this write overlaps or is adjacent to the most recent pending write 
+  //   of bytes, then that write is extended to include this write.
+  uint16_t const usedSize = EEPROM_WRITE_BUFFER_SIZE - writeBufferState.remaining;
+  uint16_t offset = 0;
+  bool isCovered = false;
+  bool isOverlappingRepeatingByte = false;
+  bool isLastWriteOfBytes = false;
+  uint16_t lastHeaderOffset = 0;
+  write_buffer_header_t lastHeader;
+  
+  if (asyncWriteState.writeSize) {
+    // The remaining bytes of the current run (if not a repeating byte) are 
+    // at the tail of the buffer, with no header.
+    if (asyncWriteState.isRepeatingByte) {
+      isOverlappingRepeatingByte = 
+          (address < asyncWriteState.writeAddress + asyncWriteState.writeSize) &&
+          (asyncWriteState.writeAddress < address + size);
+    } else {
+      isCovered = replaceSupersededBytes(
+          0, 
+          asyncWriteState.writeAddress, 
+          asyncWriteState.writeSize, 
+          address, 
+          byteData, 
+          size
+          );
+      offset = asyncWriteState.writeSize;
+    }
+  }
+  
+  while (offset < usedSize) {
+    peekHeaderInWriteBuffer(offset, &lastHeader);
+    
+    uint16_t const pendingAddress = getHeaderAddress(&lastHeader);
+    uint16_t const pendingSize = getHeaderSize(&lastHeader);
+    
+    lastHeaderOffset = offset;
+    offset += EEPROM_WRITE_BUFFER_HEADER_SIZE;
+    isLastWriteOfBytes = !lastHeader.isRepeatingByte;
+    
+    if (lastHeader.isRepeatingByte) {
+      isOverlappingRepeatingByte |= 
+          (address < pendingAddress + pendingSize) &&
+          (pendingAddress < address + size);
+      offset += 1;
+    } else {
+      isCovered |= replaceSupersededBytes(
+          offset,
+          pendingAddress,
+          pendingSize,
+          address, 
+          byteData, 
+          size
+          );
+      offset += pendingSize;
+    }
+  }
+  
+  if (isCovered && !isOverlappingRepeatingByte) {
+    return true;
+  }
+  
+  // Trim bytes from the start and end of this write that EEPROM already 
+  // contains. Only if no pending write of a repeating byte overlaps, because 
+  // it could change those bytes before this write. Pending writes of bytes 
+  // that overlap were already updated with the new values above.
+  // Also only if no EEPROM write is in progress, to avoid waiting for it.
+  if (!isOverlappingRepeatingByte && !NVMCON0bits.GO) {
+#ifdef PROFILE_ENABLED
+    uint8_t const originalSize = size;
+#endif
+    
+    while (size && (readByteFromEeprom(address) == *byteData)) {
+      ++address;
+      ++byteData;
+      --size;
+    }
+    
+    while (size && (readByteFromEeprom(address + size - 1) == byteData[size - 1])) {
+      --size;
+    }
+    
+#ifdef PROFILE_ENABLED
+    asyncByteCounts.trimmed += originalSize - size;
+#endif
+
+    if (size == 0) {
+      return true;
+    }
+  }
+  
+  if (isLastWriteOfBytes) {
+    uint16_t const lastAddress = getHeaderAddress(&lastHeader);
+    uint16_t const lastSize = getHeaderSize(&lastHeader);
+    
+    if ((address <= lastAddress + lastSize) && (lastAddress <= address + size)) {
+      uint16_t const start = (address < lastAddress) ? address : lastAddress;
+      uint16_t const end = ((address + size) > (lastAddress + lastSize)) 
+          ? (address + size) 
+          : (lastAddress + lastSize);
+      uint16_t const growth = (end - start) - lastSize;
+      
+      if (growth <= writeBufferState.remaining) {
+        uint16_t const dataOffset = lastHeaderOffset + EEPROM_WRITE_BUFFER_HEADER_SIZE;
+        uint16_t const shift = lastAddress - start;
+        
+        // Shift the existing data to make room for new data before it.
+        if (shift) {
+          for (uint16_t i = lastSize; i > 0; --i) {
+            writeBufferState.buffer[getWriteBufferIndex(dataOffset + shift + i - 1)] = 
+                writeBufferState.buffer[getWriteBufferIndex(dataOffset + i - 1)];
+          }
+        }
+        
+        for (uint16_t i = 0; i < size; ++i) {
+          writeBufferState.buffer[getWriteBufferIndex(dataOffset + (address - start) + i)] = 
+              byteData[i];
+        }
+        
+        setHeaderAddressAndSize(&lastHeader, start, end - start);
+        pokeHeaderInWriteBuffer(lastHeaderOffset, &lastHeader);
+        
+        writeBufferState.remaining -= growth;
+        writeBufferState.head = getWriteBufferIndex(usedSize + growth);
+        
+        return true;
+      }
+    }
+  }
 
   // Confirm that there's enough room in the buffer for this data and a header
   if (size + EEPROM_WRITE_BUFFER_HEADER_SIZE > writeBufferState.remaining) {
@@ -470,11 +875,6 @@ bool EEPROM_AsyncWriteBytes(uint16_t address, void const* data, uint8_t size) {
   header.isRepeatingByte = false;
   writeHeaderToWriteBuffer(&header);
   
-  /**
-   * Pointer to the next byte of data to be written to the buffer.
-   */
-  uint8_t const* byteData = data;
-  
   // Write all data bytes to the buffer.
   while (size--) {
     writeByteToWriteBuffer(*byteData++);
@@ -483,6 +883,21 @@ bool EEPROM_AsyncWriteBytes(uint16_t address, void const* data, uint8_t size) {
   return true;
 }
 
+#ifdef PROFILE_ENABLED
+void EEPROM_SetByteWriteHandler(EEPROM_ByteWriteHandler handler) {
+  byteWriteHandler = handler;
+}
+
+void EEPROM_DumpAsyncByteCounts(void) {
+  printf(
+      "[PROFILE] EEPROM async bytes: %lu written, %lu skipped, %lu trimmed\r\n",
+      asyncByteCounts.written,
+      asyncByteCounts.skipped,
+      asyncByteCounts.trimmed
+      );
+}
+#endif
+
 void EEPROM_AsyncErase(void) {
   // Reinitialize this EEPROM module to reset/clear all previously pending 
   // buffered writes.
@@ -10,6 +10,7 @@
 
 #include <stdint.h>
 #include <stdbool.h>
+#include "../util/profile.h"
 
 #ifdef	__cplusplus
 extern "C" {
@@ -35,6 +36,9 @@ void EEPROM_Task(void);
 /**
  * Read a single byte from EEPROM.
  * 
+ * The result includes pending async writes that have not been written to
+ * EEPROM yet.
+ * 
  * @param address - The EEPROM address to read.
  * @return The byte value from EEPROM.
  */
@@ -43,6 +47,9 @@ uint8_t EEPROM_ReadByte(uint16_t address);
 /**
  * Read multiple bytes of data from EEPROM.
  * 
+ * The result includes pending async writes that have not been written to
+ * EEPROM yet.
+ * 
  * @param address - The EEPROM address to start reading from.
  * @param dest - A pointer to the destination buffer where data will be written.
  * @param size - The number of bytes to read from EEPROM.
@@ -103,6 +110,17 @@ bool EEPROM_AsyncWriteByteN(uint16_t address, uint8_t value, uint16_t n);
  * NOTE: This async write will be queued up behind any previously pending
  *       async writes.
  * 
+ * NOTE: This write is combined with pending async writes where possible:
+ *       pending values for the same addresses are replaced (never written), 
+ *       and a write that overlaps or is adjacent to the most recent pending 
+ *       write extends that write instead of using another buffer entry.
+ *       Bytes are always written in ascending address order within a write.
+ * 
+ * NOTE: Bytes at the start and end of the data that already match EEPROM are
+ *       trimmed before buffering, and each remaining byte is compared to 
+ *       EEPROM again before it is written, so unchanged bytes are never
+ *       written.
+ * 
  * @param address - The EEPROM address to start writing at.
  * @param data - A pointer to the data to write to EEPROM.
  * @param size - The number of bytes of data to write to EEPROM.
@@ -119,6 +137,31 @@ bool EEPROM_AsyncWriteBytes(uint16_t address, void const* data, uint8_t size);
  */
 void EEPROM_AsyncErase(void);
 
+#ifdef PROFILE_ENABLED
+/**
+ * Handler for each byte physically written to EEPROM.
+ * 
+ * @param address - The EEPROM address that was written.
+ */
+typedef void (*EEPROM_ByteWriteHandler)(uint16_t address);
+
+/**
+ * Sets a handler to be called for each byte physically written to EEPROM
+ * (not including writes that were skipped because the EEPROM already 
+ * contained the value). For profiling the wear of EEPROM.
+ * 
+ * @param handler - The handler function.
+ */
+void EEPROM_SetByteWriteHandler(EEPROM_ByteWriteHandler handler);
+
+/**
+ * Prints the number of bytes that async writes have physically written to 
+ * EEPROM, skipped (EEPROM already contained the value), and trimmed 
+ * (before buffering) since power-on to STDIO.
+ */
+void EEPROM_DumpAsyncByteCounts(void);
+#endif
+
 /**
  * Test if all current/pending EEPROM writes are complete.
  * @return True if all current/pending EEPROM writes are complete.
@@ -0,0 +1,1317 @@
+/**
+ * @file
+ * @author Jeff Lau
+ *
+ * See header file for module description.
+ *
+ * Layout of the reserved flash area (offsets relative to
+ * PHONEBOOK_FLASH_ADDRESS):
+ * - The first page contains the header (header_t).
+ * - Entry records start at the second page. A record never crosses a page
+ *   boundary; if a record does not fit in the rest of a page, then the rest
+ *   of the page is left erased (0xFF) and the record starts at the next page.
+ * - The sorted name index follows the record area: the 16-bit record offsets
+ *   of all entries, sorted by name (case insensitive), then by record offset.
+ * - The phone number index is at the end of the area: a hash table of
+ *   NUMBER_INDEX_SLOT_COUNT 16-bit record offsets (0xFFFF = empty slot), keyed
+ *   by the compressed phone number, with linear probing (see 
+ *   getNumberIndexSlot()). While the sorted name index is being built, this 
+ *   area is used as scratch space (see sortNames()), so the phone number index
+ *   is built afterwards.
+ *
+ * Each record is:
+ * - A header byte: upper nibble is the compressed phone number length (bytes),
+ *   lower nibble is the name length minus 1. Never 0xFF.
+ * - The compressed phone number (see compressPhoneNumber()).
+ * - The name (not null-terminated).
+ */
+
+#include "phonebook.h"
+#include "../bluetooth/atcmd.h"
+#include "../util/string.h"
+#include "../util/scheduler.h"
+#include <xc.h>
+#include <string.h>
+#include <stddef.h>
+#include <ctype.h>
+#include <stdio.h>
+
+/**
+ * Size (in bytes) of a page of program flash memory (the unit of erasing).
+ */
+#define PAGE_SIZE (256)
+
+/**
+ * Number of slots in the phone number index. 
+ * 
+ * Keeps the index at most 2/3 full with PHONEBOOK_MAX_ENTRIES, so that probe 
+ * sequences stay short. Must be at least PHONEBOOK_MAX_ENTRIES, because the
+ * index area is also the scratch space for sorting the name index.
+ */
+#define NUMBER_INDEX_SLOT_COUNT (3072)
+
+/**
+ * Value of an empty phone number index slot (erased flash).
+ */
+#define NUMBER_INDEX_EMPTY_SLOT (0xFFFF)
+
+/**
+ * Offset of the phone number index.
+ */
+#define NUMBER_INDEX_OFFSET (PHONEBOOK_FLASH_SIZE - NUMBER_INDEX_SLOT_COUNT * 2)
+
+/**
+ * Offset of the sorted name index.
+ */
+#define NAME_INDEX_OFFSET (NUMBER_INDEX_OFFSET - PHONEBOOK_MAX_ENTRIES * 2)
+
+/**
+ * Offset of the scratch space for sorting the name index.
+ */
+#define SORT_SCRATCH_OFFSET (NUMBER_INDEX_OFFSET)
+
+/**
+ * Offset of the first record.
+ */
+#define RECORDS_OFFSET (PAGE_SIZE)
+
+/**
+ * End offset of the record area.
+ */
+#define RECORDS_END_OFFSET (NAME_INDEX_OFFSET)
+
+/**
+ * Identifies a valid header (and the version of the layout).
+ */
+#define MAGIC (0x5044)
+
+/**
+ * Value of header_t.indexedFlag after both indexes are complete.
+ * (The erased value is 0xFFFF, so the flag can be written once without
+ * erasing the header).
+ */
+#define INDEXED_FLAG (0x0000)
+
+#define MAX_COMPRESSED_NUMBER_LENGTH (MAX_EXTENDED_PHONE_NUMBER_LENGTH >> 1)
+
+#define MAX_RECORD_SIZE (1 + MAX_COMPRESSED_NUMBER_LENGTH + PHONEBOOK_MAX_NAME_LENGTH)
+
+/**
+ * Number of entries requested from the phone in each "+CPBR" command (also
+ * the number of entries that can be staged in RAM).
+ */
+#define SYNC_CHUNK_SIZE (8)
+
+/**
+ * Max number of index entries written per execution of PHONEBOOK_Task() while
+ * building the indexes.
+ */
+#define INDEX_RECORDS_PER_TASK (16)
+
+/**
+ * Number of records that are sorted in RAM by the first pass of sorting the
+ * name index (the length of the sorted runs that are then merged).
+ */
+#define SORT_RUN_SIZE (16)
+
+/**
+ * Header at the start of the reserved flash area.
+ */
+typedef struct {
+  uint16_t magic;
+  uint16_t count;
+  uint16_t indexedFlag;
+} header_t;
+
+/**
+ * An entry received from the phone, staged in RAM until PHONEBOOK_Task()
+ * stores it.
+ */
+typedef struct {
+  uint16_t phoneIndex;
+  uint8_t record[MAX_RECORD_SIZE];
+} stagedEntry_t;
+
+typedef enum SyncState {
+  SyncState_IDLE,
+  /**
+   * Waiting for the response to "+CPBR=?" (the range of phonebook indexes).
+   */
+  SyncState_QUERY_RANGE,
+  /**
+   * Preparing flash and requesting the next chunk of entries.
+   */
+  SyncState_REQUEST_CHUNK,
+  /**
+   * Waiting for the response to a chunk request (entries are staged in RAM).
+   */
+  SyncState_RECEIVE_CHUNK,
+  /**
+   * Comparing/writing the staged entries of a chunk (one per task pass).
+   */
+  SyncState_STORE_CHUNK,
+  SyncState_FINISH,
+  SyncState_SORT_NAMES,
+  SyncState_ERASE_NUMBER_INDEX,
+  SyncState_BUILD_NUMBER_INDEX
+} SyncState;
+
+/**
+ * Module state.
+ */
+static struct {
+  /**
+   * Number of stored entries (0 if the stored phonebook is not valid).
+   */
+  uint16_t count;
+  bool isIndexed;
+
+  struct {
+    SyncState state;
+    /**
+     * True if the stored phonebook is being rewritten. Otherwise, received
+     * entries are compared against the stored phonebook.
+     */
+    bool isWriting;
+    bool isHeaderErased;
+    /**
+     * True if the rest of the current chunk is ignored, because the sync
+     * restarts at an earlier phone index.
+     */
+    bool isRestartPending;
+    /**
+     * True if the record area is full.
+     */
+    bool isFull;
+    uint16_t storedCount;
+    uint16_t nextPhoneIndex;
+    uint16_t lastPhoneIndex;
+    uint16_t chunkLastPhoneIndex;
+    /**
+     * Number of entries compared/written so far.
+     */
+    uint16_t count;
+    /**
+     * End offset of the last compared/written record.
+     */
+    uint16_t offset;
+    /**
+     * Phone index of the first record in the page of the last record.
+     */
+    uint16_t pageStartPhoneIndex;
+    /**
+     * Number of records before the first record in the page of the last
+     * record.
+     */
+    uint16_t pageStartCount;
+    /**
+     * End offset of flash pages that have been erased for writing.
+     */
+    uint16_t erasedEndOffset;
+    /**
+     * True if the last byte written (at offset - 1) is waiting to be written
+     * together with the next byte as a full word.
+     */
+    bool hasPendingByte;
+    uint8_t pendingByte;
+    /**
+     * Entries of the current chunk, received from the phone but not yet
+     * compared/written.
+     */
+    stagedEntry_t stagedEntries[SYNC_CHUNK_SIZE];
+    uint8_t stagedCount;
+    /**
+     * Index of the next staged entry to compare/write.
+     */
+    uint8_t stagedPosition;
+  } sync;
+
+  struct {
+    /**
+     * End offset of erased flash pages of the index (or sort pass 
+     * destination) being written.
+     */
+    uint16_t erasedEndOffset;
+    /**
+     * Offset of the next record to add to the index.
+     */
+    uint16_t scanOffset;
+    /**
+     * Number of records remaining to be added to the index.
+     */
+    uint16_t scanRemaining;
+    /**
+     * Length of the sorted runs in the source of the current sort pass (0 for
+     * the first pass, which reads the records).
+     */
+    uint16_t runSize;
+    uint16_t srcOffset;
+    uint16_t dstOffset;
+    /**
+     * Number of entries written to the destination of the current sort pass.
+     */
+    uint16_t position;
+    /**
+     * Source positions of the two runs being merged.
+     */
+    uint16_t left;
+    uint16_t leftEnd;
+    uint16_t right;
+    uint16_t rightEnd;
+  } index;
+} module;
+
+static void setFlashAddress(uint16_t offset) {
+  uint32_t const address = PHONEBOOK_FLASH_ADDRESS + offset;
+
+  NVMADRU = (uint8_t)(address >> 16);
+  NVMADRH = (uint8_t)(address >> 8);
+  NVMADRL = (uint8_t)address;
+}
+
+/**
+ * Reads bytes from the reserved flash area.
+ *
+ * @param offset - Offset within the reserved flash area.
+ * @param dest - Destination buffer.
+ * @param size - Number of bytes to read.
+ */
+static void readFlash(uint16_t offset, void* dest, uint8_t size) {
+  uint8_t* byteDest = dest;
+
+  // Ensure that NVM (EEPROM) is ready for a new operation
+  while(NVMCON0bits.GO);
+
+  setFlashAddress(offset & ~1);
+
+  // Set the NVMCMD control bits for PFM Word Read operation, post increment
+  NVMCON1bits.NVMCMD = 0b001;
+
+  if (offset & 1) {
+    NVMCON0bits.GO = 1;
+    *byteDest++ = NVMDATH;
+    --size;
+  }
+
+  while (size) {
+    NVMCON0bits.GO = 1;
+    *byteDest++ = NVMDATL;
+
+    if (!--size) {
+      break;
+    }
+
+    *byteDest++ = NVMDATH;
+    --size;
+  }
+
+  NVMCON1bits.NVMCMD = 0b000;
+}
+
+static uint8_t readFlashByte(uint16_t offset) {
+  uint8_t result;
+  readFlash(offset, &result, 1);
+  return result;
+}
+
+static uint16_t readFlashWord(uint16_t offset) {
+  uint16_t result;
+  readFlash(offset, &result, 2);
+  return result;
+}
+
+/**
+ * Performs the unlock sequence and starts a PFM write/erase operation that
+ * has already been set up.
+ *
+ * The CPU stalls until the operation is complete.
+ */
+static void startFlashOperation(void) {
+  // Disable all interrupts
+  uint8_t GIEBitValue = INTCON0bits.GIE;
+  INTCON0bits.GIE = 0;
+
+  // Perform the unlock sequence
+  NVMLOCK = 0x55;
+  NVMLOCK = 0xAA;
+
+  NVMCON0bits.GO = 1;
+
+  // Restore all interrupts
+  INTCON0bits.GIE = GIEBitValue;
+
+  while (NVMCON0bits.GO);
+
+  // Set the NVMCMD control bits for read to help prevent accidental writes
+  NVMCON1bits.NVMCMD = 0b000;
+}
+
+/**
+ * Erases a page of the reserved flash area.
+ *
+ * @param offset - Offset of the start of the page.
+ */
+static void eraseFlashPage(uint16_t offset) {
+  // Ensure that NVM (EEPROM) is ready for a new operation
+  while(NVMCON0bits.GO);
+
+  setFlashAddress(offset);
+
+  // Set the NVMCMD control bits for PFM Page Erase operation
+  NVMCON1bits.NVMCMD = 0b110;
+
+  startFlashOperation();
+}
+
+/**
+ * Writes a word to an erased location of the reserved flash area.
+ *
+ * @param offset - An even offset within the reserved flash area.
+ * @param word - The value to write.
+ */
+static void writeFlashWord(uint16_t offset, uint16_t word) {
+  // Ensure that NVM (EEPROM) is ready for a new operation
+  while(NVMCON0bits.GO);
+
+  setFlashAddress(offset);
+  NVMDATL = (uint8_t)word;
+  NVMDATH = (uint8_t)(word >> 8);
+
+  // Set the NVMCMD control bits for PFM Word Write operation
+  NVMCON1bits.NVMCMD = 0b011;
+
+  startFlashOperation();
+}
+
+static uint8_t getRecordNumberLength(uint8_t recordHeader) {
+  return recordHeader >> 4;
+}
+
+static uint8_t getRecordNameLength(uint8_t recordHeader) {
+  return (recordHeader & 0x0F) + 1;
+}
+
+static uint8_t getRecordSize(uint8_t recordHeader) {
+  return 1 + getRecordNumberLength(recordHeader) + getRecordNameLength(recordHeader);
+}
+
+/**
+ * Gets the offset where a record is placed.
+ *
+ * @param offset - End offset of the previous record.
+ * @param size - Size of the record.
+ * @return The start offset of the record (start of the next page if the
+ *         record does not fit in the rest of the current page).
+ */
+static uint16_t getRecordPlacement(uint16_t offset, uint8_t size) {
+  if (((offset & (PAGE_SIZE - 1)) + size) > PAGE_SIZE) {
+    offset = (offset | (PAGE_SIZE - 1)) + 1;
+  }
+
+  return offset;
+}
+
+static uint16_t getNextRecordOffset(uint16_t offset) {
+  offset += getRecordSize(readFlashByte(offset));
+
+  if ((offset & (PAGE_SIZE - 1)) && (readFlashByte(offset) == 0xFF)) {
+    // Rest of the page is unused
+    offset = (offset | (PAGE_SIZE - 1)) + 1;
+  }
+
+  return offset;
+}
+
+/**
+ * Reads the null-terminated name of a record.
+ */
+static char* readRecordName(uint16_t offset, char* dest) {
+  uint8_t const recordHeader = readFlashByte(offset);
+  uint8_t const nameLength = getRecordNameLength(recordHeader);
+
+  readFlash(offset + 1 + getRecordNumberLength(recordHeader), dest, nameLength);
+  dest[nameLength] = 0;
+
+  return dest;
+}
+
+/**
+ * Compares records by name (case insensitive), then by offset, so that no
+ * two records are equal.
+ */
+static int compareRecords(uint16_t offset, uint16_t otherOffset) {
+  char name[PHONEBOOK_MAX_NAME_LENGTH + 1];
+  char otherName[PHONEBOOK_MAX_NAME_LENGTH + 1];
+  int const result = strnicmp(
+      readRecordName(offset, name), 
+      readRecordName(otherOffset, otherName), 
+      PHONEBOOK_MAX_NAME_LENGTH
+      );
+
+  if (result) {
+    return result;
+  }
+
+  return (offset < otherOffset) ? -1 : (offset > otherOffset);
+}
+
+/**
+ * Copies only the dialable characters of a phone number, then simplifies it
+ * (see simplifyPhoneNumber()).
+ *
+ * @param dest - Destination buffer of MAX_EXTENDED_PHONE_NUMBER_LENGTH + 1
+ *        chars.
+ * @param number - A phone number as received from the phone.
+ */
+static void normalizePhoneNumber(char* dest, char const* number) {
+  char dialable[MAX_EXTENDED_PHONE_NUMBER_LENGTH + 1];
+  uint8_t length = 0;
+
+  while (*number && (length < MAX_EXTENDED_PHONE_NUMBER_LENGTH)) {
+    char const c = *number++;
+
+    if (isdigit(c) || (c == '*') || (c == '#') || ((c == '+') && !length)) {
+      dialable[length++] = c;
+    }
+  }
+
+  dialable[length] = 0;
+  simplifyPhoneNumber(dest, dialable);
+}
+
+/**
+ * Compresses a normalized phone number and gets the length of the used part.
+ *
+ * @param dest - Destination buffer of MAX_COMPRESSED_NUMBER_LENGTH bytes.
+ * @param number - A normalized phone number.
+ * @return The number of bytes used by the compressed phone number.
+ */
+static uint8_t compressNumber(uint8_t* dest, char const* number) {
+  compressPhoneNumber(dest, number, MAX_EXTENDED_PHONE_NUMBER_LENGTH);
+
+  uint8_t length = 0;
+
+  while ((length < MAX_COMPRESSED_NUMBER_LENGTH) && (dest[length] != 0xFF)) {
+    ++length;
+  }
+
+  return length;
+}
+
+/**
+ * Gets the phone number index slot where probing for a phone number starts.
+ *
+ * @param compressedNumber - A compressed phone number.
+ * @param length - Number of bytes used by the compressed phone number.
+ * @return The slot number.
+ */
+static uint16_t getNumberIndexSlot(uint8_t const* compressedNumber, uint8_t length) {
+  uint16_t hash = 5381;
+
+  while (length--) {
+    hash = (uint16_t)((hash << 5) + hash) ^ *compressedNumber++;
+  }
+
+  return hash % NUMBER_INDEX_SLOT_COUNT;
+}
+
+static uint16_t getNumberIndexSlotOffset(uint16_t slot) {
+  return NUMBER_INDEX_OFFSET + (slot << 1);
+}
+
+static uint16_t getNextNumberIndexSlot(uint16_t slot) {
+  return (slot == NUMBER_INDEX_SLOT_COUNT - 1) ? 0 : (slot + 1);
+}
+
+/**
+ * Gets the offset of the record at a position of the sorted name index.
+ *
+ * @return The record offset, or 0 if the position is not valid.
+ */
+static uint16_t getRecordOffsetAtPosition(uint16_t position) {
+  if (!module.isIndexed || (position >= module.count)) {
+    return 0;
+  }
+
+  return readFlashWord(NAME_INDEX_OFFSET + (position << 1));
+}
+
+static void loadHeader(void) {
+  header_t header;
+  readFlash(0, &header, sizeof(header));
+
+  if ((header.magic == MAGIC) && (header.count <= PHONEBOOK_MAX_ENTRIES)) {
+    module.count = header.count;
+    module.isIndexed = (header.indexedFlag == INDEXED_FLAG);
+  } else {
+    module.count = 0;
+    module.isIndexed = false;
+  }
+}
+
+/**
+ * Writes the next byte of record data while writing the stored phonebook.
+ *
+ * Bytes are written in pairs, as full words.
+ */
+static void writeSyncByte(uint8_t value) {
+  if (module.sync.hasPendingByte) {
+    writeFlashWord(module.sync.offset - 1, module.sync.pendingByte | ((uint16_t)value << 8));
+    module.sync.hasPendingByte = false;
+  } else {
+    module.sync.pendingByte = value;
+    module.sync.hasPendingByte = true;
+  }
+
+  ++module.sync.offset;
+}
+
+static void flushSyncByte(void) {
+  if (module.sync.hasPendingByte) {
+    writeFlashWord(module.sync.offset - 1, module.sync.pendingByte | 0xFF00);
+    module.sync.hasPendingByte = false;
+  }
+}
+
+/**
+ * Erases the next page for writing the stored phonebook, if needed to write
+ * up to an offset.
+ *
+ * @return True if a page was erased.
+ */
+static bool eraseNextSyncPage(uint16_t endOffset) {
+  if (endOffset > RECORDS_END_OFFSET) {
+    endOffset = RECORDS_END_OFFSET;
+  }
+
+  if (module.sync.erasedEndOffset >= endOffset) {
+    return false;
+  }
+
+  eraseFlashPage(module.sync.erasedEndOffset);
+  module.sync.erasedEndOffset += PAGE_SIZE;
+
+  return true;
+}
+
+/**
+ * Switches from comparing to writing the stored phonebook.
+ *
+ * @param offset - Start offset of the page to start writing at.
+ */
+static void startWritingSync(uint16_t offset) {
+  module.sync.isWriting = true;
+  module.sync.isHeaderErased = false;
+  module.sync.offset = offset;
+  module.sync.erasedEndOffset = offset;
+  module.sync.hasPendingByte = false;
+  // The stored phonebook is not valid while it is being rewritten
+  module.count = 0;
+  module.isIndexed = false;
+}
+
+/**
+ * Compresses an entry received from the phone into a record, and stages it
+ * for storing by PHONEBOOK_Task().
+ *
+ * Only works in RAM, because this is called from an AT command response 
+ * handler, which may run while flash must not be erased/written (see 
+ * PHONEBOOK_Task()).
+ */
+static void stageSyncEntry(uint16_t phoneIndex, char const* number, char* name) {
+  if (module.sync.stagedCount == SYNC_CHUNK_SIZE) {
+    return;
+  }
+
+  stagedEntry_t* const entry = &module.sync.stagedEntries[module.sync.stagedCount];
+  uint8_t* const record = entry->record;
+  char normalizedNumber[MAX_EXTENDED_PHONE_NUMBER_LENGTH + 1];
+
+  normalizePhoneNumber(normalizedNumber, number);
+  utf2ascii(name);
+
+  uint8_t const numberLength = compressNumber(record + 1, normalizedNumber);
+  uint8_t nameLength = (uint8_t)strlen(name);
+
+  if (!numberLength || !nameLength) {
+    return;
+  }
+
+  if (nameLength > PHONEBOOK_MAX_NAME_LENGTH) {
+    nameLength = PHONEBOOK_MAX_NAME_LENGTH;
+  }
+
+  record[0] = (uint8_t)(numberLength << 4) | (nameLength - 1);
+  memcpy(record + 1 + numberLength, name, nameLength);
+  entry->phoneIndex = phoneIndex;
+  ++module.sync.stagedCount;
+}
+
+/**
+ * Compares a staged entry against the stored phonebook, or writes it.
+ *
+ * Performs at most one page erase per call. 
+ *
+ * @return False if a page was erased instead of storing the entry (call 
+ *         again on a later task pass).
+ */
+static bool storeSyncEntry(stagedEntry_t const* entry) {
+  uint8_t const* const record = entry->record;
+  uint8_t const size = getRecordSize(record[0]);
+  uint16_t const offset = getRecordPlacement(module.sync.offset, size);
+
+  if (
+      (module.sync.count == PHONEBOOK_MAX_ENTRIES) ||
+      ((offset + size) > RECORDS_END_OFFSET)
+      ) {
+    printf("[PHONEBOOK] Full at %u entries\r\n", module.sync.count);
+    module.sync.isFull = true;
+    return true;
+  }
+
+  if ((offset & (PAGE_SIZE - 1)) == 0) {
+    module.sync.pageStartPhoneIndex = entry->phoneIndex;
+    module.sync.pageStartCount = module.sync.count;
+  }
+
+  if (!module.sync.isWriting) {
+    if (module.sync.count < module.sync.storedCount) {
+      uint8_t storedRecord[MAX_RECORD_SIZE];
+      readFlash(offset, storedRecord, size);
+
+      if (!memcmp(record, storedRecord, size)) {
+        module.sync.offset = offset + size;
+        ++module.sync.count;
+        return true;
+      }
+    }
+
+    // The phonebook has changed. The page of this record must be erased
+    // before it can be rewritten, so restart from the first entry of the page.
+    printf("[PHONEBOOK] Changed at entry %u\r\n", module.sync.count);
+    startWritingSync(offset & ~(PAGE_SIZE - 1));
+    module.sync.count = module.sync.pageStartCount;
+    module.sync.nextPhoneIndex = module.sync.pageStartPhoneIndex;
+    module.sync.isRestartPending = true;
+    return true;
+  }
+
+  // Pages should already be erased in advance by requestSyncChunk()
+  if (eraseNextSyncPage(offset + size)) {
+    return false;
+  }
+
+  if (offset != module.sync.offset) {
+    flushSyncByte();
+    module.sync.offset = offset;
+  }
+
+  for (uint8_t i = 0; i < size; ++i) {
+    writeSyncByte(record[i]);
+  }
+
+  ++module.sync.count;
+  return true;
+}
+
+/**
+ * Parses a phonebook index (or the first number of a range like "(1-500)").
+ */
+static uint16_t parsePhoneIndex(char const* text, char const** end) {
+  uint16_t result = 0;
+
+  if (*text == '(') {
+    ++text;
+  }
+
+  while (isdigit(*text)) {
+    result = result * 10 + (uint16_t)(*text++ - '0');
+  }
+
+  if (end) {
+    *end = text;
+  }
+
+  return result;
+}
+
+/**
+ * Formats a phonebook index without padding.
+ * 
+ * @return A pointer to the null terminator after the formatted index.
+ */
+static char* appendPhoneIndex(char* dest, uint16_t index) {
+  uint8_t length = 1;
+  
+  for (uint16_t i = index; i >= 10; i /= 10) {
+    ++length;
+  }
+  
+  uint2str(dest, index, length, 0);
+  
+  return dest + length;
+}
+
+static void handleRangeAtResponse(ATCMD_Response response, char const* result, uint8_t resultLength) {
+  if (module.sync.state != SyncState_QUERY_RANGE) {
+    return;
+  }
+
+  if (response == ATCMD_Response_RESULT) {
+    // +CPBR: (<first>-<last>),<nlength>,<tlength>
+    char field[16];
+    char const* end;
+    parseNextCsvField(field, sizeof(field), result + 7, result + resultLength);
+    module.sync.nextPhoneIndex = parsePhoneIndex(field, &end);
+    module.sync.lastPhoneIndex = (*end == '-') ? parsePhoneIndex(end + 1, NULL) : module.sync.nextPhoneIndex;
+  } else if ((response == ATCMD_Response_OK) && module.sync.lastPhoneIndex) {
+    printf("[PHONEBOOK] Syncing indexes %u-%u\r\n", module.sync.nextPhoneIndex, module.sync.lastPhoneIndex);
+    module.sync.state = SyncState_REQUEST_CHUNK;
+    SCHEDULER_MarkRunnable(SCHEDULER_Task_PHONEBOOK);
+  } else {
+    printf("[PHONEBOOK] Phonebook not supported\r\n");
+    module.sync.state = SyncState_IDLE;
+  }
+}
+
+static void handleChunkAtResponse(ATCMD_Response response, char const* result, uint8_t resultLength) {
+  if (module.sync.state != SyncState_RECEIVE_CHUNK) {
+    return;
+  }
+
+  if (response == ATCMD_Response_RESULT) {
+    // +CPBR: <index>,<number>,<type>,<text>
+    char const* const resultEnd = result + resultLength;
+    char number[MAX_EXTENDED_PHONE_NUMBER_LENGTH + 1];
+    char name[48];
+
+    char const* nextField = parseNextCsvField(name, sizeof(name), result + 7, resultEnd);
+    uint16_t const phoneIndex = parsePhoneIndex(name, NULL);
+    nextField = parseNextCsvField(number, sizeof(number), nextField, resultEnd);
+    // Skip type
+    nextField = skipCsvFields(nextField, resultEnd, 1);
+    // text
+    parseNextCsvField(name, sizeof(name), nextField, resultEnd);
+
+    stageSyncEntry(phoneIndex, number, name);
+  } else if ((response == ATCMD_Response_OK) || (response == ATCMD_Response_ERROR)) {
+    // NOTE: Some phones respond with an error for a range with no entries.
+    module.sync.stagedPosition = 0;
+    module.sync.state = SyncState_STORE_CHUNK;
+    SCHEDULER_MarkRunnable(SCHEDULER_Task_PHONEBOOK);
+  } else {
+    PHONEBOOK_CancelSync();
+  }
+}
+
+/**
+ * Prepares flash for the next chunk of entries (one page operation per call),
+ * then requests the chunk.
+ * 
+ * @return False if the request could not be sent, because there is no room 
+ *         for another AT command.
+ */
+static bool requestSyncChunk(void) {
+  if (module.sync.isFull || (module.sync.nextPhoneIndex > module.sync.lastPhoneIndex)) {
+    module.sync.state = SyncState_FINISH;
+    return true;
+  }
+
+  if (module.sync.isWriting) {
+    if (!module.sync.isHeaderErased) {
+      eraseFlashPage(0);
+      module.sync.isHeaderErased = true;
+      return true;
+    }
+
+    if (eraseNextSyncPage(module.sync.offset + SYNC_CHUNK_SIZE * MAX_RECORD_SIZE + PAGE_SIZE)) {
+      return true;
+    }
+  }
+
+  uint16_t lastPhoneIndex = module.sync.nextPhoneIndex + (SYNC_CHUNK_SIZE - 1);
+
+  if (lastPhoneIndex > module.sync.lastPhoneIndex) {
+    lastPhoneIndex = module.sync.lastPhoneIndex;
+  }
+
+  char command[sizeof("+CPBR=65535,65535")] = "+CPBR=";
+  char* const separator = appendPhoneIndex(command + 6, module.sync.nextPhoneIndex);
+  *separator = ',';
+  appendPhoneIndex(separator + 1, lastPhoneIndex);
+
+  if (!ATCMD_Send(command, handleChunkAtResponse)) {
+    return false;
+  }
+
+  module.sync.chunkLastPhoneIndex = lastPhoneIndex;
+  module.sync.stagedCount = 0;
+  module.sync.state = SyncState_RECEIVE_CHUNK;
+  return true;
+}
+
+/**
+ * Stores the next staged entry of the current chunk, or requests the next 
+ * chunk after all staged entries are stored.
+ */
+static void storeSyncChunk(void) {
+  if (
+      !module.sync.isRestartPending && 
+      !module.sync.isFull && 
+      (module.sync.stagedPosition < module.sync.stagedCount)
+      ) {
+    if (storeSyncEntry(&module.sync.stagedEntries[module.sync.stagedPosition])) {
+      ++module.sync.stagedPosition;
+    }
+
+    return;
+  }
+
+  if (module.sync.isRestartPending) {
+    module.sync.isRestartPending = false;
+  } else {
+    module.sync.nextPhoneIndex = module.sync.chunkLastPhoneIndex + 1;
+  }
+
+  module.sync.stagedCount = 0;
+  module.sync.state = SyncState_REQUEST_CHUNK;
+}
+
+static void startIndexing(void);
+
+static void finishSync(void) {
+  if (!module.sync.isWriting) {
+    if (module.sync.count == module.sync.storedCount) {
+      printf("[PHONEBOOK] Unchanged (%u entries)\r\n", module.sync.count);
+      
+      if (module.isIndexed) {
+        module.sync.state = SyncState_IDLE;
+      } else {
+        startIndexing();
+      }
+      
+      return;
+    }
+
+    // Entries were removed from the end. Records are still valid; only the
+    // header must be rewritten.
+    startWritingSync(module.sync.offset);
+  }
+
+  flushSyncByte();
+
+  if (!module.sync.isHeaderErased) {
+    eraseFlashPage(0);
+  }
+
+  writeFlashWord(offsetof(header_t, magic), MAGIC);
+  writeFlashWord(offsetof(header_t, count), module.sync.count);
+  module.count = module.sync.count;
+  module.isIndexed = false;
+
+  printf("[PHONEBOOK] Stored %u entries\r\n", module.count);
+  startIndexing();
+}
+
+/**
+ * Starts a pass of sorting the name index, which writes all entries to the
+ * (erased) destination area in runs that are twice as long as the runs of the
+ * source area (or SORT_RUN_SIZE for the first pass).
+ */
+static void startSortPass(void) {
+  module.index.position = 0;
+  module.index.rightEnd = 0;
+  module.index.erasedEndOffset = module.index.dstOffset;
+}
+
+/**
+ * Starts building the sorted name index, followed by the phone number index.
+ */
+static void startIndexing(void) {
+  if (!module.count) {
+    module.sync.state = SyncState_IDLE;
+    return;
+  }
+
+  // Passes alternate between the name index area and the scratch area. The 
+  // first pass writes to whichever area makes the last pass write to the name
+  // index area.
+  bool isScratchFirst = false;
+
+  for (uint16_t runSize = SORT_RUN_SIZE; runSize < module.count; runSize <<= 1) {
+    isScratchFirst = !isScratchFirst;
+  }
+
+  module.index.scanOffset = RECORDS_OFFSET;
+  module.index.scanRemaining = module.count;
+  module.index.runSize = 0;
+  module.index.dstOffset = isScratchFirst ? SORT_SCRATCH_OFFSET : NAME_INDEX_OFFSET;
+  startSortPass();
+  module.sync.state = SyncState_SORT_NAMES;
+}
+
+/**
+ * Sorts the next SORT_RUN_SIZE records in RAM, and writes them as the next 
+ * run of the first sort pass.
+ */
+static void sortNextRun(void) {
+  uint16_t offsets[SORT_RUN_SIZE];
+  uint8_t size = 0;
+
+  while (module.index.scanRemaining && (size < SORT_RUN_SIZE)) {
+    uint16_t const offset = module.index.scanOffset;
+    uint8_t i = size;
+
+    if (--module.index.scanRemaining) {
+      module.index.scanOffset = getNextRecordOffset(offset);
+    }
+
+    while (i && (compareRecords(offset, offsets[i - 1]) < 0)) {
+      offsets[i] = offsets[i - 1];
+      --i;
+    }
+
+    offsets[i] = offset;
+    ++size;
+  }
+
+  for (uint8_t i = 0; i < size; ++i) {
+    writeFlashWord(module.index.dstOffset + (module.index.position++ << 1), offsets[i]);
+  }
+}
+
+static uint16_t readSortSource(uint16_t position) {
+  return readFlashWord(module.index.srcOffset + (position << 1));
+}
+
+/**
+ * Merges the next entries of pairs of sorted runs of the source into the
+ * destination of the current sort pass.
+ */
+static void mergeNextEntries(void) {
+  for (uint8_t i = 0; (i < INDEX_RECORDS_PER_TASK) && (module.index.position < module.count); ++i) {
+    if (module.index.position == module.index.rightEnd) {
+      // Start merging the next pair of runs
+      module.index.left = module.index.position;
+      module.index.leftEnd = module.index.left + module.index.runSize;
+      
+      if (module.index.leftEnd > module.count) {
+        module.index.leftEnd = module.count;
+      }
+      
+      module.index.right = module.index.leftEnd;
+      module.index.rightEnd = module.index.right + module.index.runSize;
+      
+      if (module.index.rightEnd > module.count) {
+        module.index.rightEnd = module.count;
+      }
+    }
+
+    uint16_t offset;
+
+    if (module.index.left == module.index.leftEnd) {
+      offset = readSortSource(module.index.right++);
+    } else if (module.index.right == module.index.rightEnd) {
+      offset = readSortSource(module.index.left++);
+    } else {
+      uint16_t const leftOffset = readSortSource(module.index.left);
+      uint16_t const rightOffset = readSortSource(module.index.right);
+
+      if (compareRecords(rightOffset, leftOffset) < 0) {
+        offset = rightOffset;
+        ++module.index.right;
+      } else {
+        offset = leftOffset;
+        ++module.index.left;
+      }
+    }
+
+    writeFlashWord(module.index.dstOffset + (module.index.position++ << 1), offset);
+  }
+}
+
+/**
+ * Builds the sorted name index with a merge sort in flash: the first pass 
+ * sorts runs of SORT_RUN_SIZE records in RAM, then each pass merges pairs of 
+ * runs into runs twice as long, alternating between the name index area and 
+ * the scratch area. Each pass reads/writes every entry once, so the whole
+ * sort is O(N log N).
+ *
+ * Performs one page erase, or writes up to INDEX_RECORDS_PER_TASK entries 
+ * (SORT_RUN_SIZE in the first pass), per call.
+ */
+static void sortNames(void) {
+  if (module.index.erasedEndOffset < module.index.dstOffset + (module.count << 1)) {
+    eraseFlashPage(module.index.erasedEndOffset);
+    module.index.erasedEndOffset += PAGE_SIZE;
+    return;
+  }
+
+  if (module.index.runSize) {
+    mergeNextEntries();
+  } else {
+    sortNextRun();
+  }
+
+  if (module.index.position < module.count) {
+    return;
+  }
+
+  // End of a pass
+  module.index.runSize = module.index.runSize ? (module.index.runSize << 1) : SORT_RUN_SIZE;
+
+  if (module.index.runSize < module.count) {
+    module.index.srcOffset = module.index.dstOffset;
+    module.index.dstOffset = (module.index.dstOffset == NAME_INDEX_OFFSET) ? SORT_SCRATCH_OFFSET : NAME_INDEX_OFFSET;
+    startSortPass();
+    return;
+  }
+
+  // The phone number index area was used as scratch space, so it is erased
+  // (again) before building the phone number index
+  module.index.erasedEndOffset = NUMBER_INDEX_OFFSET;
+  module.sync.state = SyncState_ERASE_NUMBER_INDEX;
+}
+
+/**
+ * Adds a record to the phone number index, in the first empty slot of its
+ * probe sequence.
+ */
+static void addToNumberIndex(uint16_t offset) {
+  uint8_t compressedNumber[MAX_COMPRESSED_NUMBER_LENGTH];
+  uint8_t const numberLength = getRecordNumberLength(readFlashByte(offset));
+
+  readFlash(offset + 1, compressedNumber, numberLength);
+
+  uint16_t slot = getNumberIndexSlot(compressedNumber, numberLength);
+
+  // There are always empty slots (see NUMBER_INDEX_SLOT_COUNT)
+  while (readFlashWord(getNumberIndexSlotOffset(slot)) != NUMBER_INDEX_EMPTY_SLOT) {
+    slot = getNextNumberIndexSlot(slot);
+  }
+
+  writeFlashWord(getNumberIndexSlotOffset(slot), offset);
+}
+
+static void buildNumberIndex(void) {
+  for (uint8_t i = 0; module.index.scanRemaining && (i < INDEX_RECORDS_PER_TASK); ++i) {
+    addToNumberIndex(module.index.scanOffset);
+
+    if (--module.index.scanRemaining) {
+      module.index.scanOffset = getNextRecordOffset(module.index.scanOffset);
+    }
+  }
+
+  if (module.index.scanRemaining) {
+    return;
+  }
+
+  writeFlashWord(offsetof(header_t, indexedFlag), INDEXED_FLAG);
+  module.isIndexed = true;
+  module.sync.state = SyncState_IDLE;
+  printf("[PHONEBOOK] Index complete\r\n");
+}
+
+void PHONEBOOK_Initialize(void) {
+  module.sync.state = SyncState_IDLE;
+  loadHeader();
+}
+
+void PHONEBOOK_Task(void) {
+  switch (module.sync.state) {
+    case SyncState_REQUEST_CHUNK:
+      if (!requestSyncChunk()) {
+        // Retried when there is room for another AT command (see 
+        // ATCMD_BT_ResponseHandler())
+        return;
+      }
+      break;
+
+    case SyncState_STORE_CHUNK:
+      storeSyncChunk();
+      break;
+
+    case SyncState_FINISH:
+      finishSync();
+      break;
+
+    case SyncState_SORT_NAMES:
+      sortNames();
+      break;
+
+    case SyncState_ERASE_NUMBER_INDEX:
+      if (module.index.erasedEndOffset < PHONEBOOK_FLASH_SIZE) {
+        eraseFlashPage(module.index.erasedEndOffset);
+        module.index.erasedEndOffset += PAGE_SIZE;
+      } else {
+        module.index.scanOffset = RECORDS_OFFSET;
+        module.index.scanRemaining = module.count;
+        module.sync.state = SyncState_BUILD_NUMBER_INDEX;
+      }
+      break;
+
+    case SyncState_BUILD_NUMBER_INDEX:
+      buildNumberIndex();
+      break;
+  }
+  
+  switch (module.sync.state) {
+    case SyncState_IDLE:
+    case SyncState_QUERY_RANGE:
+    case SyncState_RECEIVE_CHUNK:
+      // Marked runnable by the AT command response (see 
+      // handleRangeAtResponse() and handleChunkAtResponse())
+      break;
+      
+    default:
+      // Storing the sync and building the indexes is background work that 
+      // does not wait for any events, so keep the task runnable until it is 
+      // done.
+      SCHEDULER_MarkRunnable(SCHEDULER_Task_PHONEBOOK);
+      break;
+  }
+}
+
+void PHONEBOOK_StartSync(void) {
+  if (module.sync.state != SyncState_IDLE) {
+    return;
+  }
+
+  // Start comparing against the stored phonebook (if valid)
+  loadHeader();
+  module.sync.storedCount = module.count;
+  module.sync.isWriting = false;
+  module.sync.isRestartPending = false;
+  module.sync.isFull = false;
+  module.sync.count = 0;
+  module.sync.offset = RECORDS_OFFSET;
+  module.sync.pageStartPhoneIndex = 0;
+  module.sync.pageStartCount = 0;
+  module.sync.nextPhoneIndex = 0;
+  module.sync.lastPhoneIndex = 0;
+  module.sync.stagedCount = 0;
+
+  if (!module.sync.storedCount) {
+    startWritingSync(RECORDS_OFFSET);
+  }
+
+  if (ATCMD_Send("+CPBR=?", handleRangeAtResponse)) {
+    module.sync.state = SyncState_QUERY_RANGE;
+  }
+}
+
+void PHONEBOOK_CancelSync(void) {
+  if (module.sync.state == SyncState_IDLE) {
+    return;
+  }
+
+  printf("[PHONEBOOK] Sync cancelled\r\n");
+  module.sync.state = SyncState_IDLE;
+
+  // If the stored phonebook was not rewritten, then it's still valid
+  // (possibly not yet indexed).
+  loadHeader();
+}
+
+bool PHONEBOOK_IsSyncing(void) {
+  return module.sync.state != SyncState_IDLE;
+}
+
+uint16_t PHONEBOOK_GetCount(void) {
+  return module.count;
+}
+
+bool PHONEBOOK_IsIndexed(void) {
+  return module.isIndexed;
+}
+
+uint16_t PHONEBOOK_GetFirstPositionForLetter(char letter) {
+  if (!module.isIndexed || !module.count) {
+    return PHONEBOOK_NO_POSITION;
+  }
+
+  letter = (char)tolower(letter);
+
+  // Binary search for the first name that starts with the letter or later
+  uint16_t position = 0;
+  uint16_t endPosition = module.count;
+
+  while (position < endPosition) {
+    uint16_t const middle = position + ((endPosition - position) >> 1);
+    uint16_t const offset = getRecordOffsetAtPosition(middle);
+    uint8_t const recordHeader = readFlashByte(offset);
+    char const firstChar = (char)readFlashByte(offset + 1 + getRecordNumberLength(recordHeader));
+
+    if (tolower(firstChar) < letter) {
+      position = middle + 1;
+    } else {
+      endPosition = middle;
+    }
+  }
+
+  return (position == module.count) ? 0 : position;
+}
+
+char* PHONEBOOK_GetName(uint16_t position, char* dest) {
+  uint16_t const offset = getRecordOffsetAtPosition(position);
+
+  if (!offset) {
+    dest[0] = 0;
+    return dest;
+  }
+
+  return readRecordName(offset, dest);
+}
+
+char* PHONEBOOK_GetNumber(uint16_t position, char* dest) {
+  uint16_t const offset = getRecordOffsetAtPosition(position);
+
+  if (!offset) {
+    dest[0] = 0;
+    return dest;
+  }
+
+  uint8_t compressedNumber[MAX_COMPRESSED_NUMBER_LENGTH];
+  uint8_t const numberLength = getRecordNumberLength(readFlashByte(offset));
+
+  memset(compressedNumber, 0xFF, MAX_COMPRESSED_NUMBER_LENGTH);
+  readFlash(offset + 1, compressedNumber, numberLength);
+  uncompressPhoneNumber(dest, compressedNumber, MAX_COMPRESSED_NUMBER_LENGTH);
+
+  return dest;
+}
+
+bool PHONEBOOK_FindName(char const* number, char* dest) {
+  if (!module.isIndexed || !module.count) {
+    return false;
+  }
+
+  char normalizedNumber[MAX_EXTENDED_PHONE_NUMBER_LENGTH + 1];
+  uint8_t compressedNumber[MAX_COMPRESSED_NUMBER_LENGTH];
+
+  normalizePhoneNumber(normalizedNumber, number);
+  uint8_t const numberLength = compressNumber(compressedNumber, normalizedNumber);
+
+  if (!numberLength) {
+    return false;
+  }
+
+  uint16_t slot = getNumberIndexSlot(compressedNumber, numberLength);
+  uint16_t offset;
+
+  while ((offset = readFlashWord(getNumberIndexSlotOffset(slot))) != NUMBER_INDEX_EMPTY_SLOT) {
+    if (getRecordNumberLength(readFlashByte(offset)) == numberLength) {
+      uint8_t storedNumber[MAX_COMPRESSED_NUMBER_LENGTH];
+      readFlash(offset + 1, storedNumber, numberLength);
+
+      if (!memcmp(storedNumber, compressedNumber, numberLength)) {
+        readRecordName(offset, dest);
+        return true;
+      }
+    }
+
+    slot = getNextNumberIndexSlot(slot);
+  }
+
+  return false;
+}
@@ -0,0 +1,186 @@
+/**
+ * @file
+ * @author Jeff Lau
+ *
+ * A copy of the paired phone's phonebook, stored in a reserved area of
+ * program flash memory (PFM).
+ *
+ * The phonebook is synced from the phone with "+CPBR" AT commands, in small
+ * chunks of entries. Each received entry is compressed (name, plus phone
+ * number at 2 digits per byte) and staged in RAM, then PHONEBOOK_Task() 
+ * streams the staged entries of each chunk into flash before requesting the
+ * next chunk, so the full phonebook is never held in RAM. Entries without a 
+ * name or phone number are ignored.
+ *
+ * While entries received from the phone match what is already stored, nothing
+ * is written to flash, so repeated syncs of an unchanged phonebook do not wear
+ * out flash.
+ *
+ * After a sync that changed the phonebook, two indexes are built in the 
+ * background (also in flash):
+ * - A sorted name index, built with a merge sort in flash (O(N log N)). 
+ *   Entries are accessed by their position in the sorted index (e.g., for
+ *   alpha scan).
+ * - An index of entries by phone number (a hash table), built in a single 
+ *   pass over the entries. Caller ID lookup by phone number uses it, so it 
+ *   does not slow down as the phonebook grows.
+ *
+ * Entries are only accessible (by position or phone number) after both 
+ * indexes are complete (see PHONEBOOK_IsIndexed()).
+ *
+ * NOTE: The reserved flash area must be excluded from the linker's ROM ranges
+ *       (see PHONEBOOK_FLASH_ADDRESS).
+ *
+ * WARNING: The CPU stalls while flash is erased/written. Flash is only 
+ *          erased/written by PHONEBOOK_Task() (never by AT command response 
+ *          handlers), one page erase per call, so the sync is paused while 
+ *          PHONEBOOK_Task() is not called (e.g., during a call).
+ */
+
+#ifndef PHONEBOOK_H
+#define	PHONEBOOK_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "../constants.h"
+
+#ifdef	__cplusplus
+extern "C" {
+#endif
+
+/**
+ * Start address of the reserved area of program flash memory.
+ *
+ * Must match the excluded range of the "code-model-rom" linker option
+ * (in nbproject/configurations.xml).
+ */
+#define PHONEBOOK_FLASH_ADDRESS (0x14000UL)
+
+/**
+ * Size (in bytes) of the reserved area of program flash memory.
+ */
+#define PHONEBOOK_FLASH_SIZE (0xC000U)
+
+/**
+ * Max number of phonebook entries (limited by the size of the indexes). Fewer
+ * entries may fit if names/numbers are long.
+ */
+#define PHONEBOOK_MAX_ENTRIES (2048)
+
+/**
+ * Max length of a phonebook entry name (longer names are truncated).
+ */
+#define PHONEBOOK_MAX_NAME_LENGTH (16)
+
+/**
+ * Position value that identifies no phonebook entry.
+ */
+#define PHONEBOOK_NO_POSITION (0xFFFF)
+
+/**
+ * Initializes this module.
+ *
+ * Loads the state of the stored phonebook from flash.
+ */
+void PHONEBOOK_Initialize(void);
+
+/**
+ * The main task implementation of this module.
+ *
+ * This must be called from the main task loop of the application, but should
+ * only be called while there is no call in progress (see module description).
+ * All flash erasing/writing is done here.
+ */
+void PHONEBOOK_Task(void);
+
+/**
+ * Starts syncing the phonebook from the phone.
+ *
+ * Does nothing if a sync is already in progress.
+ */
+void PHONEBOOK_StartSync(void);
+
+/**
+ * Cancels a sync in progress (e.g., when the phone disconnects).
+ *
+ * If the stored phonebook was already being changed, then it is left empty
+ * until the next complete sync.
+ */
+void PHONEBOOK_CancelSync(void);
+
+/**
+ * Tests if the phonebook is currently being synced (including building the
+ * indexes).
+ *
+ * @return True if the phonebook is being synced.
+ */
+bool PHONEBOOK_IsSyncing(void);
+
+/**
+ * Gets the number of stored phonebook entries.
+ *
+ * @return The number of phonebook entries.
+ */
+uint16_t PHONEBOOK_GetCount(void);
+
+/**
+ * Tests if the indexes are complete, so that entries can be accessed by 
+ * position, and found by PHONEBOOK_FindName().
+ *
+ * @return True if the indexes are complete.
+ */
+bool PHONEBOOK_IsIndexed(void);
+
+/**
+ * Gets the sorted position of the first phonebook entry with a name that
+ * starts with the specified letter (case insensitive), or a subsequent
+ * character if there is no name starting with the specified letter.
+ *
+ * If there is no such entry, then the position of the first entry is returned.
+ *
+ * @param letter - A letter of the alphabet.
+ * @return The sorted position, or PHONEBOOK_NO_POSITION if there are no
+ *         accessible entries.
+ */
+uint16_t PHONEBOOK_GetFirstPositionForLetter(char letter);
+
+/**
+ * Gets the name of a phonebook entry.
+ *
+ * @param position - Sorted position of the entry.
+ * @param dest - Destination buffer of at least PHONEBOOK_MAX_NAME_LENGTH + 1
+ *        chars.
+ * @return A pointer to the destination buffer. Contains an empty string if
+ *         the position is not valid.
+ */
+char* PHONEBOOK_GetName(uint16_t position, char* dest);
+
+/**
+ * Gets the phone number of a phonebook entry.
+ *
+ * @param position - Sorted position of the entry.
+ * @param dest - Destination buffer of at least
+ *        MAX_EXTENDED_PHONE_NUMBER_LENGTH + 1 chars.
+ * @return A pointer to the destination buffer. Contains an empty string if
+ *         the position is not valid.
+ */
+char* PHONEBOOK_GetNumber(uint16_t position, char* dest);
+
+/**
+ * Finds the name of the phonebook entry for a phone number (for caller ID).
+ *
+ * @param number - A phone number (simplified via simplifyPhoneNumber() before
+ *        comparing).
+ * @param dest - Destination buffer of at least PHONEBOOK_MAX_NAME_LENGTH + 1
+ *        chars.
+ * @return True if found (name copied to `dest`). Always false while the
+ *         indexes are not complete.
+ */
+bool PHONEBOOK_FindName(char const* number, char* dest);
+
+#ifdef	__cplusplus
+}
+#endif
+
+#endif	/* PHONEBOOK_H */
+
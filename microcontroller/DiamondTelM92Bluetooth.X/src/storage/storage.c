@@ -13,10 +13,21 @@
 #include <stddef.h>
 #include <stdlib.h>
 #include <ctype.h>
+#include <stdio.h>
 
 #define MARKER (0b10101100)
 #define VERSION (25)
 
+/**
+ * Number of slots in the call time journal.
+ */
+#define CALL_TIME_JOURNAL_SIZE (2)
+
+/**
+ * Number of slots in the settings journal.
+ */
+#define SETTINGS_JOURNAL_SIZE (2)
+
 typedef struct {
   uint8_t number[MAX_EXTENDED_PHONE_NUMBER_LENGTH >> 1];
   char name[STORAGE_MAX_DIRECTORY_NAME_LENGTH];
@@ -42,6 +53,35 @@ typedef struct {
   uint8_t totalCallSeconds;
 } call_time_t;
 
+/**
+ * A slot of the call time journal.
+ * 
+ * Call time is written to EEPROM after every call, so it is written to the
+ * next slot of a small journal (rotating through all slots) rather than
+ * always to the same bytes, to spread the wear of EEPROM.
+ * 
+ * The valid slot with the most recent sequence number is the current value.
+ * The check byte detects slots that were never written, or where writing was
+ * interrupted.
+ */
+typedef struct {
+  call_time_t callTime;
+  uint8_t sequence;
+  uint8_t check;
+} call_time_journal_slot_t;
+
+/**
+ * A slot of the settings journal.
+ * 
+ * See call_time_journal_slot_t.
+ */
+typedef struct {
+  uint8_t volumeLevels[VOLUME_MODE_COUNT];
+  uint8_t directoryIndex;
+  uint8_t sequence;
+  uint8_t check;
+} settings_journal_slot_t;
+
 typedef struct {
   uint8_t marker;
   uint8_t version;
@@ -61,175 +101,734 @@ typedef struct {
   uint8_t speedDial[3][MAX_EXTENDED_PHONE_NUMBER_LENGTH >> 1];
   uint8_t securityCode[SECURITY_CODE_LENGTH >> 1];
   uint8_t callerIdMode;
-  uint8_t reserved[44];
+  // NOTE: The fixed `callTime`, `volumeLevels`, and `directoryIndex` fields
+  //       above are only used if their journal has no valid slot (e.g., 
+  //       storage that was formatted before journals were added).
+  call_time_journal_slot_t callTimeJournal[CALL_TIME_JOURNAL_SIZE];
+  settings_journal_slot_t settingsJournal[SETTINGS_JOURNAL_SIZE];
+  uint8_t reserved[6];
+} settings_t;
+
+/**
+ * Layout of all storage in EEPROM.
+ * 
+ * Only the settings are always loaded into memory. Directory entries and 
+ * credit card numbers are loaded on demand into a small cache 
+ * (see getCachedEntry()).
+ */
+typedef struct {
+  settings_t settings;
   directory_entry_t directory[STORAGE_DIRECTORY_SIZE];
   uint8_t creditCardNumbers[STORAGE_CREDIT_CARD_COUNT][CREDIT_CARD_NUMBER_LENGTH >> 1];
 } storage_t;
 
-static storage_t storage;
+static settings_t settings;
+
+/**
+ * State of a journal.
+ */
+typedef struct {
+  /**
+   * Index of the slot with the current value.
+   */
+  uint8_t slotIndex;
+  /**
+   * Sequence number of the slot with the current value.
+   */
+  uint8_t sequence;
+} journal_state_t;
+
+static journal_state_t callTimeJournalState;
+static journal_state_t settingsJournalState;
+
+#ifdef PROFILE_ENABLED
+/**
+ * A range of storage that is counted separately for profiling EEPROM wear.
+ */
+typedef struct {
+  char const* label;
+  /**
+   * Address of the start of this range. The range ends at the start of the 
+   * next range.
+   */
+  uint16_t address;
+} write_count_range_t;
+
+static write_count_range_t const writeCountRanges[] = {
+  { "header", 0 },
+  { "lcdViewAngle", offsetof(settings_t, lcdViewAngle) },
+  { "volumeLevels", offsetof(settings_t, volumeLevels) },
+  { "directoryIndex", offsetof(settings_t, directoryIndex) },
+  { "ringtone", offsetof(settings_t, ringtone) },
+  { "callTime", offsetof(settings_t, callTime) },
+  { "toggles", offsetof(settings_t, toggles) },
+  { "other settings", offsetof(settings_t, activeOwnNumberIndex) },
+  { "callTimeJournal", offsetof(settings_t, callTimeJournal) },
+  { "settingsJournal", offsetof(settings_t, settingsJournal) },
+  { "reserved", offsetof(settings_t, reserved) },
+  { "directory", offsetof(storage_t, directory) },
+  { "creditCardNumbers", offsetof(storage_t, creditCardNumbers) }
+};
+
+#define WRITE_COUNT_RANGE_COUNT (sizeof(writeCountRanges) / sizeof(writeCountRanges[0]))
+
+/**
+ * Number of bytes physically written to EEPROM for each range in 
+ * `writeCountRanges`.
+ */
+static uint32_t writeCounts[WRITE_COUNT_RANGE_COUNT];
+
+static void handleEepromByteWrite(uint16_t address) {
+  uint8_t i = WRITE_COUNT_RANGE_COUNT - 1;
+  
+  while (address < writeCountRanges[i].address) {
+    --i;
+  }
+  
+  ++writeCounts[i];
+}
+#endif
+
+/**
+ * Number of directory entries/credit card numbers that are cached in memory.
+ */
+#define ENTRY_CACHE_SIZE (4)
+
+/**
+ * Cache key flag for a credit card number (combined with the credit card 
+ * index). Keys without this flag are directory indexes.
+ */
+#define ENTRY_CACHE_KEY_CREDIT_CARD (0x80)
+
+/**
+ * Cache key of an unused cache entry.
+ */
+#define ENTRY_CACHE_KEY_NONE (0xFF)
+
+/**
+ * A directory entry or credit card number that is cached in memory.
+ */
+typedef struct {
+  /**
+   * Identifies the cached data (directory index, or credit card index 
+   * combined with ENTRY_CACHE_KEY_CREDIT_CARD).
+   */
+  uint8_t key;
+  union {
+    directory_entry_t directoryEntry;
+    uint8_t creditCardNumber[CREDIT_CARD_NUMBER_LENGTH >> 1];
+  } data;
+} cache_entry_t;
+
+/**
+ * Cache of recently used directory entries and credit card numbers.
+ */
+static struct {
+  cache_entry_t entries[ENTRY_CACHE_SIZE];
+  /**
+   * Indexes of `entries`, from most recently used to least recently used.
+   */
+  uint8_t order[ENTRY_CACHE_SIZE];
+} entryCache;
+
+/**
+ * Bit flags of directory entries that are not empty (bit N = index N).
+ */
+static uint32_t populatedDirectoryEntries;
+
+/**
+ * Bit flags of directory entries that have a name (bit N = index N).
+ */
+static uint32_t namedDirectoryEntries;
+
+/**
+ * Number of letters in the alphabet.
+ */
+#define ALPHABET_SIZE (26)
 
 static uint8_t sortedNameIndexes[STORAGE_DIRECTORY_SIZE];
 static uint8_t sortedNameSize;
 
+/**
+ * Position of each directory index within `sortedNameIndexes`, or 0xFF if the
+ * directory entry has no name.
+ */
+static uint8_t sortedNamePositions[STORAGE_DIRECTORY_SIZE];
+
+/**
+ * For each letter of the alphabet, the position within `sortedNameIndexes` of 
+ * the first name that starts with that letter or any subsequent character
+ * (case insensitive). Equal to `sortedNameSize` if there is no such name.
+ */
+static uint8_t letterSortedNamePositions[ALPHABET_SIZE];
+
+/**
+ * True if the sorted names are up to date with the directory.
+ * 
+ * The sorted names are only built when first needed, because all names must 
+ * be read from EEPROM. After that, they are updated incrementally for each 
+ * changed directory entry.
+ */
+static bool isSortedNameIndexesValid;
+
+/**
+ * Number of trailing digits of phone numbers that are compared to match 
+ * a caller's phone number to a directory entry.
+ */
+#define CALLER_ID_MATCH_LENGTH (SHORT_PHONE_NUMBER_LENGTH)
+
+/**
+ * Caller ID key value that identifies no key.
+ */
+#define CALLER_ID_KEY_NONE (0)
+
+/**
+ * Caller ID key of each named directory entry (see getCallerIdKey()), or 
+ * CALLER_ID_KEY_NONE if the directory entry has no name.
+ */
+static uint16_t callerIdKeys[STORAGE_DIRECTORY_SIZE];
+
+/**
+ * True if the caller ID keys are up to date with the directory.
+ * 
+ * Like the sorted names, the caller ID keys are only built when first needed,
+ * then updated incrementally for each changed directory entry.
+ */
+static bool isCallerIdKeysValid;
+
+/**
+ * Gets the EEPROM address of a directory entry.
+ * 
+ * @param index - A valid directory index.
+ * @return The EEPROM address.
+ */
+static uint16_t getDirectoryEntryAddress(uint8_t index) {
+  return offsetof(storage_t, directory) + sizeof(directory_entry_t) * index;
+}
+
+/**
+ * Gets the EEPROM address of a credit card number.
+ * 
+ * @param index - A valid credit card index.
+ * @return The EEPROM address.
+ */
+static uint16_t getCreditCardNumberAddress(uint8_t index) {
+  return offsetof(storage_t, creditCardNumbers) + (CREDIT_CARD_NUMBER_LENGTH >> 1) * index;
+}
+
+static void initializeEntryCache(void) {
+  for (uint8_t i = 0; i < ENTRY_CACHE_SIZE; ++i) {
+    entryCache.entries[i].key = ENTRY_CACHE_KEY_NONE;
+    entryCache.order[i] = i;
+  }
+}
+
+/**
+ * Gets a cached directory entry or credit card number, loading it from 
+ * EEPROM (replacing the least recently used cache entry) if it is not 
+ * already cached.
+ * 
+ * @param key - Identifies the directory entry or credit card number.
+ * @return Pointer to the cache entry.
+ */
+static cache_entry_t* getCachedEntry(uint8_t key) {
+  uint8_t orderIndex = 0;
+  
+  while (
+      (orderIndex < ENTRY_CACHE_SIZE - 1) && 
+      (entryCache.entries[entryCache.order[orderIndex]].key != key)
+      ) {
+    ++orderIndex;
+  }
+  
+  uint8_t const entryIndex = entryCache.order[orderIndex];
+  cache_entry_t* const entry = &entryCache.entries[entryIndex];
+
+  if (entry->key != key) {
+    // Not cached, so replace the least recently used entry.
+    entry->key = key;
+    
+    if (key & ENTRY_CACHE_KEY_CREDIT_CARD) {
+      EEPROM_ReadBytes(
+          getCreditCardNumberAddress(key & ~ENTRY_CACHE_KEY_CREDIT_CARD),
+          entry->data.creditCardNumber,
+          CREDIT_CARD_NUMBER_LENGTH >> 1
+          );
+    } else {
+      EEPROM_ReadBytes(
+          getDirectoryEntryAddress(key),
+          &entry->data.directoryEntry,
+          sizeof(directory_entry_t)
+          );
+    }
+  }
+  
+  // Move to most recently used
+  memmove(entryCache.order + 1, entryCache.order, orderIndex);
+  entryCache.order[0] = entryIndex;
+  
+  return entry;
+}
+
+/**
+ * Reads a directory name from EEPROM (not cached).
+ * 
+ * @param index - A valid directory index.
+ * @param dest - Destination buffer of STORAGE_MAX_DIRECTORY_NAME_LENGTH chars.
+ *        NOT null-terminated if the name is of max length.
+ */
+static void readDirectoryName(uint8_t index, char* dest) {
+  EEPROM_ReadBytes(
+      getDirectoryEntryAddress(index) + offsetof(directory_entry_t, name),
+      dest,
+      STORAGE_MAX_DIRECTORY_NAME_LENGTH
+      );
+}
+
+/**
+ * Initializes the populated/named flags of all directory entries.
+ */
+static void initializeDirectoryEntryFlags(void) {
+  populatedDirectoryEntries = 0;
+  namedDirectoryEntries = 0;
+  
+  for (uint8_t i = 0; i < STORAGE_DIRECTORY_SIZE; ++i) {
+    uint16_t const address = getDirectoryEntryAddress(i);
+    
+    if (EEPROM_ReadByte(address + offsetof(directory_entry_t, number)) != 0xFF) {
+      populatedDirectoryEntries |= (uint32_t)1 << i;
+      
+      if (EEPROM_ReadByte(address + offsetof(directory_entry_t, name))) {
+        namedDirectoryEntries |= (uint32_t)1 << i;
+      }
+    }
+  }
+}
+
+/**
+ * Compares a name to the name of a directory entry, for sorting.
+ * 
+ * Names are compared case insensitive. Equal names are sorted by directory 
+ * index.
+ * 
+ * @param name - A directory name.
+ * @param index - The directory index that `name` belongs to.
+ * @param otherIndex - Directory index of the name to compare against.
+ * @return Negative if `name` sorts before the other name, positive if it
+ *         sorts after.
+ */
+static int compareNameToDirectoryName(char const* name, uint8_t index, uint8_t otherIndex) {
+  static char otherName[STORAGE_MAX_DIRECTORY_NAME_LENGTH];
+  
+  readDirectoryName(otherIndex, otherName);
+  
+  int result = strnicmp(name, otherName, STORAGE_MAX_DIRECTORY_NAME_LENGTH);
+  
+  return result ? result : ((int8_t)index - (int8_t)otherIndex);
+}
+
 static int compareNameIndexes(void const* a, void const* b) {
-  int result = strnicmp(
-    storage.directory[*((uint8_t const*)a)].name,
-    storage.directory[*((uint8_t const*)b)].name,
-    STORAGE_MAX_DIRECTORY_NAME_LENGTH  
-  );
+  static char nameA[STORAGE_MAX_DIRECTORY_NAME_LENGTH];
+  
+  readDirectoryName(*((uint8_t const*)a), nameA);
   
-  return result ? result : (*((int8_t const*)a) - *((int8_t const*)b));
+  return compareNameToDirectoryName(nameA, *((uint8_t const*)a), *((uint8_t const*)b));
+}
+
+/**
+ * Updates `sortedNamePositions` for all sorted names starting at a position.
+ * 
+ * @param startPosition - Position within `sortedNameIndexes` to start at.
+ */
+static void updateSortedNamePositions(uint8_t startPosition) {
+  for (uint8_t i = startPosition; i < sortedNameSize; ++i) {
+    sortedNamePositions[sortedNameIndexes[i]] = i;
+  }
 }
 
-static void initializeSortedNameIndexes(void) {
+static void updateSortedNameIndexes(void) {
+  if (isSortedNameIndexesValid) {
+    return;
+  }
+  
   sortedNameSize = 0;
   
   for (uint8_t i = 0; i < STORAGE_DIRECTORY_SIZE; ++i) {
-    if (!STORAGE_IsDirectoryEntryEmpty(i) && storage.directory[i].name[0]) {
+    sortedNamePositions[i] = 0xFF;
+    
+    if (namedDirectoryEntries & ((uint32_t)1 << i)) {
       sortedNameIndexes[sortedNameSize++] = i;
     }
   }
   
   qsort(sortedNameIndexes, sortedNameSize, 1, compareNameIndexes);
+  updateSortedNamePositions(0);
+  
+  uint8_t position = 0;
+  
+  for (uint8_t i = 0; i < ALPHABET_SIZE; ++i) {
+    while (
+        (position < sortedNameSize) &&
+        (tolower(EEPROM_ReadByte(getDirectoryEntryAddress(sortedNameIndexes[position]) + offsetof(directory_entry_t, name))) < 'a' + i)
+        ) {
+      ++position;
+    }
+    
+    letterSortedNamePositions[i] = position;
+  }
+  
+  isSortedNameIndexesValid = true;
 }
 
-#define COMPRESSED_ASTERISK (0x0A)
-#define COMPRESSED_POUND (0x0B)
-#define COMPRESSED_PAUSE (0x0C)
-#define COMPRESSED_CC_MEMORY (0x0D)
-#define COMPRESSED_TERMINATOR (0x0F)
-
-static void compressPhoneNumber(uint8_t* dest, char const* phoneNumber, uint8_t maxLength) {
-  if (phoneNumber == NULL) {
-    memset(dest, 0xFF, maxLength >> 1);
+/**
+ * Removes a directory entry from the sorted names.
+ * 
+ * @param index - A valid directory index. Nothing is done if it is not 
+ *        currently in the sorted names.
+ */
+static void removeSortedName(uint8_t index) {
+  uint8_t const position = sortedNamePositions[index];
+  
+  if (position == 0xFF) {
     return;
   }
   
-  size_t len = strlen(phoneNumber);
+  --sortedNameSize;
+  memmove(sortedNameIndexes + position, sortedNameIndexes + position + 1, sortedNameSize - position);
+  sortedNamePositions[index] = 0xFF;
+  updateSortedNamePositions(position);
   
-  if (len > maxLength) {
-    phoneNumber += len - maxLength;
+  // If the removed name was the first for a letter, then the next name 
+  // (now at the same position) is the new first for that letter, so only
+  // subsequent positions are affected.
+  for (uint8_t i = 0; i < ALPHABET_SIZE; ++i) {
+    if (letterSortedNamePositions[i] > position) {
+      --letterSortedNamePositions[i];
+    }
   }
+}
+
+/**
+ * Inserts a directory entry into the sorted names.
+ * 
+ * @param index - A valid directory index that is not currently in the sorted 
+ *        names.
+ * @param name - The (non-empty) name of the directory entry. The name of the 
+ *        entry in EEPROM is not used, because it may not be written yet.
+ */
+static void insertSortedName(uint8_t index, char const* name) {
+  uint8_t position = 0;
+  uint8_t endPosition = sortedNameSize;
   
-  uint8_t i = 0;
-  uint8_t prevNibble;
-  uint8_t nextNibble;
-  
-  while (*phoneNumber) {
-    if (isdigit(*phoneNumber)) {
-      nextNibble = *phoneNumber - '0';
-    } else if (*phoneNumber == '*') {
-      nextNibble = COMPRESSED_ASTERISK;
-    } else if (*phoneNumber == '#') {
-      nextNibble = COMPRESSED_POUND;
-    } else if (*phoneNumber == 'P') {
-      nextNibble = COMPRESSED_PAUSE;
-    } else if (*phoneNumber == 'M') {
-      nextNibble = COMPRESSED_CC_MEMORY;
+  // Binary search for the first sorted name that the new name sorts before
+  while (position < endPosition) {
+    uint8_t const middle = (position + endPosition) >> 1;
+    
+    if (compareNameToDirectoryName(name, index, sortedNameIndexes[middle]) > 0) {
+      position = middle + 1;
     } else {
-      nextNibble = COMPRESSED_TERMINATOR;
+      endPosition = middle;
     }
+  }
+  
+  memmove(sortedNameIndexes + position + 1, sortedNameIndexes + position, sortedNameSize - position);
+  sortedNameIndexes[position] = index;
+  ++sortedNameSize;
+  updateSortedNamePositions(position);
+  
+  int const firstChar = tolower(name[0]);
+  
+  for (uint8_t i = 0; i < ALPHABET_SIZE; ++i) {
+    uint8_t* const letterPosition = &letterSortedNamePositions[i];
     
-    if (i & 1) {
-      *dest++ = (uint8_t)(prevNibble << 4) | nextNibble;
-    } else {
-      prevNibble = nextNibble;
+    // The new name becomes the first for a letter if it is inserted at the 
+    // previous first position, and it qualifies for the letter.
+    if ((*letterPosition > position) || ((*letterPosition == position) && (firstChar < 'a' + i))) {
+      ++*letterPosition;
     }
+  }
+}
+
+/**
+ * Gets the trailing digits of a phone number that are compared for caller ID.
+ * 
+ * Only the part of the phone number before any pause ('P') or credit card 
+ * memory ('M') is used, and non-digit characters are ignored.
+ * 
+ * @param dest - Destination buffer of at least CALLER_ID_MATCH_LENGTH + 1 
+ *        chars.
+ * @param number - A phone number.
+ * @return A pointer to the destination buffer.
+ */
+static char* getCallerIdDigits(char* dest, char const* number) {
+  uint8_t length = 0;
+  
+  while (*number && (*number != 'P') && (*number != 'M')) {
+    char const c = *number++;
     
-    ++phoneNumber;
-    ++i;
+    if (isdigit(c)) {
+      if (length == CALLER_ID_MATCH_LENGTH) {
+        memmove(dest, dest + 1, CALLER_ID_MATCH_LENGTH - 1);
+        --length;
+      }
+      
+      dest[length++] = c;
+    }
   }
   
-  if (i & 1) {
-    *dest++ = (uint8_t)(prevNibble << 4) | COMPRESSED_TERMINATOR;
-    ++i;
+  dest[length] = 0;
+  
+  return dest;
+}
+
+/**
+ * Calculates the caller ID key of caller ID digits.
+ * 
+ * Different digits may produce the same key, so a matching key must be 
+ * verified by comparing the digits.
+ * 
+ * @param digits - Caller ID digits (see getCallerIdDigits()).
+ * @return The caller ID key. Never CALLER_ID_KEY_NONE.
+ */
+static uint16_t getCallerIdKey(char const* digits) {
+  // Start at 1 so that leading zeros change the key
+  uint16_t key = 1;
+  
+  while (*digits) {
+    key = key * 10 + (*digits++ - '0');
   }
   
-  memset(dest, 0xFF, (maxLength - i) >> 1);
+  return (key == CALLER_ID_KEY_NONE) ? 1 : key;
 }
 
-static char uncompressPhoneNumberNibble(uint8_t nibble) {
-  if (nibble < 10) {
-    return '0' + nibble;
-  } else if (nibble == COMPRESSED_ASTERISK) {
-    return '*';
-  } else if (nibble == COMPRESSED_POUND) {
-    return '#';
-  } else if (nibble == COMPRESSED_PAUSE) {
-    return 'P';
-  } else if (nibble == COMPRESSED_CC_MEMORY) {
-    return 'M';
-  } else {
-    return 0;
+/**
+ * Reads the caller ID digits of a directory entry from EEPROM (not cached).
+ * 
+ * @param index - A valid directory index.
+ * @param dest - Destination buffer of at least CALLER_ID_MATCH_LENGTH + 1 
+ *        chars.
+ * @return A pointer to the destination buffer.
+ */
+static char* readDirectoryCallerIdDigits(uint8_t index, char* dest) {
+  uint8_t compressedNumber[MAX_EXTENDED_PHONE_NUMBER_LENGTH >> 1];
+  char number[MAX_EXTENDED_PHONE_NUMBER_LENGTH + 1];
+  
+  EEPROM_ReadBytes(
+      getDirectoryEntryAddress(index) + offsetof(directory_entry_t, number),
+      compressedNumber,
+      MAX_EXTENDED_PHONE_NUMBER_LENGTH >> 1
+      );
+  
+  uncompressPhoneNumber(number, compressedNumber, MAX_EXTENDED_PHONE_NUMBER_LENGTH >> 1);
+  
+  return getCallerIdDigits(dest, number);
+}
+
+static void updateCallerIdKeys(void) {
+  if (isCallerIdKeysValid) {
+    return;
+  }
+  
+  char digits[CALLER_ID_MATCH_LENGTH + 1];
+  
+  for (uint8_t i = 0; i < STORAGE_DIRECTORY_SIZE; ++i) {
+    if (namedDirectoryEntries & ((uint32_t)1 << i)) {
+      callerIdKeys[i] = getCallerIdKey(readDirectoryCallerIdDigits(i, digits));
+    } else {
+      callerIdKeys[i] = CALLER_ID_KEY_NONE;
+    }
+  }
+  
+  isCallerIdKeysValid = true;
+}
+
+/**
+ * Calculates the check byte of a journal slot.
+ * 
+ * @param slot - Pointer to the journal slot.
+ * @param size - Size of the journal slot, not including the check byte,
+ *        which must be the last byte of the slot.
+ * @return The check byte value for the slot.
+ */
+static uint8_t calculateJournalCheck(void const* slot, uint8_t size) {
+  uint8_t const* slotBytes = slot;
+  uint8_t sum = 0;
+  
+  while (size--) {
+    sum += *slotBytes++;
   }
+  
+  // Inverted so that neither an erased (all 0xFF) nor an all zero slot is valid
+  return (uint8_t)~sum;
 }
 
-static char* uncompressPhoneNumber(char* dest, uint8_t const* compressedPhoneNumber, uint8_t maxCompressedLength) {
-  uint8_t i = 0;
+/**
+ * Finds the slot with the current value in a journal.
+ * 
+ * @param journal - Pointer to the first slot of the journal.
+ * @param slotSize - Size of each slot (the sequence and check bytes must be
+ *        the last two bytes of each slot).
+ * @param slotCount - Number of slots in the journal.
+ * @param state - Updated with the slot index and sequence of the current slot.
+ * @return True if a valid slot was found.
+ */
+static bool findCurrentJournalSlot(
+    void const* journal, 
+    uint8_t slotSize, 
+    uint8_t slotCount, 
+    journal_state_t* state
+    ) {
+  uint8_t const* slot = journal;
+  bool isFound = false;
+  
+  for (uint8_t i = 0; i < slotCount; ++i, slot += slotSize) {
+    uint8_t const sequence = slot[slotSize - 2];
+    
+    if (
+        (slot[slotSize - 1] == calculateJournalCheck(slot, slotSize - 1)) &&
+        (!isFound || ((int8_t)(sequence - state->sequence) > 0))
+        ) {
+      state->slotIndex = i;
+      state->sequence = sequence;
+      isFound = true;
+    }
+  }
   
-  while (i < maxCompressedLength) {
-    uint8_t nextCompressedByte = *compressedPhoneNumber++;
-    *dest++ = uncompressPhoneNumberNibble((nextCompressedByte & 0xF0) >> 4);
-    *dest++ = uncompressPhoneNumberNibble(nextCompressedByte & 0x0F);
-    ++i;
+  return isFound;
+}
+
+/**
+ * Writes the next slot of the call time journal with the current call time.
+ */
+static void writeCallTimeJournal(void) {
+  if (++callTimeJournalState.slotIndex == CALL_TIME_JOURNAL_SIZE) {
+    callTimeJournalState.slotIndex = 0;
   }
   
-  *dest = 0;
+  call_time_journal_slot_t* slot = &settings.callTimeJournal[callTimeJournalState.slotIndex];
   
-  return dest;
+  slot->callTime = settings.callTime;
+  slot->sequence = ++callTimeJournalState.sequence;
+  slot->check = calculateJournalCheck(slot, offsetof(call_time_journal_slot_t, check));
+  
+  EEPROM_AsyncWriteBytes(
+      offsetof(settings_t, callTimeJournal) + sizeof(call_time_journal_slot_t) * callTimeJournalState.slotIndex,
+      slot,
+      sizeof(call_time_journal_slot_t)
+  );
+}
+
+/**
+ * Writes the next slot of the settings journal with the current settings.
+ */
+static void writeSettingsJournal(void) {
+  if (++settingsJournalState.slotIndex == SETTINGS_JOURNAL_SIZE) {
+    settingsJournalState.slotIndex = 0;
+  }
+  
+  settings_journal_slot_t* slot = &settings.settingsJournal[settingsJournalState.slotIndex];
+  
+  memcpy(slot->volumeLevels, settings.volumeLevels, VOLUME_MODE_COUNT);
+  slot->directoryIndex = settings.directoryIndex;
+  slot->sequence = ++settingsJournalState.sequence;
+  slot->check = calculateJournalCheck(slot, offsetof(settings_journal_slot_t, check));
+  
+  EEPROM_AsyncWriteBytes(
+      offsetof(settings_t, settingsJournal) + sizeof(settings_journal_slot_t) * settingsJournalState.slotIndex,
+      slot,
+      sizeof(settings_journal_slot_t)
+  );
+}
+
+/**
+ * Loads the current values from the journals (if valid) over the values 
+ * that were loaded from the fixed fields.
+ */
+static void loadJournals(void) {
+  if (findCurrentJournalSlot(
+      settings.callTimeJournal, 
+      sizeof(call_time_journal_slot_t), 
+      CALL_TIME_JOURNAL_SIZE, 
+      &callTimeJournalState
+      )) {
+    settings.callTime = settings.callTimeJournal[callTimeJournalState.slotIndex].callTime;
+  } else {
+    callTimeJournalState.slotIndex = CALL_TIME_JOURNAL_SIZE - 1;
+    callTimeJournalState.sequence = 0;
+  }
+  
+  if (findCurrentJournalSlot(
+      settings.settingsJournal, 
+      sizeof(settings_journal_slot_t), 
+      SETTINGS_JOURNAL_SIZE, 
+      &settingsJournalState
+      )) {
+    settings_journal_slot_t const* slot = &settings.settingsJournal[settingsJournalState.slotIndex];
+    memcpy(settings.volumeLevels, slot->volumeLevels, VOLUME_MODE_COUNT);
+    settings.directoryIndex = slot->directoryIndex;
+  } else {
+    settingsJournalState.slotIndex = SETTINGS_JOURNAL_SIZE - 1;
+    settingsJournalState.sequence = 0;
+  }
 }
 
 static void initializeDefaultStorageData(void) {
-  storage.marker = MARKER;
-  storage.version = VERSION;
-  storage.lcdViewAngle = 0;
-  storage.volumeLevels[VOLUME_Mode_ALERT] = VOLUME_Level_MID;
-  storage.volumeLevels[VOLUME_Mode_HANDSET] = VOLUME_Level_MID;
-  storage.volumeLevels[VOLUME_Mode_HANDS_FREE] = VOLUME_Level_MID;
-  storage.volumeLevels[VOLUME_Mode_SPEAKER] = VOLUME_Level_MID;
-  storage.volumeLevels[VOLUME_Mode_TONE] = VOLUME_Level_MID;
-  storage.volumeLevels[VOLUME_Mode_GAME_MUSIC] = VOLUME_Level_MID;
-  storage.directoryIndex = 0;
-  storage.ringtone = 0;
-  storage.callTime.lastCallMinutes = 0;
-  storage.callTime.lastCallSeconds = 0;
-  storage.callTime.accumulatedCallMinutes = 0;
-  storage.callTime.accumulatedCallSeconds = 0;
-  storage.callTime.totalCallMinutes = 0;
-  storage.callTime.totalCallSeconds = 0;
-  storage.toggles.statusBeepEnabled = true;
-  storage.toggles.oneMinuteBeepEnabled = false;
-  storage.toggles.oemHandsFreeIntegrationEnabled = false;
-  storage.toggles.showOwnNumberEnabled = true;
-  storage.toggles.dualNumbersEnabled = false;
-  storage.toggles.cumulativeTimerResetEnabled = true;
-  storage.toggles.autoAnswerEnabled = false;
-  storage.activeOwnNumberIndex = 0;
-  storage.programmingCount = 0;
-  storage.tetrisHighScore = 0;
-  storage.callerIdMode = 0;
-  memset(storage.tetrisHighScoreInitials, '?', 3);
-  memset(storage.pairedDeviceName, 0, STORAGE_MAX_DEVICE_NAME_LENGTH);
-  memset(storage.ownNumber, 0, (STANDARD_PHONE_NUMBER_LENGTH >> 1) * 2);
-  memset(storage.lastDialedNumber, 0xFF, MAX_EXTENDED_PHONE_NUMBER_LENGTH >> 1);
-  memset(storage.speedDial, 0xFF, (MAX_EXTENDED_PHONE_NUMBER_LENGTH >> 1) * 3);
-  memset(storage.securityCode, 0, (SECURITY_CODE_LENGTH >> 1));
+  settings.marker = MARKER;
+  settings.version = VERSION;
+  settings.lcdViewAngle = 0;
+  settings.volumeLevels[VOLUME_Mode_ALERT] = VOLUME_Level_MID;
+  settings.volumeLevels[VOLUME_Mode_HANDSET] = VOLUME_Level_MID;
+  settings.volumeLevels[VOLUME_Mode_HANDS_FREE] = VOLUME_Level_MID;
+  settings.volumeLevels[VOLUME_Mode_SPEAKER] = VOLUME_Level_MID;
+  settings.volumeLevels[VOLUME_Mode_TONE] = VOLUME_Level_MID;
+  settings.volumeLevels[VOLUME_Mode_GAME_MUSIC] = VOLUME_Level_MID;
+  settings.directoryIndex = 0;
+  settings.ringtone = 0;
+  settings.callTime.lastCallMinutes = 0;
+  settings.callTime.lastCallSeconds = 0;
+  settings.callTime.accumulatedCallMinutes = 0;
+  settings.callTime.accumulatedCallSeconds = 0;
+  settings.callTime.totalCallMinutes = 0;
+  settings.callTime.totalCallSeconds = 0;
+  settings.toggles.statusBeepEnabled = true;
+  settings.toggles.oneMinuteBeepEnabled = false;
+  settings.toggles.oemHandsFreeIntegrationEnabled = false;
+  settings.toggles.showOwnNumberEnabled = true;
+  settings.toggles.dualNumbersEnabled = false;
+  settings.toggles.cumulativeTimerResetEnabled = true;
+  settings.toggles.autoAnswerEnabled = false;
+  settings.activeOwnNumberIndex = 0;
+  settings.programmingCount = 0;
+  settings.tetrisHighScore = 0;
+  settings.callerIdMode = 0;
+  memset(settings.tetrisHighScoreInitials, '?', 3);
+  memset(settings.pairedDeviceName, 0, STORAGE_MAX_DEVICE_NAME_LENGTH);
+  memset(settings.ownNumber, 0, (STANDARD_PHONE_NUMBER_LENGTH >> 1) * 2);
+  memset(settings.lastDialedNumber, 0xFF, MAX_EXTENDED_PHONE_NUMBER_LENGTH >> 1);
+  memset(settings.speedDial, 0xFF, (MAX_EXTENDED_PHONE_NUMBER_LENGTH >> 1) * 3);
+  memset(settings.securityCode, 0, (SECURITY_CODE_LENGTH >> 1));
+  // Erased journals are invalid, so the fixed fields will be used
+  memset(settings.callTimeJournal, 0xFF, sizeof(settings.callTimeJournal));
+  memset(settings.settingsJournal, 0xFF, sizeof(settings.settingsJournal));
+  callTimeJournalState.slotIndex = CALL_TIME_JOURNAL_SIZE - 1;
+  callTimeJournalState.sequence = 0;
+  settingsJournalState.slotIndex = SETTINGS_JOURNAL_SIZE - 1;
+  settingsJournalState.sequence = 0;
 
   // Store everything except for the directory to EEPROM
-  EEPROM_WriteBytes(0, &storage, offsetof(storage_t, reserved));
+  EEPROM_WriteBytes(0, &settings, offsetof(settings_t, reserved));
 
   // Make all directory entries empty in EEPROM
   for (uint16_t i = 0; i < STORAGE_DIRECTORY_SIZE; ++i) {
     // Set first character of phone number to null
-    storage.directory[i].number[0] = 0xFF;
     EEPROM_WriteByte(
-        offsetof(storage_t, directory) + sizeof(directory_entry_t) * i + offsetof(directory_entry_t, number),
+        getDirectoryEntryAddress(i) + offsetof(directory_entry_t, number),
         0xFF
     );
 
     // Set first character of name to null
     EEPROM_WriteByte(
-        offsetof(storage_t, directory) + sizeof(directory_entry_t) * i + offsetof(directory_entry_t, name),
+        getDirectoryEntryAddress(i) + offsetof(directory_entry_t, name),
         0
     );
   }
@@ -268,36 +867,41 @@ static void initializeDefaultStorageData(void) {
   // Make all credit card entries empty in EEPROM
   for (uint16_t i = 0; i < STORAGE_CREDIT_CARD_COUNT; ++i) {
     // Set first character of phone number to null
-    storage.creditCardNumbers[i][0] = 0xFF;
-    EEPROM_WriteByte(
-        offsetof(storage_t, creditCardNumbers) + (CREDIT_CARD_NUMBER_LENGTH >> 1) * i,
-        0xFF
-    );
+    EEPROM_WriteByte(getCreditCardNumberAddress(i), 0xFF);
   }
 }
 
 void STORAGE_Initialize(void) {
-  storage.marker = EEPROM_ReadByte(0);
-  storage.version = EEPROM_ReadByte(1);
+#ifdef PROFILE_ENABLED
+  EEPROM_SetByteWriteHandler(handleEepromByteWrite);
+#endif
+
+  initializeEntryCache();
+
+  settings.marker = EEPROM_ReadByte(0);
+  settings.version = EEPROM_ReadByte(1);
   
-  if ((storage.marker != MARKER) || (storage.version != VERSION)) {
+  if ((settings.marker != MARKER) || (settings.version != VERSION)) {
     initializeDefaultStorageData();
   } else {
-    EEPROM_ReadBytes(0, &storage, sizeof(storage));
+    EEPROM_ReadBytes(0, &settings, sizeof(settings));
+    loadJournals();
     
-    if (storage.callerIdMode == 0xFF) {
+    if (settings.callerIdMode == 0xFF) {
       STORAGE_SetCallerIdMode(CALLER_ID_Mode_OFF);
     }
   }
   
-  initializeSortedNameIndexes();
+  initializeDirectoryEntryFlags();
+  isSortedNameIndexesValid = false;
+  isCallerIdKeysValid = false;
 }
 
 uint8_t STORAGE_GetLcdViewAngle(void) {
-  if (storage.lcdViewAngle > 7) {
+  if (settings.lcdViewAngle > 7) {
     return 0;
   }
-  return storage.lcdViewAngle;
+  return settings.lcdViewAngle;
 }
 
 void STORAGE_SetLcdViewAngle(uint8_t lcdViewAngle) {
@@ -305,12 +909,12 @@ void STORAGE_SetLcdViewAngle(uint8_t lcdViewAngle) {
     return;
   }
   
-  if (lcdViewAngle == storage.lcdViewAngle) {
+  if (lcdViewAngle == settings.lcdViewAngle) {
     return;
   }
   
-  storage.lcdViewAngle = lcdViewAngle;
-  EEPROM_AsyncWriteByte(offsetof(storage_t, lcdViewAngle), lcdViewAngle);
+  settings.lcdViewAngle = lcdViewAngle;
+  EEPROM_AsyncWriteByte(offsetof(settings_t, lcdViewAngle), lcdViewAngle);
 }
 
 VOLUME_Level STORAGE_GetVolumeLevel(VOLUME_Mode mode) {
@@ -318,11 +922,11 @@ VOLUME_Level STORAGE_GetVolumeLevel(VOLUME_Mode mode) {
     return 0;
   }
   
-  if (storage.volumeLevels[mode] > VOLUME_Level_MAX) {
+  if (settings.volumeLevels[mode] > VOLUME_Level_MAX) {
     return VOLUME_Level_MAX;
   }
   
-  return storage.volumeLevels[mode];
+  return settings.volumeLevels[mode];
 }
 
 void STORAGE_SetVolumeLevel(VOLUME_Mode mode, VOLUME_Level level) {
@@ -330,12 +934,12 @@ void STORAGE_SetVolumeLevel(VOLUME_Mode mode, VOLUME_Level level) {
     return;
   }
   
-  if (level == storage.volumeLevels[mode]) {
+  if (level == settings.volumeLevels[mode]) {
     return;
   }
   
-  storage.volumeLevels[mode] = level;
-  EEPROM_AsyncWriteByte(offsetof(storage_t, volumeLevels) + mode, level);
+  settings.volumeLevels[mode] = level;
+  writeSettingsJournal();
 }
 
 char* STORAGE_GetOwnNumber(uint8_t index, char* dest) {
@@ -343,7 +947,7 @@ char* STORAGE_GetOwnNumber(uint8_t index, char* dest) {
     index = 0;
   }
   
-  return uncompressPhoneNumber(dest, storage.ownNumber[index], STANDARD_PHONE_NUMBER_LENGTH >> 1);
+  return uncompressPhoneNumber(dest, settings.ownNumber[index], STANDARD_PHONE_NUMBER_LENGTH >> 1);
 }
 
 void STORAGE_SetOwnNumber(uint8_t index, char const* ownNumber) {
@@ -351,23 +955,23 @@ void STORAGE_SetOwnNumber(uint8_t index, char const* ownNumber) {
     index = 0;
   }
   
-  compressPhoneNumber(storage.ownNumber[index], ownNumber, STANDARD_PHONE_NUMBER_LENGTH);
+  compressPhoneNumber(settings.ownNumber[index], ownNumber, STANDARD_PHONE_NUMBER_LENGTH);
   EEPROM_AsyncWriteBytes(
-      offsetof(storage_t, ownNumber) + index * (STANDARD_PHONE_NUMBER_LENGTH >> 1), 
-      storage.ownNumber[index], 
+      offsetof(settings_t, ownNumber) + index * (STANDARD_PHONE_NUMBER_LENGTH >> 1), 
+      settings.ownNumber[index], 
       STANDARD_PHONE_NUMBER_LENGTH >> 1
   );
 }
 
 char* STORAGE_GetLastDialedNumber(char* dest) {
-  return uncompressPhoneNumber(dest, storage.lastDialedNumber, MAX_EXTENDED_PHONE_NUMBER_LENGTH >> 1);
+  return uncompressPhoneNumber(dest, settings.lastDialedNumber, MAX_EXTENDED_PHONE_NUMBER_LENGTH >> 1);
 }
 
 void STORAGE_SetLastDialedNumber(char const* lastDialedNumber) {
-  compressPhoneNumber(storage.lastDialedNumber, lastDialedNumber, MAX_EXTENDED_PHONE_NUMBER_LENGTH);
+  compressPhoneNumber(settings.lastDialedNumber, lastDialedNumber, MAX_EXTENDED_PHONE_NUMBER_LENGTH);
   EEPROM_AsyncWriteBytes(
-      offsetof(storage_t, lastDialedNumber), 
-      storage.lastDialedNumber, 
+      offsetof(settings_t, lastDialedNumber), 
+      settings.lastDialedNumber, 
       MAX_EXTENDED_PHONE_NUMBER_LENGTH >> 1
   );
 }
@@ -376,7 +980,7 @@ char* STORAGE_GetSpeedDial(uint8_t index, char* dest) {
   if (index >= 3) {
     dest[0] = 0;
   } else {
-    uncompressPhoneNumber(dest, storage.speedDial[index], MAX_EXTENDED_PHONE_NUMBER_LENGTH >> 1);
+    uncompressPhoneNumber(dest, settings.speedDial[index], MAX_EXTENDED_PHONE_NUMBER_LENGTH >> 1);
   }
   
   return dest;
@@ -387,10 +991,10 @@ void STORAGE_SetSpeedDial(uint8_t index, char const* number) {
     return;
   }
 
-  compressPhoneNumber(storage.speedDial[index], number, MAX_EXTENDED_PHONE_NUMBER_LENGTH);
+  compressPhoneNumber(settings.speedDial[index], number, MAX_EXTENDED_PHONE_NUMBER_LENGTH);
   EEPROM_AsyncWriteBytes(
-      offsetof(storage_t, speedDial) + (MAX_EXTENDED_PHONE_NUMBER_LENGTH >> 1) * index, 
-      storage.speedDial[index], 
+      offsetof(settings_t, speedDial) + (MAX_EXTENDED_PHONE_NUMBER_LENGTH >> 1) * index, 
+      settings.speedDial[index], 
       MAX_EXTENDED_PHONE_NUMBER_LENGTH >> 1
   );
 }
@@ -399,7 +1003,7 @@ char* STORAGE_GetDirectoryNumber(uint8_t index, char* dest) {
   if (index >= STORAGE_DIRECTORY_SIZE) {
     dest[0] = 0;
   } else {
-    uncompressPhoneNumber(dest, storage.directory[index].number, MAX_EXTENDED_PHONE_NUMBER_LENGTH >> 1);
+    uncompressPhoneNumber(dest, getCachedEntry(index)->data.directoryEntry.number, MAX_EXTENDED_PHONE_NUMBER_LENGTH >> 1);
     dest[MAX_EXTENDED_PHONE_NUMBER_LENGTH] = 0;
   }
   
@@ -414,7 +1018,7 @@ char* STORAGE_GetDirectoryName(uint8_t index, char* dest) {
   if (index >= STORAGE_DIRECTORY_SIZE) {
     dest[0] = 0;
   } else {
-    strncpy(dest, storage.directory[index].name, STORAGE_MAX_DIRECTORY_NAME_LENGTH)[STORAGE_MAX_DIRECTORY_NAME_LENGTH] = 0;
+    strncpy(dest, getCachedEntry(index)->data.directoryEntry.name, STORAGE_MAX_DIRECTORY_NAME_LENGTH)[STORAGE_MAX_DIRECTORY_NAME_LENGTH] = 0;
   }
   
   return dest;
@@ -425,27 +1029,89 @@ void STORAGE_SetDirectoryEntry(uint8_t index, char const* number, char const* na
     return;
   }
 
+  directory_entry_t* const entry = &getCachedEntry(index)->data.directoryEntry;
+  uint32_t const indexFlag = (uint32_t)1 << index;
+
   if (number) {
-    compressPhoneNumber(storage.directory[index].number, number, MAX_EXTENDED_PHONE_NUMBER_LENGTH);
+    compressPhoneNumber(entry->number, number, MAX_EXTENDED_PHONE_NUMBER_LENGTH);
   } else {
-    memset(storage.directory[index].number, 0xFF, MAX_EXTENDED_PHONE_NUMBER_LENGTH >> 1);
+    memset(entry->number, 0xFF, MAX_EXTENDED_PHONE_NUMBER_LENGTH >> 1);
   }
   
-  memset(storage.directory[index].name, 0xFF, STORAGE_MAX_DIRECTORY_NAME_LENGTH);
+  memset(entry->name, 0xFF, STORAGE_MAX_DIRECTORY_NAME_LENGTH);
   
   if (name && number && number[0]) {
-    strncpy(storage.directory[index].name, name, STORAGE_MAX_DIRECTORY_NAME_LENGTH);
+    strncpy(entry->name, name, STORAGE_MAX_DIRECTORY_NAME_LENGTH);
   } else {
-    storage.directory[index].name[0] = 0;
+    entry->name[0] = 0;
   }
 
   EEPROM_AsyncWriteBytes(
-      offsetof(storage_t, directory) + sizeof(directory_entry_t) * index, 
-      storage.directory + index, 
+      getDirectoryEntryAddress(index), 
+      entry, 
       sizeof(directory_entry_t)
   );
   
-  initializeSortedNameIndexes();
+  if (entry->number[0] == 0xFF) {
+    populatedDirectoryEntries &= ~indexFlag;
+  } else {
+    populatedDirectoryEntries |= indexFlag;
+  }
+  
+  if (isSortedNameIndexesValid) {
+    removeSortedName(index);
+  }
+  
+  if ((entry->number[0] != 0xFF) && entry->name[0]) {
+    namedDirectoryEntries |= indexFlag;
+    
+    if (isSortedNameIndexesValid) {
+      insertSortedName(index, entry->name);
+    }
+  } else {
+    namedDirectoryEntries &= ~indexFlag;
+  }
+  
+  if (isCallerIdKeysValid) {
+    if (namedDirectoryEntries & indexFlag) {
+      char number[MAX_EXTENDED_PHONE_NUMBER_LENGTH + 1];
+      char digits[CALLER_ID_MATCH_LENGTH + 1];
+      
+      // Use the stored (compressed) number, because it may have been truncated
+      uncompressPhoneNumber(number, entry->number, MAX_EXTENDED_PHONE_NUMBER_LENGTH >> 1);
+      callerIdKeys[index] = getCallerIdKey(getCallerIdDigits(digits, number));
+    } else {
+      callerIdKeys[index] = CALLER_ID_KEY_NONE;
+    }
+  }
+}
+
+bool STORAGE_FindDirectoryName(char const* number, char* dest) {
+  char digits[CALLER_ID_MATCH_LENGTH + 1];
+  char entryDigits[CALLER_ID_MATCH_LENGTH + 1];
+  
+  getCallerIdDigits(digits, number);
+  
+  if (!digits[0]) {
+    return false;
+  }
+  
+  updateCallerIdKeys();
+  
+  uint16_t const key = getCallerIdKey(digits);
+  
+  for (uint8_t i = 0; i < STORAGE_DIRECTORY_SIZE; ++i) {
+    if (
+        (callerIdKeys[i] == key) && 
+        !strcmp(digits, readDirectoryCallerIdDigits(i, entryDigits))
+        ) {
+      readDirectoryName(i, dest);
+      dest[STORAGE_MAX_DIRECTORY_NAME_LENGTH] = 0;
+      return true;
+    }
+  }
+  
+  return false;
 }
 
 uint8_t STORAGE_GetFirstEmptyDirectoryIndex(void) {
@@ -479,15 +1145,15 @@ uint8_t STORAGE_GetNextPopulatedDirectoryIndex(uint8_t startIndex, bool forward)
 }
 
 uint8_t STORAGE_GetNextNamedDirectoryIndex(uint8_t startIndex, bool forward) {
-  uint8_t nameIndex;
-  
-  for (nameIndex = 0; nameIndex < sortedNameSize; ++nameIndex) {
-    if (sortedNameIndexes[nameIndex] == startIndex) {
-      break;
-    }
+  if (startIndex >= STORAGE_DIRECTORY_SIZE) {
+    return 0xFF;
   }
   
-  if (nameIndex == sortedNameSize) {
+  updateSortedNameIndexes();
+  
+  uint8_t nameIndex = sortedNamePositions[startIndex];
+  
+  if (nameIndex == 0xFF) {
     return 0xFF;
   }
   
@@ -505,6 +1171,8 @@ uint8_t STORAGE_GetNextNamedDirectoryIndex(uint8_t startIndex, bool forward) {
 }
 
 uint8_t STORAGE_GetFirstNamedDirectoryIndexForLetter(char letter) {
+  updateSortedNameIndexes();
+
   if (!sortedNameSize) {
     return 0xFF;
   }
@@ -512,8 +1180,22 @@ uint8_t STORAGE_GetFirstNamedDirectoryIndexForLetter(char letter) {
   uint8_t index;
   letter = (char)tolower(letter);
   
+  if ((letter >= 'a') && (letter <= 'z')) {
+    index = letterSortedNamePositions[letter - 'a'];
+    
+    if (index == sortedNameSize) {
+      index = 0;
+    }
+    
+    return sortedNameIndexes[index];
+  }
+  
   for (index = 0; index < sortedNameSize; ++index) {
-    if (tolower(storage.directory[sortedNameIndexes[index]].name[0]) >= letter) {
+    char const firstChar = (char)EEPROM_ReadByte(
+        getDirectoryEntryAddress(sortedNameIndexes[index]) + offsetof(directory_entry_t, name)
+        );
+    
+    if (tolower(firstChar) >= letter) {
       break;
     }
   }
@@ -530,7 +1212,7 @@ bool STORAGE_IsDirectoryEntryEmpty(uint8_t index) {
     return true;
   }
   
-  return storage.directory[index].number[0] == 0xFF;
+  return !(populatedDirectoryEntries & ((uint32_t)1 << index));
 }
 
 bool STORAGE_IsDirectoryNameEmpty(uint8_t index) {
@@ -538,31 +1220,35 @@ bool STORAGE_IsDirectoryNameEmpty(uint8_t index) {
     return true;
   }
   
-  return !storage.directory[index].name[0];
+  return !(namedDirectoryEntries & ((uint32_t)1 << index));
 }
 
 uint8_t STORAGE_GetDirectoryIndex(void) {
-  if (storage.directoryIndex >= STORAGE_DIRECTORY_SIZE) {
+  if (settings.directoryIndex >= STORAGE_DIRECTORY_SIZE) {
     return 0;
   }
   
-  return storage.directoryIndex;
+  return settings.directoryIndex;
 }
 
 void STORAGE_SetDirectoryIndex(uint8_t index) {
-  if ((index == storage.directoryIndex) || (index >= STORAGE_DIRECTORY_SIZE)) {
+  if ((index == settings.directoryIndex) || (index >= STORAGE_DIRECTORY_SIZE)) {
     return;
   }
   
-  storage.directoryIndex = index;
-  EEPROM_AsyncWriteByte(offsetof(storage_t, directoryIndex), index);
+  settings.directoryIndex = index;
+  writeSettingsJournal();
 }
 
 char* STORAGE_GetCreditCardNumber(uint8_t index, char* dest) {
   if (index >= STORAGE_CREDIT_CARD_COUNT) {
     dest[0] = 0;
   } else {
-    uncompressPhoneNumber(dest, storage.creditCardNumbers[index], CREDIT_CARD_NUMBER_LENGTH >> 1);
+    uncompressPhoneNumber(
+        dest, 
+        getCachedEntry(ENTRY_CACHE_KEY_CREDIT_CARD | index)->data.creditCardNumber, 
+        CREDIT_CARD_NUMBER_LENGTH >> 1
+        );
   }
   
   return dest;
@@ -573,136 +1259,138 @@ void STORAGE_SetCreditCardNumber(uint8_t index, char const* number) {
     return;
   }
 
-  compressPhoneNumber(storage.creditCardNumbers[index], number, CREDIT_CARD_NUMBER_LENGTH);
+  uint8_t* const creditCardNumber = getCachedEntry(ENTRY_CACHE_KEY_CREDIT_CARD | index)->data.creditCardNumber;
+  
+  compressPhoneNumber(creditCardNumber, number, CREDIT_CARD_NUMBER_LENGTH);
   
   EEPROM_AsyncWriteBytes(
-      offsetof(storage_t, creditCardNumbers) + (CREDIT_CARD_NUMBER_LENGTH >> 1) * index, 
-      storage.creditCardNumbers[index], 
+      getCreditCardNumberAddress(index), 
+      creditCardNumber, 
       CREDIT_CARD_NUMBER_LENGTH >> 1
   );
 }
 
 RINGTONE_Type STORAGE_GetRingtone(void) {
-  if (storage.ringtone >= RINGTONE_COUNT) {
+  if (settings.ringtone >= RINGTONE_COUNT) {
     return 0;
   }
   
-  return storage.ringtone;
+  return settings.ringtone;
 }
 
 void STORAGE_SetRingtone(RINGTONE_Type ringtone) {
-  if ((ringtone == storage.ringtone) || (ringtone >= RINGTONE_COUNT)) {
+  if ((ringtone == settings.ringtone) || (ringtone >= RINGTONE_COUNT)) {
     return;
   }
   
-  storage.ringtone = ringtone;
-  EEPROM_AsyncWriteByte(offsetof(storage_t, ringtone), ringtone);
+  settings.ringtone = ringtone;
+  EEPROM_AsyncWriteByte(offsetof(settings_t, ringtone), ringtone);
 }
 
 uint8_t STORAGE_GetLastCallMinutes(void) {
-  return storage.callTime.lastCallMinutes;
+  return settings.callTime.lastCallMinutes;
 }
 
 uint8_t STORAGE_GetLastCallSeconds(void) {
-  return storage.callTime.lastCallSeconds;
+  return settings.callTime.lastCallSeconds;
 }
 
 
 void STORAGE_SetLastCallTime(uint8_t minutes, uint8_t seconds) {
-  storage.callTime.lastCallMinutes = minutes;
-  storage.callTime.lastCallSeconds = seconds;
+  settings.callTime.lastCallMinutes = minutes;
+  settings.callTime.lastCallSeconds = seconds;
 
-  storage.callTime.accumulatedCallMinutes += minutes;
-  storage.callTime.accumulatedCallSeconds += seconds;
+  settings.callTime.accumulatedCallMinutes += minutes;
+  settings.callTime.accumulatedCallSeconds += seconds;
   
-  if (storage.callTime.accumulatedCallSeconds >= 60) {
-    storage.callTime.accumulatedCallSeconds -= 60;
-    ++storage.callTime.accumulatedCallMinutes;
+  if (settings.callTime.accumulatedCallSeconds >= 60) {
+    settings.callTime.accumulatedCallSeconds -= 60;
+    ++settings.callTime.accumulatedCallMinutes;
   }
 
-  storage.callTime.totalCallMinutes += minutes;
-  storage.callTime.totalCallSeconds += seconds;
+  settings.callTime.totalCallMinutes += minutes;
+  settings.callTime.totalCallSeconds += seconds;
   
-  if (storage.callTime.totalCallSeconds >= 60) {
-    storage.callTime.totalCallSeconds -= 60;
-    ++storage.callTime.totalCallMinutes;
+  if (settings.callTime.totalCallSeconds >= 60) {
+    settings.callTime.totalCallSeconds -= 60;
+    ++settings.callTime.totalCallMinutes;
   }
 
-  EEPROM_AsyncWriteBytes(offsetof(storage_t, callTime), &storage.callTime, sizeof(storage.callTime));
+  writeCallTimeJournal();
 }
 
 uint16_t STORAGE_GetAccumulatedCallMinutes(void) {
-  return storage.callTime.accumulatedCallMinutes;
+  return settings.callTime.accumulatedCallMinutes;
 }
 
 uint8_t STORAGE_GetAccumulatedCallSeconds(void) {
-  return storage.callTime.accumulatedCallSeconds;
+  return settings.callTime.accumulatedCallSeconds;
 }
 
 uint16_t STORAGE_GetTotalCallMinutes(void) {
-  return storage.callTime.totalCallMinutes;
+  return settings.callTime.totalCallMinutes;
 }
 
 uint8_t STORAGE_GetTotalCallSeconds(void) {
-  return storage.callTime.totalCallSeconds;
+  return settings.callTime.totalCallSeconds;
 }
 
 void STORAGE_ResetCallTime(void) {
-  storage.callTime.lastCallMinutes = 0;
-  storage.callTime.lastCallSeconds = 0;
-  storage.callTime.accumulatedCallMinutes = 0;
-  storage.callTime.accumulatedCallSeconds = 0;
+  settings.callTime.lastCallMinutes = 0;
+  settings.callTime.lastCallSeconds = 0;
+  settings.callTime.accumulatedCallMinutes = 0;
+  settings.callTime.accumulatedCallSeconds = 0;
 
-  EEPROM_AsyncWriteBytes(offsetof(storage_t, callTime), &storage.callTime, sizeof(storage.callTime));
+  writeCallTimeJournal();
 }
 
 bool STORAGE_GetStatusBeepEnabled(void) {
-  return storage.toggles.statusBeepEnabled;
+  return settings.toggles.statusBeepEnabled;
 }
 
 void STORAGE_SetStatusBeepEnabled(bool enabled) {
-  storage.toggles.statusBeepEnabled = enabled;
-  EEPROM_AsyncWriteBytes(offsetof(storage_t, toggles), &storage.toggles, sizeof(toggles_t));
+  settings.toggles.statusBeepEnabled = enabled;
+  EEPROM_AsyncWriteBytes(offsetof(settings_t, toggles), &settings.toggles, sizeof(toggles_t));
 }
 
 bool STORAGE_GetOneMinuteBeepEnabled(void) {
-  return storage.toggles.oneMinuteBeepEnabled;
+  return settings.toggles.oneMinuteBeepEnabled;
 }
 
 void STORAGE_SetOneMinuteBeepEnabled(bool enabled) {
-  storage.toggles.oneMinuteBeepEnabled = enabled;
-  EEPROM_AsyncWriteBytes(offsetof(storage_t, toggles), &storage.toggles, sizeof(toggles_t));
+  settings.toggles.oneMinuteBeepEnabled = enabled;
+  EEPROM_AsyncWriteBytes(offsetof(settings_t, toggles), &settings.toggles, sizeof(toggles_t));
 }
 
 bool STORAGE_GetOemHandsFreeIntegrationEnabled(void) {
-  return storage.toggles.oemHandsFreeIntegrationEnabled;
+  return settings.toggles.oemHandsFreeIntegrationEnabled;
 }
 
 void STORAGE_SetOemHandsFreeIntegrationEnabled(bool enabled) {
-  storage.toggles.oemHandsFreeIntegrationEnabled = enabled;
-  EEPROM_AsyncWriteBytes(offsetof(storage_t, toggles), &storage.toggles, sizeof(toggles_t));
+  settings.toggles.oemHandsFreeIntegrationEnabled = enabled;
+  EEPROM_AsyncWriteBytes(offsetof(settings_t, toggles), &settings.toggles, sizeof(toggles_t));
 }
 
 CALLER_ID_Mode STORAGE_GetCallerIdMode(void) {
-  return storage.callerIdMode;
+  return settings.callerIdMode;
 }
 
 void STORAGE_SetCallerIdMode(CALLER_ID_Mode mode) {
-  storage.callerIdMode = mode;
-  EEPROM_AsyncWriteByte(offsetof(storage_t, callerIdMode), storage.callerIdMode);
+  settings.callerIdMode = mode;
+  EEPROM_AsyncWriteByte(offsetof(settings_t, callerIdMode), settings.callerIdMode);
 }
 
 bool STORAGE_GetShowOwnNumberEnabled(void) {
-  return storage.toggles.showOwnNumberEnabled;
+  return settings.toggles.showOwnNumberEnabled;
 }
 
 void STORAGE_SetShowOwnNumberEnabled(bool enabled) {
-  storage.toggles.showOwnNumberEnabled = enabled;
-  EEPROM_AsyncWriteBytes(offsetof(storage_t, toggles), &storage.toggles, sizeof(toggles_t));
+  settings.toggles.showOwnNumberEnabled = enabled;
+  EEPROM_AsyncWriteBytes(offsetof(settings_t, toggles), &settings.toggles, sizeof(toggles_t));
 }
 
 bool STORAGE_GetDualNumberEnabled(void) {
-  return storage.toggles.dualNumbersEnabled;
+  return settings.toggles.dualNumbersEnabled;
 }
 
 void STORAGE_SetDualNumberEnabled(bool enabled) {
@@ -710,30 +1398,30 @@ void STORAGE_SetDualNumberEnabled(bool enabled) {
     STORAGE_SetActiveOwnNumberIndex(0);
   }
   
-  storage.toggles.dualNumbersEnabled = enabled;
-  EEPROM_AsyncWriteBytes(offsetof(storage_t, toggles), &storage.toggles, sizeof(toggles_t));
+  settings.toggles.dualNumbersEnabled = enabled;
+  EEPROM_AsyncWriteBytes(offsetof(settings_t, toggles), &settings.toggles, sizeof(toggles_t));
 }
 
 bool STORAGE_GetCumulativeTimerResetEnabled(void) {
-  return storage.toggles.cumulativeTimerResetEnabled;
+  return settings.toggles.cumulativeTimerResetEnabled;
 }
 
 void STORAGE_SetCumulativeTimerResetEnabled(bool enabled) {
-  storage.toggles.cumulativeTimerResetEnabled = enabled;
-  EEPROM_AsyncWriteBytes(offsetof(storage_t, toggles), &storage.toggles, sizeof(toggles_t));
+  settings.toggles.cumulativeTimerResetEnabled = enabled;
+  EEPROM_AsyncWriteBytes(offsetof(settings_t, toggles), &settings.toggles, sizeof(toggles_t));
 }
 
 bool STORAGE_GetAutoAnswerEnabled(void) {
-  return storage.toggles.autoAnswerEnabled;
+  return settings.toggles.autoAnswerEnabled;
 }
 
 void STORAGE_SetAutoAnswerEnabled(bool enabled) {
-  storage.toggles.autoAnswerEnabled = enabled;
-  EEPROM_AsyncWriteBytes(offsetof(storage_t, toggles), &storage.toggles, sizeof(toggles_t));
+  settings.toggles.autoAnswerEnabled = enabled;
+  EEPROM_AsyncWriteBytes(offsetof(settings_t, toggles), &settings.toggles, sizeof(toggles_t));
 }
 
 uint8_t STORAGE_GetActiveOwnNumberIndex(void) {
-  return storage.activeOwnNumberIndex;
+  return settings.activeOwnNumberIndex;
 }
 
 void STORAGE_SetActiveOwnNumberIndex(uint8_t index) {
@@ -741,54 +1429,65 @@ void STORAGE_SetActiveOwnNumberIndex(uint8_t index) {
     return;
   }
   
-  storage.activeOwnNumberIndex = index;
-  EEPROM_AsyncWriteByte(offsetof(storage_t, activeOwnNumberIndex), index);
+  settings.activeOwnNumberIndex = index;
+  EEPROM_AsyncWriteByte(offsetof(settings_t, activeOwnNumberIndex), index);
 }
 
 uint8_t STORAGE_GetProgrammingCount(void) {
-  return storage.programmingCount;
+  return settings.programmingCount;
 }
 
 void STORAGE_SetProgrammingCount(uint8_t count) {
-  storage.programmingCount = count;
-  EEPROM_AsyncWriteByte(offsetof(storage_t, programmingCount), count);
+  settings.programmingCount = count;
+  EEPROM_AsyncWriteByte(offsetof(settings_t, programmingCount), count);
 }
 
 uint16_t STORAGE_GetTetrisHighScore(void) {
-  return storage.tetrisHighScore;
+  return settings.tetrisHighScore;
 }
 
 void STORAGE_SetTetrisHighScore(uint16_t score) {
-  storage.tetrisHighScore = score;
-  EEPROM_AsyncWriteBytes(offsetof(storage_t, tetrisHighScore), &storage.tetrisHighScore, sizeof(storage.tetrisHighScore));
+  settings.tetrisHighScore = score;
+  EEPROM_AsyncWriteBytes(offsetof(settings_t, tetrisHighScore), &settings.tetrisHighScore, sizeof(settings.tetrisHighScore));
 }
 
 char* STORAGE_GetTetrisHighScoreInitials(char* dest) {
-  strncpy(dest, storage.tetrisHighScoreInitials, MAX_PLAYER_INITIALS_LENGTH)[MAX_PLAYER_INITIALS_LENGTH] = 0;
+  strncpy(dest, settings.tetrisHighScoreInitials, MAX_PLAYER_INITIALS_LENGTH)[MAX_PLAYER_INITIALS_LENGTH] = 0;
   return dest;
 }
 
 void STORAGE_SetTetrisHighScoreInitials(char const* initials) {
-  strncpy(storage.tetrisHighScoreInitials, initials, MAX_PLAYER_INITIALS_LENGTH);
-  EEPROM_AsyncWriteBytes(offsetof(storage_t, tetrisHighScoreInitials), storage.tetrisHighScoreInitials, MAX_PLAYER_INITIALS_LENGTH);
+  strncpy(settings.tetrisHighScoreInitials, initials, MAX_PLAYER_INITIALS_LENGTH);
+  EEPROM_AsyncWriteBytes(offsetof(settings_t, tetrisHighScoreInitials), settings.tetrisHighScoreInitials, MAX_PLAYER_INITIALS_LENGTH);
 }
 
 char* STORAGE_GetPairedDeviceName(char* dest){
-  strncpy(dest, storage.pairedDeviceName, STORAGE_MAX_DEVICE_NAME_LENGTH)[STORAGE_MAX_DEVICE_NAME_LENGTH] = 0;
+  strncpy(dest, settings.pairedDeviceName, STORAGE_MAX_DEVICE_NAME_LENGTH)[STORAGE_MAX_DEVICE_NAME_LENGTH] = 0;
   return dest;
 }
 
 void STORAGE_SetPairedDeviceName(char const* deviceName) {
-  strncpy(storage.pairedDeviceName, deviceName, STORAGE_MAX_DEVICE_NAME_LENGTH);
-  EEPROM_AsyncWriteBytes(offsetof(storage_t, pairedDeviceName), storage.pairedDeviceName, STORAGE_MAX_DEVICE_NAME_LENGTH);
+  strncpy(settings.pairedDeviceName, deviceName, STORAGE_MAX_DEVICE_NAME_LENGTH);
+  EEPROM_AsyncWriteBytes(offsetof(settings_t, pairedDeviceName), settings.pairedDeviceName, STORAGE_MAX_DEVICE_NAME_LENGTH);
 }
 
 char* STORAGE_GetSecurityCode(char* dest) {
-  uncompressPhoneNumber(dest, storage.securityCode, SECURITY_CODE_LENGTH >> 1);
+  uncompressPhoneNumber(dest, settings.securityCode, SECURITY_CODE_LENGTH >> 1);
   return dest;
 }
 
+#ifdef PROFILE_ENABLED
+void STORAGE_DumpWriteCounts(void) {
+  EEPROM_DumpAsyncByteCounts();
+  printf("[PROFILE] EEPROM bytes written:\r\n");
+  
+  for (uint8_t i = 0; i < WRITE_COUNT_RANGE_COUNT; ++i) {
+    printf("[PROFILE]   %s: %lu\r\n", writeCountRanges[i].label, writeCounts[i]);
+  }
+}
+#endif
+
 void STORAGE_SetSecurityCode(char const* code) {
-  compressPhoneNumber(storage.securityCode, code, SECURITY_CODE_LENGTH);
-  EEPROM_AsyncWriteBytes(offsetof(storage_t, securityCode), storage.securityCode, SECURITY_CODE_LENGTH >> 1);
+  compressPhoneNumber(settings.securityCode, code, SECURITY_CODE_LENGTH);
+  EEPROM_AsyncWriteBytes(offsetof(settings_t, securityCode), settings.securityCode, SECURITY_CODE_LENGTH >> 1);
 }
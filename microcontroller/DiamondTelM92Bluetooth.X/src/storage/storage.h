@@ -4,8 +4,11 @@
  * 
  * This module provides access to all persistent storage for this application.
  * 
- * A copy of the persisted EEPROM data is loaded into memory for more convenient
- * and quick access/processing.
+ * A copy of the persisted settings is loaded into memory for more convenient
+ * and quick access/processing. The much larger directory and credit card 
+ * numbers are read from EEPROM on demand (through a small cache of recently
+ * used entries), which keeps both RAM usage and the time spent in 
+ * STORAGE_Initialize() small.
  * 
  * All setter functions both update the in-memory data immediately, and 
  * asynchronously write the data to EEPROM. This prevents updates from 
@@ -13,6 +16,10 @@
  * that the data is saved to EEPROM upon returning from the setter function. 
  * If necessary, use EEPROM_IsDoneWriting()  to confirm that all asynchronous 
  * EEPROM writes are complete.
+ * 
+ * Frequently written values (call time, volume levels, and directory index) 
+ * are written to the next slot of a small journal in EEPROM each time, 
+ * rather than always to the same bytes, to spread the wear of EEPROM.
  */
 
 #ifndef STORAGE_H
@@ -27,6 +34,7 @@ extern "C" {
 #include "../sound/volume.h"  
 #include "../sound/ringtone.h"  
 #include "../constants.h"
+#include "../util/profile.h"
 
 /**
  * Number of credit cards that can be stored.
@@ -69,6 +77,14 @@ extern "C" {
  */
 void STORAGE_Initialize(void);
 
+#ifdef PROFILE_ENABLED
+/**
+ * Prints the number of bytes physically written to EEPROM for each area of 
+ * storage since power-on to STDIO.
+ */
+void STORAGE_DumpWriteCounts(void);
+#endif
+
 /**
  * Get the stored handset LCD view angle.
  * 
@@ -216,6 +232,25 @@ void STORAGE_SetDirectoryNumber(uint8_t index, char const* number);
  * @return The provided destination char buffer.
  */
 char* STORAGE_GetDirectoryName(uint8_t index, char* dest);
+
+/**
+ * Finds the name of the directory entry for a phone number (for caller ID).
+ * 
+ * Phone numbers are matched by their trailing SHORT_PHONE_NUMBER_LENGTH 
+ * digits (or all digits, if shorter), so that the same number matches with 
+ * or without an area code or country code. Only named directory entries are
+ * matched. If multiple entries match, then the lowest directory index is used.
+ * 
+ * The lookup only compares a small key per directory entry that is kept in 
+ * memory, so it is fast enough to use while a call is ringing. Only entries
+ * with a matching key are read from EEPROM to verify the match.
+ * 
+ * @param number - A phone number.
+ * @param dest - The destination char buffer. The buffer size must be at least 
+ *        STORAGE_MAX_DIRECTORY_NAME_LENGTH + 1.
+ * @return True if found (name copied to `dest`).
+ */
+bool STORAGE_FindDirectoryName(char const* number, char* dest);
 /**
  * Set a stored phone number directory entry, with an associated name.
  * 
@@ -8,6 +8,11 @@
 #include "../../mcc_generated_files/uart3.h"
 #include "../../mcc_generated_files/tmr2.h"
 #include "../../mcc_generated_files/pin_manager.h"
+#include "../util/profile.h"
+#include "../util/scheduler.h"
+#ifdef PROFILE_ENABLED
+#include "../storage/storage.h"
+#endif
 #include <string.h>
 #include <stdio.h>
 
@@ -43,6 +48,75 @@ static const HANDSET_UartCmd indicatorCmdLookup[INDICATOR_COUNT] = {
 
 #define BLANK_PRINTABLE_CHAR (' ')
 
+/**
+ * Bit flags for all text display positions.
+ */
+#define ALL_TEXT_CELLS ((uint16_t)((1 << HANDSET_TEXT_DISPLAY_LENGTH) - 1))
+
+/**
+ * Size of the queue of UART commands waiting to be passed to UART3.
+ * 
+ * Commands are passed from this queue to UART3's (much smaller) write buffer
+ * only as fast as UART3 can accept them, so that commands still in this queue
+ * can be coalesced with newer commands.
+ */
+#define CMD_QUEUE_SIZE (32)
+
+/**
+ * Maximum number of commands that flushText() adds to the command queue
+ * (clearing and re-printing the entire display).
+ */
+#define TEXT_FLUSH_MAX_CMDS (HANDSET_TEXT_DISPLAY_LENGTH + 1)
+
+/**
+ * Size of the list of commands that were deferred by writeCommand() because 
+ * the command queue did not have room to first flush pending text changes.
+ * 
+ * A full text flush plus all deferred commands must fit in the empty command
+ * queue (see releaseDeferredCommands()), so this is as large as it can be.
+ */
+#define DEFERRED_CMD_LIST_SIZE (CMD_QUEUE_SIZE - TEXT_FLUSH_MAX_CMDS)
+
+/**
+ * Groups of commands for coalescing in the command queue.
+ * 
+ * A command in a "state" group (any group after CmdGroup_TEXT) replaces a
+ * queued command of the same group, if no CmdGroup_BARRIER command is queued
+ * between them.
+ */
+typedef enum CmdGroup {
+  /**
+   * Never coalesced, and nothing is coalesced across it.
+   */
+  CmdGroup_BARRIER,
+  /**
+   * Text printing (including text positioning and clearing). 
+   * Never coalesced, but "state" commands may be coalesced across it.
+   */
+  CmdGroup_TEXT,
+  CmdGroup_BACKLIGHT,
+  CmdGroup_LCD_ANGLE,
+  /**
+   * First of INDICATOR_COUNT groups for individual indicators.
+   * Add the HANDSET_Indicator to get the group for that indicator.
+   */
+  CmdGroup_INDICATOR
+} CmdGroup;
+
+/**
+ * A command in the command queue.
+ */
+typedef struct {
+  /**
+   * The UART command.
+   */
+  uint8_t cmd;
+  /**
+   * The CmdGroup of the command.
+   */
+  uint8_t group;
+} queuedCmd_t;
+
 /**
  * Module state.
  */
@@ -52,15 +126,79 @@ static struct {
    */
   HANDSET_EventHandler eventHandler;
   /**
-   * The character that is currently printed at position 0.
+   * Shadow framebuffer of the text display, indexed by display position.
    * 
-   * This is needed to work around some bugs with positioning a
-   * flashing cursor on the Handset.
+   * All text printing functions only update this framebuffer. The changes
+   * are sent to the Handset by flushText(), using as few UART bytes as 
+   * possible.
+   * 
+   * The character at position 0 is also needed to work around some bugs with 
+   * positioning a flashing cursor on the Handset.
+   * See HANDSET_ShowFlashingCursorAt() implementation.
+   */
+  char text[HANDSET_TEXT_DISPLAY_LENGTH];
+  /**
+   * The text that is believed to be currently displayed on the Handset, 
+   * indexed by display position.
+   */
+  char shownText[HANDSET_TEXT_DISPLAY_LENGTH];
+  /**
+   * Bit flags of text display positions that must be sent to the Handset 
+   * by the next flushText(), even if unchanged (bit N = position N).
    * 
-   * See HANDSET_ShowFlashingCursorAt() and HANDSET_HideFlashingCursor()
-   * implementations.
+   * Used to send text unconditionally while command optimization is disabled.
+   */
+  uint16_t forcedTextCells;
+  /**
+   * True if `shownText` is known to match the Handset's display.
+   */
+  bool isShownTextValid;
+  /**
+   * Ring buffer of commands waiting to be passed to UART3.
+   */
+  queuedCmd_t cmdQueue[CMD_QUEUE_SIZE];
+  /**
+   * Index of the oldest command in `cmdQueue`.
+   */
+  uint8_t cmdQueueStart;
+  /**
+   * Number of commands in `cmdQueue`.
+   */
+  uint8_t cmdQueueCount;
+  /**
+   * Commands (oldest first) that are waiting for `deferredText` to be flushed
+   * before they can be added to `cmdQueue`.
+   */
+  queuedCmd_t deferredCmds[DEFERRED_CMD_LIST_SIZE];
+  /**
+   * Number of commands in `deferredCmds`.
+   */
+  uint8_t deferredCmdCount;
+  /**
+   * Snapshot of the text framebuffer when the first of `deferredCmds` was
+   * deferred. This text is sent to the Handset before the deferred commands.
+   */
+  char deferredText[HANDSET_TEXT_DISPLAY_LENGTH];
+#ifdef PROFILE_ENABLED
+  /**
+   * Number of commands that were coalesced into an already queued command.
+   */
+  uint32_t cmdsCoalesced;
+  /**
+   * Number of commands that were dropped by writeCommand() because there was
+   * no room to queue or defer them.
    */
-  char charAtPos0;
+  uint32_t cmdsDropped;
+  /**
+   * Number of UART bytes that would have been sent by the text printing 
+   * functions if each call was sent to the Handset directly.
+   */
+  uint32_t textBytesRequested;
+  /**
+   * Number of UART bytes actually sent for text by flushText().
+   */
+  uint32_t textBytesSent;
+#endif
   /**
    * True if the Handset is currently "on-hook".
    */
@@ -334,6 +472,318 @@ static bool isValidCharPos(uint8_t pos) {
   return pos < HANDSET_TEXT_DISPLAY_LENGTH;
 }
 
+/**
+ * Sets a character in the text framebuffer.
+ * 
+ * @param pos - A valid display position.
+ * @param c - A printable character.
+ */
+static void setTextAt(uint8_t pos, char c) {
+  handset.text[pos] = c;
+  SCHEDULER_MarkRunnable(SCHEDULER_Task_HANDSET);
+  
+  if (!handset.isCommandOptimizationEnabled) {
+    handset.forcedTextCells |= (uint16_t)(1 << pos);
+  }
+}
+
+/**
+ * Performs "standard" printing of a character into the text framebuffer.
+ * 
+ * All characters are shifted to the next higher position, and the character
+ * is placed at position 0.
+ * 
+ * @param c - A printable character.
+ */
+static void shiftInText(char c) {
+  memmove(handset.text + 1, handset.text, HANDSET_TEXT_DISPLAY_LENGTH - 1);
+  handset.text[0] = c;
+  SCHEDULER_MarkRunnable(SCHEDULER_Task_HANDSET);
+
+  if (!handset.isCommandOptimizationEnabled) {
+    handset.forcedTextCells = ALL_TEXT_CELLS;
+  }
+}
+
+/**
+ * Passes as many queued commands to UART3 as it can currently accept,
+ * without waiting.
+ */
+static void pumpCommandQueue(void) {
+  while (handset.cmdQueueCount && UART3_is_tx_ready()) {
+    UART3_Write(handset.cmdQueue[handset.cmdQueueStart].cmd);
+    handset.cmdQueueStart = (handset.cmdQueueStart + 1) % CMD_QUEUE_SIZE;
+    --handset.cmdQueueCount;
+  }
+}
+
+/**
+ * Replaces a command of the same "state" group in a ring buffer of commands, 
+ * if there is one with no barrier between it and the end of the buffer.
+ * 
+ * @param cmds - The ring buffer of commands.
+ * @param start - Index of the oldest command in `cmds`.
+ * @param count - Number of commands in `cmds`.
+ * @param size - Size of `cmds`.
+ * @param cmd - The UART command.
+ * @param group - The CmdGroup of the command.
+ * @return True if a command was replaced.
+ */
+static bool coalesceCommand(
+    queuedCmd_t* cmds, 
+    uint8_t start, 
+    uint8_t count, 
+    uint8_t size, 
+    uint8_t cmd, 
+    CmdGroup group
+    ) {
+  if (group > CmdGroup_TEXT) {
+    uint8_t i = count;
+    
+    while (i) {
+      --i;
+      queuedCmd_t* const queuedCmd = &cmds[(start + i) % size];
+      
+      if (queuedCmd->group == CmdGroup_BARRIER) {
+        break;
+      }
+      
+      if (queuedCmd->group == group) {
+        queuedCmd->cmd = cmd;
+#ifdef PROFILE_ENABLED
+        ++handset.cmdsCoalesced;
+#endif
+        return true;
+      }
+    }
+  }
+  
+  return false;
+}
+
+/**
+ * Gets the number of commands that can be added to the command queue.
+ */
+static uint8_t getCommandQueueFreeSize(void) {
+  return CMD_QUEUE_SIZE - handset.cmdQueueCount;
+}
+
+/**
+ * Adds a command to the command queue.
+ * 
+ * If the command is in a "state" group, and a command of the same group is 
+ * still queued (with no barrier in between), then the queued command is 
+ * replaced instead.
+ * 
+ * This never waits for room in the queue. Callers must check the room first.
+ * 
+ * @param cmd - The UART command.
+ * @param group - The CmdGroup of the command.
+ * @return False if the queue is full, so the command was not added.
+ */
+static bool enqueueCommand(uint8_t cmd, CmdGroup group) {
+  if (coalesceCommand(
+      handset.cmdQueue, 
+      handset.cmdQueueStart, 
+      handset.cmdQueueCount, 
+      CMD_QUEUE_SIZE, 
+      cmd, 
+      group
+      )) {
+    return true;
+  }
+  
+  if (handset.cmdQueueCount == CMD_QUEUE_SIZE) {
+    return false;
+  }
+  
+  queuedCmd_t* const queuedCmd = &handset.cmdQueue[
+      (handset.cmdQueueStart + handset.cmdQueueCount) % CMD_QUEUE_SIZE
+      ];
+  
+  queuedCmd->cmd = cmd;
+  queuedCmd->group = group;
+  ++handset.cmdQueueCount;
+  
+  return true;
+}
+
+/**
+ * Sends all changes in a text framebuffer to the Handset.
+ * 
+ * Changed characters are either printed individually at their positions
+ * (2 bytes each), or the whole display is cleared and re-printed with 
+ * "standard" printing from the highest non-blank position down to position 0 
+ * (1 byte each, plus 1 for clearing), whichever is fewer bytes. At most
+ * TEXT_FLUSH_MAX_CMDS commands are queued.
+ * 
+ * This must be called before sending any other command, so that the Handset 
+ * receives the text and other commands in the same order they were requested
+ * (see writeCommand()).
+ * 
+ * If the command queue does not have room for all of the changes, then 
+ * nothing is sent, and the changes remain pending for the next flush.
+ * 
+ * @param text - The text framebuffer to send (normally `handset.text`).
+ */
+static void flushText(char const* text) {
+  uint16_t changedCells = handset.forcedTextCells;
+  uint8_t changedCount = 0;
+  int8_t lastNonBlankPos = -1;
+  
+  for (uint8_t pos = 0; pos < HANDSET_TEXT_DISPLAY_LENGTH; ++pos) {
+    uint16_t const cellBit = (uint16_t)(1 << pos);
+    
+    if (text[pos] != handset.shownText[pos]) {
+      changedCells |= cellBit;
+    }
+    
+    if (changedCells & cellBit) {
+      ++changedCount;
+    }
+    
+    if (text[pos] != BLANK_PRINTABLE_CHAR) {
+      lastNonBlankPos = (int8_t)pos;
+    }
+  }
+  
+  if (!changedCount && handset.isShownTextValid) {
+    return;
+  }
+  
+  uint8_t const reprintCost = (uint8_t)(lastNonBlankPos + 2);
+  bool const isReprint = !handset.isShownTextValid || (reprintCost < (changedCount << 1));
+#ifdef PROFILE_ENABLED
+  uint8_t bytesSent;
+#endif
+  
+  if (getCommandQueueFreeSize() < (isReprint ? reprintCost : (changedCount << 1))) {
+    return;
+  }
+  
+  if (isReprint) {
+    enqueueCommand(HANDSET_UartCmd_DELETE_ALL_TEXT, CmdGroup_TEXT);
+    
+    for (int8_t pos = lastNonBlankPos; pos >= 0; --pos) {
+      enqueueCommand(text[pos], CmdGroup_TEXT);
+    }
+    
+#ifdef PROFILE_ENABLED
+    bytesSent = reprintCost;
+#endif
+  } else {
+    for (int8_t pos = HANDSET_TEXT_DISPLAY_LENGTH - 1; pos >= 0; --pos) {
+      if (changedCells & (uint16_t)(1 << pos)) {
+        enqueueCommand(HANDSET_UartCmd_SET_PRINT_POS_0 + (uint8_t)pos, CmdGroup_TEXT);
+        enqueueCommand(text[pos], CmdGroup_TEXT);
+      }
+    }
+    
+#ifdef PROFILE_ENABLED
+    bytesSent = changedCount << 1;
+#endif
+  }
+  
+#ifdef PROFILE_ENABLED
+  handset.textBytesSent += bytesSent;
+#endif
+
+  memcpy(handset.shownText, text, HANDSET_TEXT_DISPLAY_LENGTH);
+  handset.forcedTextCells = 0;
+  handset.isShownTextValid = true;
+}
+
+/**
+ * Tests if the text framebuffer has changes that have not been flushed yet.
+ * 
+ * @return True if flushText() would queue any commands.
+ */
+static bool isTextChanged(void) {
+  return !handset.isShownTextValid || 
+      handset.forcedTextCells ||
+      memcmp(handset.text, handset.shownText, HANDSET_TEXT_DISPLAY_LENGTH);
+}
+
+/**
+ * Tests if the deferred text snapshot and all deferred commands fit in the 
+ * command queue (see releaseDeferredCommands()).
+ * 
+ * Always true while the command queue is empty.
+ */
+static bool canReleaseDeferredCommands(void) {
+  return getCommandQueueFreeSize() >= TEXT_FLUSH_MAX_CMDS + handset.deferredCmdCount;
+}
+
+/**
+ * Sends the deferred text snapshot, followed by all deferred commands.
+ * 
+ * Must only be called if canReleaseDeferredCommands().
+ */
+static void releaseDeferredCommands(void) {
+  flushText(handset.deferredText);
+  
+  for (uint8_t i = 0; i < handset.deferredCmdCount; ++i) {
+    enqueueCommand(handset.deferredCmds[i].cmd, handset.deferredCmds[i].group);
+  }
+  
+  handset.deferredCmdCount = 0;
+}
+
+/**
+ * Sends a command to the Handset, after any pending text changes.
+ * 
+ * If the command queue does not have room for the pending text changes, then
+ * the command is deferred (along with a snapshot of the text that must be sent 
+ * before it) until HANDSET_Task() finds the queue empty, rather than waiting 
+ * for room. Once a command is deferred, all later commands are also deferred
+ * to keep them in order.
+ * 
+ * This never waits. If the list of deferred commands is full (and the command
+ * can't be coalesced into it), then the deferred commands are released early
+ * if the queue has room for them. Otherwise, the command is dropped.
+ * 
+ * @param cmd - The UART command to send to the handset.
+ * @param group - The CmdGroup of the command.
+ * @return False if the command was dropped.
+ */
+static bool writeCommand(uint8_t cmd, CmdGroup group) {
+  SCHEDULER_MarkRunnable(SCHEDULER_Task_HANDSET);
+
+  if (!handset.deferredCmdCount) {
+    if (HANDSET_GetCommandQueueRoom() > (isTextChanged() ? TEXT_FLUSH_MAX_CMDS : 0)) {
+      flushText(handset.text);
+      return enqueueCommand(cmd, group);
+    }
+    
+    memcpy(handset.deferredText, handset.text, HANDSET_TEXT_DISPLAY_LENGTH);
+  } else if (coalesceCommand(
+      handset.deferredCmds, 
+      0, 
+      handset.deferredCmdCount, 
+      DEFERRED_CMD_LIST_SIZE, 
+      cmd, 
+      group
+      )) {
+    return true;
+  } else if (handset.deferredCmdCount == DEFERRED_CMD_LIST_SIZE) {
+    if (!canReleaseDeferredCommands()) {
+#ifdef PROFILE_ENABLED
+      ++handset.cmdsDropped;
+#endif
+      return false;
+    }
+    
+    releaseDeferredCommands();
+    return writeCommand(cmd, group);
+  }
+  
+  handset.deferredCmds[handset.deferredCmdCount].cmd = cmd;
+  handset.deferredCmds[handset.deferredCmdCount].group = group;
+  ++handset.deferredCmdCount;
+  
+  return true;
+}
+
 /**
  * Interrupt-on-change handler for the PWR button input pin.
  * 
@@ -343,11 +793,20 @@ static bool isValidCharPos(uint8_t pos) {
  */
 static void pwrButtonInterruptHandler(void) {
   handset.isPwrButtonChangeDetected = true;
+  SCHEDULER_MarkRunnable(SCHEDULER_Task_HANDSET);
 }
 
 void HANDSET_Initialize(HANDSET_EventHandler eventHandler) {
   handset.eventHandler = eventHandler;
-  handset.charAtPos0 = BLANK_PRINTABLE_CHAR;
+  memset(handset.text, BLANK_PRINTABLE_CHAR, HANDSET_TEXT_DISPLAY_LENGTH);
+  memset(handset.shownText, BLANK_PRINTABLE_CHAR, HANDSET_TEXT_DISPLAY_LENGTH);
+  handset.forcedTextCells = 0;
+  // The handset's display contents are unknown until the first flush, which
+  // will clear and re-print the entire display.
+  handset.isShownTextValid = false;
+  handset.cmdQueueStart = 0;
+  handset.cmdQueueCount = 0;
+  handset.deferredCmdCount = 0;
   handset.isPwrButtonChangeDetected = false;
   handset.isPwrButtonDown = !IO_PWR_GetValue();
   handset.currentButtonDownDuration = HANDSET_HoldDuration_MAX + 1;
@@ -359,6 +818,22 @@ void HANDSET_Initialize(HANDSET_EventHandler eventHandler) {
 void HANDSET_Task(void) {
   HANDSET_Event event;
 
+  // Text changes are only sent after all previously queued commands have been
+  // passed to UART3. Until then, further text changes are accumulated in the
+  // framebuffer, so that superseded text is never sent. Deferred commands (and
+  // the text that must precede them) go first.
+  if (!handset.cmdQueueCount) {
+    if (handset.deferredCmdCount) {
+      releaseDeferredCommands();
+    } else {
+      flushText(handset.text);
+    }
+  } else if (handset.deferredCmdCount && canReleaseDeferredCommands()) {
+    releaseDeferredCommands();
+  }
+  
+  pumpCommandQueue();
+
   PIE3bits.TMR2IE = 0;
   uint16_t currentButtonDownDuration = (handset.currentButtonDownDuration > HANDSET_HoldDuration_MAX)
          ? HANDSET_HoldDuration_NONE 
@@ -417,6 +892,20 @@ void HANDSET_Task(void) {
     uint8_t cmd = UART1_Read();
     
     switch(cmd) {
+#ifdef PROFILE_ENABLED
+      case 0x00:
+        PROFILE_Dump();
+        printf(
+            "[PROFILE] HANDSET text bytes: %lu requested, %lu sent, %lu saved\r\n",
+            handset.textBytesRequested,
+            handset.textBytesSent,
+            handset.textBytesRequested - handset.textBytesSent
+            );
+        printf("[PROFILE] HANDSET commands coalesced: %lu\r\n", handset.cmdsCoalesced);
+        printf("[PROFILE] HANDSET commands dropped: %lu\r\n", handset.cmdsDropped);
+        STORAGE_DumpWriteCounts();
+        break;
+#endif
       case HANDSET_UartCmd_BLINKING_TEXT_ON:
         HANDSET_SetTextBlink(true);
         break;
@@ -571,11 +1060,17 @@ void HANDSET_Timer1MS_Interrupt(void) {
       case HANDSET_HoldDuration_VERY_LONG:
       case HANDSET_HoldDuration_MAX:
         handset.currentButtonHold = handset.currentButtonDownDuration;
+        SCHEDULER_MarkRunnable(SCHEDULER_Task_HANDSET);
         break;
     }
   }
 }
 
+bool HANDSET_IsTimer1MSInterruptRequired(void) {
+  return handset.currentButtonDown && 
+      (handset.currentButtonDownDuration < HANDSET_HoldDuration_MAX);
+}
+
 uint8_t HANDSET_GetDisplayPos(int8_t col, int8_t row) {
   if (col < 0 || col >= HANDSET_TEXT_DISPLAY_COLUMNS) {
     return 0xFF;
@@ -592,7 +1087,7 @@ uint8_t HANDSET_GetDisplayPos(int8_t col, int8_t row) {
 }
 
 void HANDSET_RequestHookStatus(void) {
-  UART3_Write(HANDSET_UartCmd_REQUEST_HOOK_STATUS);
+  writeCommand(HANDSET_UartCmd_REQUEST_HOOK_STATUS, CmdGroup_BARRIER);
 }
 
 bool HANDSET_IsOnHook(void) {
@@ -641,31 +1136,32 @@ void HANDSET_SetBacklight(bool on) {
     return;
   }
   
-  handset.isBacklightOn = on;
-  UART3_Write(on ? HANDSET_UartCmd_BACKLIGHT_ON : HANDSET_UartCmd_BACKLIGHT_OFF);
+  if (writeCommand(on ? HANDSET_UartCmd_BACKLIGHT_ON : HANDSET_UartCmd_BACKLIGHT_OFF, CmdGroup_BACKLIGHT)) {
+    handset.isBacklightOn = on;
+  }
 }
 
 void HANDSET_SetLcdViewAngle(uint8_t angle) {
   if (angle <= HANDSET_MAX_LCD_VIEW_ANGLE) {
-    UART3_Write(HANDSET_UartCmd_SET_LCD_ANGLE_0 + angle);
+    writeCommand(HANDSET_UartCmd_SET_LCD_ANGLE_0 + angle, CmdGroup_LCD_ANGLE);
   }
 }
 
 void HANDSET_DisableTextDisplay(void) {
   if (!handset.textDisplayDisableCount++ || !handset.isCommandOptimizationEnabled) {
     if (handset.isTextBlinkOn) {
-      UART3_Write(HANDSET_UartCmd_BLINKING_TEXT_OFF);
+      writeCommand(HANDSET_UartCmd_BLINKING_TEXT_OFF, CmdGroup_BARRIER);
     }
-    UART3_Write(HANDSET_UartCmd_TEXT_DISPLAY_OFF);
+    writeCommand(HANDSET_UartCmd_TEXT_DISPLAY_OFF, CmdGroup_BARRIER);
   }
 }
 
 void HANDSET_EnableTextDisplay(void) {
   if ((handset.textDisplayDisableCount == 1) || !handset.isCommandOptimizationEnabled) {
     handset.textDisplayDisableCount = 0;
-    UART3_Write(HANDSET_UartCmd_TEXT_DISPLAY_ON);
+    writeCommand(HANDSET_UartCmd_TEXT_DISPLAY_ON, CmdGroup_BARRIER);
     if (handset.isTextBlinkOn) {
-      UART3_Write(HANDSET_UartCmd_BLINKING_TEXT_ON);
+      writeCommand(HANDSET_UartCmd_BLINKING_TEXT_ON, CmdGroup_BARRIER);
     }
   } else if (handset.textDisplayDisableCount) {
     --handset.textDisplayDisableCount;
@@ -677,7 +1173,7 @@ void HANDSET_SetTextBlink(bool on) {
       ((handset.isTextBlinkOn != on) && !handset.textDisplayDisableCount) || 
       !handset.isCommandOptimizationEnabled
       ) {
-    UART3_Write(on ? HANDSET_UartCmd_BLINKING_TEXT_ON : HANDSET_UartCmd_BLINKING_TEXT_OFF);
+    writeCommand(on ? HANDSET_UartCmd_BLINKING_TEXT_ON : HANDSET_UartCmd_BLINKING_TEXT_OFF, CmdGroup_BARRIER);
     // This command forces the text display to be enabled, so keep the
     // disabled count in sync if this was called with command optimization
     // disabled.
@@ -687,12 +1183,15 @@ void HANDSET_SetTextBlink(bool on) {
 }
 
 void HANDSET_SetTextAllPixels(bool on) {
-  UART3_Write(on ? HANDSET_UartCmd_ALL_TEXT_PIXELS_ON : HANDSET_UartCmd_ALL_TEXT_PIXELS_OFF);
-  handset.charAtPos0 = on ? HANDSET_Symbol_RECTANGLE : BLANK_PRINTABLE_CHAR;
+  writeCommand(on ? HANDSET_UartCmd_ALL_TEXT_PIXELS_ON : HANDSET_UartCmd_ALL_TEXT_PIXELS_OFF, CmdGroup_BARRIER);
+  // This command replaces all text on the Handset, so update both the 
+  // framebuffer and the shown text to match.
+  memset(handset.text, on ? HANDSET_Symbol_RECTANGLE : BLANK_PRINTABLE_CHAR, HANDSET_TEXT_DISPLAY_LENGTH);
+  memcpy(handset.shownText, handset.text, HANDSET_TEXT_DISPLAY_LENGTH);
 }
 
 void HANDSET_SetAllIndicators(bool on) {
-  UART3_Write(on ? HANDSET_UartCmd_ALL_INDICATORS_ON : HANDSET_UartCmd_ALL_INDICATORS_OFF); 
+  writeCommand(on ? HANDSET_UartCmd_ALL_INDICATORS_ON : HANDSET_UartCmd_ALL_INDICATORS_OFF, CmdGroup_BARRIER); 
   memset(handset.indicatorState, on, INDICATOR_COUNT);
 }
 
@@ -711,20 +1210,23 @@ void HANDSET_SetIndicator(HANDSET_Indicator indicator, bool on) {
     // to individual commands to turn each of the two indicators on/off.
 
     if (!handset.isCommandOptimizationEnabled || (on != handset.indicatorState[HANDSET_Indicator_NO])) {
-      UART3_Write(HANDSET_UartCmd_INDICATOR_NO_ON + offset);
-      handset.indicatorState[HANDSET_Indicator_NO] = on;
+      if (writeCommand(HANDSET_UartCmd_INDICATOR_NO_ON + offset, CmdGroup_INDICATOR + HANDSET_Indicator_NO)) {
+        handset.indicatorState[HANDSET_Indicator_NO] = on;
+      }
     }
     
     if (!handset.isCommandOptimizationEnabled || (on != handset.indicatorState[HANDSET_Indicator_SVC])) {
-      UART3_Write(HANDSET_UartCmd_INDICATOR_SVC_ON + offset);
-      handset.indicatorState[HANDSET_Indicator_SVC] = on;
+      if (writeCommand(HANDSET_UartCmd_INDICATOR_SVC_ON + offset, CmdGroup_INDICATOR + HANDSET_Indicator_SVC)) {
+        handset.indicatorState[HANDSET_Indicator_SVC] = on;
+      }
     }
   } else if (!handset.isCommandOptimizationEnabled || (on != handset.indicatorState[indicator])) {
     // All indicators aside from NO_SVC are individual indicators according
     // to the handset.
     
-    UART3_Write(indicatorCmdLookup[indicator] + offset);
-    handset.indicatorState[indicator] = on;
+    if (writeCommand(indicatorCmdLookup[indicator] + offset, CmdGroup_INDICATOR + indicator)) {
+      handset.indicatorState[indicator] = on;
+    }
   }
 }
 
@@ -734,7 +1236,7 @@ void HANDSET_SetSignalStrength(uint8_t signalStrength) {
     signalStrength = HANDSET_MAX_SIGNAL_STRENGTH;
   }
   
-  UART3_Write(HANDSET_UartCmd_SET_SIGNAL_STRENGTH_0 + signalStrength);
+  writeCommand(HANDSET_UartCmd_SET_SIGNAL_STRENGTH_0 + signalStrength, CmdGroup_BARRIER);
 
   memset(
       handset.indicatorState + HANDSET_Indicator_SIGNAL_BAR_1, 
@@ -766,8 +1268,16 @@ void HANDSET_SetSignalBarAtIndex(uint8_t index, bool on) {
 }
 
 void HANDSET_ClearText(void) {
-  UART3_Write(HANDSET_UartCmd_DELETE_ALL_TEXT);
-  handset.charAtPos0 = BLANK_PRINTABLE_CHAR;
+  memset(handset.text, BLANK_PRINTABLE_CHAR, HANDSET_TEXT_DISPLAY_LENGTH);
+  SCHEDULER_MarkRunnable(SCHEDULER_Task_HANDSET);
+  
+  if (!handset.isCommandOptimizationEnabled) {
+    handset.forcedTextCells = ALL_TEXT_CELLS;
+  }
+  
+#ifdef PROFILE_ENABLED
+  handset.textBytesRequested += 1;
+#endif
 }
 
 bool HANDSET_IsCharPrintable(char c) {
@@ -781,10 +1291,11 @@ bool HANDSET_IsCharPrintable(char c) {
 }
 
 void HANDSET_PrintChar(char c) {
-  c = ensurePrintableChar(c);
-
-  UART3_Write(c);
-  handset.charAtPos0 = c;
+  shiftInText(ensurePrintableChar(c));
+  
+#ifdef PROFILE_ENABLED
+  handset.textBytesRequested += 1;
+#endif
 }
 
 void HANDSET_PrintCharN(char c, size_t n) {
@@ -794,12 +1305,14 @@ void HANDSET_PrintCharN(char c, size_t n) {
     n = HANDSET_TEXT_DISPLAY_LENGTH;
   }
   
+#ifdef PROFILE_ENABLED
+  handset.textBytesRequested += n;
+#endif
+
   while(n > 0) {
-    UART3_Write(c);
+    shiftInText(c);
     --n;
   }
-  
-  handset.charAtPos0 = c;
 }
 
 void HANDSET_PrintString(char const* str) {
@@ -837,14 +1350,11 @@ void HANDSET_PrintStringN(char const* str, size_t n) {
 
 void HANDSET_PrintCharAt(char c, uint8_t pos) {
   if (isValidCharPos(pos)) {
-    c = ensurePrintableChar(c);
-
-    UART3_Write(HANDSET_UartCmd_SET_PRINT_POS_0 + pos);
-    UART3_Write(c);
+    setTextAt(pos, ensurePrintableChar(c));
     
-    if (pos == 0) {
-      handset.charAtPos0 = c;
-    }
+#ifdef PROFILE_ENABLED
+    handset.textBytesRequested += 2;
+#endif
   }
 }
 
@@ -863,11 +1373,13 @@ void HANDSET_PrintCharNAt(char c, size_t n, uint8_t pos) {
   c = ensurePrintableChar(c);
 
   while(n > 0) {
-    UART3_Write(HANDSET_UartCmd_SET_PRINT_POS_0 + pos);
-    UART3_Write(c);
+    setTextAt(pos, c);
+    
+#ifdef PROFILE_ENABLED
+    handset.textBytesRequested += 2;
+#endif
     
     if (pos == 0) {
-      handset.charAtPos0 = c;
       // We can't print any more characters beyond this position, so break
       // out early.
       break;
@@ -940,11 +1452,14 @@ void HANDSET_ShowFlashingCursorAt(uint8_t pos) {
     // then sending the command to hide the flashing cursor (in that order only),
     // somehow guarantees that the cursor can be reliably shown, then reliably 
     // repositioned or hidden later.
-    UART3_Write(HANDSET_UartCmd_SET_PRINT_POS_0);
-    UART3_Write(handset.charAtPos0);
-    UART3_Write(HANDSET_UartCmd_HIDE_CURSOR);
-
-    UART3_Write(HANDSET_UartCmd_SHOW_CURSOR_POS_0 + pos);
+    //
+    // Pending text changes are flushed first, so that the character at 
+    // position 0 is the character that is actually displayed.
+    writeCommand(HANDSET_UartCmd_SET_PRINT_POS_0, CmdGroup_BARRIER);
+    writeCommand(handset.text[0], CmdGroup_BARRIER);
+    writeCommand(HANDSET_UartCmd_HIDE_CURSOR, CmdGroup_BARRIER);
+
+    writeCommand(HANDSET_UartCmd_SHOW_CURSOR_POS_0 + pos, CmdGroup_BARRIER);
     // This command forces the text display to be enabled, so keep the
     // disabled count in sync if this was called with command optimization
     // disabled.
@@ -954,7 +1469,7 @@ void HANDSET_ShowFlashingCursorAt(uint8_t pos) {
 
 void HANDSET_HideFlashingCursor(void) {
   if (!handset.isCommandOptimizationEnabled || !handset.textDisplayDisableCount) {
-    UART3_Write(HANDSET_UartCmd_HIDE_CURSOR);
+    writeCommand(HANDSET_UartCmd_HIDE_CURSOR, CmdGroup_BARRIER);
     // This command forces the text display to be enabled, so keep the
     // disabled count in sync if this was called with command optimization
     // disabled.
@@ -967,7 +1482,9 @@ void HANDSET_SetMasterAudio(bool on) {
     return;
   }
   
-  UART3_Write(on ? HANDSET_UartCmd_MASTER_AUDIO_ON : HANDSET_UartCmd_MASTER_AUDIO_OFF);
+  if (!writeCommand(on ? HANDSET_UartCmd_MASTER_AUDIO_ON : HANDSET_UartCmd_MASTER_AUDIO_OFF, CmdGroup_BARRIER)) {
+    return;
+  }
 
   // Sometimes a loud audio "pop" occurs while turning the master audio on, and 
   // it is sometimes able to cause a false "logic high" reading on the UART TX 
@@ -979,7 +1496,7 @@ void HANDSET_SetMasterAudio(bool on) {
   //   both "logic high". So an unwanted voltage spike during the null command
   //   does not corrupt the command.
   if (on) {
-    UART3_Write(0);
+    writeCommand(0, CmdGroup_BARRIER);
   }
   
   handset.isMasterAudioOn = on;
@@ -990,8 +1507,9 @@ void HANDSET_SetMicrophone(bool on) {
     return;
   }
   
-  UART3_Write(on ? HANDSET_UartCmd_MICROPHONE_ON : HANDSET_UartCmd_MICROPHONE_OFF);
-  handset.isMicrophoneOn = on;
+  if (writeCommand(on ? HANDSET_UartCmd_MICROPHONE_ON : HANDSET_UartCmd_MICROPHONE_OFF, CmdGroup_BARRIER)) {
+    handset.isMicrophoneOn = on;
+  }
 }
 
 void HANDSET_SetLoudSpeaker(bool on) {
@@ -1000,7 +1518,9 @@ void HANDSET_SetLoudSpeaker(bool on) {
   }
   
   if (on) {
-    UART3_Write(HANDSET_UartCmd_LOUD_SPEAKER_ON);
+    if (!writeCommand(HANDSET_UartCmd_LOUD_SPEAKER_ON, CmdGroup_BARRIER)) {
+      return;
+    }
   } else {
     // When turning the loudspeaker off, send the UART command immediately 
     // rather than adding to the end of the UART write buffer to help minimize
@@ -1017,15 +1537,37 @@ void HANDSET_SetEarSpeaker(bool on) {
     return;
   }
   
-  UART3_Write(on ? HANDSET_UartCmd_EAR_SPEAKER_ON : HANDSET_UartCmd_EAR_SPEAKER_OFF);
-  handset.isEarSpeakerOn = on;
+  if (writeCommand(on ? HANDSET_UartCmd_EAR_SPEAKER_ON : HANDSET_UartCmd_EAR_SPEAKER_OFF, CmdGroup_BARRIER)) {
+    handset.isEarSpeakerOn = on;
+  }
 }
 
 void HANDSET_SendArbitraryCommand(uint8_t cmd) {
-  UART3_Write(cmd);
+  writeCommand(cmd, CmdGroup_BARRIER);
+  // The command may have changed the displayed text in unknown ways, so
+  // the entire display must be re-printed by the next flush.
+  handset.isShownTextValid = false;
+}
+
+uint8_t HANDSET_GetCommandQueueRoom(void) {
+  return handset.deferredCmdCount ? 0 : (CMD_QUEUE_SIZE - handset.cmdQueueCount);
 }
 
 void HANDSET_FlushWriteBuffer(void) {
+  if (handset.deferredCmdCount) {
+    while (handset.cmdQueueCount) {
+      pumpCommandQueue();
+    }
+    
+    releaseDeferredCommands();
+  }
+  
+  flushText(handset.text);
+  
+  while (handset.cmdQueueCount) {
+    pumpCommandQueue();
+  }
+  
   while (!UART3_is_tx_done());
 }
 
@@ -586,7 +586,11 @@ void HANDSET_Initialize(HANDSET_EventHandler eventHandler);
 /**
  * Main task loop behavior for the HANDSET module.
  * 
- * Must be called from the main task loop of the app.
+ * Must be called from the main task loop of the app, whenever 
+ * SCHEDULER_Task_HANDSET is runnable. The HANDSET module marks it runnable
+ * when text or commands are written, when a button hold duration is reached, 
+ * and when the PWR button changes. UART1/UART3 receive and UART3 transmit 
+ * interrupts must also mark it runnable (see main.c).
  */
 void HANDSET_Task(void);
 
@@ -597,6 +601,15 @@ void HANDSET_Task(void);
  */
 void HANDSET_Timer1MS_Interrupt(void);
 
+/**
+ * Tests if HANDSET_Timer1MS_Interrupt() must currently be called.
+ * 
+ * It is only required while the hold duration of a button is being timed.
+ * 
+ * @return True if the 1ms timer interrupt is required.
+ */
+bool HANDSET_IsTimer1MSInterruptRequired(void);
+
 /**
  * Get the raw one-dimensional display position that corresponds to a 
  * 2-dimensional (col, row) coordinate, where col=0 is the left-most column and
@@ -929,6 +942,12 @@ void HANDSET_SetSignalBarAtIndex(uint8_t index, bool on);
 
 /**
  * Clears all text on the display.
+ * 
+ * NOTE: All text printing functions only update a framebuffer of the text 
+ *       display. Changed characters are sent to the handset by the next
+ *       HANDSET_Task(), HANDSET_FlushWriteBuffer(), or any other command to the
+ *       handset, using the fewest UART commands needed to update the display.
+ *       Printing text and then changing it again before then costs nothing.
  */
 void HANDSET_ClearText(void);
 
@@ -1207,10 +1226,43 @@ void HANDSET_SetEarSpeaker(bool on);
  */
 void HANDSET_SendArbitraryCommand(uint8_t cmd);
 
+/**
+ * Handset command queue room (see HANDSET_GetCommandQueueRoom()) needed to 
+ * redraw the entire text display between HANDSET_DisableTextDisplay() and
+ * HANDSET_EnableTextDisplay() without deferring any commands.
+ */
+#define HANDSET_FULL_REDRAW_QUEUE_ROOM (HANDSET_TEXT_DISPLAY_LENGTH + 3)
+
+/**
+ * Gets the number of commands that can be added to the handset command queue
+ * without waiting.
+ * 
+ * Commands to the handset are queued, and passed on to UART3 as fast as it
+ * can accept them by HANDSET_Task(). Pending text changes are sent ahead of 
+ * each command. If the queue does not have room for them, then the command
+ * (and all commands after it) is deferred until there is room, so it does
+ * not wait and is never sent ahead of earlier text. Nothing ever waits for
+ * room: if the list of deferred commands is also full, then further commands
+ * are dropped (a setter whose command is dropped keeps its previous state, so
+ * calling it again retries). Callers that redraw a lot (e.g., games) can check
+ * the remaining room first (see HANDSET_FULL_REDRAW_QUEUE_ROOM), and defer the
+ * redraw to a later task pass if there is not enough.
+ * 
+ * Commands that only change a state (backlight, LCD angle, individual 
+ * indicators) replace a queued command for the same state, so superseded
+ * state changes do not use extra room or UART bytes.
+ * 
+ * @return The number of commands that can be added without waiting, or zero
+ *         while any commands are deferred.
+ */
+uint8_t HANDSET_GetCommandQueueRoom(void);
+
 /**
  * Waits for all pending UART commands to be sent to the handset before 
  * returning.
  * 
+ * Any pending text display changes are sent first.
+ * 
  * This is useful when you need to be able to make assumptions about the next 
  * handset command being sent immediately for timing purposes.
  */
@@ -23,6 +23,7 @@
 #include "../util/interval.h"
 #include "../sound/sound.h"
 #include <stdio.h>
+#include <string.h>
 
 /**
  * Amount of time (hundredths of a second) to wait for indication that the 
@@ -54,6 +55,17 @@
  */
 #define DEFER_BATTERY_LEVEL_OK_EVENT_TIMEOUT (200)
 
+/**
+ * Max number of simulated button presses that can wait for room in the UART4 
+ * write buffer.
+ */
+#define PENDING_BUTTON_PRESS_QUEUE_SIZE (4)
+
+/**
+ * Number of UART bytes sent to the Transceiver per simulated button press.
+ */
+#define BUTTON_PRESS_UART_LENGTH (2)
+
 /**
  * Module state.
  */
@@ -100,6 +112,15 @@ static struct {
    * than an unsolicited "event".
    */
   timeout_t recentSimulatedButtonPressTimeout;
+  /**
+   * Simulated button presses waiting for room in the UART4 write buffer,
+   * oldest first.
+   */
+  HANDSET_Button pendingButtonPresses[PENDING_BUTTON_PRESS_QUEUE_SIZE];
+  /**
+   * Number of buttons in `pendingButtonPresses`.
+   */
+  uint8_t pendingButtonPressCount;
   /**
    * True if the transceiver is connected to external power.
    * 
@@ -124,19 +145,51 @@ static struct {
 } module;
 
 /**
- * Send Handset events to the Transceiver to simulate a complete press and
- * release of a Handset button.
+ * Send Handset events to the Transceiver for as many pending simulated button
+ * presses as will fit in the UART4 write buffer, without waiting.
  * 
  * Also starts (or restarts) the `recentSimulatedButtonPressTimeout` so 
  * certain subsequent commands from the Transceiver can be ignored as being a 
  * direct consequence of the simulated button press.
+ */
+static void sendPendingButtonPresses(void) {
+  uint8_t sentCount = 0;
+  
+  while (
+      (sentCount < module.pendingButtonPressCount) && 
+      (uart4TxBufferRemaining >= BUTTON_PRESS_UART_LENGTH)
+      ) {
+    UART4_Write(module.pendingButtonPresses[sentCount++]);
+    UART4_Write(HANDSET_UartEvent_RELEASE);
+    TIMEOUT_Start(&module.recentSimulatedButtonPressTimeout, 50);
+  }
+  
+  if (sentCount) {
+    module.pendingButtonPressCount -= sentCount;
+    memmove(
+        module.pendingButtonPresses, 
+        module.pendingButtonPresses + sentCount, 
+        module.pendingButtonPressCount * sizeof(HANDSET_Button)
+        );
+  }
+}
+
+/**
+ * Simulate a complete press and release of a Handset button.
+ * 
+ * The button press is sent to the Transceiver immediately if there is room in 
+ * the UART4 write buffer. Otherwise, it is sent by a later TRANSCEIVER_Task().
  * 
  * @param button - The button to simulate.
  */
 static void simulateButtonPress(HANDSET_Button button) {
-  UART4_Write(button);
-  UART4_Write(HANDSET_UartEvent_RELEASE);
-  TIMEOUT_Start(&module.recentSimulatedButtonPressTimeout, 50);
+  if (module.pendingButtonPressCount == PENDING_BUTTON_PRESS_QUEUE_SIZE) {
+    printf("[TSCVR] Simulated button press queue full!\r\n");
+    return;
+  }
+  
+  module.pendingButtonPresses[module.pendingButtonPressCount++] = button;
+  sendPendingButtonPresses();
 }
 
 /**
@@ -149,20 +202,29 @@ static bool wasButtonPressRecentlySimulated(void) {
 
 void TRANSCEIVER_Initialize(TRANSCEIVER_EventHandler eventHandler) {
   module.eventHandler = eventHandler;
+  TIMEOUT_InitializeOnTimerWheel(&module.transceiverReadyTimeout);
+  TIMEOUT_SetTask(&module.transceiverReadyTimeout, SCHEDULER_Task_TRANSCEIVER);
   TIMEOUT_Start(&module.transceiverReadyTimeout, TRANSCEIVER_READY_TIMOUT);
-  INTERVAL_Initialize(&module.batteryLevelRequestInterval, BATTERY_LEVEL_REQUEST_INTERVAL);
-  TIMEOUT_Cancel(&module.batteryLevelRequestTimeout);
+  INTERVAL_InitializeOnTimerWheel(&module.batteryLevelRequestInterval, BATTERY_LEVEL_REQUEST_INTERVAL);
+  INTERVAL_SetTask(&module.batteryLevelRequestInterval, SCHEDULER_Task_TRANSCEIVER);
+  TIMEOUT_InitializeOnTimerWheel(&module.batteryLevelRequestTimeout);
+  TIMEOUT_SetTask(&module.batteryLevelRequestTimeout, SCHEDULER_Task_TRANSCEIVER);
   module.pendingBatteryLevel = 0;
   module.batteryLevel = 0;
-  TIMEOUT_Cancel(&module.deferBatteryLevelOkEventTimeout);
+  TIMEOUT_InitializeOnTimerWheel(&module.deferBatteryLevelOkEventTimeout);
+  TIMEOUT_SetTask(&module.deferBatteryLevelOkEventTimeout, SCHEDULER_Task_TRANSCEIVER);
   module.isBatteryLevelLow = false;
-  TIMEOUT_Cancel(&module.recentSimulatedButtonPressTimeout);
+  TIMEOUT_InitializeOnTimerWheel(&module.recentSimulatedButtonPressTimeout);
+  TIMEOUT_SetTask(&module.recentSimulatedButtonPressTimeout, SCHEDULER_Task_TRANSCEIVER);
+  module.pendingButtonPressCount = 0;
   module.isConnectedToExternalPower = true;
   module.isPowerButtonPressed = false;
   module.isPoweringOff = false;
 }
 
 void TRANSCEIVER_Task(void) {
+  sendPendingButtonPresses();
+  
   if (UART4_is_rx_ready()) {
     HANDSET_UartCmd cmd = UART4_Read();
     
@@ -337,14 +399,6 @@ void TRANSCEIVER_HANDSET_EventHandler(HANDSET_Event const* event) {
   }
 }
 
-void TRANSCEIVER_Timer10MS_Interrupt(void) {
-  TIMEOUT_Timer_Interrupt(&module.transceiverReadyTimeout);
-  TIMEOUT_Timer_Interrupt(&module.batteryLevelRequestTimeout);
-  TIMEOUT_Timer_Interrupt(&module.deferBatteryLevelOkEventTimeout);
-  TIMEOUT_Timer_Interrupt(&module.recentSimulatedButtonPressTimeout);
-  INTERVAL_Timer_Interrupt(&module.batteryLevelRequestInterval);  
-}
-
 void TRANSCEIVER_PollBatteryLevelNow(void) {
   printf("[TSCVR] Poll Battery Level Now\r\n");
   INTERVAL_SkipAhead(&module.batteryLevelRequestInterval);
@@ -84,13 +84,6 @@ void TRANSCEIVER_Initialize(TRANSCEIVER_EventHandler eventHandler);
  */
 void TRANSCEIVER_Task(void);
 
-/**
- * 10 millisecond timer event handler for the Transceiver module.
- * 
- * This must be called from a timer interrupt with a 10 millisecond period.
- */
-void TRANSCEIVER_Timer10MS_Interrupt(void);
-
 /**
  * Handset event handler for this module.
  * 
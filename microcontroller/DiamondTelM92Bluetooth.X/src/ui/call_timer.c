@@ -7,6 +7,7 @@
 #include "../telephone/handset.h"
 #include "../storage/storage.h"
 #include "../sound/sound.h"
+#include "../util/scheduler.h"
 #include "../../mcc_generated_files/tmr0.h"
 #include <stdint.h>
 
@@ -49,6 +50,7 @@ static void timer100MS_Interrupt(void) {
   if (++module.timerInterruptCount == 10) {
     module.secondTimerExpired = true;
     module.timerInterruptCount = 0;
+    SCHEDULER_MarkRunnable(SCHEDULER_Task_APP);
   }
 }
 
@@ -59,6 +61,10 @@ void CALL_TIMER_Initialize(void) {
   module.isDisplayUpdateEnabled = false;
   
   TMR0_SetInterruptHandler(&timer100MS_Interrupt);
+  // The generated initialization starts the timer, but it is only needed 
+  // while the call timer is running (see CALL_TIMER_Start()). Every timer 
+  // interrupt wakes the CPU from Idle mode.
+  TMR0_StopTimer();
 }
 
 void CALL_TIMER_Task(void) {
@@ -80,7 +80,7 @@ static void resetInput(void) {
 
 void CLR_CODES_Initialize(void) {
   module.isActive = false;
-  TIMEOUT_Cancel(&module.activeTimeout);
+  TIMEOUT_InitializeOnTimerWheel(&module.activeTimeout);
 }
 
 void CLR_CODES_Start(CLR_CODES_EventHandler eventHandler) {
@@ -96,14 +96,6 @@ void CLR_CODES_Task(void) {
   }
 }
 
-void CLR_CODES_Timer10MS_Interrupt(void) {
-  if (!module.isActive) {
-    return;
-  }
-  
-  TIMEOUT_Timer_Interrupt(&module.activeTimeout);
-}
-
 void CLR_CODES_HANDSET_EventHandler(HANDSET_Event const* event) {
   if (!module.isActive || !(event->type == HANDSET_EventType_BUTTON_DOWN)) {
     return;
@@ -28,8 +28,6 @@ void CLR_CODES_Start(CLR_CODES_EventHandler eventHandler);
 
 void CLR_CODES_Task(void);
 
-void CLR_CODES_Timer10MS_Interrupt(void);
-
 void CLR_CODES_HANDSET_EventHandler(HANDSET_Event const* event);
 
 #ifdef	__cplusplus
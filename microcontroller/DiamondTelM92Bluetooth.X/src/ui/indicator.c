@@ -18,8 +18,8 @@ static uint8_t signalSweepIndex;
 static interval_t signalSweepInterval;
 
 void INDICATOR_Initialize(void) {
-  INTERVAL_Initialize(&flashingInterval, 50);
-  INTERVAL_Initialize(&signalSweepInterval, 10);
+  INTERVAL_InitializeOnTimerWheel(&flashingInterval, 50);
+  INTERVAL_InitializeOnTimerWheel(&signalSweepInterval, 10);
 }
 
 void INDICATOR_Task(void) {
@@ -53,11 +53,6 @@ void INDICATOR_Task(void) {
   }
 }
 
-void INDICATOR_Timer10MS_Interrupt(void) {
-  INTERVAL_Timer_Interrupt(&flashingInterval);
-  INTERVAL_Timer_Interrupt(&signalSweepInterval);
-}
-
 void INDICATOR_StartFlashing(HANDSET_Indicator indicator) {
   for (uint8_t i = 0; i < flashingIndicatorsCount; ++i) {
     if (flashingIndicators[i] == indicator) {
@@ -16,7 +16,6 @@ extern "C" {
 
 void INDICATOR_Initialize(void);
 void INDICATOR_Task(void);
-void INDICATOR_Timer10MS_Interrupt(void);
 
 void INDICATOR_StartFlashing(HANDSET_Indicator indicator);
 void INDICATOR_StopFlashing(HANDSET_Indicator indicator, bool isOn);
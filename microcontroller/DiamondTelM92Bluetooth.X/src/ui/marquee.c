@@ -43,16 +43,12 @@ static void printMarqueeText(void) {
 }
 
 void MARQUEE_Initialize(void) {
-  INTERVAL_Initialize(&state.scrollInterval, SCROLL_INTERVAL);
+  INTERVAL_InitializeOnTimerWheel(&state.scrollInterval, SCROLL_INTERVAL);
+  TIMEOUT_InitializeOnTimerWheel(&state.scrollDelayTimeout);
   memset(state.text, ' ', 6);
   state.text[MAX_TEXT_LENGTH] = 0;
 }
 
-void MARQUEE_Timer10MS_Interrupt(void) {
-  INTERVAL_Timer_Interrupt(&state.scrollInterval);
-  TIMEOUT_Timer_Interrupt(&state.scrollDelayTimeout);
-}
-
 void MARQUEE_Task(void) {
   if (TIMEOUT_Task(&state.scrollDelayTimeout)) {
     INTERVAL_Start(&state.scrollInterval, true);
@@ -19,8 +19,6 @@ typedef enum MARQUEE_Row {
   
 void MARQUEE_Initialize(void);
 
-void MARQUEE_Timer10MS_Interrupt(void);
-
 void MARQUEE_Task(void);
 
 void MARQUEE_Start(char const* text, MARQUEE_Row row);
@@ -9,29 +9,57 @@
 #include "interval.h"
 
 void INTERVAL_Initialize(interval_t* interval, uint16_t duration) {
+  if (interval->_isOnTimerWheel) {
+    TIMER_WHEEL_Cancel(&interval->_entry);
+    interval->_isOnTimerWheel = false;
+  }
+  
   // First mark the timer as expired. This guarantees that execution of
   // INTERVAL_Timer_Interrupt from within a timer interrupt will not interfere 
   // with writing any other variables.
-  interval->_timerExpired = true;
+  interval->_entry._isExpired = true;
 
   interval->_isRunning = false;
   interval->_duration = duration;
   interval->_timer = 0;
-  interval->_timerExpired = false;
+  interval->_entry._isExpired = false;
+}
+
+void INTERVAL_InitializeOnTimerWheel(interval_t* interval, uint16_t duration) {
+  INTERVAL_Initialize(interval, duration);
+  interval->_isOnTimerWheel = true;
+}
+
+void INTERVAL_SetTask(interval_t* interval, SCHEDULER_Task task) {
+  interval->_entry._task = task;
 }
 
 void INTERVAL_Timer_Interrupt(interval_t* interval) {
-  if (!interval->_timerExpired && interval->_timer != 0) {
+  if (interval->_isOnTimerWheel) {
+    return;
+  }
+  
+  if (!interval->_entry._isExpired && interval->_timer != 0) {
     if (--interval->_timer == 0) {
-      interval->_timerExpired = true;
+      TIMER_WHEEL_Expire(&interval->_entry);
     }
   }
 }
 
 bool INTERVAL_Task(interval_t* interval) {
-  if (interval->_timerExpired) {
-    interval->_timer = interval->_duration;
-    interval->_timerExpired = (interval->_timer == 0);
+  if (interval->_entry._isExpired) {
+    if (interval->_isOnTimerWheel) {
+      // Stays expired if the duration is zero
+      TIMER_WHEEL_Schedule(&interval->_entry, interval->_duration);
+    } else {
+      interval->_timer = interval->_duration;
+      
+      if (interval->_timer == 0) {
+        TIMER_WHEEL_Expire(&interval->_entry);
+      } else {
+        interval->_entry._isExpired = false;
+      }
+    }
 
     return true;
   }
@@ -40,10 +68,16 @@ bool INTERVAL_Task(interval_t* interval) {
 }
 
 void INTERVAL_Start(interval_t* interval, bool triggerImmediately) {
+  if (interval->_isOnTimerWheel) {
+    TIMER_WHEEL_Schedule(&interval->_entry, triggerImmediately ? 0 : interval->_duration);
+    interval->_isRunning = true;
+    return;
+  }
+  
   // First mark the timer as expired. This guarantees that execution of
   // INTERVAL_Timer_Interrupt from within a timer interrupt will not interfere 
   // with writing any other variables.
-  interval->_timerExpired = true;
+  interval->_entry._isExpired = true;
   
   if (triggerImmediately) {
     interval->_timer = 0;
@@ -52,25 +86,40 @@ void INTERVAL_Start(interval_t* interval, bool triggerImmediately) {
   }
 
   interval->_isRunning = true;  
-  interval->_timerExpired = (interval->_timer == 0);
+  
+  if (interval->_timer == 0) {
+    TIMER_WHEEL_Expire(&interval->_entry);
+  } else {
+    interval->_entry._isExpired = false;
+  }
 }
 
 void INTERVAL_SkipAhead(interval_t* interval) {
   if (interval->_isRunning) {
-    interval->_timerExpired = true;
-    interval->_timer = 0;
+    if (interval->_isOnTimerWheel) {
+      TIMER_WHEEL_Schedule(&interval->_entry, 0);
+    } else {
+      interval->_timer = 0;
+      TIMER_WHEEL_Expire(&interval->_entry);
+    }
   }
 }
 
 void INTERVAL_Cancel(interval_t* interval) {
+  if (interval->_isOnTimerWheel) {
+    TIMER_WHEEL_Cancel(&interval->_entry);
+    interval->_isRunning = false;
+    return;
+  }
+  
   // First mark the timer as expired. This guarantees that execution of
   // INTERVAL_Timer_Interrupt from within a timer interrupt will not interfere 
   // with writing any other variables.
-  interval->_timerExpired = true;
+  interval->_entry._isExpired = true;
 
   interval->_timer = 0;
   interval->_isRunning = false;
-  interval->_timerExpired = false;
+  interval->_entry._isExpired = false;
 }
 
 bool INTERVAL_IsRunning(interval_t* interval) {
@@ -11,6 +11,7 @@
 
 #include <stdint.h>
 #include <stdbool.h>
+#include "timer_wheel.h"
 
 #ifdef	__cplusplus
 extern "C" {
@@ -33,6 +34,11 @@ extern "C" {
  *    execution of code you want to run periodically.
  * -# Use INTERVAL_Start() and INTERVAL_Cancel() to start/cancel a the interval.
  * 
+ * Alternatively, use INTERVAL_InitializeOnTimerWheel() instead of 
+ * INTERVAL_Initialize() to place the interval on the timer wheel (see 
+ * timer_wheel.h), which then advances the interval instead of 
+ * INTERVAL_Timer_Interrupt().
+ * 
  * 
  * NOTE: This is not exactly precise. The amount of error in time between
  * starting a interval and when your code will process the first occurrence of
@@ -46,24 +52,30 @@ extern "C" {
  * precision of the interval.
  */
 typedef struct interval_t {
+  /**
+   * The timer wheel entry of this interval. Also contains the expired state 
+   * of the interval's timer (true if the next occurrence of this interval is
+   * ready to be triggered), even if this interval is not on the timer wheel.
+   */
+  timer_wheel_entry_t _entry;
   /**
    * True if this interval is currently running.
    */
   volatile bool _isRunning;
   /**
    * The number of timer interrupts remaining before the next occurrence of
-   * this interval will trigger.
+   * this interval will trigger (not used if this interval is on the timer 
+   * wheel).
    */
   volatile uint16_t _timer;
-  /**
-   * True if the timer has expired and the next occurrence if this interval
-   * is ready to be triggered.
-   */
-  volatile bool _timerExpired;
   /**
    * The duration between occurrences of this interval (used to reset #_timer).
    */
   uint16_t _duration;
+  /**
+   * True if this interval is advanced by the timer wheel.
+   */
+  bool _isOnTimerWheel;
 } interval_t;
 
 /**
@@ -82,6 +94,29 @@ typedef struct interval_t {
  */
 void INTERVAL_Initialize(interval_t* interval, uint16_t duration);
 
+/**
+ * Initialize an interval to be advanced by the timer wheel (see 
+ * timer_wheel.h) instead of INTERVAL_Timer_Interrupt().
+ * 
+ * Otherwise the same as INTERVAL_Initialize().
+ * 
+ * @param interval - Pointer to an interval.
+ * @param duration - The desired duration between intervals, in terms of 
+ *        "count" of timer wheel ticks.
+ */
+void INTERVAL_InitializeOnTimerWheel(interval_t* interval, uint16_t duration);
+
+/**
+ * Sets the task that is marked runnable when the interval is ready to be
+ * triggered (see scheduler.h).
+ * 
+ * By default, the application task (SCHEDULER_Task_APP) is marked runnable.
+ * 
+ * @param interval - Pointer to an interval.
+ * @param task - The task that processes the interval with INTERVAL_Task().
+ */
+void INTERVAL_SetTask(interval_t* interval, SCHEDULER_Task task);
+
 /**
  * Performs periodic advancement of the interval and detecting if its timer 
  * has timed out.
@@ -93,6 +128,8 @@ void INTERVAL_Initialize(interval_t* interval, uint16_t duration);
  * The period of the timer interrupt determines how quickly the interval
  * timer runs.
  * 
+ * Does nothing if the interval is on the timer wheel.
+ * 
  * @param interval - Pointer to an interval.
  */
 void INTERVAL_Timer_Interrupt(interval_t* interval);
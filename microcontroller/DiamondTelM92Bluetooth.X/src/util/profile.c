@@ -0,0 +1,254 @@
+/**
+ * @file
+ * @author Jeff Lau
+ *
+ * Optional execution time profiling of main loop tasks and timer interrupt
+ * handlers.
+ */
+
+#include "profile.h"
+
+#ifdef PROFILE_ENABLED
+
+#include <xc.h>
+#include <stdio.h>
+
+/**
+ * Number of histogram buckets per profiled call.
+ *
+ * Bucket N counts execution times less than (32 << N) us, except for the last
+ * bucket, which counts all longer execution times.
+ */
+#define HISTOGRAM_SIZE (8)
+
+/**
+ * Number of bits to shift an execution time to the right to get the input
+ * for finding the bucket index in the histogram.
+ */
+#define HISTOGRAM_SHIFT (5)
+
+/**
+ * Collected execution time statistics of a profiled call.
+ */
+typedef struct {
+  /**
+   * Number of recorded executions (saturates at the max value).
+   */
+  uint16_t count;
+  /**
+   * Minimum execution time (us).
+   */
+  uint16_t min;
+  /**
+   * Maximum execution time (us).
+   */
+  uint16_t max;
+  /**
+   * Total execution time (us) of all recorded executions.
+   */
+  uint32_t total;
+  /**
+   * Number of recorded executions in each histogram bucket
+   * (saturates at the max value).
+   */
+  uint16_t histogram[HISTOGRAM_SIZE];
+} stats_t;
+
+static char const* const labels[PROFILE_ID_COUNT] = {
+  "Main Loop",
+  "Idle",
+  "EEPROM",
+  "VOLUME",
+  "SOUND",
+  "INDICATOR",
+  "MARQUEE",
+  "BT Decode",
+  "BT Send",
+  "HANDSET",
+  "TRANSCEIVER",
+  "EXTERNAL_MIC",
+  "CALL_TIMER",
+  "ATCMD",
+  "CLR_CODES",
+  "PHONEBOOK",
+  "10ms ISR",
+  "1ms ISR"
+};
+
+/**
+ * Module state.
+ */
+static struct {
+  /**
+   * Statistics of each profiled call, indexed by PROFILE_Id.
+   */
+  stats_t stats[PROFILE_ID_COUNT];
+  /**
+   * If true, then all recorded executions are ignored until the end of the
+   * current main loop execution.
+   */
+  volatile bool isDiscardingMainLoop;
+  /**
+   * Number of CPU wake-ups from Idle mode.
+   */
+  uint32_t wakeUpCount;
+} module;
+
+static void resetStats(void) {
+  for (uint8_t i = 0; i < PROFILE_ID_COUNT; ++i) {
+    stats_t* stats = &module.stats[i];
+
+    stats->count = 0;
+    stats->min = UINT16_MAX;
+    stats->max = 0;
+    stats->total = 0;
+
+    for (uint8_t j = 0; j < HISTOGRAM_SIZE; ++j) {
+      stats->histogram[j] = 0;
+    }
+  }
+}
+
+/**
+ * Calculates an average number of occurrences per second.
+ *
+ * @param count - Number of occurrences.
+ * @param elapsed - Elapsed time (us). Must be at least 1000.
+ * @return The average number of occurrences per second.
+ */
+static uint32_t getRatePerSecond(uint32_t count, uint32_t elapsed) {
+  uint32_t const elapsedMs = elapsed / 1000;
+
+  return (count <= (UINT32_MAX / 1000))
+      ? (count * 1000) / elapsedMs
+      : (count / elapsedMs) * 1000;
+}
+
+void PROFILE_Initialize(void) {
+  // TMR1: FOSC/4 (8 MHz) with 1:8 prescale = 1us per count
+  T1CON = 0;
+  T1GCON = 0;
+  T1CLK = 0b00001;
+  TMR1H = 0;
+  TMR1L = 0;
+  T1CONbits.CKPS = 0b11;
+  T1CONbits.ON = 1;
+
+  resetStats();
+  module.isDiscardingMainLoop = false;
+  module.wakeUpCount = 0;
+}
+
+uint16_t PROFILE_GetTimestamp(void) {
+  uint8_t high;
+  uint8_t low;
+
+  // Read the high byte again after the low byte to detect (and retry) if
+  // the low byte rolled over between reads. This is used instead of the
+  // timer's 16-bit read mode, because that mode's latched high byte can be
+  // overwritten if an interrupt handler also reads the timer.
+  do {
+    high = TMR1H;
+    low = TMR1L;
+  } while (high != TMR1H);
+
+  return ((uint16_t)high << 8) | low;
+}
+
+void PROFILE_Record(PROFILE_Id id, uint16_t startTimestamp) {
+  uint16_t duration = PROFILE_GetTimestamp() - startTimestamp;
+
+  if (module.isDiscardingMainLoop) {
+    if (id == PROFILE_Id_MAIN_LOOP) {
+      module.isDiscardingMainLoop = false;
+    }
+
+    return;
+  }
+
+  stats_t* stats = &module.stats[id];
+
+  if (stats->count != UINT16_MAX) {
+    ++stats->count;
+  }
+
+  if (duration < stats->min) {
+    stats->min = duration;
+  }
+
+  if (duration > stats->max) {
+    stats->max = duration;
+  }
+
+  stats->total += duration;
+
+  uint8_t bucket = 0;
+  duration >>= HISTOGRAM_SHIFT;
+
+  while (duration && (bucket < (HISTOGRAM_SIZE - 1))) {
+    duration >>= 1;
+    ++bucket;
+  }
+
+  if (stats->histogram[bucket] != UINT16_MAX) {
+    ++stats->histogram[bucket];
+  }
+}
+
+void PROFILE_RecordWakeUp(void) {
+  ++module.wakeUpCount;
+}
+
+void PROFILE_Dump(void) {
+  printf("[PROFILE] Name: count min max (us) | <32 <64 <128 <256 <512 <1024 <2048 >=2048 (us)\r\n");
+
+  for (uint8_t i = 0; i < PROFILE_ID_COUNT; ++i) {
+    stats_t stats;
+
+    // Copy with interrupts disabled to get a consistent snapshot of
+    // stats that are recorded from within interrupt handlers.
+    uint8_t GIEBitValue = INTCON0bits.GIE;
+    INTCON0bits.GIE = 0;
+    stats = module.stats[i];
+    INTCON0bits.GIE = GIEBitValue;
+
+    if (!stats.count) {
+      printf("[PROFILE] %s: 0\r\n", labels[i]);
+      continue;
+    }
+
+    printf("[PROFILE] %s: %u %u %u |", labels[i], stats.count, stats.min, stats.max);
+
+    for (uint8_t j = 0; j < HISTOGRAM_SIZE; ++j) {
+      printf(" %u", stats.histogram[j]);
+    }
+
+    printf("\r\n");
+  }
+
+  // The main loop and idle time alternate, so together they are the elapsed
+  // time since the last reset (not counting this dump, and the interrupt 
+  // handlers that ran between periods of Idle mode while waiting).
+  uint16_t const loopCount = module.stats[PROFILE_Id_MAIN_LOOP].count;
+  uint32_t const idleTotal = module.stats[PROFILE_Id_IDLE].total;
+  uint32_t const elapsed = module.stats[PROFILE_Id_MAIN_LOOP].total + idleTotal;
+
+  if (elapsed >= 1000) {
+    printf(
+        "[PROFILE] Main Loop: %lu per second, %lu wake-ups per second, %lu%% idle\r\n",
+        getRatePerSecond(loopCount, elapsed),
+        getRatePerSecond(module.wakeUpCount, elapsed),
+        idleTotal / (elapsed / 100)
+        );
+  }
+
+  module.wakeUpCount = 0;
+
+  uint8_t GIEBitValue = INTCON0bits.GIE;
+  INTCON0bits.GIE = 0;
+  resetStats();
+  module.isDiscardingMainLoop = true;
+  INTCON0bits.GIE = GIEBitValue;
+}
+
+#endif
@@ -0,0 +1,148 @@
+/**
+ * @file
+ * @author Jeff Lau
+ *
+ * Optional execution time profiling of main loop tasks and timer interrupt
+ * handlers.
+ *
+ * Profiling is disabled unless PROFILE_ENABLED is defined. While disabled,
+ * PROFILE_CALL() simply executes the wrapped call, and no RAM, timer, or
+ * execution time is used for profiling.
+ *
+ * While enabled, TMR1 is used as a free-running 1us timer for timestamps,
+ * and the min/max/histogram of execution times of each profiled call is
+ * accumulated in a RAM table. Send a 0x00 byte over the UART1 debug port to
+ * dump (and reset) the collected statistics (see HANDSET_Task()).
+ *
+ * NOTE: Interrupts are not paused while profiling, so the time spent in
+ *       interrupt handlers is included in the time of whatever was interrupted.
+ *       Timing is also limited to 65,535us; longer execution times will be
+ *       recorded incorrectly.
+ */
+
+#ifndef PROFILE_H
+#define	PROFILE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef	__cplusplus
+extern "C" {
+#endif
+
+/**
+ * Uncomment to enable profiling.
+ */
+//#define PROFILE_ENABLED
+
+/**
+ * Identifies each profiled call.
+ */
+typedef enum PROFILE_Id {
+  /**
+   * A single complete execution of APP_Task() from the main loop.
+   */
+  PROFILE_Id_MAIN_LOOP,
+  /**
+   * A single period of Idle mode while waiting for a task to become runnable
+   * (see SCHEDULER_WaitUntilRunnable()), until the CPU is woken by the next 
+   * interrupt. The 10ms timer always runs, so this is never longer than 10ms,
+   * even though a whole wait may be much longer.
+   */
+  PROFILE_Id_IDLE,
+  PROFILE_Id_EEPROM_TASK,
+  PROFILE_Id_VOLUME_TASK,
+  PROFILE_Id_SOUND_TASK,
+  PROFILE_Id_INDICATOR_TASK,
+  PROFILE_Id_MARQUEE_TASK,
+  PROFILE_Id_BT_COMMAND_DECODE_TASK,
+  PROFILE_Id_BT_COMMAND_SEND_TASK,
+  PROFILE_Id_HANDSET_TASK,
+  PROFILE_Id_TRANSCEIVER_TASK,
+  PROFILE_Id_EXTERNAL_MIC_TASK,
+  PROFILE_Id_CALL_TIMER_TASK,
+  PROFILE_Id_ATCMD_TASK,
+  PROFILE_Id_CLR_CODES_TASK,
+  PROFILE_Id_PHONEBOOK_TASK,
+  /**
+   * The complete APP_Timer10MS_Interrupt() fan-out.
+   */
+  PROFILE_Id_TIMER_10MS_INTERRUPT,
+  /**
+   * The complete APP_Timer1MS_Interrupt() fan-out.
+   */
+  PROFILE_Id_TIMER_1MS_INTERRUPT,
+  PROFILE_ID_COUNT
+} PROFILE_Id;
+
+#ifdef PROFILE_ENABLED
+
+/**
+ * Initializes profiling.
+ *
+ * Configures and starts TMR1, and resets all statistics.
+ */
+void PROFILE_Initialize(void);
+
+/**
+ * Gets the current profiling timestamp.
+ *
+ * Safe to be called from both the main loop and interrupt handlers.
+ *
+ * @return The current value of the free-running 1us timer.
+ */
+uint16_t PROFILE_GetTimestamp(void);
+
+/**
+ * Records the execution time of a profiled call.
+ *
+ * @param id - Identifies the profiled call.
+ * @param startTimestamp - The PROFILE_GetTimestamp() result from immediately
+ *        before the profiled call started.
+ */
+void PROFILE_Record(PROFILE_Id id, uint16_t startTimestamp);
+
+/**
+ * Counts a wake-up of the CPU from Idle mode.
+ */
+void PROFILE_RecordWakeUp(void);
+
+/**
+ * Prints all collected statistics to STDIO, then resets all statistics.
+ *
+ * A summary of the main loop is also printed: the average number of main loop
+ * executions per second, CPU wake-ups from Idle mode per second (including
+ * wake-ups by interrupts that did not make the main loop runnable), and the
+ * percentage of time spent idle (between
+ * executions of the main loop). The summary is only accurate if the dump
+ * happens before 65,535 main loop executions have been recorded.
+ *
+ * The main loop execution in which the dump happens is excluded from the
+ * statistics, because of the time it takes to print the dump.
+ */
+void PROFILE_Dump(void);
+
+/**
+ * Executes a call and records its execution time.
+ *
+ * @param id - Identifies the profiled call.
+ * @param call - The call to be executed.
+ */
+#define PROFILE_CALL(id, call) do { \
+  uint16_t const profileStartTimestamp = PROFILE_GetTimestamp(); \
+  call; \
+  PROFILE_Record((id), profileStartTimestamp); \
+} while (0)
+
+#else
+
+#define PROFILE_CALL(id, call) call
+
+#endif
+
+#ifdef	__cplusplus
+}
+#endif
+
+#endif	/* PROFILE_H */
+
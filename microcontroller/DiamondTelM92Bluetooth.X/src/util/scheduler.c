@@ -0,0 +1,91 @@
+/**
+ * @file
+ * @author Jeff Lau
+ *
+ * Event-driven execution of the main loop's tasks.
+ */
+
+#include "scheduler.h"
+#include "profile.h"
+#include <xc.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+/**
+ * Module state.
+ */
+static struct {
+  /**
+   * True for each task (indexed by SCHEDULER_Task) that must be executed 
+   * again.
+   * 
+   * NOTE: One byte per task, so that each flag is set/cleared atomically
+   *       without disabling interrupts.
+   */
+  volatile bool isRunnable[SCHEDULER_TASK_COUNT];
+} module;
+
+/**
+ * Tests if any task is runnable.
+ * 
+ * @return True if any task is runnable.
+ */
+static bool isAnyTaskRunnable(void) {
+  for (uint8_t i = 0; i < SCHEDULER_TASK_COUNT; ++i) {
+    if (module.isRunnable[i]) {
+      return true;
+    }
+  }
+  
+  return false;
+}
+
+void SCHEDULER_Initialize(void) {
+  // SLEEP enters Idle mode, so that all peripherals and timers keep running
+  CPUDOZEbits.IDLEN = 1;
+  
+  for (uint8_t i = 0; i < SCHEDULER_TASK_COUNT; ++i) {
+    module.isRunnable[i] = true;
+  }
+}
+
+void SCHEDULER_MarkRunnable(SCHEDULER_Task task) {
+  module.isRunnable[task] = true;
+}
+
+bool SCHEDULER_TakeRunnable(SCHEDULER_Task task) {
+  if (!module.isRunnable[task]) {
+    return false;
+  }
+  
+  module.isRunnable[task] = false;
+  return true;
+}
+
+void SCHEDULER_WaitUntilRunnable(void) {
+  uint8_t GIEBitValue = INTCON0bits.GIE;
+  INTCON0bits.GIE = 0;
+
+  // The runnable state is tested with interrupts disabled, so that an
+  // interrupt cannot mark a task runnable between the test and the SLEEP
+  // instruction. An enabled interrupt still wakes the CPU while interrupts
+  // are disabled; it is then handled as soon as interrupts are re-enabled.
+  while (!isAnyTaskRunnable()) {
+#ifdef PROFILE_ENABLED
+    uint16_t const sleepTimestamp = PROFILE_GetTimestamp();
+#endif
+    SLEEP();
+    NOP();
+#ifdef PROFILE_ENABLED
+    // Recorded per SLEEP, because a whole wait may be much longer than the 
+    // profiling timer can measure
+    PROFILE_Record(PROFILE_Id_IDLE, sleepTimestamp);
+    PROFILE_RecordWakeUp();
+#endif
+    INTCON0bits.GIE = 1;
+    NOP();
+    INTCON0bits.GIE = 0;
+  }
+
+  INTCON0bits.GIE = GIEBitValue;
+}
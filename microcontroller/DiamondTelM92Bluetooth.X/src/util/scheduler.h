@@ -0,0 +1,103 @@
+/**
+ * @file
+ * @author Jeff Lau
+ *
+ * Event-driven execution of the main loop's tasks.
+ *
+ * Without the scheduler, the main loop executes every task continuously, even
+ * when there is nothing to do, because every module polls for its own events.
+ * With the scheduler, each task has its own "runnable" flag, and a task is
+ * only executed by the main loop after something has happened that may
+ * require work from it. The CPU is put into Idle mode (CPU halted, peripherals
+ * and timers still running) while no task is runnable.
+ *
+ * A task is marked runnable by:
+ * - Interrupt handlers that produce events for it (received UART data, pin
+ *   changes, and timer ticks that expire one of its timeouts/intervals or
+ *   timers; a timer tick that expires nothing marks nothing).
+ * - Any code that gives it work (e.g., queuing a command to be sent by it).
+ * - Itself, while it has more background work to do than can be done in a
+ *   single execution, or is waiting on hardware that does not interrupt.
+ *
+ * The application task (APP_Task()'s state machine, and the modules that only
+ * react to timeouts/intervals or to calls from the application) is marked
+ * runnable by every event that is dispatched to the application.
+ */
+
+#ifndef SCHEDULER_H
+#define	SCHEDULER_H
+
+#include <stdbool.h>
+
+#ifdef	__cplusplus
+extern "C" {
+#endif
+
+/**
+ * Identifies each task that has its own runnable flag.
+ */
+typedef enum SCHEDULER_Task {
+  /**
+   * The application: APP_Task()'s state machine, and the tasks of all modules
+   * that only react to timeouts/intervals or to calls from the application.
+   *
+   * Must be zero (0), because it is the task of every timeout/interval that
+   * is not explicitly assigned to another task (see TIMEOUT_SetTask()).
+   */
+  SCHEDULER_Task_APP = 0,
+  SCHEDULER_Task_EEPROM,
+  SCHEDULER_Task_BT_COMMAND_DECODE,
+  SCHEDULER_Task_BT_COMMAND_SEND,
+  SCHEDULER_Task_HANDSET,
+  SCHEDULER_Task_TRANSCEIVER,
+  SCHEDULER_Task_EXTERNAL_MIC,
+  SCHEDULER_Task_PHONEBOOK,
+  SCHEDULER_TASK_COUNT
+} SCHEDULER_Task;
+
+/**
+ * Initializes this module.
+ *
+ * Configures the SLEEP instruction to enter Idle mode, and marks all tasks
+ * runnable (so that each executes at least once).
+ */
+void SCHEDULER_Initialize(void);
+
+/**
+ * Marks a task runnable, so that it executes again (at least once) before the
+ * CPU is put into Idle mode.
+ *
+ * Safe to be called from both the main loop and interrupt handlers.
+ *
+ * @param task - The task.
+ */
+void SCHEDULER_MarkRunnable(SCHEDULER_Task task);
+
+/**
+ * Tests if a task is runnable, and clears its runnable state.
+ *
+ * Must be called from the main loop immediately before (conditionally)
+ * executing the task, so that the task is runnable again if it is marked
+ * runnable during its own execution.
+ *
+ * @param task - The task.
+ * @return True if the task is runnable, and must be executed now.
+ */
+bool SCHEDULER_TakeRunnable(SCHEDULER_Task task);
+
+/**
+ * Waits until any task is runnable.
+ *
+ * The CPU is held in Idle mode while waiting. Any interrupt wakes the CPU,
+ * but only interrupts that mark a task runnable end the wait.
+ *
+ * Must be called from the main loop, between executions of APP_Task().
+ */
+void SCHEDULER_WaitUntilRunnable(void);
+
+#ifdef	__cplusplus
+}
+#endif
+
+#endif	/* SCHEDULER_H */
+
@@ -21,56 +21,232 @@
  */
 #define DEFAULT_ASCII_CHAR ('?')
 
-/** An entry for a UTF8 -> ASCII mapping. */
-typedef struct {
-  /** A 16-bit UTF8 code. */
-  uint16_t utf8Code;
-  /** The ASCII character that should be printed as a best match for the UTF8 code. */
-  char asciiCode;
-} utf2ascii_entry_t;
+/**
+ * Number of UTF8 codes in each page of the UTF8 -> ASCII mapping.
+ */
+#define UTF2ASCII_PAGE_SIZE (128)
 
 /**
- * UTF8 -> ASCII mapping for looking up the "best match" ASCII character
- * to be printed in place of the UTF8 code 
- * (because the phone handset only supports ASCII)
- *
- * The entries in this array MUST be in ascending UTF8 code order! 
+ * Number of bits to shift a UTF8 code to the right to get its page index.
  */
-static utf2ascii_entry_t const utf2ascii_lookup[] = {
-  { 0x00A5, HANDSET_Symbol_YEN_SIGN },
-  { 0x03B1, HANDSET_Symbol_ALPHA },
-  { 0x2018, '\'' },
-  { 0x2019, '\'' },
-  { 0x201C, '"' },
-  { 0x201D, '"' },
-  { 0x2192, HANDSET_Symbol_RIGHT_ARROW },
-  { 0x21FE, HANDSET_Symbol_RIGHT_ARROW },
-  { 0x25A0, HANDSET_Symbol_RECTANGLE },
-  { 0x25A4, HANDSET_Symbol_RECTANGLE_STRIPED },
-  { 0x25AE, HANDSET_Symbol_RECTANGLE },
-  { 0x25B2, HANDSET_Symbol_LARGE_UP_ARROW },
-  { 0x25B4, HANDSET_Symbol_SMALL_UP_ARROW },
-  { 0x25B5, HANDSET_Symbol_SMALL_UP_ARROW_OUTLINE },
-  { 0x25BC, HANDSET_Symbol_LARGE_DOWN_ARROW },
-  { 0x25BE, HANDSET_Symbol_SMALL_DOWN_ARROW },
-  { 0x25BF, HANDSET_Symbol_SMALL_DOWN_ARROW_OUTLINE },
-};
+#define UTF2ASCII_PAGE_SHIFT (7)
 
-#define UTF2ASCII_LOOKUP_LENGTH (sizeof(utf2ascii_lookup) / sizeof(utf2ascii_entry_t))
+/**
+ * Pages of the UTF8 -> ASCII mapping for looking up the "best match" ASCII 
+ * character to be printed in place of a UTF8 code
+ * (because the phone handset only supports ASCII).
+ * 
+ * Each page maps UTF2ASCII_PAGE_SIZE consecutive UTF8 codes, indexed by the low 
+ * bits of the UTF8 code. A value of 0 means there is no "best match", and 
+ * DEFAULT_ASCII_CHAR is used instead.
+ * 
+ * Covers Latin-1 Supplement, Latin Extended-A/B (accented letters are mapped 
+ * to the base letter), spacing modifier letters, general punctuation, 
+ * currency symbols, arrows and geometric shapes (mapped to handset symbols
+ * where possible), and the Greek letter alpha.
+ * 
+ * NOTE: The letter mappings were generated from the Unicode character names 
+ *       and compatibility decompositions. Pages of UTF8 codes without any 
+ *       mappings are omitted (see `utf2ascii_pageNumbers`).
+ */
+static char const utf2ascii_pages[][UTF2ASCII_PAGE_SIZE] = {
+  {
+    /* 0x0080 */ 0, 0, 0, 0, 0, 0, 0, 0,
+    /* 0x0088 */ 0, 0, 0, 0, 0, 0, 0, 0,
+    /* 0x0090 */ 0, 0, 0, 0, 0, 0, 0, 0,
+    /* 0x0098 */ 0, 0, 0, 0, 0, 0, 0, 0,
+    /* 0x00A0 */ ' ', '!', 'c', 'L', 0, HANDSET_Symbol_YEN_SIGN, '|', 'S',
+    /* 0x00A8 */ '"', 'C', 'a', '<', '-', '-', 'R', '-',
+    /* 0x00B0 */ 'o', '+', '2', '3', '\'', 'u', 'P', '.',
+    /* 0x00B8 */ ',', '1', 'o', '>', 0, 0, 0, '?',
+    /* 0x00C0 */ 'A', 'A', 'A', 'A', 'A', 'A', 'A', 'C',
+    /* 0x00C8 */ 'E', 'E', 'E', 'E', 'I', 'I', 'I', 'I',
+    /* 0x00D0 */ 'D', 'N', 'O', 'O', 'O', 'O', 'O', 'x',
+    /* 0x00D8 */ 'O', 'U', 'U', 'U', 'U', 'Y', 0, 's',
+    /* 0x00E0 */ 'a', 'a', 'a', 'a', 'a', 'a', 'a', 'c',
+    /* 0x00E8 */ 'e', 'e', 'e', 'e', 'i', 'i', 'i', 'i',
+    /* 0x00F0 */ 'd', 'n', 'o', 'o', 'o', 'o', 'o', '/',
+    /* 0x00F8 */ 'o', 'u', 'u', 'u', 'u', 'y', 0, 'y'
+  },
+  {
+    /* 0x0100 */ 'A', 'a', 'A', 'a', 'A', 'a', 'C', 'c',
+    /* 0x0108 */ 'C', 'c', 'C', 'c', 'C', 'c', 'D', 'd',
+    /* 0x0110 */ 'D', 'd', 'E', 'e', 'E', 'e', 'E', 'e',
+    /* 0x0118 */ 'E', 'e', 'E', 'e', 'G', 'g', 'G', 'g',
+    /* 0x0120 */ 'G', 'g', 'G', 'g', 'H', 'h', 'H', 'h',
+    /* 0x0128 */ 'I', 'i', 'I', 'i', 'I', 'i', 'I', 'i',
+    /* 0x0130 */ 'I', 'i', 'I', 'i', 'J', 'j', 'K', 'k',
+    /* 0x0138 */ 'k', 'L', 'l', 'L', 'l', 'L', 'l', 'L',
+    /* 0x0140 */ 'l', 'L', 'l', 'N', 'n', 'N', 'n', 'N',
+    /* 0x0148 */ 'n', 'n', 'N', 'n', 'O', 'o', 'O', 'o',
+    /* 0x0150 */ 'O', 'o', 'O', 'o', 'R', 'r', 'R', 'r',
+    /* 0x0158 */ 'R', 'r', 'S', 's', 'S', 's', 'S', 's',
+    /* 0x0160 */ 'S', 's', 'T', 't', 'T', 't', 'T', 't',
+    /* 0x0168 */ 'U', 'u', 'U', 'u', 'U', 'u', 'U', 'u',
+    /* 0x0170 */ 'U', 'u', 'U', 'u', 'W', 'w', 'Y', 'y',
+    /* 0x0178 */ 'Y', 'Z', 'z', 'Z', 'z', 'Z', 'z', 's'
+  },
+  {
+    /* 0x0180 */ 'b', 'B', 'B', 'b', 0, 0, 0, 'C',
+    /* 0x0188 */ 'c', 0, 'D', 'D', 'd', 0, 0, 0,
+    /* 0x0190 */ 0, 'F', 'f', 'G', 0, 'h', 0, 'I',
+    /* 0x0198 */ 'K', 'k', 'l', 0, 0, 'N', 'n', 'O',
+    /* 0x01A0 */ 'O', 'o', 'O', 'o', 'P', 'p', 0, 0,
+    /* 0x01A8 */ 0, 0, 0, 't', 'T', 't', 'T', 'U',
+    /* 0x01B0 */ 'u', 0, 'V', 'Y', 'y', 'Z', 'z', 0,
+    /* 0x01B8 */ 0, 0, 0, 0, 0, 0, 0, 0,
+    /* 0x01C0 */ 0, 0, 0, 0, 'D', 'D', 'd', 'L',
+    /* 0x01C8 */ 'L', 'l', 'N', 'N', 'n', 'A', 'a', 'I',
+    /* 0x01D0 */ 'i', 'O', 'o', 'U', 'u', 'U', 'u', 'U',
+    /* 0x01D8 */ 'u', 'U', 'u', 'U', 'u', 0, 'A', 'a',
+    /* 0x01E0 */ 'A', 'a', 'A', 'a', 'G', 'g', 'G', 'g',
+    /* 0x01E8 */ 'K', 'k', 'O', 'o', 'O', 'o', 0, 0,
+    /* 0x01F0 */ 'j', 'D', 'D', 'd', 'G', 'g', 0, 0,
+    /* 0x01F8 */ 'N', 'n', 'A', 'a', 'A', 'a', 'O', 'o'
+  },
+  {
+    /* 0x0200 */ 'A', 'a', 'A', 'a', 'E', 'e', 'E', 'e',
+    /* 0x0208 */ 'I', 'i', 'I', 'i', 'O', 'o', 'O', 'o',
+    /* 0x0210 */ 'R', 'r', 'R', 'r', 'U', 'u', 'U', 'u',
+    /* 0x0218 */ 'S', 's', 'T', 't', 0, 0, 'H', 'h',
+    /* 0x0220 */ 'N', 'd', 'O', 'o', 'Z', 'z', 'A', 'a',
+    /* 0x0228 */ 'E', 'e', 'O', 'o', 'O', 'o', 'O', 'o',
+    /* 0x0230 */ 'O', 'o', 'Y', 'y', 'l', 'n', 't', 0,
+    /* 0x0238 */ 0, 0, 'A', 'C', 'c', 'L', 'T', 's',
+    /* 0x0240 */ 'z', 0, 0, 'B', 'U', 0, 'E', 'e',
+    /* 0x0248 */ 'J', 'j', 0, 'q', 'R', 'r', 'Y', 'y',
+    /* 0x0250 */ 0, 0, 0, 0, 0, 0, 0, 0,
+    /* 0x0258 */ 0, 0, 0, 0, 0, 0, 0, 0,
+    /* 0x0260 */ 0, 0, 0, 0, 0, 0, 0, 0,
+    /* 0x0268 */ 0, 0, 0, 0, 0, 0, 0, 0,
+    /* 0x0270 */ 0, 0, 0, 0, 0, 0, 0, 0,
+    /* 0x0278 */ 0, 0, 0, 0, 0, 0, 0, 0
+  },
+  {
+    /* 0x0280 */ 0, 0, 0, 0, 0, 0, 0, 0,
+    /* 0x0288 */ 0, 0, 0, 0, 0, 0, 0, 0,
+    /* 0x0290 */ 0, 0, 0, 0, 0, 0, 0, 0,
+    /* 0x0298 */ 0, 0, 0, 0, 0, 0, 0, 0,
+    /* 0x02A0 */ 0, 0, 0, 0, 0, 0, 0, 0,
+    /* 0x02A8 */ 0, 0, 0, 0, 0, 0, 0, 0,
+    /* 0x02B0 */ 'h', 0, 'j', 'r', 0, 0, 0, 'w',
+    /* 0x02B8 */ 'y', '\'', '"', 0, '\'', 0, 0, 0,
+    /* 0x02C0 */ 0, 0, 0, 0, 0, 0, '^', 0,
+    /* 0x02C8 */ '\'', 0, 0, '`', 0, 0, 0, 0,
+    /* 0x02D0 */ ':', 0, 0, 0, 0, 0, 0, 0,
+    /* 0x02D8 */ 0, 0, 0, 0, '~', 0, 0, 0,
+    /* 0x02E0 */ 0, 'l', 's', 'x', 0, 0, 0, 0,
+    /* 0x02E8 */ 0, 0, 0, 0, 0, 0, 0, 0,
+    /* 0x02F0 */ 0, 0, 0, 0, 0, 0, 0, 0,
+    /* 0x02F8 */ 0, 0, 0, 0, 0, 0, 0, 0
+  },
+  {
+    /* 0x0380 */ 0, 0, 0, 0, 0, 0, 0, 0,
+    /* 0x0388 */ 0, 0, 0, 0, 0, 0, 0, 0,
+    /* 0x0390 */ 0, 0, 0, 0, 0, 0, 0, 0,
+    /* 0x0398 */ 0, 0, 0, 0, 0, 0, 0, 0,
+    /* 0x03A0 */ 0, 0, 0, 0, 0, 0, 0, 0,
+    /* 0x03A8 */ 0, 0, 0, 0, 0, 0, 0, 0,
+    /* 0x03B0 */ 0, HANDSET_Symbol_ALPHA, 0, 0, 0, 0, 0, 0,
+    /* 0x03B8 */ 0, 0, 0, 0, 0, 0, 0, 0,
+    /* 0x03C0 */ 0, 0, 0, 0, 0, 0, 0, 0,
+    /* 0x03C8 */ 0, 0, 0, 0, 0, 0, 0, 0,
+    /* 0x03D0 */ 0, 0, 0, 0, 0, 0, 0, 0,
+    /* 0x03D8 */ 0, 0, 0, 0, 0, 0, 0, 0,
+    /* 0x03E0 */ 0, 0, 0, 0, 0, 0, 0, 0,
+    /* 0x03E8 */ 0, 0, 0, 0, 0, 0, 0, 0,
+    /* 0x03F0 */ 0, 0, 0, 0, 0, 0, 0, 0,
+    /* 0x03F8 */ 0, 0, 0, 0, 0, 0, 0, 0
+  },
+  {
+    /* 0x2000 */ ' ', ' ', ' ', ' ', ' ', ' ', ' ', ' ',
+    /* 0x2008 */ ' ', ' ', ' ', 0, 0, 0, 0, 0,
+    /* 0x2010 */ '-', '-', '-', '-', '-', '-', '|', 0,
+    /* 0x2018 */ '\'', '\'', '\'', '\'', '"', '"', '"', '"',
+    /* 0x2020 */ '+', '+', '*', 0, '.', 0, '.', '-',
+    /* 0x2028 */ 0, 0, 0, 0, 0, 0, 0, ' ',
+    /* 0x2030 */ '%', 0, '\'', '"', 0, '`', 0, 0,
+    /* 0x2038 */ 0, '<', '>', 0, 0, 0, 0, 0,
+    /* 0x2040 */ 0, 0, 0, 0, '/', 0, 0, 0,
+    /* 0x2048 */ 0, 0, 0, 0, 0, 0, 0, 0,
+    /* 0x2050 */ 0, 0, 0, 0, 0, 0, 0, 0,
+    /* 0x2058 */ 0, 0, 0, 0, 0, 0, 0, ' ',
+    /* 0x2060 */ 0, 0, 0, 0, 0, 0, 0, 0,
+    /* 0x2068 */ 0, 0, 0, 0, 0, 0, 0, 0,
+    /* 0x2070 */ '0', 'i', 0, 0, '4', '5', '6', '7',
+    /* 0x2078 */ '8', '9', 0, 0, 0, 0, 0, 'n'
+  },
+  {
+    /* 0x2080 */ '0', '1', '2', '3', '4', '5', '6', '7',
+    /* 0x2088 */ '8', '9', 0, 0, 0, 0, 0, 0,
+    /* 0x2090 */ 'a', 'e', 'o', 'x', 0, 'h', 'k', 'l',
+    /* 0x2098 */ 'm', 'n', 'p', 's', 't', 0, 0, 0,
+    /* 0x20A0 */ 0, 0, 0, 0, 0, 0, 0, 0,
+    /* 0x20A8 */ 'R', 0, 0, 0, 'E', 0, 0, 0,
+    /* 0x20B0 */ 0, 0, 0, 0, 0, 0, 0, 0,
+    /* 0x20B8 */ 0, 0, 0, 0, 0, 0, 0, 0,
+    /* 0x20C0 */ 0, 0, 0, 0, 0, 0, 0, 0,
+    /* 0x20C8 */ 0, 0, 0, 0, 0, 0, 0, 0,
+    /* 0x20D0 */ 0, 0, 0, 0, 0, 0, 0, 0,
+    /* 0x20D8 */ 0, 0, 0, 0, 0, 0, 0, 0,
+    /* 0x20E0 */ 0, 0, 0, 0, 0, 0, 0, 0,
+    /* 0x20E8 */ 0, 0, 0, 0, 0, 0, 0, 0,
+    /* 0x20F0 */ 0, 0, 0, 0, 0, 0, 0, 0,
+    /* 0x20F8 */ 0, 0, 0, 0, 0, 0, 0, 0
+  },
+  {
+    /* 0x2180 */ 0, 0, 0, 0, 0, 0, 0, 0,
+    /* 0x2188 */ 0, 0, 0, 0, 0, 0, 0, 0,
+    /* 0x2190 */ '<', HANDSET_Symbol_LARGE_UP_ARROW, HANDSET_Symbol_RIGHT_ARROW, HANDSET_Symbol_LARGE_DOWN_ARROW, 0, 0, 0, 0,
+    /* 0x2198 */ 0, 0, 0, 0, 0, 0, 0, 0,
+    /* 0x21A0 */ 0, 0, 0, 0, 0, 0, 0, 0,
+    /* 0x21A8 */ 0, 0, 0, 0, 0, 0, 0, 0,
+    /* 0x21B0 */ 0, 0, 0, 0, 0, 0, 0, 0,
+    /* 0x21B8 */ 0, 0, 0, 0, 0, 0, 0, 0,
+    /* 0x21C0 */ 0, 0, 0, 0, 0, 0, 0, 0,
+    /* 0x21C8 */ 0, 0, 0, 0, 0, 0, 0, 0,
+    /* 0x21D0 */ 0, 0, 0, 0, 0, 0, 0, 0,
+    /* 0x21D8 */ 0, 0, 0, 0, 0, 0, 0, 0,
+    /* 0x21E0 */ 0, 0, 0, 0, 0, 0, 0, 0,
+    /* 0x21E8 */ 0, 0, 0, 0, 0, 0, 0, 0,
+    /* 0x21F0 */ 0, 0, 0, 0, 0, 0, 0, 0,
+    /* 0x21F8 */ 0, 0, 0, 0, 0, 0, HANDSET_Symbol_RIGHT_ARROW, 0
+  },
+  {
+    /* 0x2580 */ 0, 0, 0, 0, 0, 0, 0, 0,
+    /* 0x2588 */ 0, 0, 0, 0, 0, 0, 0, 0,
+    /* 0x2590 */ 0, 0, 0, 0, 0, 0, 0, 0,
+    /* 0x2598 */ 0, 0, 0, 0, 0, 0, 0, 0,
+    /* 0x25A0 */ HANDSET_Symbol_RECTANGLE, 0, 0, 0, HANDSET_Symbol_RECTANGLE_STRIPED, 0, 0, 0,
+    /* 0x25A8 */ 0, 0, 0, 0, 0, 0, HANDSET_Symbol_RECTANGLE, 0,
+    /* 0x25B0 */ 0, 0, HANDSET_Symbol_LARGE_UP_ARROW, 0, HANDSET_Symbol_SMALL_UP_ARROW, HANDSET_Symbol_SMALL_UP_ARROW_OUTLINE, 0, 0,
+    /* 0x25B8 */ 0, 0, 0, 0, HANDSET_Symbol_LARGE_DOWN_ARROW, 0, HANDSET_Symbol_SMALL_DOWN_ARROW, HANDSET_Symbol_SMALL_DOWN_ARROW_OUTLINE,
+    /* 0x25C0 */ 0, 0, 0, 0, 0, 0, 0, 0,
+    /* 0x25C8 */ 0, 0, 0, 0, 0, 0, 0, 0,
+    /* 0x25D0 */ 0, 0, 0, 0, 0, 0, 0, 0,
+    /* 0x25D8 */ 0, 0, 0, 0, 0, 0, 0, 0,
+    /* 0x25E0 */ 0, 0, 0, 0, 0, 0, 0, 0,
+    /* 0x25E8 */ 0, 0, 0, 0, 0, 0, 0, 0,
+    /* 0x25F0 */ 0, 0, 0, 0, 0, 0, 0, 0,
+    /* 0x25F8 */ 0, 0, 0, 0, 0, 0, 0, 0
+  }
+};
 
-//#define USE_BINARY_SEARCH
+/**
+ * For each page index of UTF8 codes (UTF8 code >> UTF2ASCII_PAGE_SHIFT), the 
+ * page number within `utf2ascii_pages`, plus 1. A value of 0 means there are 
+ * no mappings for the page. Page indexes beyond the end of this array also 
+ * have no mappings.
+ */
+static uint8_t const utf2ascii_pageNumbers[] = {
+  /* 0x0000 */ 0, 1, 2, 3, 4, 5, 0, 6, 0, 0, 0, 0, 0, 0, 0, 0,
+  /* 0x0800 */ 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+  /* 0x1000 */ 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+  /* 0x1800 */ 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+  /* 0x2000 */ 7, 8, 0, 9, 0, 0, 0, 0, 0, 0, 0, 10
+};
 
-#ifdef USE_BINARY_SEARCH
-static int utf2ascii_compare(void const* key, void const* entry) {
-  if (*(uint16_t const*)key < ((utf2ascii_entry_t const*)entry)->utf8Code) {
-    return -1;
-  } else if (*(uint16_t const*)key > ((utf2ascii_entry_t const*)entry)->utf8Code) {
-    return 1;
-  } else {
-    return 0;
-  }
-}
-#endif
+#define UTF2ASCII_PAGE_NUMBERS_LENGTH (sizeof(utf2ascii_pageNumbers) / sizeof(utf2ascii_pageNumbers[0]))
 
 char* utf2ascii(char* str) {
   /**
@@ -229,49 +405,18 @@ char* utf2ascii(char* str) {
              */
             char c = DEFAULT_ASCII_CHAR;
 
-#ifdef USE_BINARY_SEARCH
-            /* Find the UTF8 -> ASCII mapping entry for the current UTF8 code */
-            utf2ascii_entry_t const* utf2ascii_entry = bsearch(
-              &utf8Code,
-              utf2ascii_lookup,
-              UTF2ASCII_LOOKUP_LENGTH,
-              sizeof(utf2ascii_entry_t),
-              &utf2ascii_compare  
-            );
-
-            if (utf2ascii_entry) {
-              c = utf2ascii_entry->asciiCode;
-            }
-#else
-            /** Pointer for performing a linear search through `utf2ascii_lookup` */
-            utf2ascii_entry_t const* utf2ascii_entry = utf2ascii_lookup;
-            
-            /* Find the UTF8 -> ASCII mapping entry for the current UTF8 code */
-            for (uint8_t i = 0; i < UTF2ASCII_LOOKUP_LENGTH; ++i) {
-              if (utf2ascii_entry->utf8Code < utf8Code) {
-                /* 
-                 * Keep iterating until we reach the first entry whose UTF8 
-                 * code is >= the code we are looking for...
-                 */
-                ++utf2ascii_entry;
-                continue;
-              }
+            /** Page index of the current UTF8 code */
+            uint16_t const pageIndex = utf8Code >> UTF2ASCII_PAGE_SHIFT;
 
-              /*
-               * Store the mapped ASCII character if we found the the entry
-               * for the target UTF8 code.
-               */
-              if (utf2ascii_entry->utf8Code == utf8Code) {
-                c = utf2ascii_entry->asciiCode;
-              }
+            /* Look up the UTF8 -> ASCII mapping for the current UTF8 code */
+            if ((pageIndex < UTF2ASCII_PAGE_NUMBERS_LENGTH) && utf2ascii_pageNumbers[pageIndex]) {
+              char const mapped = utf2ascii_pages[utf2ascii_pageNumbers[pageIndex] - 1][utf8Code & (UTF2ASCII_PAGE_SIZE - 1)];
               
-              /* 
-               * Break out of the loop early because we either found, 
-               * or will never find, the target
-               */
-              break;
+              if (mapped) {
+                c = mapped;
+              }
             }
-#endif            
+
             /* Write the best match ASCII character to the result. */
             *dest++ = c;
           }
@@ -296,7 +441,111 @@ char* utf2ascii(char* str) {
 }
 
 
-char const* parseNextCsvField(char* dest, char const* csv) {
+/**
+ * Finds the end of the value of a CSV field.
+ * 
+ * @param csv - A pointer to the first char of the field value (after the 
+ *        opening quote, if quoted).
+ * @param csvEnd - A pointer to the end of the CSV string.
+ * @param isQuoted - True if the field value is quoted.
+ * @param next - Updated with a pointer to the beginning of the next CSV field,
+ *        or `csvEnd` if there are no more fields.
+ * @return A pointer to the end of the field value (immediately after its last
+ *         char, not including the closing quote).
+ */
+static char const* findCsvFieldEnd(char const* csv, char const* csvEnd, bool isQuoted, char const** next) {
+  while (true) {
+    if ((csv == csvEnd) || !*csv) {
+      *next = csvEnd;
+      return csv;
+    }
+    
+    if (isQuoted && (*csv == '"')) {
+      char const nextChar = (csv + 1 == csvEnd) ? 0 : csv[1];
+      
+      if (nextChar == '"') {
+        csv += 2;
+        continue;
+      } else if (nextChar == ',') {
+        *next = csv + 2;
+        return csv;
+      } else if (!nextChar) {
+        *next = csvEnd;
+        return csv;
+      }
+    }
+    
+    if (!isQuoted && (*csv == ',')) {
+      *next = csv + 1;
+      return csv;
+    }
+    
+    ++csv;
+  }
+}
+
+char const* scanNextCsvField(csv_field_t* field, char const* csv, char const* csvEnd) {
+  if ((csv >= csvEnd) || !*csv) {
+    field->start = csv;
+    field->length = 0;
+    field->isQuoted = false;
+    return csvEnd;
+  }
+  
+  bool const isQuoted = (*csv == '"');
+  char const* const start = isQuoted ? csv + 1 : csv;
+  
+  field->start = start;
+  field->length = (uint8_t)(findCsvFieldEnd(start, csvEnd, isQuoted, &csv) - start);
+  field->isQuoted = isQuoted;
+  
+  return csv;
+}
+
+char const* skipCsvFields(char const* csv, char const* csvEnd, uint8_t count) {
+  // Fields are skipped without a view of each field
+  while (count-- && (csv < csvEnd)) {
+    if (!*csv) {
+      return csvEnd;
+    }
+    
+    bool const isQuoted = (*csv == '"');
+    findCsvFieldEnd(isQuoted ? csv + 1 : csv, csvEnd, isQuoted, &csv);
+  }
+  
+  return csv;
+}
+
+char* copyCsvField(char* dest, uint8_t destSize, csv_field_t const* field) {
+  char* const destStart = dest;
+  char* const destEnd = dest + destSize - 1;
+  char const* src = field->start;
+  char const* const srcEnd = src + field->length;
+  
+  while ((src != srcEnd) && (dest != destEnd)) {
+    if (field->isQuoted && (*src == '"') && (src + 1 != srcEnd) && (src[1] == '"')) {
+      // Escaped quote
+      ++src;
+    }
+    
+    *dest++ = *src++;
+  }
+  
+  *dest = 0;
+  
+  return destStart;
+}
+
+char const* parseNextCsvField(char* dest, uint8_t destSize, char const* csv, char const* csvEnd) {
+  // Scans and copies in a single pass (unlike scanNextCsvField() followed by
+  // copyCsvField())
+  char* const destEnd = dest + destSize - 1;
+  
+  if ((csv >= csvEnd) || !*csv) {
+    *dest = 0;
+    return csvEnd;
+  }
+  
   bool isQuoted = (*csv == '"');
   
   if (isQuoted) {
@@ -304,20 +553,25 @@ char const* parseNextCsvField(char* dest, char const* csv) {
   }
   
   while (true) {
-    if (!*csv) {
+    if ((csv == csvEnd) || !*csv) {
+      csv = csvEnd;
       break;
     }
     
     if (isQuoted && (*csv == '"')) {
-      if (csv[1] == '"') {
-        *dest++ = '"';
+      char const next = (csv + 1 == csvEnd) ? 0 : csv[1];
+      
+      if (next == '"') {
+        if (dest != destEnd) {
+          *dest++ = '"';
+        }
         csv += 2;
         continue;
-      } else if (csv[1] == ',') {
+      } else if (next == ',') {
         csv += 2;
         break;
-      } else if (!csv[1]) {
-        ++csv;
+      } else if (!next) {
+        csv = csvEnd;
         break;
       }
     }
@@ -327,7 +581,10 @@ char const* parseNextCsvField(char* dest, char const* csv) {
       break;
     }
     
-    *dest++ = *csv++;
+    if (dest != destEnd) {
+      *dest++ = *csv;
+    }
+    ++csv;
   }
   
   *dest = 0;
@@ -348,6 +605,20 @@ bool strstart(char const *str, char const* start) {
   return true;
 }
 
+bool strnstart(char const *str, uint8_t length, char const* start) {
+  while(*start) {
+    if (!length || (*str != *start)) {
+      return false;
+    }
+    
+    ++str;
+    ++start;
+    --length;
+  }
+  
+  return true;
+}
+
 int strnicmp(char const* a, char const* b, int len) {
   for (; len; --len, ++a, ++b) {
     if (!*a || !*b) {
@@ -457,4 +728,90 @@ char* formatPhoneNumber(char* const dest, char const* number) {
   }
   
   return dest;
-}
\ No newline at end of file
+}
+
+#define COMPRESSED_ASTERISK (0x0A)
+#define COMPRESSED_POUND (0x0B)
+#define COMPRESSED_PAUSE (0x0C)
+#define COMPRESSED_CC_MEMORY (0x0D)
+#define COMPRESSED_TERMINATOR (0x0F)
+
+void compressPhoneNumber(uint8_t* dest, char const* phoneNumber, uint8_t maxLength) {
+  if (phoneNumber == NULL) {
+    memset(dest, 0xFF, maxLength >> 1);
+    return;
+  }
+  
+  size_t len = strlen(phoneNumber);
+  
+  if (len > maxLength) {
+    phoneNumber += len - maxLength;
+  }
+  
+  uint8_t i = 0;
+  uint8_t prevNibble = 0;
+  uint8_t nextNibble;
+  
+  while (*phoneNumber) {
+    if (isdigit(*phoneNumber)) {
+      nextNibble = *phoneNumber - '0';
+    } else if (*phoneNumber == '*') {
+      nextNibble = COMPRESSED_ASTERISK;
+    } else if (*phoneNumber == '#') {
+      nextNibble = COMPRESSED_POUND;
+    } else if (*phoneNumber == 'P') {
+      nextNibble = COMPRESSED_PAUSE;
+    } else if (*phoneNumber == 'M') {
+      nextNibble = COMPRESSED_CC_MEMORY;
+    } else {
+      nextNibble = COMPRESSED_TERMINATOR;
+    }
+    
+    if (i & 1) {
+      *dest++ = (uint8_t)(prevNibble << 4) | nextNibble;
+    } else {
+      prevNibble = nextNibble;
+    }
+    
+    ++phoneNumber;
+    ++i;
+  }
+  
+  if (i & 1) {
+    *dest++ = (uint8_t)(prevNibble << 4) | COMPRESSED_TERMINATOR;
+    ++i;
+  }
+  
+  memset(dest, 0xFF, (maxLength - i) >> 1);
+}
+
+static char uncompressPhoneNumberNibble(uint8_t nibble) {
+  if (nibble < 10) {
+    return '0' + nibble;
+  } else if (nibble == COMPRESSED_ASTERISK) {
+    return '*';
+  } else if (nibble == COMPRESSED_POUND) {
+    return '#';
+  } else if (nibble == COMPRESSED_PAUSE) {
+    return 'P';
+  } else if (nibble == COMPRESSED_CC_MEMORY) {
+    return 'M';
+  } else {
+    return 0;
+  }
+}
+
+char* uncompressPhoneNumber(char* dest, uint8_t const* compressedPhoneNumber, uint8_t maxCompressedLength) {
+  uint8_t i = 0;
+  
+  while (i < maxCompressedLength) {
+    uint8_t nextCompressedByte = *compressedPhoneNumber++;
+    *dest++ = uncompressPhoneNumberNibble((nextCompressedByte & 0xF0) >> 4);
+    *dest++ = uncompressPhoneNumberNibble(nextCompressedByte & 0x0F);
+    ++i;
+  }
+  
+  *dest = 0;
+  
+  return dest;
+}
@@ -8,6 +8,7 @@
 #ifndef STRING_H
 #define	STRING_H
 
+#include <stdint.h>
 #include <stdbool.h>
 
 #ifdef	__cplusplus
@@ -31,22 +32,101 @@ extern "C" {
  */
 char* utf2ascii(char* str);
 
+/**
+ * A view of a single field of a CSV (comma-separated values) string, without
+ * copying the field value.
+ */
+typedef struct csv_field_t {
+  /**
+   * Pointer to the first char of the field value (after the opening quote,
+   * if quoted).
+   */
+  char const* start;
+  /**
+   * Length of the field value (not including quotes). Escaped quotes ("") 
+   * within a quoted value are still escaped.
+   */
+  uint8_t length;
+  /**
+   * True if the field value is quoted.
+   */
+  bool isQuoted;
+} csv_field_t;
+
+/**
+ * Scans a single field from the beginning of a CSV (comma-separated values) 
+ * string, without copying the field value.
+ * 
+ * Use skipCsvFields() to skip fields that are not needed, and 
+ * parseNextCsvField() to copy the unquoted value of only the fields that are 
+ * actually needed (in a single pass), or copyCsvField() to copy a field that 
+ * has already been scanned.
+ * 
+ * The CSV string does not need to be null-terminated, so this can be used
+ * to parse directly from a received data buffer.
+ * 
+ * @param field - Updated with a view of the field.
+ * @param csv - A pointer to the beginning of a CSV field of a CSV string.
+ * @param csvEnd - A pointer to the end of the CSV string (immediately after 
+ *        its last character). Scanning also stops at a null terminator, if 
+ *        found before the end.
+ * @return A pointer to the beginning of the next CSV field of the provided 
+ *         CSV string. Returns `csvEnd` if there are no more fields.
+ */
+char const* scanNextCsvField(csv_field_t* field, char const* csv, char const* csvEnd);
+
+/**
+ * Skips over multiple fields of a CSV (comma-separated values) string.
+ * 
+ * @param csv - A pointer to the beginning of a CSV field of a CSV string.
+ * @param csvEnd - A pointer to the end of the CSV string (see 
+ *        scanNextCsvField()).
+ * @param count - The number of fields to skip.
+ * @return A pointer to the beginning of the CSV field after the skipped 
+ *         fields. Returns `csvEnd` if there are no more fields.
+ */
+char const* skipCsvFields(char const* csv, char const* csvEnd, uint8_t count);
+
+/**
+ * Copies the value of a CSV field that was scanned by scanNextCsvField().
+ * 
+ * If the field is quoted, then escaped quotes in the value ("") are 
+ * converted to quotes (").
+ * 
+ * @param dest - The destination buffer for the CSV field value. The value is 
+ *        truncated if necessary to fit in the buffer, and is always 
+ *        null-terminated.
+ * @param destSize - The size of the destination buffer, including space for
+ *        the null terminator.
+ * @param field - A view of a CSV field.
+ * @return A pointer to the destination buffer.
+ */
+char* copyCsvField(char* dest, uint8_t destSize, csv_field_t const* field);
+
 /**
  * Parses a single field from the beginning of a CSV (comma-separated values) string.
  * 
  * If the field is quoted, then the resulting value will have the quotes
  * stripped away, and escaped quotes in the string ("") converted to quotes (").
  * 
- * @param dest - The destination buffer for the CSV field value.
- *        The caller is responsible for guaranteeing that the buffer is large 
- *        enough to contain the entirety of any possible value from the CSV 
- *        source, including a null terminator.
+ * The CSV string does not need to be null-terminated, so this can be used
+ * to parse directly from a received data buffer.
+ * 
+ * @param dest - The destination buffer for the CSV field value. The value is 
+ *        truncated if necessary to fit in the buffer, and is always 
+ *        null-terminated.
+ * @param destSize - The size of the destination buffer, including space for
+ *        the null terminator.
  * @param csv - A pointer to the beginning of a CSV field of a CSV string.
+ * @param csvEnd - A pointer to the end of the CSV string (immediately after 
+ *        its last character). Parsing also stops at a null terminator, if 
+ *        found before the end.
  * @return A pointer to the beginning of the next CSV field of the provided CSV string.
  *         This return value can be subsequently passed in as the `csv` parameter
- *         to this function to parse the next field.
+ *         to this function to parse the next field. Returns `csvEnd` if
+ *         there are no more fields.
  */
-char const* parseNextCsvField(char* dest, char const* csv);
+char const* parseNextCsvField(char* dest, uint8_t destSize, char const* csv, char const* csvEnd);
 
 /**
  * Test if a string starts with a specified substring.
@@ -56,6 +136,16 @@ char const* parseNextCsvField(char* dest, char const* csv);
  */
 bool strstart(char const *str, char const* start);
 
+/**
+ * Test if a string of known length (not necessarily null-terminated) starts 
+ * with a specified substring.
+ * @param str - The string to be tested.
+ * @param length - The length of `str`.
+ * @param start - The null-terminated string to look for at the start.
+ * @return True if `str` starts with `start`.
+ */
+bool strnstart(char const *str, uint8_t length, char const* start);
+
 /**
  * Case-insensitive version of strncmp().
  * 
@@ -123,6 +213,35 @@ char* simplifyPhoneNumber(char* dest, char const* number);
  */
 char* formatPhoneNumber(char* dest, char const* number);
 
+/**
+ * Compresses a phone number to 2 characters (nibbles) per byte.
+ * 
+ * Supported characters are digits, '*', '#', 'P' (pause), and 'M' (credit 
+ * card memory). The compressed number is terminated by a 0xF nibble if it is 
+ * shorter than the max length, and the remainder of the destination is 
+ * filled with 0xFF.
+ * 
+ * @param dest - Destination buffer of (maxLength / 2) bytes.
+ * @param phoneNumber - A phone number, or NULL for an empty phone number.
+ *        If longer than the max length, then only the trailing characters are
+ *        kept.
+ * @param maxLength - The max number of characters to compress. Must be even.
+ */
+void compressPhoneNumber(uint8_t* dest, char const* phoneNumber, uint8_t maxLength);
+
+/**
+ * Uncompresses a phone number that was compressed by compressPhoneNumber().
+ * 
+ * @param dest - Destination buffer for the null-terminated phone number, of 
+ *        at least (maxCompressedLength * 2 + 1) chars.
+ * @param compressedPhoneNumber - The compressed phone number.
+ * @param maxCompressedLength - The max length (in bytes) of the compressed 
+ *        phone number.
+ * @return A pointer to the null terminator at the end of the destination 
+ *         string.
+ */
+char* uncompressPhoneNumber(char* dest, uint8_t const* compressedPhoneNumber, uint8_t maxCompressedLength);
+
 #ifdef	__cplusplus
 }
 #endif
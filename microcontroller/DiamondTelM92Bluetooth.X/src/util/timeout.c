@@ -8,17 +8,30 @@
 
 #include "timeout.h"
 
+void TIMEOUT_InitializeOnTimerWheel(timeout_t* timeout) {
+  TIMEOUT_Cancel(timeout);
+  timeout->_isOnTimerWheel = true;
+}
+
+void TIMEOUT_SetTask(timeout_t* timeout, SCHEDULER_Task task) {
+  timeout->_entry._task = task;
+}
+
 void TIMEOUT_Timer_Interrupt(timeout_t* timeout) {
-  if (!timeout->_timerExpired && timeout->_timer != 0) {
+  if (timeout->_isOnTimerWheel) {
+    return;
+  }
+  
+  if (!timeout->_entry._isExpired && timeout->_timer != 0) {
     if (--timeout->_timer == 0) {
-      timeout->_timerExpired = true;
+      TIMER_WHEEL_Expire(&timeout->_entry);
     }
   }
 }
 
 bool TIMEOUT_Task(timeout_t* timeout) {
-  if (timeout->_timerExpired) {
-    timeout->_timerExpired = false;
+  if (timeout->_entry._isExpired) {
+    timeout->_entry._isExpired = false;
     timeout->_isPending = false;
     return true;
   }
@@ -27,23 +40,42 @@ bool TIMEOUT_Task(timeout_t* timeout) {
 }
 
 void TIMEOUT_Start(timeout_t* timeout,  uint16_t duration) {
+  if (timeout->_isOnTimerWheel) {
+    TIMER_WHEEL_Schedule(&timeout->_entry, duration);
+    timeout->_isPending = true;
+    return;
+  }
+  
   // First mark the timer as expired. This guarantees that execution of
   // TIMEOUT_Timer_Interrupt from within a timer interrupt will not interfere 
   // with writing any other variables.
-  timeout->_timerExpired = true;
+  timeout->_entry._isExpired = true;
 
   timeout->_timer = duration;
   timeout->_isPending = true;
   // Finally set the true "expired" state of the timer.
   // It is immediately expired if the duration is zero.
-  timeout->_timerExpired = (duration == 0);
+  if (duration == 0) {
+    TIMER_WHEEL_Expire(&timeout->_entry);
+  } else {
+    timeout->_entry._isExpired = false;
+  }
 }
 
 void TIMEOUT_StartOrContinue(timeout_t* timeout,  uint16_t duration) {
+  if (timeout->_isOnTimerWheel) {
+    if (!duration || (duration > TIMER_WHEEL_GetRemainingTicks(&timeout->_entry))) {
+      TIMER_WHEEL_Schedule(&timeout->_entry, duration);
+    }
+    
+    timeout->_isPending = true;
+    return;
+  }
+  
   // First mark the timer as expired. This guarantees that execution of
   // TIMEOUT_Timer_Interrupt from within a timer interrupt will not interfere 
   // with writing any other variables.
-  timeout->_timerExpired = true;
+  timeout->_entry._isExpired = true;
 
   if (duration > timeout->_timer) {
     timeout->_timer = duration;
@@ -52,19 +84,29 @@ void TIMEOUT_StartOrContinue(timeout_t* timeout,  uint16_t duration) {
   timeout->_isPending = true;
   // Finally set the true "expired" state of the timer.
   // It is immediately expired if the duration is zero.
-  timeout->_timerExpired = (duration == 0);
+  if (duration == 0) {
+    TIMER_WHEEL_Expire(&timeout->_entry);
+  } else {
+    timeout->_entry._isExpired = false;
+  }
 }
 
 
 void TIMEOUT_Cancel(timeout_t* timeout) {
+  if (timeout->_isOnTimerWheel) {
+    TIMER_WHEEL_Cancel(&timeout->_entry);
+    timeout->_isPending = false;
+    return;
+  }
+  
   // First mark the timer as expired. This guarantees that execution of
   // TIMEOUT_Timer_Interrupt from within a timer interrupt will not interfere 
   // with writing any other variables.
-  timeout->_timerExpired = true;
+  timeout->_entry._isExpired = true;
 
   timeout->_timer = 0;
   timeout->_isPending = false;
-  timeout->_timerExpired = false;
+  timeout->_entry._isExpired = false;
 }
 
 bool TIMEOUT_IsPending(timeout_t const* timeout) {
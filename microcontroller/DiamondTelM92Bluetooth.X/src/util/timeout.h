@@ -11,6 +11,7 @@
 
 #include <stdint.h>
 #include <stdbool.h>
+#include "timer_wheel.h"
 
 #ifdef	__cplusplus
 extern "C" {
@@ -31,6 +32,10 @@ extern "C" {
  *    completion of the timeout.
  * -# Use TIMEOUT_Start() and TIMEOUT_Cancel() to start/cancel a timeout.
  * 
+ * Alternatively, use TIMEOUT_InitializeOnTimerWheel() once to place the
+ * timeout on the timer wheel (see timer_wheel.h), which then advances the 
+ * timeout instead of TIMEOUT_Timer_Interrupt().
+ * 
  * 
  * NOTE: This is not exactly precise. The amount of error in time between
  * starting a timeout and when your code will process the timeout expiration
@@ -45,20 +50,46 @@ extern "C" {
  */
 typedef struct timeout_t {
   /**
-   * The number of timer interrupts remaining before this timeout will complete.
+   * The timer wheel entry of this timeout. Also contains the expired state of
+   * the timeout's timer, even if this timeout is not on the timer wheel.
    */
-  volatile uint16_t _timer;
+  timer_wheel_entry_t _entry;
   /**
-   * True if the timeout was pending and the timer has now expired, 
-   * but completion of the timeout has not yet been processed.
+   * The number of timer interrupts remaining before this timeout will complete
+   * (not used if this timeout is on the timer wheel).
    */
-  volatile bool _timerExpired;
+  volatile uint16_t _timer;
   /**
    * True if this timeout has been started and has not yet completed.
    */
   bool _isPending;
+  /**
+   * True if this timeout is advanced by the timer wheel.
+   */
+  bool _isOnTimerWheel;
 } timeout_t;
 
+/**
+ * Initializes a timeout to be advanced by the timer wheel (see timer_wheel.h)
+ * instead of TIMEOUT_Timer_Interrupt().
+ * 
+ * The initial state of the timeout will be NOT pending.
+ * 
+ * @param timeout - Pointer to a timeout.
+ */
+void TIMEOUT_InitializeOnTimerWheel(timeout_t* timeout);
+
+/**
+ * Sets the task that is marked runnable when the timeout expires (see 
+ * scheduler.h). 
+ * 
+ * By default, the application task (SCHEDULER_Task_APP) is marked runnable.
+ * 
+ * @param timeout - Pointer to a timeout.
+ * @param task - The task that processes the timeout with TIMEOUT_Task().
+ */
+void TIMEOUT_SetTask(timeout_t* timeout, SCHEDULER_Task task);
+
 /**
  * Performs periodic advancement of the timeout and detecting if its timer 
  * has timed out.
@@ -70,6 +101,8 @@ typedef struct timeout_t {
  * The period of the timer interrupt determines how quickly the timeout
  * timer runs.
  * 
+ * Does nothing if the timeout is on the timer wheel.
+ * 
  * @param timeout - Pointer to a timeout.
  */
 void TIMEOUT_Timer_Interrupt(timeout_t* timeout);
@@ -0,0 +1,196 @@
+/**
+ * @file
+ * @author Jeff Lau
+ *
+ * A hierarchical timer wheel that advances any number of timeouts/intervals
+ * from a single call in a timer interrupt.
+ */
+
+#include "timer_wheel.h"
+#include <xc.h>
+#include <stddef.h>
+
+/**
+ * Number of levels of the wheel.
+ */
+#define LEVEL_COUNT (4)
+
+/**
+ * Number of bits of the tick that select a slot within a level.
+ */
+#define LEVEL_BITS (4)
+
+/**
+ * Number of slots in each level of the wheel.
+ */
+#define SLOT_COUNT (1 << LEVEL_BITS)
+
+/**
+ * Bit mask of a slot index within a level.
+ */
+#define SLOT_MASK (SLOT_COUNT - 1)
+
+/**
+ * Module state.
+ *
+ * Modified by both the timer interrupt and the main task loop, so the main
+ * task loop must only modify it with interrupts disabled.
+ */
+static struct {
+  /**
+   * Head of the list of scheduled entries in each slot of each level.
+   */
+  timer_wheel_entry_t* slots[LEVEL_COUNT][SLOT_COUNT];
+  /**
+   * The current tick of the wheel.
+   */
+  volatile uint16_t tick;
+} module;
+
+/**
+ * Removes an entry from the slot that it is scheduled in.
+ *
+ * @param entry - Pointer to a scheduled timer wheel entry.
+ */
+static void unlinkEntry(timer_wheel_entry_t* entry) {
+  *entry->_prevNext = entry->_next;
+
+  if (entry->_next) {
+    entry->_next->_prevNext = entry->_prevNext;
+  }
+
+  entry->_prevNext = NULL;
+}
+
+/**
+ * Links an entry into the slot for its expiration tick, or expires the entry
+ * if its expiration tick is the current tick.
+ *
+ * @param entry - Pointer to an unscheduled timer wheel entry.
+ */
+static void linkEntry(timer_wheel_entry_t* entry) {
+  uint16_t remaining = entry->_expirationTick - module.tick;
+
+  if (!remaining) {
+    TIMER_WHEEL_Expire(entry);
+    return;
+  }
+
+  // Select the lowest level whose slots span the remaining ticks
+  uint8_t level = 0;
+  uint8_t shift = 0;
+
+  while (remaining >>= LEVEL_BITS) {
+    ++level;
+    shift += LEVEL_BITS;
+  }
+
+  timer_wheel_entry_t** const head = &module.slots[level][(entry->_expirationTick >> shift) & SLOT_MASK];
+
+  entry->_next = *head;
+  entry->_prevNext = head;
+
+  if (*head) {
+    (*head)->_prevNext = &entry->_next;
+  }
+
+  *head = entry;
+}
+
+/**
+ * Moves all entries of a slot down to lower levels (or expires them).
+ *
+ * @param level - A level greater than zero (0).
+ * @param slot - A slot index within the level.
+ */
+static void cascadeSlot(uint8_t level, uint8_t slot) {
+  timer_wheel_entry_t* entry = module.slots[level][slot];
+  module.slots[level][slot] = NULL;
+
+  while (entry) {
+    timer_wheel_entry_t* const next = entry->_next;
+    entry->_prevNext = NULL;
+    linkEntry(entry);
+    entry = next;
+  }
+}
+
+void TIMER_WHEEL_Timer_Interrupt(void) {
+  uint16_t const tick = ++module.tick;
+
+  // Cascade higher levels first, because their entries may be moved into
+  // the slots of lower levels that are processed for this same tick.
+  if (!(tick & 0x0FFF)) {
+    cascadeSlot(3, (tick >> 12) & SLOT_MASK);
+  }
+
+  if (!(tick & 0x00FF)) {
+    cascadeSlot(2, (tick >> 8) & SLOT_MASK);
+  }
+
+  if (!(tick & 0x000F)) {
+    cascadeSlot(1, (tick >> 4) & SLOT_MASK);
+  }
+
+  timer_wheel_entry_t** const head = &module.slots[0][tick & SLOT_MASK];
+  timer_wheel_entry_t* entry = *head;
+  *head = NULL;
+
+  while (entry) {
+    entry->_prevNext = NULL;
+    TIMER_WHEEL_Expire(entry);
+    entry = entry->_next;
+  }
+}
+
+void TIMER_WHEEL_Expire(timer_wheel_entry_t* entry) {
+  entry->_isExpired = true;
+  SCHEDULER_MarkRunnable((SCHEDULER_Task)entry->_task);
+}
+
+void TIMER_WHEEL_Schedule(timer_wheel_entry_t* entry, uint16_t ticks) {
+  uint8_t GIEBitValue = INTCON0bits.GIE;
+  INTCON0bits.GIE = 0;
+
+  if (entry->_prevNext) {
+    unlinkEntry(entry);
+  }
+
+  entry->_isExpired = false;
+  entry->_expirationTick = module.tick + ticks;
+  linkEntry(entry);
+
+  INTCON0bits.GIE = GIEBitValue;
+}
+
+void TIMER_WHEEL_Cancel(timer_wheel_entry_t* entry) {
+  uint8_t GIEBitValue = INTCON0bits.GIE;
+  INTCON0bits.GIE = 0;
+
+  if (entry->_prevNext) {
+    unlinkEntry(entry);
+  }
+
+  entry->_isExpired = false;
+
+  INTCON0bits.GIE = GIEBitValue;
+}
+
+uint16_t TIMER_WHEEL_GetRemainingTicks(timer_wheel_entry_t const* entry) {
+  uint16_t result = 0;
+
+  uint8_t GIEBitValue = INTCON0bits.GIE;
+  INTCON0bits.GIE = 0;
+
+  if (entry->_prevNext) {
+    result = entry->_expirationTick - module.tick;
+  }
+
+  INTCON0bits.GIE = GIEBitValue;
+
+  return result;
+}
+
+bool TIMER_WHEEL_IsExpired(timer_wheel_entry_t const* entry) {
+  return entry->_isExpired;
+}
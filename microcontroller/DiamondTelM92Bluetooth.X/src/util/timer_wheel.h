@@ -0,0 +1,137 @@
+/**
+ * @file
+ * @author Jeff Lau
+ *
+ * A hierarchical timer wheel that advances any number of timeouts/intervals
+ * from a single call in a timer interrupt.
+ *
+ * Without the timer wheel, every timeout/interval must be advanced
+ * individually by the timer interrupt, so the interrupt handler's execution
+ * time grows with the number of timeouts/intervals, even if they are not
+ * running. With the timer wheel, each scheduled entry is linked into a slot
+ * of the wheel for its expiration time, and the timer interrupt only
+ * processes the entries of the slots that are reached by the current tick.
+ *
+ * The wheel has multiple levels of slots. Entries that expire within the next
+ * 16 ticks are in level 0 (1 tick per slot). Entries that expire later are in
+ * higher levels (16, 256, and 4096 ticks per slot), and are moved down to
+ * lower levels as their expiration time gets closer. Each entry is moved at
+ * most 3 times, so the execution time of the timer interrupt is proportional
+ * to the number of expiring entries, rather than the number of entries.
+ *
+ * Timeouts and intervals are placed on the timer wheel via
+ * TIMEOUT_InitializeOnTimerWheel() and INTERVAL_InitializeOnTimerWheel(),
+ * and are otherwise used exactly the same as if they were advanced
+ * individually.
+ *
+ * Whenever an entry expires (on or off the timer wheel), the task that it
+ * belongs to is marked runnable (see scheduler.h).
+ */
+
+#ifndef TIMER_WHEEL_H
+#define	TIMER_WHEEL_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "scheduler.h"
+
+#ifdef	__cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Contains the state of a single timer wheel entry.
+ *
+ * The contents of this struct should not be accessed/manipulated directly.
+ * Instead, pass a pointer to the various `TIMER_WHEEL_*` functions.
+ */
+typedef struct timer_wheel_entry_t {
+  /**
+   * The next entry in the same slot of the wheel.
+   */
+  struct timer_wheel_entry_t* _next;
+  /**
+   * Pointer to the pointer that points to this entry (either the head of a
+   * slot, or the `_next` of the previous entry in the slot), or NULL if this
+   * entry is not scheduled.
+   */
+  struct timer_wheel_entry_t** _prevNext;
+  /**
+   * The tick of the wheel at which this entry expires.
+   */
+  uint16_t _expirationTick;
+  /**
+   * True if this entry has expired, and the expiration has not yet been
+   * cleared (by re-scheduling or canceling the entry).
+   */
+  volatile bool _isExpired;
+  /**
+   * The SCHEDULER_Task that is marked runnable when this entry expires
+   * (SCHEDULER_Task_APP, unless changed by TIMEOUT_SetTask() or 
+   * INTERVAL_SetTask()).
+   */
+  uint8_t _task;
+} timer_wheel_entry_t;
+
+/**
+ * Advances the timer wheel by one tick, and expires all entries that are
+ * scheduled to expire at the new tick.
+ *
+ * Must be called from a timer interrupt that triggers periodically. The
+ * period of the timer interrupt determines the duration of a tick.
+ */
+void TIMER_WHEEL_Timer_Interrupt(void);
+
+/**
+ * Schedules an entry to expire after a number of ticks.
+ *
+ * If the entry was already scheduled, then it is re-scheduled. The expired
+ * state of the entry is cleared, unless the number of ticks is zero (0), in
+ * which case the entry is immediately expired.
+ *
+ * @param entry - Pointer to a timer wheel entry.
+ * @param ticks - Number of ticks until the entry expires.
+ */
+void TIMER_WHEEL_Schedule(timer_wheel_entry_t* entry, uint16_t ticks);
+
+/**
+ * Expires an entry that is not scheduled, and marks its task runnable.
+ *
+ * Used by timeouts/intervals that are not on the timer wheel, whose expired
+ * state is also kept in their entry. Safe to be called from interrupt 
+ * handlers.
+ *
+ * @param entry - Pointer to a timer wheel entry.
+ */
+void TIMER_WHEEL_Expire(timer_wheel_entry_t* entry);
+
+/**
+ * Cancels an entry and clears its expired state.
+ *
+ * @param entry - Pointer to a timer wheel entry.
+ */
+void TIMER_WHEEL_Cancel(timer_wheel_entry_t* entry);
+
+/**
+ * Gets the number of ticks remaining until an entry expires.
+ *
+ * @param entry - Pointer to a timer wheel entry.
+ * @return The number of ticks remaining, or zero (0) if the entry is not
+ *         scheduled (including if it has already expired).
+ */
+uint16_t TIMER_WHEEL_GetRemainingTicks(timer_wheel_entry_t const* entry);
+
+/**
+ * Tests if an entry has expired.
+ *
+ * @param entry - Pointer to a timer wheel entry.
+ * @return True if the entry has expired since it was last scheduled.
+ */
+bool TIMER_WHEEL_IsExpired(timer_wheel_entry_t const* entry);
+
+#ifdef	__cplusplus
+}
+#endif
+
+#endif	/* TIMER_WHEEL_H */
+